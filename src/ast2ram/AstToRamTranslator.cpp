@@ -77,6 +77,7 @@
 #include "ram/Expression.h"
 #include "ram/Extend.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/FloatConstant.h"
 #include "ram/IO.h"
 #include "ram/IntrinsicOperator.h"
@@ -84,6 +85,7 @@
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/Node.h"
@@ -99,6 +101,7 @@
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -1011,11 +1014,7 @@ Own<ram::Statement> AstToRamTranslator::translateRecursiveRelation(const std::se
                     mk<ram::Filter>(mk<ram::Negation>(mk<ram::EmptinessCheck>(souffle::clone(src))),
                             mk<ram::Project>(souffle::clone(dest), std::move(values))));
         }
-        for (std::size_t i = 0; i < dest->get()->getArity(); i++) {
-            values.push_back(mk<ram::TupleElement>(0, i));
-        }
-        auto stmt = mk<ram::Query>(mk<ram::Scan>(
-                souffle::clone(src), 0, mk<ram::Project>(souffle::clone(dest), std::move(values))));
+        auto stmt = mk<ram::Merge>(souffle::clone(dest), souffle::clone(src));
         if (dest->get()->getRepresentation() == RelationRepresentation::EQREL) {
             return mk<ram::Sequence>(
                     mk<ram::Extend>(souffle::clone(dest), souffle::clone(src)), std::move(stmt));
@@ -1551,6 +1550,41 @@ void AstToRamTranslator::translateProgram(const ast::TranslationUnit& translatio
     // maintain the index of the SCC within the topological order
     size_t indexOfScc = 0;
 
+    // the index of the SCC at which each relation expires, if it is read after being computed
+    std::map<const ast::Relation*, size_t> expiryIndex;
+    for (size_t i = 0; i < expirySchedule.size(); i++) {
+        for (const auto* relation : expirySchedule[i].expired()) {
+            expiryIndex[relation] = i;
+        }
+    }
+
+    // the relations computed and retained so far, which may be spilled under a memory limit
+    std::vector<const ast::Relation*> retained;
+
+    // a function to spill retained relations, those not read again first, then those read last
+    const auto& makeRamSpill = [&](VecOwn<ram::Statement>& current) {
+        const auto& getNextUse = [&](const ast::Relation* relation) {
+            auto pos = expiryIndex.find(relation);
+            return (pos == expiryIndex.end() || pos->second <= indexOfScc) ? expirySchedule.size()
+                                                                             : pos->second;
+        };
+        std::sort(retained.begin(), retained.end(), [&](const ast::Relation* a, const ast::Relation* b) {
+            auto useA = getNextUse(a);
+            auto useB = getNextUse(b);
+            if (useA != useB) {
+                return useA > useB;
+            }
+            return a->getQualifiedName() < b->getQualifiedName();
+        });
+        VecOwn<ram::RelationReference> relRefs;
+        for (const auto* relation : retained) {
+            relRefs.push_back(translateRelation(relation));
+        }
+        if (!relRefs.empty()) {
+            appendStmt(current, mk<ram::Spill>(std::move(relRefs)));
+        }
+    };
+
     // create all Ram relations in ramRels
     for (const auto& scc : sccOrder.order()) {
         const auto& isRecursive = sccGraph.isRecursive(scc);
@@ -1624,6 +1658,30 @@ void AstToRamTranslator::translateProgram(const ast::TranslationUnit& translatio
             }
         }
 
+        // freeze the relations of this stratum retained for later strata, as they are only read
+        if (Global::config().has("freeze-relations") && !Global::config().has("provenance")) {
+            for (const auto* relation : allInterns) {
+                if (internExps.count(relation) == 0) {
+                    appendStmt(current, mk<ram::Freeze>(translateRelation(relation)));
+                }
+            }
+        }
+
+        // spill the relations retained for later strata if memory is limited
+        if (Global::config().has("memory-limit")) {
+            for (const auto* relation : allInterns) {
+                retained.push_back(relation);
+            }
+            if (!Global::config().has("provenance")) {
+                retained.erase(std::remove_if(retained.begin(), retained.end(),
+                                       [&](const ast::Relation* relation) {
+                                           return internExps.count(relation) > 0;
+                                       }),
+                        retained.end());
+            }
+            makeRamSpill(current);
+        }
+
         // create subroutine for this stratum
         ramSubs["stratum_" + std::to_string(indexOfScc)] = mk<ram::Sequence>(std::move(current));
         indexOfScc++;
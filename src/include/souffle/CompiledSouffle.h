@@ -17,13 +17,17 @@
 #pragma once
 
 #include "souffle/CompiledTuple.h"
+#include "souffle/PatternCache.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SignalHandler.h"
 #include "souffle/SouffleInterface.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/datastructure/BloomFilter.h"
 #include "souffle/datastructure/Brie.h"
 #include "souffle/datastructure/EquivalenceRelation.h"
+#include "souffle/datastructure/HashSet.h"
+#include "souffle/datastructure/InsertBuffer.h"
 #include "souffle/datastructure/Table.h"
 #include "souffle/io/IOSystem.h"
 #include "souffle/io/WriteStream.h"
@@ -223,6 +227,12 @@ public:
         data = true;
         return !result;
     }
+    template <typename T>
+    void insertAll(const T& other) {
+        if (!other.empty()) {
+            data = true;
+        }
+    }
     bool contains(const t_tuple& /* t */) const {
         return data;
     }
@@ -0,0 +1,89 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NativeQuery.h
+ *
+ * Interface between the interpreter and queries it compiled to native
+ * code while running.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <cstddef>
+#include <type_traits>
+
+namespace souffle {
+
+/**
+ * @class NativeQueryContext
+ *
+ * The relations of the interpreter as seen by a query compiled to native code.
+ *
+ * A compiled query refers to relations through the accesses the interpreter
+ * enumerated for it, numbered in the order of the operations and conditions
+ * of the query. Each access stands for one scan, range search, existence or
+ * emptiness check, or projection, and is served by the indexes and views the
+ * interpreter set up for the query. Parallel scans and searches call their
+ * visitor with the context of the calling thread.
+ */
+class NativeQueryContext {
+public:
+    /** Called for each visited tuple; returning false stops the visit */
+    using Visitor = bool (*)(void* closure, NativeQueryContext& ctxt, const RamDomain* tuple);
+
+    virtual ~NativeQueryContext() = default;
+
+    /** Visit all tuples of a relation */
+    virtual void scan(std::size_t access, Visitor visitor, void* closure) = 0;
+
+    /** Visit the tuples of a relation between the given bounds */
+    virtual void range(std::size_t access, const RamDomain* low, const RamDomain* high, Visitor visitor,
+            void* closure) = 0;
+
+    /** Test whether a relation contains the given tuple */
+    virtual bool contains(std::size_t access, const RamDomain* tuple) = 0;
+
+    /** Test whether a relation contains a tuple between the given bounds */
+    virtual bool contains(std::size_t access, const RamDomain* low, const RamDomain* high) = 0;
+
+    /** Test whether a relation is empty */
+    virtual bool empty(std::size_t access) = 0;
+
+    /** Insert a tuple into a relation */
+    virtual void insert(std::size_t access, const RamDomain* tuple) = 0;
+
+    /** Visit all tuples of a relation with a callable object */
+    template <typename Func>
+    void forEach(std::size_t access, Func&& func) {
+        scan(access, &visit<Func>, &func);
+    }
+
+    /** Visit the tuples of a relation between the given bounds with a callable object */
+    template <typename Func>
+    void forEachInRange(std::size_t access, const RamDomain* low, const RamDomain* high, Func&& func) {
+        range(access, low, high, &visit<Func>, &func);
+    }
+
+private:
+    template <typename Func>
+    static bool visit(void* closure, NativeQueryContext& ctxt, const RamDomain* tuple) {
+        return (*static_cast<std::remove_reference_t<Func>*>(closure))(ctxt, tuple);
+    }
+};
+
+/** Signature of the entry point of a compiled query */
+using NativeQueryFunction = void (*)(NativeQueryContext& ctxt);
+
+/** Name of the entry point of a compiled query */
+constexpr const char* NATIVE_QUERY_SYMBOL = "souffle_native_query";
+
+}  // end of namespace souffle
@@ -0,0 +1,200 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PatternCache.h
+ *
+ * Evaluation of the string constraints match and contains on symbols,
+ * shared by the interpreter and synthesised programs.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace souffle {
+
+/**
+ * @class PatternCache
+ *
+ * Evaluates match and contains constraints on symbols of a symbol table.
+ *
+ * Since symbols are immutable, regular expressions are compiled once per pattern
+ * symbol and the outcome of a constraint is memoised per pair of symbols.
+ * Patterns known before evaluation starts can be pinned; all other entries are
+ * kept in bounded tables that are flushed when they overflow. The tables are
+ * sharded, each shard with its own lock, so that the cache can be used by
+ * concurrent threads.
+ */
+class PatternCache {
+public:
+    PatternCache(const SymbolTable& symTable, size_t capacity = 1 << 16)
+            : symTable(symTable), shardCapacity(std::max<size_t>(capacity / NUM_SHARDS, 1)) {}
+
+    /**
+     * Compile a pattern ahead of evaluation and keep it for the lifetime of the
+     * cache. Must not be called concurrently with any other operation.
+     */
+    void pin(RamDomain pattern) {
+        pinned[pattern] = compile(pattern);
+    }
+
+    /** @brief Check whether the text matches the regular expression; false for a malformed pattern */
+    bool match(RamDomain pattern, RamDomain text) {
+        MatchOutcome outcome = getMatchOutcome(pattern, text);
+        if (outcome == MatchOutcome::MALFORMED) {
+            std::cerr << "warning: wrong pattern provided for match(\"" << symTable.resolve(pattern)
+                      << "\",\"" << symTable.resolve(text) << "\").\n";
+        }
+        return outcome == MatchOutcome::MATCH;
+    }
+
+    /** @brief Check whether the text does not match the regular expression; false for a malformed pattern */
+    bool notMatch(RamDomain pattern, RamDomain text) {
+        MatchOutcome outcome = getMatchOutcome(pattern, text);
+        if (outcome == MatchOutcome::MALFORMED) {
+            std::cerr << "warning: wrong pattern provided for !match(\"" << symTable.resolve(pattern)
+                      << "\",\"" << symTable.resolve(text) << "\").\n";
+        }
+        return outcome == MatchOutcome::NO_MATCH;
+    }
+
+    /** @brief Check whether the pattern is a substring of the text */
+    bool contains(RamDomain pattern, RamDomain text) {
+        auto key = std::make_pair(pattern, text);
+        Shard& shard = getShard(PairHash()(key));
+        {
+            auto lease = shard.access.acquire();
+            auto pos = shard.contains.find(key);
+            if (pos != shard.contains.end()) {
+                return pos->second;
+            }
+        }
+        bool result = symTable.resolve(text).find(symTable.resolve(pattern)) != std::string::npos;
+        auto lease = shard.access.acquire();
+        insertBounded(shard.contains, key, result);
+        return result;
+    }
+
+private:
+    enum class MatchOutcome : uint8_t { NO_MATCH, MATCH, MALFORMED };
+
+    using Regex = std::shared_ptr<const std::regex>;
+    using SymbolPair = std::pair<RamDomain, RamDomain>;
+
+    /** hash function for pairs of symbols */
+    struct PairHash {
+        std::size_t operator()(const SymbolPair& key) const {
+            std::hash<RamDomain> domainHash;
+            std::size_t seed = domainHash(key.first);
+            seed ^= domainHash(key.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    /** a part of the cache guarded by its own lock */
+    struct Shard {
+        Lock access;
+        /** compiled patterns; null for malformed patterns */
+        std::unordered_map<RamDomain, Regex> regexes;
+        std::unordered_map<SymbolPair, MatchOutcome, PairHash> matches;
+        std::unordered_map<SymbolPair, bool, PairHash> contains;
+    };
+
+    static constexpr size_t NUM_SHARDS = 16;
+
+    Shard& getShard(std::size_t hash) {
+        return shards[hash % NUM_SHARDS];
+    }
+
+    /** insert into a table, flushing the table first if it is full */
+    template <typename Map, typename Key, typename Value>
+    void insertBounded(Map& map, const Key& key, const Value& value) {
+        if (map.size() >= shardCapacity) {
+            map.clear();
+        }
+        map.emplace(key, value);
+    }
+
+    /** compile a pattern; null if it is malformed */
+    Regex compile(RamDomain pattern) const {
+        try {
+            return std::make_shared<const std::regex>(symTable.resolve(pattern));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    /** return the compiled pattern, compiling it if it is not cached */
+    Regex getRegex(RamDomain pattern) {
+        auto pin = pinned.find(pattern);
+        if (pin != pinned.end()) {
+            return pin->second;
+        }
+        Shard& shard = getShard(std::hash<RamDomain>()(pattern));
+        {
+            auto lease = shard.access.acquire();
+            auto pos = shard.regexes.find(pattern);
+            if (pos != shard.regexes.end()) {
+                return pos->second;
+            }
+        }
+        // compile outside of the lock; a concurrent compilation of the same pattern is harmless
+        Regex regex = compile(pattern);
+        auto lease = shard.access.acquire();
+        insertBounded(shard.regexes, pattern, regex);
+        return regex;
+    }
+
+    MatchOutcome getMatchOutcome(RamDomain pattern, RamDomain text) {
+        auto key = std::make_pair(pattern, text);
+        Shard& shard = getShard(PairHash()(key));
+        {
+            auto lease = shard.access.acquire();
+            auto pos = shard.matches.find(key);
+            if (pos != shard.matches.end()) {
+                return pos->second;
+            }
+        }
+        MatchOutcome outcome = MatchOutcome::MALFORMED;
+        if (Regex regex = getRegex(pattern)) {
+            outcome = std::regex_match(symTable.resolve(text), *regex) ? MatchOutcome::MATCH
+                                                                        : MatchOutcome::NO_MATCH;
+        }
+        auto lease = shard.access.acquire();
+        insertBounded(shard.matches, key, outcome);
+        return outcome;
+    }
+
+    const SymbolTable& symTable;
+
+    /** maximal number of entries of each table in a shard */
+    const size_t shardCapacity;
+
+    /** patterns compiled before evaluation; read-only during evaluation */
+    std::unordered_map<RamDomain, Regex> pinned;
+
+    std::array<Shard, NUM_SHARDS> shards;
+};
+
+}  // namespace souffle
@@ -17,21 +17,29 @@
 
 #pragma once
 
+#include "souffle/datastructure/SlabArena.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/ParallelUtil.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <new>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <typeinfo>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
 namespace souffle {
 
 namespace detail {
@@ -202,6 +210,167 @@ struct binary_search : public search_strategy {
     }
 };
 
+/**
+ * A search strategy for keys consisting of a small number of signed integer
+ * components, compared lexicographically by the given columns.
+ *
+ * Instead of comparing keys one by one through the comparator, the range of
+ * keys equal to the searched key is narrowed column by column: the keys agreeing
+ * on the previous columns form a sub-range sorted by the next column, in which
+ * the keys less than and not greater than the searched value are counted with
+ * vector instructions (AVX2 or SSE4.2, depending on the target) and a scalar
+ * loop for the remainder. The comparator passed to the search operations is
+ * ignored and must realise the same order as the given columns.
+ *
+ * Keys not eligible for this strategy -- all but tuples of up to four 32 or
+ * 64 bit signed integers -- are searched through a binary search.
+ *
+ * @tparam Columns .. the columns compared by the order of the b-tree, by priority
+ */
+template <unsigned... Columns>
+struct simd_search : public search_strategy {
+    static_assert(sizeof...(Columns) > 0, "at least one column needs to be compared");
+
+    /**
+     * Required user-defined default constructor.
+     */
+    simd_search() = default;
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * is not less than the given key. Equal to the lower bound.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter operator()(const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lower_bound(k, a, b, comp);
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * is not less than the given key.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter lower_bound(const Key& k, Iter a, Iter b, Comp& comp) const {
+        if constexpr (is_eligible<Key>::value) {
+            narrow(k, a, b);
+            return a;
+        } else {
+            return binary_search().lower_bound(k, a, b, comp);
+        }
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * such that the given key is less than the referenced element.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter upper_bound(const Key& k, Iter a, Iter b, Comp& comp) const {
+        if constexpr (is_eligible<Key>::value) {
+            narrow(k, a, b);
+            return b;
+        } else {
+            return binary_search().upper_bound(k, a, b, comp);
+        }
+    }
+
+private:
+    static constexpr unsigned columns[] = {Columns...};
+
+    // determines whether a key type is a tuple of up to four 32 or 64 bit signed integers
+    template <typename Key, typename = void>
+    struct is_eligible : public std::false_type {};
+
+    template <typename Key>
+    struct is_eligible<Key, std::void_t<typename Key::value_type, decltype(Key::arity)>> {
+        using value_type = typename Key::value_type;
+        static constexpr bool value =
+                std::is_integral<value_type>::value && std::is_signed<value_type>::value &&
+                (sizeof(value_type) == 4 || sizeof(value_type) == 8) && Key::arity <= 4 &&
+                sizeof(Key) == Key::arity * sizeof(value_type);
+    };
+
+    /**
+     * Narrows the given range down to the keys equal to the given key.
+     */
+    template <typename Key, typename Iter>
+    static void narrow(const Key& k, Iter& a, Iter& b) {
+        for (unsigned column : columns) {
+            if (a == b) {
+                return;
+            }
+            std::size_t less;
+            std::size_t notGreater;
+            count(&(*a)[column], b - a, Key::arity, k[column], less, notGreater);
+            b = a + notGreater;
+            a = a + less;
+        }
+    }
+
+    /**
+     * Counts the values less than and not greater than the given value among the
+     * given number of values, each the given stride apart.
+     */
+    template <typename T>
+    static void count(const T* values, std::size_t n, std::size_t stride, T value, std::size_t& less,
+            std::size_t& notGreater) {
+        std::size_t i = 0;
+        std::size_t greater = 0;
+        less = 0;
+#if defined(__AVX2__)
+        if constexpr (sizeof(T) == 4) {
+            const __m256i val = _mm256_set1_epi32(value);
+            const __m256i index =
+                    _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+            for (; i + 8 <= n; i += 8) {
+                const auto* pos = reinterpret_cast<const int*>(values + i * stride);
+                const __m256i cur = (stride == 1) ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))
+                                                  : _mm256_i32gather_epi32(pos, index, 4);
+                less += __builtin_popcountll(
+                        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(val, cur))));
+                greater += __builtin_popcountll(
+                        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cur, val))));
+            }
+        } else {
+            const __m256i val = _mm256_set1_epi64x(value);
+            const __m128i index = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(stride));
+            for (; i + 4 <= n; i += 4) {
+                const auto* pos = reinterpret_cast<const long long*>(values + i * stride);
+                const __m256i cur = (stride == 1) ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))
+                                                  : _mm256_i32gather_epi64(pos, index, 8);
+                less += __builtin_popcountll(
+                        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(val, cur))));
+                greater += __builtin_popcountll(
+                        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(cur, val))));
+            }
+        }
+#elif defined(__SSE4_2__)
+        if constexpr (sizeof(T) == 4) {
+            const __m128i val = _mm_set1_epi32(value);
+            for (; i + 4 <= n; i += 4) {
+                const T* pos = values + i * stride;
+                const __m128i cur = _mm_setr_epi32(pos[0], pos[stride], pos[2 * stride], pos[3 * stride]);
+                less += __builtin_popcountll(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(val, cur))));
+                greater += __builtin_popcountll(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(cur, val))));
+            }
+        } else {
+            const __m128i val = _mm_set1_epi64x(value);
+            for (; i + 2 <= n; i += 2) {
+                const T* pos = values + i * stride;
+                const __m128i cur = _mm_set_epi64x(pos[stride], pos[0]);
+                less += __builtin_popcountll(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(val, cur))));
+                greater += __builtin_popcountll(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(cur, val))));
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            const T cur = values[i * stride];
+            less += (cur < value);
+            greater += (value < cur);
+        }
+        notGreater = n - greater;
+    }
+};
+
 // ---------- search strategies selection --------------
 
 /**
@@ -216,6 +385,9 @@ struct strategy_selection {
 struct linear : public strategy_selection<linear_search> {};
 struct binary : public strategy_selection<binary_search> {};
 
+template <unsigned... Columns>
+struct simd : public strategy_selection<simd_search<Columns...>> {};
+
 // by default every key utilizes binary search
 template <typename Key>
 struct default_strategy : public binary {};
@@ -243,11 +415,11 @@ struct updater {
  * @tparam blockSize    .. determines the number of bytes/block utilized by leaf nodes
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
  * @tparam isSet        .. true = set, false = multiset
+ * @tparam isCounted    .. true = inner nodes cache the number of entries in their sub-tree, supporting rank()
  */
-template <typename Key, typename Comparator,
-        typename Allocator,  // is ignored so far - TODO: add support
-        unsigned blockSize, typename SearchStrategy, bool isSet, typename WeakComparator = Comparator,
-        typename Updater = detail::updater<Key>>
+template <typename Key, typename Comparator, typename Allocator, unsigned blockSize, typename SearchStrategy,
+        bool isSet, typename WeakComparator = Comparator, typename Updater = detail::updater<Key>,
+        bool isCounted = false>
 class btree {
 public:
     class iterator;
@@ -297,6 +469,26 @@ protected:
     using field_index_type = uint8_t;
     using lock_type = OptimisticReadWriteLock;
 
+    /**
+     * The arenas the nodes of a tree are allocated from. Leaves are kept apart from
+     * inner nodes, such that they may be spilled while the inner nodes, visited by
+     * every search, remain in memory.
+     */
+    struct node_arena {
+        SlabArena<Allocator> inner;
+        SlabArena<Allocator> leaves;
+
+        void clear() {
+            inner.clear();
+            leaves.clear();
+        }
+
+        void swap(node_arena& other) {
+            inner.swap(other.inner);
+            leaves.swap(other.leaves);
+        }
+    };
+
     struct node;
 
     /**
@@ -384,10 +576,10 @@ protected:
         /**
          * A deep-copy operation creating a clone of this node.
          */
-        node* clone() const {
+        node* clone(node_arena& arena) const {
             // create a clone of this node
-            node* res = (this->isInner()) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* res = (this->isInner()) ? static_cast<node*>(createNode<inner_node>(arena))
+                                          : static_cast<node*>(createNode<leaf_node>(arena));
 
             // copy basic fields
             res->position = this->position;
@@ -405,7 +597,7 @@ protected:
             // copy child nodes recursively
             auto* ires = (inner_node*)res;
             for (size_type i = 0; i <= this->numElements; ++i) {
-                ires->children[i] = this->getChild(i)->clone();
+                ires->children[i] = this->getChild(i)->clone(arena);
                 ires->children[i]->parent = res;
             }
 
@@ -459,19 +651,46 @@ protected:
 
         /**
          * Counts the number of entries contained in the sub-tree rooted
-         * by this node.
+         * by this node. In counted trees, the counts of inner nodes are
+         * cached until the next modification of their sub-tree, such that
+         * repeated counts only visit modified paths.
          */
         size_type countEntries() const {
             if (this->isLeaf()) {
                 return this->numElements;
             }
+            if constexpr (isCounted) {
+                size_type cached = asInnerNode().numEntries.load(std::memory_order_relaxed);
+                if (cached != inner_node::unknownEntries) {
+                    return cached;
+                }
+            }
             size_type sum = this->numElements;
             for (unsigned i = 0; i <= this->numElements; ++i) {
                 sum += getChild(i)->countEntries();
             }
+            if constexpr (isCounted) {
+                asInnerNode().numEntries.store(sum, std::memory_order_relaxed);
+            }
             return sum;
         }
 
+        /**
+         * Invalidates the cached entry count of this node. To be called on
+         * every inner node an insertion descends through, and on the nodes
+         * locked by a split or rebalancing whose entries change.
+         */
+        void resetEntryCount() {
+            if constexpr (isCounted) {
+                if (this->isInner()) {
+                    auto& count = asInnerNode().numEntries;
+                    if (count.load(std::memory_order_relaxed) != inner_node::unknownEntries) {
+                        count.store(inner_node::unknownEntries, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
         /**
          * Determines the amount of memory used by the sub-tree rooted
          * by this node.
@@ -540,17 +759,19 @@ protected:
          *
          * @param root .. a pointer to the root-pointer of the enclosing b-tree
          *                 (might have to be updated if the root-node needs to be split)
+         * @param arena .. the arena of the enclosing b-tree, providing new nodes
          * @param idx  .. the position of the insert causing the split
          */
 #ifdef IS_PARALLEL
-        void split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        void split(node** root, lock_type& root_lock, node_arena& arena, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void split(node** root, lock_type& root_lock, int idx) {
+        void split(node** root, lock_type& root_lock, node_arena& arena, int idx) {
 #endif
             assert(this->numElements == maxKeys);
 
@@ -558,8 +779,8 @@ protected:
             int split_point = getSplitPoint(idx);
 
             // create a new sibling node
-            node* sibling = (this->inner) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* sibling = (this->inner) ? static_cast<node*>(createNode<inner_node>(arena))
+                                          : static_cast<node*>(createNode<leaf_node>(arena));
 
 #ifdef IS_PARALLEL
             // lock sibling
@@ -589,10 +810,13 @@ protected:
 
             // update parent
 #ifdef IS_PARALLEL
-            grow_parent(root, root_lock, sibling, locked_nodes);
+            grow_parent(root, root_lock, arena, sibling, locked_nodes);
 #else
-            grow_parent(root, root_lock, sibling);
+            grow_parent(root, root_lock, arena, sibling);
 #endif
+
+            // this node moved entries to the new sibling, whose count is unknown
+            this->resetEntryCount();
         }
 
         /**
@@ -604,18 +828,20 @@ protected:
          * of a split. The number of moved elements will be <= the given idx.
          *
          * @param root .. the root node of the b-tree being part of
+         * @param arena .. the arena of the b-tree, providing new nodes
          * @param idx  .. the position of the insert triggering this operation
          */
         // TODO: remove root_lock ... no longer needed
 #ifdef IS_PARALLEL
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        int rebalance_or_split(node** root, lock_type& root_lock, node_arena& arena, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx) {
+        int rebalance_or_split(node** root, lock_type& root_lock, node_arena& arena, int idx) {
 #endif
 
             // this node is full ... and needs some space
@@ -633,7 +859,7 @@ protected:
                 // lock access to left sibling
                 if (!left->lock.try_start_write()) {
                     // left node is currently updated => skip balancing and split
-                    split(root, root_lock, idx, locked_nodes);
+                    split(root, root_lock, arena, idx, locked_nodes);
                     return 0;
                 }
 #endif
@@ -689,6 +915,10 @@ protected:
                     left->numElements += num;
                     this->numElements -= num;
 
+                    // invalidate the cached entry counts of both locked nodes
+                    left->resetEntryCount();
+                    this->resetEntryCount();
+
 #ifdef IS_PARALLEL
                     left->lock.end_write();
 #endif
@@ -704,9 +934,9 @@ protected:
 
             // Option B) split node
 #ifdef IS_PARALLEL
-            split(root, root_lock, idx, locked_nodes);
+            split(root, root_lock, arena, idx, locked_nodes);
 #else
-            split(root, root_lock, idx);
+            split(root, root_lock, arena, idx);
 #endif
             return 0;  // = no re-balancing
         }
@@ -718,24 +948,26 @@ protected:
          * use only)
          *
          * @param root .. a pointer to the root-pointer of the containing tree
+         * @param arena .. the arena of the containing tree, providing new nodes
          * @param sibling .. the new right-sibling to be add to the parent node
          */
 #ifdef IS_PARALLEL
-        void grow_parent(node** root, lock_type& root_lock, node* sibling, std::vector<node*>& locked_nodes) {
+        void grow_parent(node** root, lock_type& root_lock, node_arena& arena, node* sibling,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void grow_parent(node** root, lock_type& root_lock, node* sibling) {
+        void grow_parent(node** root, lock_type& root_lock, node_arena& arena, node* sibling) {
 #endif
 
             if (this->parent == nullptr) {
                 assert(*root == this);
 
                 // create a new root node
-                auto* new_root = new inner_node();
+                auto* new_root = createNode<inner_node>(arena);
                 new_root->numElements = 1;
                 new_root->keys[0] = keys[this->numElements];
 
@@ -757,9 +989,9 @@ protected:
 
 #ifdef IS_PARALLEL
                 parent->insert_inner(
-                        root, root_lock, pos, this, keys[this->numElements], sibling, locked_nodes);
+                        root, root_lock, arena, pos, this, keys[this->numElements], sibling, locked_nodes);
 #else
-                parent->insert_inner(root, root_lock, pos, this, keys[this->numElements], sibling);
+                parent->insert_inner(root, root_lock, arena, pos, this, keys[this->numElements], sibling);
 #endif
             }
         }
@@ -768,18 +1000,19 @@ protected:
          * Inserts a new element into an inner node (for internal use only).
          *
          * @param root .. a pointer to the root-pointer of the containing tree
+         * @param arena .. the arena of the containing tree, providing new nodes
          * @param pos  .. the position to insert the new key
          * @param key  .. the key to insert
          * @param newNode .. the new right-child of the inserted key
          */
 #ifdef IS_PARALLEL
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode, std::vector<node*>& locked_nodes) {
+        void insert_inner(node** root, lock_type& root_lock, node_arena& arena, unsigned pos,
+                node* predecessor, const Key& key, node* newNode, std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(souffle::contains(locked_nodes, this));
 #else
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode) {
+        void insert_inner(node** root, lock_type& root_lock, node_arena& arena, unsigned pos,
+                node* predecessor, const Key& key, node* newNode) {
 #endif
 
             // check capacity
@@ -792,9 +1025,9 @@ protected:
 
                 // split this node
 #ifdef IS_PARALLEL
-                pos -= rebalance_or_split(root, root_lock, pos, locked_nodes);
+                pos -= rebalance_or_split(root, root_lock, arena, pos, locked_nodes);
 #else
-                pos -= rebalance_or_split(root, root_lock, pos);
+                pos -= rebalance_or_split(root, root_lock, arena, pos);
 #endif
 
                 // complete insertion within new sibling if necessary
@@ -819,9 +1052,9 @@ protected:
                     }
 
                     pos = (i > other->numElements) ? 0 : i;
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode, locked_nodes);
+                    other->insert_inner(root, root_lock, arena, pos, predecessor, key, newNode, locked_nodes);
 #else
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode);
+                    other->insert_inner(root, root_lock, arena, pos, predecessor, key, newNode);
 #endif
                     return;
                 }
@@ -1057,25 +1290,27 @@ protected:
      * the generic implementation of a node by the storage locations
      * of child pointers.
      */
-    struct inner_node : public node {
+    /**
+     * The cached number of entries in the sub-tree rooted by an inner node of a
+     * counted tree.
+     */
+    struct entry_count {
+        // the marker of an unknown number of entries
+        static constexpr size_type unknownEntries = std::numeric_limits<size_type>::max();
+
+        // the cached number of entries, or the marker
+        mutable std::atomic<size_type> numEntries{unknownEntries};
+    };
+
+    // inner nodes of trees that are not counted carry no count
+    struct no_entry_count {};
+
+    struct inner_node : public node, public std::conditional_t<isCounted, entry_count, no_entry_count> {
         // references to child nodes owned by this node
         node* children[node::maxKeys + 1];
 
         // a simple default constructor initializing member fields
         inner_node() : node(true) {}
-
-        // clear up child nodes recursively
-        ~inner_node() {
-            for (unsigned i = 0; i <= this->numElements; ++i) {
-                if (children[i] != nullptr) {
-                    if (children[i]->isLeaf()) {
-                        delete static_cast<leaf_node*>(children[i]);
-                    } else {
-                        delete static_cast<inner_node*>(children[i]);
-                    }
-                }
-            }
-        }
     };
 
     /**
@@ -1100,6 +1335,8 @@ public:
         // the index of the element currently addressed within the referenced node
         field_index_type pos = 0;
 
+        friend class btree;
+
     public:
         // default constructor -- creating an end-iterator
         iterator() : cur(nullptr) {}
@@ -1224,6 +1461,32 @@ protected:
     // a pointer to the left-most node of this tree (initial note for iteration)
     leaf_node* leftmost;
 
+    // the arenas all nodes of this tree are allocated from
+    node_arena arena;
+
+    /**
+     * Creates a new node of the given type in the given arena.
+     */
+    template <typename T>
+    static T* createNode(node_arena& arena) {
+        auto& slabs = std::is_same<T, leaf_node>::value ? arena.leaves : arena.inner;
+        return new (slabs.allocate(sizeof(T), alignof(T))) T();
+    }
+
+    /**
+     * Destructs the given node and its sub-tree, without releasing their memory.
+     */
+    static void destroyTree(node* cur) {
+        if (cur->isLeaf()) {
+            static_cast<leaf_node*>(cur)->~leaf_node();
+            return;
+        }
+        for (size_type i = 0; i <= cur->numElements; ++i) {
+            destroyTree(cur->getChild(i));
+        }
+        static_cast<inner_node*>(cur)->~inner_node();
+    }
+
     /* -------------- operator hint statistics ----------------- */
 
     // an aggregation of statistical values of the hint utilization
@@ -1257,7 +1520,7 @@ public:
     // a constructor creating a tree from the given iterator range
     template <typename Iter>
     btree(const Iter& a, const Iter& b) : root(nullptr), leftmost(nullptr) {
-        insert(a, b);
+        insertSortedBulk(a, b);
     }
 
     // a move constructor
@@ -1265,6 +1528,7 @@ public:
             : comp(other.comp), weak_comp(other.weak_comp), root(other.root), leftmost(other.leftmost) {
         other.root = nullptr;
         other.leftmost = nullptr;
+        arena.swap(other.arena);
     }
 
     // a copy constructor
@@ -1273,14 +1537,6 @@ public:
         *this = set;
     }
 
-protected:
-    /**
-     * An internal constructor enabling the specific creation of a tree
-     * based on internal parameters.
-     */
-    btree(size_type /* size */, node* root, leaf_node* leftmost) : root(root), leftmost(leftmost) {}
-
-public:
     // the destructor freeing all contained nodes
     ~btree() {
         clear();
@@ -1298,6 +1554,40 @@ public:
         return (root) ? root->countEntries() : 0;
     }
 
+    /**
+     * Determines the number of elements preceding the element referenced by the
+     * given iterator, the number of elements in this tree for the end iterator.
+     * The difference of the ranks of two iterators is the length of the range
+     * they delimit, obtained in logarithmic time while the entry counts cached
+     * within the inner nodes are up to date. Only counted trees support ranks,
+     * which may not be determined concurrently with modifications of this tree.
+     */
+    size_type rank(const iterator& it) const {
+        static_assert(isCounted, "ranks require a counted tree");
+        if (it.cur == nullptr) {
+            return size();
+        }
+
+        // the elements before the referenced one within its own node
+        const node* cur = it.cur;
+        size_type res = it.pos;
+        if (cur->isInner()) {
+            for (size_type i = 0; i <= it.pos; ++i) {
+                res += cur->getChild(i)->countEntries();
+            }
+        }
+
+        // the elements left of the path from the root to the node
+        for (; cur->parent != nullptr; cur = cur->parent) {
+            const node* parent = cur->parent;
+            res += cur->position;
+            for (size_type i = 0; i < cur->position; ++i) {
+                res += parent->getChild(i)->countEntries();
+            }
+        }
+        return res;
+    }
+
     /**
      * Inserts the given key into this tree.
      */
@@ -1328,7 +1618,7 @@ public:
             }
 
             // create new node
-            leftmost = new leaf_node();
+            leftmost = createNode<leaf_node>(arena);
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1365,7 +1655,8 @@ public:
             return true;
         };
 
-        if (hints.last_insert.any(checkHint)) {
+        // insertions into counted trees descend from the root, invalidating the counts on their path
+        if (!isCounted && hints.last_insert.any(checkHint)) {
             // register this as a hit
             hint_stats.inserts.addHit();
         } else {
@@ -1437,6 +1728,9 @@ public:
                     return insert(k, hints);
                 }
 
+                // the number of entries below this node may change
+                cur->resetEntryCount();
+
                 // go to next
                 cur = next;
 
@@ -1526,7 +1820,7 @@ public:
 
                 // split this node
                 auto old_root = root;
-                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, arena, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -1578,7 +1872,7 @@ public:
         // special handling for inserting first element
         if (empty()) {
             // create new node
-            leftmost = new leaf_node();
+            leftmost = createNode<leaf_node>(arena);
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1598,8 +1892,8 @@ public:
             return true;
         };
 
-        // test last insert
-        if (hints.last_insert.any(checkHints)) {
+        // test last insert, unless the counts on the path from the root have to be invalidated
+        if (!isCounted && hints.last_insert.any(checkHints)) {
             hint_stats.inserts.addHit();
         } else {
             hint_stats.inserts.addMiss();
@@ -1625,6 +1919,9 @@ public:
                     return false;
                 }
 
+                // the number of entries below this node may change
+                cur->resetEntryCount();
+
                 cur = cur->getChild(idx);
                 continue;
             }
@@ -1653,7 +1950,7 @@ public:
 
             if (cur->numElements >= node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(&root, root_lock, idx);
+                idx -= cur->rebalance_or_split(&root, root_lock, arena, idx);
 
                 // insert element in right fragment
                 if (((size_type)idx) > cur->numElements) {
@@ -1683,19 +1980,49 @@ public:
     }
 
     /**
-     * Inserts the given range of elements into this tree.
+     * Inserts the given range of elements into this tree, one by one.
      */
     template <typename Iter>
     void insert(const Iter& a, const Iter& b) {
-        // TODO: improve this beyond a naive insert
         operation_hints hints;
-        // a naive insert so far .. seems to work fine
         for (auto it = a; it != b; ++it) {
             // use insert with hint
             insert(*it, hints);
         }
     }
 
+    /**
+     * Inserts the given range of elements into this tree. Sorted runs of elements
+     * beyond the maximum of this tree are appended to its rightmost nodes, such that
+     * loading sorted data takes linear time; all other elements are inserted one by one.
+     *
+     * Unlike insert(a, b), this operation must not be run concurrently with other
+     * operations on this tree.
+     */
+    template <typename Iter>
+    void insertSortedBulk(const Iter& a, const Iter& b) {
+        operation_hints hints;
+        insertRange(a, b, [&](const Key& k) { insert(k, hints); }, [](Key&) {});
+    }
+
+    /**
+     * Inserts all elements of the given tree into this tree. An empty tree
+     * becomes a deep copy of the given tree; otherwise the elements are appended
+     * or inserted in order, such that each insertion starts from the hinted leaf.
+     *
+     * This operation must not be run concurrently with other operations on this tree.
+     */
+    void insertAll(const btree& other) {
+        if (this == &other) {
+            return;
+        }
+        if (empty()) {
+            *this = other;
+            return;
+        }
+        insertSortedBulk(other.begin(), other.end());
+    }
+
     // Obtains an iterator referencing the first element of the tree.
     iterator begin() const {
         return iterator(leftmost, 0);
@@ -1919,18 +2246,55 @@ public:
     }
 
     /**
-     * Clears this tree.
+     * Obtains an iterator referencing the element preceding the element referenced
+     * by the given iterator, end() if there is none. The predecessor of the end
+     * iterator is the last element of this tree, such that the last element of a
+     * range is obtained as the predecessor of the end of the range.
+     */
+    iterator predecessor(const iterator& it) const {
+        const node* cur = it.cur;
+
+        // the predecessor of the end is the maximum
+        if (cur == nullptr) {
+            return (empty()) ? end() : getLast(root);
+        }
+
+        // the predecessor of a key in an inner node is the maximum of its left sub-tree
+        if (cur->isInner()) {
+            return getLast(cur->getChild(it.pos));
+        }
+
+        // otherwise it is the previous key in the leaf, or the separator left of the closest ancestor
+        if (it.pos > 0) {
+            return iterator(cur, it.pos - 1);
+        }
+        while (cur->parent != nullptr && cur->position == 0) {
+            cur = cur->parent;
+        }
+        return (cur->parent == nullptr) ? end() : iterator(cur->parent, cur->position - 1);
+    }
+
+    /**
+     * Clears this tree. The nodes are released together with the slabs of the arena
+     * they have been allocated from; they are only visited if their keys need to be
+     * destructed.
      */
     void clear() {
-        if (root != nullptr) {
-            if (root->isLeaf()) {
-                delete static_cast<leaf_node*>(root);
-            } else {
-                delete static_cast<inner_node*>(root);
-            }
+        if (root != nullptr && !std::is_trivially_destructible<Key>::value) {
+            destroyTree(root);
         }
         root = nullptr;
         leftmost = nullptr;
+        arena.clear();
+    }
+
+    /**
+     * Spills the leaves of this tree, see SlabArena::spill(). The tree remains
+     * usable; its leaves are paged in from the spill file as they are accessed.
+     * The tree may not be modified concurrently.
+     */
+    void spill() {
+        arena.leaves.spill();
     }
 
     /**
@@ -1942,6 +2306,7 @@ public:
         // swap the content
         std::swap(root, other.root);
         std::swap(leftmost, other.leftmost);
+        arena.swap(other.arena);
     }
 
     // Implementation of the assignment operation for trees.
@@ -1952,13 +2317,15 @@ public:
         }
 
         // create a deep-copy of the content of the other tree
+        clear();
+
         // shortcut for empty sets
         if (other.empty()) {
             return *this;
         }
 
         // clone content (deep copy)
-        root = other.root->clone();
+        root = other.root->clone(arena);
 
         // update leftmost reference
         auto tmp = root;
@@ -2083,22 +2450,24 @@ public:
                                            std::random_access_iterator_tag>::value,
             R>::type
     load(const Iter& a, const Iter& b) {
+        R res;
+
         // quick exit - empty range
         if (a == b) {
-            return R();
+            return res;
         }
 
-        // resolve tree recursively
-        auto root = buildSubTree(a, b - 1);
+        // resolve tree recursively, in the arena of the result
+        res.root = buildSubTree(res.arena, a, b - 1);
 
         // find leftmost node
-        node* leftmost = root;
+        node* leftmost = res.root;
         while (!leftmost->isLeaf()) {
             leftmost = leftmost->getChild(0);
         }
+        res.leftmost = static_cast<leaf_node*>(leftmost);
 
-        // build result
-        return R(b - a, root, static_cast<leaf_node*>(leftmost));
+        return res;
     }
 
 protected:
@@ -2130,7 +2499,183 @@ protected:
                weak_less(k, node->keys[node->numElements - 1]);
     }
 
+    /**
+     * Inserts the given range of elements into this tree, appending sorted runs of
+     * elements beyond the maximum of this tree and inserting all other elements
+     * using the given operation.
+     *
+     * @param insertOne .. inserts a single element
+     * @param prepare   .. invoked on each appended element before it is stored
+     */
+    template <typename Iter, typename InsertOne, typename Prepare>
+    void insertRange(Iter it, const Iter& end, const InsertOne& insertOne, const Prepare& prepare) {
+        // the maximum of this tree, kept up to date while inserting
+        Key maximum;
+        bool hasMaximum = false;
+
+        // the maximum is the last key of the lowest non-empty node on the rightmost path
+        for (node* cur = root; cur != nullptr; cur = getRightmostChild(cur)) {
+            if (!cur->isEmpty()) {
+                maximum = cur->keys[cur->numElements - 1];
+                hasMaximum = true;
+            }
+        }
+
+        while (it != end) {
+            if (!hasMaximum || isBeyond(maximum, *it)) {
+                it = append(it, end, maximum, prepare);
+                hasMaximum = true;
+            } else {
+                insertOne(*it);
+                ++it;
+            }
+        }
+    }
+
 private:
+    /**
+     * Obtains an iterator referencing the maximum of the sub-tree rooted by the given node.
+     */
+    iterator getLast(const node* cur) const {
+        while (cur->isInner()) {
+            cur = cur->getChild(cur->numElements);
+        }
+        // the rightmost leaf may be empty, the maximum is then its separator
+        return (cur->numElements > 0) ? iterator(cur, cur->numElements - 1) : predecessor(iterator(cur, 0));
+    }
+
+    /**
+     * Obtains the rightmost child of the given node, null for leaf nodes.
+     */
+    static node* getRightmostChild(const node* cur) {
+        return cur->isLeaf() ? nullptr : cur->getChild(cur->numElements);
+    }
+
+    /**
+     * Determines whether the given key may be appended to a tree of the given maximum.
+     */
+    bool isBeyond(const Key& maximum, const Key& k) const {
+        return isSet ? weak_less(maximum, k) : !weak_less(k, maximum);
+    }
+
+    /**
+     * Appends the longest prefix of the given range that is sorted and beyond the
+     * maximum of this tree. The prefix fills the rightmost leaf; whenever a node is
+     * full the next key becomes a separator in its parent and a new rightmost node
+     * is started below it, so that nodes are filled completely and no node is ever
+     * split. Finally, the rightmost nodes are rebalanced with their left siblings.
+     *
+     * @return the position of the first element that has not been appended
+     */
+    template <typename Iter, typename Prepare>
+    Iter append(Iter it, const Iter& end, Key& maximum, const Prepare& prepare) {
+        // the rightmost nodes of this tree, indexed by their level above the leaves
+        std::vector<node*> spine;
+        if (empty()) {
+            leftmost = createNode<leaf_node>(arena);
+            root = leftmost;
+            spine.push_back(leftmost);
+        } else {
+            for (node* cur = root; cur != nullptr; cur = getRightmostChild(cur)) {
+                spine.insert(spine.begin(), cur);
+                // all existing nodes that gain entries are on this path
+                cur->resetEntryCount();
+            }
+        }
+
+        do {
+            Key k = *it;
+            prepare(k);
+
+            // find the lowest rightmost node with space left, adding a new root if there is none
+            size_type level = 0;
+            while (spine[level]->isFull()) {
+                if (++level == spine.size()) {
+                    auto* top = createNode<inner_node>(arena);
+                    top->children[0] = root;
+                    root->parent = top;
+                    root->position = 0;
+                    root = top;
+                    spine.push_back(top);
+                }
+            }
+
+            node* cur = spine[level];
+            cur->keys[cur->numElements] = k;
+            cur->numElements++;
+
+            // start new rightmost nodes below the new separator
+            while (level > 0) {
+                node* child = (level == 1) ? static_cast<node*>(createNode<leaf_node>(arena))
+                                             : createNode<inner_node>(arena);
+                child->parent = cur;
+                child->position = cur->numElements;
+                cur->getChildren()[cur->numElements] = child;
+                spine[--level] = child;
+                cur = child;
+            }
+
+            maximum = k;
+            ++it;
+        } while (it != end && isBeyond(maximum, *it));
+
+        // top-down, such that every rightmost node has keys left of its rightmost child
+        for (size_type level = spine.size() - 1; level-- > 0;) {
+            if (spine[level]->numElements < node::maxKeys / 2) {
+                rebalanceWithLeftSibling(spine[level]);
+            }
+        }
+
+        return it;
+    }
+
+    /**
+     * Moves keys from the left sibling of the given node, through their separator
+     * in the parent, into the given node, such that both hold about the same number
+     * of keys.
+     */
+    static void rebalanceWithLeftSibling(node* cur) {
+        node* parent = cur->parent;
+        size_type pos = cur->position;
+        assert(pos > 0 && "no left sibling");
+        node* left = parent->getChild(pos - 1);
+
+        size_type target = (left->numElements + cur->numElements) / 2;
+        if (target <= cur->numElements) {
+            return;
+        }
+        size_type num = target - cur->numElements;
+        size_type first = left->numElements - num;
+
+        // make room for the moved keys, the separator becomes the last of them
+        for (size_type j = cur->numElements; j-- > 0;) {
+            cur->keys[j + num] = cur->keys[j];
+        }
+        for (size_type j = 0; j + 1 < num; ++j) {
+            cur->keys[j] = left->keys[first + 1 + j];
+        }
+        cur->keys[num - 1] = parent->keys[pos - 1];
+        parent->keys[pos - 1] = left->keys[first];
+
+        // move the children to the right of the new separator as well
+        if (cur->isInner()) {
+            node** children = cur->getChildren();
+            for (size_type j = cur->numElements + 1; j-- > 0;) {
+                children[j + num] = children[j];
+                children[j + num]->position = j + num;
+            }
+            for (size_type j = 0; j < num; ++j) {
+                children[j] = left->getChild(first + 1 + j);
+                children[j]->parent = cur;
+                children[j]->position = j;
+            }
+        }
+
+        left->numElements = first;
+        cur->numElements += num;
+        left->resetEntryCount();
+    }
+
     /**
      * Determines whether the range covered by this node covers
      * the upper bound of the given key.
@@ -2142,7 +2687,7 @@ private:
 
     // Utility function for the load operation above.
     template <typename Iter>
-    static node* buildSubTree(const Iter& a, const Iter& b) {
+    static node* buildSubTree(node_arena& arena, const Iter& a, const Iter& b) {
         const int N = node::maxKeys;
 
         // divide range in N+1 sub-ranges
@@ -2151,7 +2696,7 @@ private:
         // terminal case: length is less then maxKeys
         if (length <= N) {
             // create a leaf node
-            node* res = new leaf_node();
+            node* res = createNode<leaf_node>(arena);
             res->numElements = length;
 
             for (int i = 0; i < length; ++i) {
@@ -2171,7 +2716,7 @@ private:
         }
 
         // create inner node
-        node* res = new inner_node();
+        node* res = createNode<inner_node>(arena);
         res->numElements = numKeys;
 
         Iter c = a;
@@ -2180,7 +2725,7 @@ private:
             res->keys[i] = c[step];
 
             // get sub-tree
-            auto child = buildSubTree(c, c + (step - 1));
+            auto child = buildSubTree(arena, c, c + (step - 1));
             child->parent = res;
             child->position = i;
             res->getChildren()[i] = child;
@@ -2189,7 +2734,7 @@ private:
         }
 
         // and the remaining part
-        auto child = buildSubTree(c, b);
+        auto child = buildSubTree(arena, c, b);
         child->parent = res;
         child->position = numKeys;
         res->getChildren()[numKeys] = child;
@@ -2201,9 +2746,9 @@ private:
 
 // Instantiation of static member search.
 template <typename Key, typename Comparator, typename Allocator, unsigned blockSize, typename SearchStrategy,
-        bool isSet, typename WeakComparator, typename Updater>
-const SearchStrategy
-        btree<Key, Comparator, Allocator, blockSize, SearchStrategy, isSet, WeakComparator, Updater>::search;
+        bool isSet, typename WeakComparator, typename Updater, bool isCounted>
+const SearchStrategy btree<Key, Comparator, Allocator, blockSize, SearchStrategy, isSet, WeakComparator,
+        Updater, isCounted>::search;
 
 }  // end namespace detail
 
@@ -2215,19 +2760,21 @@ const SearchStrategy
  * @tparam Allocator     .. utilized for allocating memory for required nodes
  * @tparam blockSize    .. determines the number of bytes/block utilized by leaf nodes
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
+ * @tparam isCounted    .. true = inner nodes cache the sizes of their sub-trees, supporting rank()
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
-        typename Allocator = std::allocator<Key>,  // is ignored so far
+        typename Allocator = std::allocator<Key>,
         unsigned blockSize = 256,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
-        typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
+        typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>,
+        bool isCounted = false>
 class btree_set : public souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, true,
-                          WeakComparator, Updater> {
+                          WeakComparator, Updater, isCounted> {
     using super = souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, true,
-            WeakComparator, Updater>;
+            WeakComparator, Updater, isCounted>;
 
     friend class souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, true,
-            WeakComparator, Updater>;
+            WeakComparator, Updater, isCounted>;
 
 public:
     /**
@@ -2241,7 +2788,7 @@ public:
      */
     template <typename Iter>
     btree_set(const Iter& a, const Iter& b) {
-        this->insert(a, b);
+        this->insertSortedBulk(a, b);
     }
 
     // A copy constructor.
@@ -2250,12 +2797,6 @@ public:
     // A move constructor.
     btree_set(btree_set&& other) : super(std::move(other)) {}
 
-private:
-    // A constructor required by the bulk-load facility.
-    template <typename s, typename n, typename l>
-    btree_set(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
-
-public:
     // Support for the assignment operator.
     btree_set& operator=(const btree_set& other) {
         super::operator=(other);
@@ -2277,19 +2818,21 @@ public:
  * @tparam Allocator     .. utilized for allocating memory for required nodes
  * @tparam blockSize    .. determines the number of bytes/block utilized by leaf nodes
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
+ * @tparam isCounted    .. true = inner nodes cache the sizes of their sub-trees, supporting rank()
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
-        typename Allocator = std::allocator<Key>,  // is ignored so far
+        typename Allocator = std::allocator<Key>,
         unsigned blockSize = 256,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
-        typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
+        typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>,
+        bool isCounted = false>
 class btree_multiset : public souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy,
-                               false, WeakComparator, Updater> {
+                               false, WeakComparator, Updater, isCounted> {
     using super = souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, false,
-            WeakComparator, Updater>;
+            WeakComparator, Updater, isCounted>;
 
     friend class souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, false,
-            WeakComparator, Updater>;
+            WeakComparator, Updater, isCounted>;
 
 public:
     /**
@@ -2303,7 +2846,7 @@ public:
      */
     template <typename Iter>
     btree_multiset(const Iter& a, const Iter& b) {
-        this->insert(a, b);
+        this->insertSortedBulk(a, b);
     }
 
     // A copy constructor.
@@ -2312,12 +2855,6 @@ public:
     // A move constructor.
     btree_multiset(btree_multiset&& other) : super(std::move(other)) {}
 
-private:
-    // A constructor required by the bulk-load facility.
-    template <typename s, typename n, typename l>
-    btree_multiset(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
-
-public:
     // Support for the assignment operator.
     btree_multiset& operator=(const btree_multiset& other) {
         super::operator=(other);
@@ -0,0 +1,206 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BloomFilter.h
+ *
+ * A concurrently updatable Bloom filter over tuples, growing with its content.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace souffle {
+
+/**
+ * A Bloom filter answering whether a tuple may have been inserted into a
+ * relation: if it answers no, the tuple has not been inserted.
+ *
+ * The filter is blocked: all bits of a tuple are within a single cache line,
+ * one bit in each of its eight words, such that a query touches a single line.
+ * The filter is made up of layers, each one sized for four times as many
+ * tuples as the one before. Tuples are added to the last layer; once it holds
+ * the number of tuples it is sized for, a new layer is added. Queries consult
+ * all layers.
+ *
+ * Insertions and queries may be conducted concurrently; clearing the filter
+ * may not. Tuples are identified by their hash values, see hash().
+ */
+class BloomFilter {
+    // the number of bits of a layer per tuple it is sized for
+    static constexpr std::size_t BITS_PER_TUPLE = 16;
+
+    // the size of the first layer if no other capacity is requested
+    static constexpr std::size_t MIN_CAPACITY = 1 << 10;
+
+    // the maximal number of layers; the last one receives all further tuples
+    static constexpr std::size_t MAX_LAYERS = 16;
+
+    struct alignas(64) Block {
+        std::atomic<uint64_t> words[8];
+    };
+
+    struct Layer {
+        Layer(std::size_t capacity)
+                : capacity(capacity),
+                  numBlocks(std::max<std::size_t>(1, capacity * BITS_PER_TUPLE / (8 * sizeof(Block)))),
+                  blocks(std::make_unique<Block[]>(numBlocks)) {
+            clear();
+        }
+
+        void clear() {
+            for (std::size_t i = 0; i < numBlocks; ++i) {
+                for (auto& word : blocks[i].words) {
+                    word.store(0, std::memory_order_relaxed);
+                }
+            }
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        // obtains the block of a hash value
+        Block& getBlock(uint64_t hash) const {
+            return blocks[((hash >> 32) * numBlocks) >> 32];
+        }
+
+        const std::size_t capacity;
+        const std::size_t numBlocks;
+        const std::unique_ptr<Block[]> blocks;
+        std::atomic<std::size_t> count{0};
+    };
+
+    // the bit of a hash value within a word of its block
+    static uint64_t getMask(uint64_t hash, std::size_t word) {
+        static constexpr uint32_t salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+        return uint64_t(1) << ((static_cast<uint32_t>(hash) * salts[word]) >> 26);
+    }
+
+    std::array<std::unique_ptr<Layer>, MAX_LAYERS> layers;
+    std::atomic<std::size_t> numLayers{1};
+    std::mutex growLock;
+
+    // obtains the layer receiving tuples, adding one if the last one is full
+    Layer& getTarget() {
+        std::size_t cur = numLayers.load(std::memory_order_acquire);
+        Layer* last = layers[cur - 1].get();
+        if (last->count.load(std::memory_order_relaxed) < last->capacity || cur == MAX_LAYERS) {
+            return *last;
+        }
+        std::lock_guard<std::mutex> guard(growLock);
+        cur = numLayers.load(std::memory_order_relaxed);
+        last = layers[cur - 1].get();
+        if (last->count.load(std::memory_order_relaxed) >= last->capacity && cur < MAX_LAYERS) {
+            layers[cur] = std::make_unique<Layer>(4 * last->capacity);
+            numLayers.store(cur + 1, std::memory_order_release);
+            last = layers[cur].get();
+        }
+        return *last;
+    }
+
+public:
+    /**
+     * Creates a filter whose first layer is sized for the given number of tuples.
+     */
+    BloomFilter(std::size_t capacity = MIN_CAPACITY) {
+        layers[0] = std::make_unique<Layer>(std::max(capacity, MIN_CAPACITY));
+    }
+
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+
+    /**
+     * Computes the hash value identifying a tuple by its given leading values.
+     */
+    static uint64_t hash(const RamDomain* values, std::size_t n) {
+        uint64_t res = 0x9e3779b97f4a7c15ULL;
+        for (std::size_t i = 0; i < n; ++i) {
+            res = (res ^ static_cast<uint32_t>(values[i])) * 0xff51afd7ed558ccdULL;
+            res ^= res >> 29;
+        }
+        res ^= res >> 33;
+        res *= 0xc4ceb9fe1a85ec53ULL;
+        res ^= res >> 33;
+        return res;
+    }
+
+    /**
+     * Adds the tuple of the given hash value.
+     */
+    void insert(uint64_t hash) {
+        Layer& layer = getTarget();
+        Block& block = layer.getBlock(hash);
+        for (std::size_t i = 0; i < 8; ++i) {
+            uint64_t mask = getMask(hash, i);
+            // avoid writing to lines shared with other threads if the bit is set already
+            if ((block.words[i].load(std::memory_order_relaxed) & mask) == 0) {
+                block.words[i].fetch_or(mask, std::memory_order_relaxed);
+            }
+        }
+        layer.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Tests whether the tuple of the given hash value may have been added.
+     */
+    bool mayContain(uint64_t hash) const {
+        std::size_t cur = numLayers.load(std::memory_order_acquire);
+        for (std::size_t l = 0; l < cur; ++l) {
+            const Block& block = layers[l]->getBlock(hash);
+            bool found = true;
+            for (std::size_t i = 0; i < 8 && found; ++i) {
+                found = (block.words[i].load(std::memory_order_relaxed) & getMask(hash, i)) != 0;
+            }
+            if (found) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Obtains the number of additions since the filter was last cleared.
+     */
+    std::size_t size() const {
+        std::size_t res = 0;
+        std::size_t cur = numLayers.load(std::memory_order_acquire);
+        for (std::size_t l = 0; l < cur; ++l) {
+            res += layers[l]->count.load(std::memory_order_relaxed);
+        }
+        return res;
+    }
+
+    /**
+     * Removes all tuples. The filter is resized to a single layer sized for the
+     * number of tuples it held, anticipating that it is filled alike again.
+     */
+    void clear() {
+        std::size_t capacity = std::max(size(), MIN_CAPACITY);
+        std::size_t cur = numLayers.load(std::memory_order_relaxed);
+        for (std::size_t l = 1; l < cur; ++l) {
+            layers[l].reset();
+        }
+        if (layers[0]->capacity == capacity) {
+            layers[0]->clear();
+        } else {
+            layers[0] = std::make_unique<Layer>(capacity);
+        }
+        numLayers.store(1, std::memory_order_release);
+    }
+};
+
+}  // namespace souffle
@@ -19,19 +19,14 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
-#include "souffle/datastructure/LambdaBTree.h"
-#include "souffle/datastructure/PiggyList.h"
 #include "souffle/datastructure/UnionFind.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/ParallelUtil.h"
-#include <atomic>
 #include <cassert>
 #include <cstddef>
-#include <functional>
 #include <iostream>
 #include <iterator>
 #include <set>
-#include <shared_mutex>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
@@ -42,21 +37,10 @@ template <typename TupleType>
 class EquivalenceRelation {
     using value_type = typename TupleType::value_type;
 
-    // mapping from representative to disjoint set
-    // just a cache, essentially, used for iteration over
-    using StatesList = souffle::PiggyList<value_type>;
-    using StatesBucket = StatesList*;
-    using StorePair = std::pair<value_type, StatesBucket>;
-    using StatesMap = souffle::LambdaBTreeSet<StorePair, std::function<StatesBucket(StorePair&)>,
-            souffle::EqrelMapComparator<StorePair>>;
-
 public:
     using element_type = TupleType;
 
-    EquivalenceRelation() : statesMapStale(false){};
-    ~EquivalenceRelation() {
-        emptyPartition();
-    }
+    EquivalenceRelation() = default;
 
     /**
      * A collection of operation hints speeding up some of the involved operations
@@ -90,6 +74,16 @@ public:
         return insert(tuple[0], tuple[1], hints);
     };
 
+    /**
+     * Insert the tuple symbolically.
+     * @param tuple The tuple to be inserted
+     * @param z the hints to where the pair should be inserted (not applicable atm)
+     * @return true if the tuple is new to the data structure
+     */
+    bool insert(const TupleType& tuple, operation_hints z) {
+        return insert(tuple[0], tuple[1], z);
+    };
+
     /**
      * Insert the two values symbolically as a binary relation
      * @param x node to be added/paired
@@ -98,8 +92,6 @@ public:
      * @return true if the pair is new to the data structure
      */
     bool insert(value_type x, value_type y, operation_hints) {
-        // indicate that iterators will have to generate on request
-        this->statesMapStale.store(true, std::memory_order_relaxed);
         bool retval = contains(x, y);
         sds.unionNodes(x, y);
         return retval;
@@ -110,21 +102,13 @@ public:
      * @param other the binary relation from which to add elements from
      */
     void insertAll(const EquivalenceRelation<TupleType>& other) {
-        other.genAllDisjointSetLists();
-
-        // iterate over partitions at a time
-        for (typename StatesMap::chunk it : other.equivalencePartition.getChunks(MAX_THREADS)) {
-            for (auto& p : it) {
-                value_type rep = p.first;
-                StatesList& pl = *p.second;
-                const size_t ksize = pl.size();
-                for (size_t i = 0; i < ksize; ++i) {
-                    this->sds.unionNodes(rep, pl.get(i));
-                }
-            }
+        // join every element of the other relation with its representative, unions may run concurrently
+        const size_t numNodes = other.sds.size();
+#pragma omp parallel for
+        for (size_t i = 0; i < numNodes; ++i) {
+            parent_t rep = other.sds.ds.findNode(i);
+            this->sds.unionNodes(other.sds.toSparse(rep), other.sds.toSparse(i));
         }
-        // invalidate iterators unconditionally
-        this->statesMapStale.store(true, std::memory_order_relaxed);
     }
 
     /**
@@ -137,9 +121,6 @@ public:
         // nothing to extend if there's no new/original knowledge
         if (other.size() == 0 || this->size() == 0) return;
 
-        this->genAllDisjointSetLists();
-        other.genAllDisjointSetLists();
-
         std::set<value_type> repsCovered;
 
         // find all the disjoint sets that need to be added to this relation
@@ -192,46 +173,19 @@ public:
         return contains(tuple[0], tuple[1]);
     };
 
-    void emptyPartition() const {
-        // delete the beautiful values inside (they're raw ptrs, so they need to be.)
-        for (auto& pair : equivalencePartition) {
-            delete pair.second;
-        }
-        // invalidate it my dude
-        this->statesMapStale.store(true, std::memory_order_relaxed);
-
-        equivalencePartition.clear();
-    }
-
     /**
      * Empty the relation
      */
     void clear() {
-        statesLock.lock();
-
         sds.clear();
-        emptyPartition();
-
-        statesLock.unlock();
     }
 
     /**
-     * Size of relation
+     * Size of relation, maintained by the disjoint set as sets are joined
      * @return the sum of the number of pairs per disjoint set
      */
     size_t size() const {
-        genAllDisjointSetLists();
-
-        statesLock.lock_shared();
-
-        size_t retVal = 0;
-        for (auto& e : this->equivalencePartition) {
-            const size_t s = e.second->size();
-            retVal += s * s;
-        }
-
-        statesLock.unlock_shared();
-        return retVal;
+        return sds.ds.pairCount();
     }
 
     // an almighty iterator for several types of iteration.
@@ -240,58 +194,40 @@ public:
     //   - and a single iter type is expected (see Relation::iterator e.g.) (i think)
     class iterator : public std::iterator<std::forward_iterator_tag, TupleType> {
     public:
+        // all the different types of iterator this can be
+        enum IterType { ALL, ANTERIOR, ANTPOST, WITHIN };
+
         // one iterator for signalling the end (simplifies)
         explicit iterator(const EquivalenceRelation* br, bool /* signalIsEndIterator */)
                 : br(br), isEndVal(true){};
 
-        explicit iterator(const EquivalenceRelation* br)
-                : br(br), ityp(IterType::ALL), djSetMapListIt(br->equivalencePartition.begin()),
-                  djSetMapListEnd(br->equivalencePartition.end()) {
+        explicit iterator(const EquivalenceRelation* br) : br(br), ityp(IterType::ALL) {
             // no need to fast forward if this iterator is empty
-            if (djSetMapListIt == djSetMapListEnd) {
+            start = br->nextRoot(0);
+            if (start == br->sds.size()) {
                 isEndVal = true;
                 return;
             }
-            // grab the pointer to the list, and make it our current list
-            djSetList = (*djSetMapListIt).second;
-            assert(djSetList->size() != 0);
+            anterior = posterior = start;
 
             updateAnterior();
             updatePosterior();
         }
 
         // WITHIN: iterator for everything within the same DJset (used for EquivalenceRelation.partition())
-        explicit iterator(const EquivalenceRelation* br, const StatesBucket within)
-                : br(br), ityp(IterType::WITHIN), djSetList(within) {
-            // empty dj set
-            if (djSetList->size() == 0) {
-                isEndVal = true;
-            }
+        // ANTERIOR: iterator that yields all (former, _) \in djset(former), starting at the dense former
+        explicit iterator(const EquivalenceRelation* br, IterType ityp, parent_t within)
+                : br(br), ityp(ityp), start(within), anterior(within), posterior(within) {
+            assert((ityp == IterType::WITHIN || ityp == IterType::ANTERIOR) && "not a set iterator");
 
             updateAnterior();
             updatePosterior();
         }
 
-        // ANTERIOR: iterator that yields all (former, _) \in djset(former) (djset(former) === within)
-        explicit iterator(const EquivalenceRelation* br, const value_type former, const StatesBucket within)
-                : br(br), ityp(IterType::ANTERIOR), djSetList(within) {
-            if (djSetList->size() == 0) {
-                isEndVal = true;
-            }
-
-            setAnterior(former);
-            updatePosterior();
-        }
-
         // ANTPOST: iterator that yields all (former, latter) \in djset(former), (djset(former) ==
-        // djset(latter) == within)
-        explicit iterator(const EquivalenceRelation* br, const value_type former, value_type latter,
-                const StatesBucket within)
-                : br(br), ityp(IterType::ANTPOST), djSetList(within) {
-            if (djSetList->size() == 0) {
-                isEndVal = true;
-            }
-
+        // djset(latter))
+        explicit iterator(const EquivalenceRelation* br, const value_type former, value_type latter)
+                : br(br), ityp(IterType::ANTPOST) {
             setAnterior(former);
             setPosterior(latter);
         }
@@ -301,9 +237,9 @@ public:
             this->cPair[0] = a;
         }
 
-        /** quick update to whatever the current index is pointing to */
+        /** quick update to whatever the current member is pointing to */
         inline void updateAnterior() {
-            this->cPair[0] = this->djSetList->get(this->cAnteriorIndex);
+            this->cPair[0] = br->sds.toSparse(this->anterior);
         }
 
         /** explicit set second half of cPair */
@@ -311,9 +247,9 @@ public:
             this->cPair[1] = b;
         }
 
-        /** quick update to whatever the current index is pointing to */
+        /** quick update to whatever the current member is pointing to */
         inline void updatePosterior() {
-            this->cPair[1] = this->djSetList->get(this->cPosteriorIndex);
+            this->cPair[1] = br->sds.toSparse(this->posterior);
         }
 
         // copy ctor
@@ -346,39 +282,33 @@ public:
                 throw std::out_of_range("error: incrementing an out of range iterator");
             }
 
+            const DisjointSet& ds = br->sds.ds;
             switch (ityp) {
                 case IterType::ALL:
-                    // move posterior along one
+                case IterType::WITHIN:
+                    // move posterior along the cycle of members
                     // see if we can't move the posterior along
-                    if (++cPosteriorIndex == djSetList->size()) {
+                    if ((posterior = ds.nextMember(posterior)) == start) {
                         // move anterior along one
                         // see if we can't move the anterior along one
-                        if (++cAnteriorIndex == djSetList->size()) {
-                            // move the djset it along one
-                            // see if we can't move it along one (we're at the end)
-                            if (++djSetMapListIt == djSetMapListEnd) {
+                        if ((anterior = ds.nextMember(anterior)) == start) {
+                            if (ityp == IterType::WITHIN) {
                                 isEndVal = true;
                                 return *this;
                             }
 
-                            // we can't iterate along this djset if it is empty
-                            djSetList = (*djSetMapListIt).second;
-                            if (djSetList->size() == 0) {
-                                throw std::out_of_range("error: encountered a zero size djset");
+                            // move on to the next djset
+                            // see if we can't move it along one (we're at the end)
+                            start = br->nextRoot(start + 1);
+                            if (start == br->sds.size()) {
+                                isEndVal = true;
+                                return *this;
                             }
-
-                            // update our cAnterior and cPosterior
-                            cAnteriorIndex = 0;
-                            cPosteriorIndex = 0;
-                            updateAnterior();
-                            updatePosterior();
+                            anterior = posterior = start;
                         }
 
                         // we moved our anterior along one
                         updateAnterior();
-
-                        cPosteriorIndex = 0;
-                        updatePosterior();
                     }
                     // we just moved our posterior along one
                     updatePosterior();
@@ -386,7 +316,7 @@ public:
                     break;
                 case IterType::ANTERIOR:
                     // step posterior along one, and if we can't, then we're done.
-                    if (++cPosteriorIndex == djSetList->size()) {
+                    if ((posterior = ds.nextMember(posterior)) == start) {
                         isEndVal = true;
                         return *this;
                     }
@@ -398,26 +328,6 @@ public:
                     // end
                     isEndVal = true;
                     break;
-                case IterType::WITHIN:
-                    // move posterior along one
-                    // see if we can't move the posterior along
-                    if (++cPosteriorIndex == djSetList->size()) {
-                        // move anterior along one
-                        // see if we can't move the anterior along one
-                        if (++cAnteriorIndex == djSetList->size()) {
-                            isEndVal = true;
-                            return *this;
-                        }
-
-                        // we moved our anterior along one
-                        updateAnterior();
-
-                        cPosteriorIndex = 0;
-                        updatePosterior();
-                    }
-                    // we just moved our posterior along one
-                    updatePosterior();
-                    break;
             }
 
             return *this;
@@ -428,21 +338,16 @@ public:
         // special tombstone value to notify that this iter represents the end
         bool isEndVal = false;
 
-        // all the different types of iterator this can be
-        enum IterType { ALL, ANTERIOR, ANTPOST, WITHIN };
         IterType ityp;
 
         TupleType cPair;
 
-        // the disjoint set that we're currently iterating through
-        StatesBucket djSetList;
-        typename StatesMap::iterator djSetMapListIt;
-        typename StatesMap::iterator djSetMapListEnd;
-
-        // used for ALL, and POSTERIOR (just a current index in the cList)
-        size_t cAnteriorIndex = 0;
-        // used for ALL, and ANTERIOR (just a current index in the cList)
-        size_t cPosteriorIndex = 0;
+        // the dense member at which the cycle through the current djset starts (its root for ALL)
+        parent_t start = 0;
+        // used for ALL, and WITHIN (the current dense member of the anterior)
+        parent_t anterior = 0;
+        // used for ALL, WITHIN, and ANTERIOR (the current dense member of the posterior)
+        parent_t posterior = 0;
     };
 
 public:
@@ -451,7 +356,6 @@ public:
      * @return the iterator that corresponds to the beginning of the binary relation
      */
     iterator begin() const {
-        genAllDisjointSetLists();
         return iterator(this);
     }
 
@@ -580,13 +484,8 @@ public:
      * @return the iterator representing this.
      */
     iterator anteriorIt(value_type anteriorVal) const {
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the anterior val resides in
-        auto found = equivalencePartition.find({sds.findNode(anteriorVal), nullptr});
-        assert(found != equivalencePartition.end() && "iterator called on partition that doesn't exist");
-
-        return iterator(this, anteriorVal, (*found).second);
+        assert(sds.nodeExists(anteriorVal) && "iterator called on partition that doesn't exist");
+        return iterator(this, iterator::IterType::ANTERIOR, sds.toDense(anteriorVal));
     }
 
     /**
@@ -601,13 +500,7 @@ public:
         // obv if they're in diff sets, then iteration for this pair just ends.
         if (!sds.sameSet(anteriorVal, posteriorVal)) return end();
 
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the val resides in
-        auto found = equivalencePartition.find({sds.findNode(posteriorVal), nullptr});
-        assert(found != equivalencePartition.end() && "iterator called on partition that doesn't exist");
-
-        return iterator(this, anteriorVal, posteriorVal, (*found).second);
+        return iterator(this, anteriorVal, posteriorVal);
     }
 
     /**
@@ -616,11 +509,7 @@ public:
      * @return an iterator that will generate all pairs within the disjoint set
      */
     iterator closure(value_type rep) const {
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the val resides in
-        auto found = equivalencePartition.find({sds.findNode(rep), nullptr});
-        return iterator(this, (*found).second);
+        return iterator(this, iterator::IterType::WITHIN, sds.toDense(rep));
     }
 
     /**
@@ -632,18 +521,21 @@ public:
      * @return a list of the iterators as ranges
      */
     std::vector<souffle::range<iterator>> partition(size_t chunks) const {
-        // generate all reps
-        genAllDisjointSetLists();
-
         size_t numPairs = this->size();
         if (numPairs == 0) return {};
         if (numPairs == 1 || chunks <= 1) return {souffle::make_range(begin(), end())};
 
+        // collect the roots of all dj sets
+        std::vector<parent_t> roots;
+        for (parent_t root = nextRoot(0); root < sds.size(); root = nextRoot(root + 1)) {
+            roots.push_back(root);
+        }
+
         // if there's more dj sets than requested chunks, then just return an iter per dj set
         std::vector<souffle::range<iterator>> ret;
-        if (chunks <= equivalencePartition.size()) {
-            for (auto& p : equivalencePartition) {
-                ret.push_back(souffle::make_range(closure(p.first), end()));
+        if (chunks <= roots.size()) {
+            for (parent_t root : roots) {
+                ret.push_back(souffle::make_range(iterator(this, iterator::IterType::WITHIN, root), end()));
             }
             return ret;
         }
@@ -652,14 +544,17 @@ public:
         // just go through and if the size of the binrel is > numpairs/chunks, then generate an anteriorIt for
         // each
         const size_t perchunk = numPairs / chunks;
-        for (const auto& itp : equivalencePartition) {
-            const size_t s = itp.second->size();
+        for (parent_t root : roots) {
+            const size_t s = sds.ds.setSize(root);
             if (s * s > perchunk) {
-                for (const auto& i : *itp.second) {
-                    ret.push_back(souffle::make_range(anteriorIt(i), end()));
-                }
+                parent_t member = root;
+                do {
+                    ret.push_back(
+                            souffle::make_range(iterator(this, iterator::IterType::ANTERIOR, member), end()));
+                    member = sds.ds.nextMember(member);
+                } while (member != root);
             } else {
-                ret.push_back(souffle::make_range(closure(itp.first), end()));
+                ret.push_back(souffle::make_range(iterator(this, iterator::IterType::WITHIN, root), end()));
             }
         }
 
@@ -686,45 +581,17 @@ private:
     // const operations *may* safely change internal state (i.e. collapse djset forest)
     mutable souffle::SparseDisjointSet<value_type> sds;
 
-    // read/write lock on equivalencePartition
-    mutable std::shared_mutex statesLock;
-
-    mutable StatesMap equivalencePartition;
-    // whether the cache is stale
-    mutable std::atomic<bool> statesMapStale;
-
     /**
-     * Generate a cache of the sets such that they can be iterated over efficiently.
-     * Each set is partitioned into a PiggyList.
+     * Obtains the first root of a dj set at or after the given dense node, the number of nodes if there is
+     * none. The members of each set are linked by the disjoint set, such that no cache of the sets is needed
+     * for iteration.
      */
-    void genAllDisjointSetLists() const {
-        statesLock.lock();
-
-        // no need to generate again, already done.
-        if (!this->statesMapStale.load(std::memory_order_acquire)) {
-            statesLock.unlock();
-            return;
-        }
-
-        // btree version
-        emptyPartition();
-
-        size_t dSetSize = this->sds.ds.a_blocks.size();
-        for (size_t i = 0; i < dSetSize; ++i) {
-            typename TupleType::value_type sparseVal = this->sds.toSparse(i);
-            parent_t rep = this->sds.findNode(sparseVal);
-
-            StorePair p = {rep, nullptr};
-            StatesList* mapList = equivalencePartition.insert(p, [&](StorePair& sp) {
-                auto* r = new StatesList(1);
-                sp.second = r;
-                return r;
-            });
-            mapList->append(sparseVal);
+    parent_t nextRoot(parent_t node) const {
+        const size_t numNodes = sds.size();
+        while (node < numNodes && !sds.ds.isRoot(node)) {
+            ++node;
         }
-
-        statesMapStale.store(false, std::memory_order_release);
-        statesLock.unlock();
+        return node;
     }
 };
 }  // namespace souffle
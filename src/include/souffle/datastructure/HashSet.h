@@ -0,0 +1,559 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HashSet.h
+ *
+ * This header file contains the implementation of a hash set of tuples,
+ * keyed on a subset of the tuple attributes.
+ *
+ * Tuples are stored inline in blocks of growing size and never move.
+ * Two open-addressing tables with linear probing refer to them: the
+ * first one maps whole tuples to their position, the second one, only
+ * maintained if the key does not cover all attributes, maps each key
+ * to a chain of the tuples sharing it. Hence membership tests take
+ * constant time, and so does locating the tuples with a given key.
+ *
+ * These lookups are paid for with memory: the tables and the slack of
+ * the blocks take more space than the nodes of a b-tree holding the same
+ * tuples, as reported by getMemoryUsage().
+ *
+ * Multiple insert operations can be conducted concurrently on hash sets.
+ * So can read-only operations. However, inserts and read operations may
+ * not be conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/PiggyList.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A hash set of tuples of the given arity, keyed on a subset of their attributes.
+ *
+ * @tparam Arity the number of attributes of the stored tuples
+ */
+template <std::size_t Arity>
+class HashSet {
+public:
+    using element_type = Tuple<RamDomain, Arity>;
+    using attribute_set = std::bitset<Arity>;
+
+private:
+    // position marking the end of a chain or a missing element
+    static constexpr std::size_t NONE = ~std::size_t(0);
+
+    // slots hold a tag taken from the hash of the referenced element in the upper bits and its position + 1
+    // in the lower bits; 0 marks a free slot and BUSY a slot claimed by an ongoing insertion
+    static constexpr unsigned POSITION_BITS = 40;
+    static constexpr std::uint64_t POSITION_MASK = (std::uint64_t(1) << POSITION_BITS) - 1;
+    static constexpr std::uint64_t BUSY = ~std::uint64_t(0);
+
+    // the capacity of the tables once the first element is inserted
+    static constexpr std::size_t MIN_CAPACITY = 64;
+
+    /** An open-addressing table of slots */
+    struct Table {
+        std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+        std::size_t capacity = 0;
+
+        // the number of slots in use or reserved by ongoing insertions
+        std::atomic<std::size_t> load{0};
+
+        void reset(std::size_t newCapacity) {
+            slots = newCapacity == 0 ? nullptr : std::make_unique<std::atomic<std::uint64_t>[]>(newCapacity);
+            capacity = newCapacity;
+        }
+
+        // the slot visited by the given probe for the given hash
+        std::atomic<std::uint64_t>& at(std::uint64_t hash, std::size_t probe) const {
+            return slots[(hash + probe) & (capacity - 1)];
+        }
+
+        // whether a table with the given load may not be filled further
+        bool exhausted(std::size_t currentLoad) const {
+            return currentLoad >= capacity / 4 * 3;
+        }
+    };
+
+    // the attributes the tuples are keyed on
+    std::vector<std::size_t> key;
+    attribute_set keyAttributes;
+
+    // whether the key covers only some attributes, such that chains of tuples are maintained per key
+    bool keyed;
+
+    // the stored tuples and, if keyed, the successor of each tuple within the chain of its key
+    RandomInsertPiggyList<element_type> elements{6};
+    RandomInsertPiggyList<std::size_t> successors{6};
+    std::atomic<std::size_t> numElements{0};
+
+    // the tables mapping tuples to their position and keys to the first tuple of their chain
+    Table tuples;
+    Table keys;
+
+    // insertions are readers of this lock; growing the tables is the writer
+    mutable ReadWriteLock growth;
+
+    static std::uint64_t combine(std::uint64_t hash, RamDomain value) {
+        hash ^= static_cast<std::uint64_t>(static_cast<RamUnsigned>(value));
+        return hash * 0x9e3779b97f4a7c15ull;
+    }
+
+    static std::uint64_t finish(std::uint64_t hash) {
+        hash ^= hash >> 29;
+        hash *= 0xbf58476d1ce4e5b9ull;
+        return hash ^ (hash >> 32);
+    }
+
+    static std::uint64_t hashTuple(const element_type& tuple) {
+        std::uint64_t hash = Arity;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            hash = combine(hash, tuple[i]);
+        }
+        return finish(hash);
+    }
+
+    std::uint64_t hashKey(const element_type& tuple) const {
+        std::uint64_t hash = key.size();
+        for (std::size_t attribute : key) {
+            hash = combine(hash, tuple[attribute]);
+        }
+        return finish(hash);
+    }
+
+    bool sameKey(const element_type& a, const element_type& b) const {
+        for (std::size_t attribute : key) {
+            if (a[attribute] != b[attribute]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::uint64_t makeSlot(std::uint64_t hash, std::size_t pos) {
+        assert(pos + 2 < POSITION_MASK && "too many elements");
+        return (hash & ~POSITION_MASK) | (pos + 1);
+    }
+
+    // whether a slot refers to an element whose hash carries the same tag
+    static bool matchesTag(std::uint64_t slot, std::uint64_t hash) {
+        return slot != BUSY && (slot & ~POSITION_MASK) == (hash & ~POSITION_MASK);
+    }
+
+    static std::size_t getPosition(std::uint64_t slot) {
+        return (slot & POSITION_MASK) - 1;
+    }
+
+    // whether a slot of the key table refers to the chain of the key of the given tuple
+    bool holdsKey(std::uint64_t slot, std::uint64_t hash, const element_type& tuple) const {
+        return matchesTag(slot, hash) && sameKey(elements.get(getPosition(slot)), tuple);
+    }
+
+    /** Obtains the position of the given tuple, NONE if it is not present */
+    std::size_t locate(const element_type& tuple) const {
+        if (tuples.capacity == 0) {
+            return NONE;
+        }
+        const std::uint64_t hash = hashTuple(tuple);
+        for (std::size_t probe = 0; probe < tuples.capacity; ++probe) {
+            std::uint64_t slot = tuples.at(hash, probe).load(std::memory_order_acquire);
+            if (slot == 0) {
+                return NONE;
+            }
+            if (matchesTag(slot, hash) && elements.get(getPosition(slot)) == tuple) {
+                return getPosition(slot);
+            }
+        }
+        return NONE;
+    }
+
+    /** Obtains the position of the first tuple with the key of the given tuple, NONE if there is none */
+    std::size_t locateKey(const element_type& tuple) const {
+        if (keys.capacity == 0) {
+            return NONE;
+        }
+        const std::uint64_t hash = hashKey(tuple);
+        for (std::size_t probe = 0; probe < keys.capacity; ++probe) {
+            std::uint64_t slot = keys.at(hash, probe).load(std::memory_order_acquire);
+            if (slot == 0) {
+                return NONE;
+            }
+            if (holdsKey(slot, hash, tuple)) {
+                return getPosition(slot);
+            }
+        }
+        return NONE;
+    }
+
+    /** Prepends the stored tuple at the given position to the chain of its key */
+    void link(std::size_t pos, const element_type& tuple) {
+        const std::uint64_t hash = hashKey(tuple);
+        successors.insertAt(pos, NONE);
+        for (std::size_t probe = 0;; ++probe) {
+            auto& slot = keys.at(hash, probe);
+            std::uint64_t cur = slot.load(std::memory_order_acquire);
+            while (cur == 0 || holdsKey(cur, hash, tuple)) {
+                // the successor is published together with the new head of the chain
+                successors.get(pos) = cur == 0 ? NONE : getPosition(cur);
+                if (slot.compare_exchange_weak(
+                            cur, makeSlot(hash, pos), std::memory_order_release, std::memory_order_acquire)) {
+                    if (cur != 0) {
+                        // the key was present already, so the slot reserved for it is not needed
+                        keys.load.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    return;
+                }
+            }
+        }
+    }
+
+    enum class Outcome { INSERTED, PRESENT, FULL };
+
+    Outcome tryInsert(const element_type& tuple, std::uint64_t hash) {
+        // reserve a slot in each table, such that probing always ends at a free slot
+        if (tuples.exhausted(tuples.load.fetch_add(1, std::memory_order_relaxed))) {
+            tuples.load.fetch_sub(1, std::memory_order_relaxed);
+            return Outcome::FULL;
+        }
+        if (keyed && keys.exhausted(keys.load.fetch_add(1, std::memory_order_relaxed))) {
+            keys.load.fetch_sub(1, std::memory_order_relaxed);
+            tuples.load.fetch_sub(1, std::memory_order_relaxed);
+            return Outcome::FULL;
+        }
+
+        for (std::size_t probe = 0;; ++probe) {
+            auto& slot = tuples.at(hash, probe);
+            std::uint64_t cur = slot.load(std::memory_order_acquire);
+            while (cur == 0 || cur == BUSY) {
+                if (cur == BUSY) {
+                    // wait for the concurrent insertion to complete; it may insert the same tuple
+                    std::this_thread::yield();
+                    cur = slot.load(std::memory_order_acquire);
+                } else if (slot.compare_exchange_weak(cur, BUSY, std::memory_order_acquire)) {
+                    std::size_t pos = numElements.fetch_add(1, std::memory_order_relaxed);
+                    elements.insertAt(pos, tuple);
+                    if (keyed) {
+                        link(pos, tuple);
+                    }
+                    slot.store(makeSlot(hash, pos), std::memory_order_release);
+                    return Outcome::INSERTED;
+                }
+            }
+            if (matchesTag(cur, hash) && elements.get(getPosition(cur)) == tuple) {
+                tuples.load.fetch_sub(1, std::memory_order_relaxed);
+                if (keyed) {
+                    keys.load.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return Outcome::PRESENT;
+            }
+        }
+    }
+
+    /** Enlarges the tables such that the given number of additional tuples and one more key fit */
+    void grow(std::size_t additional) {
+        growth.start_write();
+        const std::size_t size = numElements.load(std::memory_order_relaxed);
+        auto enlarge = [&](Table& table, std::size_t additional) {
+            std::size_t capacity = std::max(MIN_CAPACITY, table.capacity);
+            while (table.load + additional >= capacity / 4 * 3) {
+                capacity *= 2;
+            }
+            if (capacity == table.capacity) {
+                return false;
+            }
+            table.reset(capacity);
+            return true;
+        };
+
+        if (enlarge(tuples, additional)) {
+            for (std::size_t pos = 0; pos < size; ++pos) {
+                const std::uint64_t hash = hashTuple(elements.get(pos));
+                std::size_t probe = 0;
+                while (tuples.at(hash, probe).load(std::memory_order_relaxed) != 0) {
+                    ++probe;
+                }
+                tuples.at(hash, probe).store(makeSlot(hash, pos), std::memory_order_relaxed);
+            }
+        }
+
+        if (keyed && enlarge(keys, 1)) {
+            // rebuild the chains, each chain ending with the earliest tuple of its key
+            for (std::size_t pos = 0; pos < size; ++pos) {
+                const element_type& tuple = elements.get(pos);
+                const std::uint64_t hash = hashKey(tuple);
+                std::size_t probe = 0;
+                while (true) {
+                    auto& slot = keys.at(hash, probe);
+                    std::uint64_t cur = slot.load(std::memory_order_relaxed);
+                    if (cur == 0 || holdsKey(cur, hash, tuple)) {
+                        successors.get(pos) = cur == 0 ? NONE : getPosition(cur);
+                        slot.store(makeSlot(hash, pos), std::memory_order_relaxed);
+                        break;
+                    }
+                    ++probe;
+                }
+            }
+        }
+        growth.end_write();
+    }
+
+public:
+    /** Creates a set keyed on all attributes */
+    HashSet() : HashSet(allAttributes()) {}
+
+    /** Creates a set keyed on the given attributes */
+    explicit HashSet(std::vector<std::size_t> key) : key(std::move(key)) {
+        assert(!this->key.empty() && "hash sets require a key");
+        for (std::size_t attribute : this->key) {
+            assert(attribute < Arity && "key attribute out of range");
+            keyAttributes.set(attribute);
+        }
+        keyed = !keyAttributes.all();
+    }
+
+    HashSet(const HashSet&) = delete;
+    HashSet& operator=(const HashSet&) = delete;
+
+    /** Obtains the list of all attributes, the default key */
+    static std::vector<std::size_t> allAttributes() {
+        std::vector<std::size_t> res;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            res.push_back(i);
+        }
+        return res;
+    }
+
+    /** Obtains the attributes this set is keyed on */
+    const attribute_set& getKey() const {
+        return keyAttributes;
+    }
+
+    std::size_t size() const {
+        return numElements.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Inserts the given tuple.
+     *
+     * @return true if the tuple has been inserted, false if it was present already
+     */
+    bool insert(const element_type& tuple) {
+        const std::uint64_t hash = hashTuple(tuple);
+        while (true) {
+            growth.start_read();
+            Outcome outcome = tryInsert(tuple, hash);
+            growth.end_read();
+            if (outcome != Outcome::FULL) {
+                return outcome == Outcome::INSERTED;
+            }
+            grow(1);
+        }
+    }
+
+    /** Inserts all tuples of the given set */
+    void insertAll(const HashSet& other) {
+        grow(other.size());
+        for (const auto& tuple : other) {
+            insert(tuple);
+        }
+    }
+
+    bool contains(const element_type& tuple) const {
+        return locate(tuple) != NONE;
+    }
+
+    void clear() {
+        elements.clear();
+        successors.clear();
+        numElements = 0;
+        tuples.reset(0);
+        tuples.load = 0;
+        keys.reset(0);
+        keys.load = 0;
+    }
+
+    /** An iterator over all tuples, in the order of their insertion. */
+    class iterator : public std::iterator<std::forward_iterator_tag, element_type> {
+        const HashSet* set = nullptr;
+        std::size_t pos = 0;
+
+    public:
+        iterator() = default;
+
+        iterator(const HashSet* set, std::size_t pos) : set(set), pos(pos) {}
+
+        bool operator==(const iterator& other) const {
+            return pos == other.pos;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const element_type& operator*() const {
+            return set->elements.get(pos);
+        }
+
+        const element_type* operator->() const {
+            return &**this;
+        }
+
+        iterator& operator++() {
+            ++pos;
+            return *this;
+        }
+    };
+
+    /**
+     * An iterator over the tuples agreeing with a given tuple on a set of attributes,
+     * following the chain of their key.
+     */
+    class equal_iterator : public std::iterator<std::forward_iterator_tag, element_type> {
+        const HashSet* set = nullptr;
+        std::size_t pos = NONE;
+
+        // whether further tuples follow in the chain of the key
+        bool chained = false;
+
+        // the attributes beyond the key to be compared, and the values to compare them to
+        attribute_set filter;
+        element_type reference;
+
+        void skip() {
+            while (pos != NONE && !matches(set->elements.get(pos))) {
+                pos = set->successors.get(pos);
+            }
+        }
+
+        bool matches(const element_type& tuple) const {
+            for (std::size_t i = 0; i < Arity; ++i) {
+                if (filter[i] && tuple[i] != reference[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        equal_iterator() = default;
+
+        equal_iterator(const HashSet* set, std::size_t pos, bool chained, const attribute_set& filter,
+                const element_type& reference)
+                : set(set), pos(pos), chained(chained), filter(filter), reference(reference) {
+            skip();
+        }
+
+        bool operator==(const equal_iterator& other) const {
+            return pos == other.pos;
+        }
+
+        bool operator!=(const equal_iterator& other) const {
+            return !(*this == other);
+        }
+
+        const element_type& operator*() const {
+            return set->elements.get(pos);
+        }
+
+        const element_type* operator->() const {
+            return &**this;
+        }
+
+        equal_iterator& operator++() {
+            pos = chained ? set->successors.get(pos) : NONE;
+            skip();
+            return *this;
+        }
+    };
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, size());
+    }
+
+    /**
+     * Obtains the tuples agreeing with the given tuple on the given attributes,
+     * which have to cover the key of this set.
+     */
+    range<equal_iterator> equalRange(const element_type& tuple, const attribute_set& attributes) const {
+        if (attributes.all()) {
+            std::size_t pos = locate(tuple);
+            return make_range(equal_iterator(this, pos, false, attribute_set(), tuple), equal_iterator());
+        }
+        assert(keyed && (attributes & keyAttributes) == keyAttributes && "attributes do not cover the key");
+        return make_range(
+                equal_iterator(this, locateKey(tuple), true, attributes & ~keyAttributes, tuple),
+                equal_iterator());
+    }
+
+    /**
+     * Partitions the tuples into the given number of chunks of consecutive tuples.
+     */
+    std::vector<range<iterator>> partition(std::size_t numChunks) const {
+        std::vector<range<iterator>> res;
+        const std::size_t total = size();
+        const std::size_t chunkSize = std::max<std::size_t>(1, (total + numChunks - 1) / numChunks);
+        for (std::size_t pos = 0; pos < total; pos += chunkSize) {
+            res.push_back(make_range(iterator(this, pos), iterator(this, std::min(pos + chunkSize, total))));
+        }
+        return res;
+    }
+
+    /**
+     * Determines the amount of memory used by this data structure.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(elements) - sizeof(successors) + elements.getMemoryUsage() +
+               successors.getMemoryUsage() + key.capacity() * sizeof(std::size_t) +
+               (tuples.capacity + keys.capacity) * sizeof(std::atomic<std::uint64_t>);
+    }
+
+    /**
+     * Prints a textual summary of statistical properties of this
+     * set to the given output stream (for debugging and tuning).
+     */
+    void printStats(std::ostream& out = std::cout) const {
+        out << " ---------------------------------\n";
+        out << "  Elements:       " << size() << "\n";
+        out << "  Tuple slots:    " << tuples.capacity << "\n";
+        if (keyed) {
+            out << "  Keys:           " << keys.load << "\n";
+            out << "  Key slots:      " << keys.capacity << "\n";
+        }
+        out << "  Size of tuple:  " << sizeof(element_type) << "\n";
+        out << " ---------------------------------\n";
+    }
+};
+
+}  // end namespace souffle
@@ -0,0 +1,109 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InsertBuffer.h
+ *
+ * Thread-local buffers of tuples, merged into a relation in bulk.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Buffers collecting the tuples inserted into a relation by the threads of a
+ * parallel operation, one buffer per thread.
+ *
+ * Instead of contending on the relation, each thread appends to its own buffer.
+ * Once the parallel operation has finished, flush() merges the buffered tuples
+ * into the relation in bulk: relations providing insertBulk() sort them in the
+ * order of each of their indexes and merge them into the indexes in parallel.
+ * Otherwise, the tuples are sorted, deduplicated and inserted one by one.
+ *
+ * The buffers are to be created outside of the parallel region, by the thread
+ * starting it; they cover the threads of a team of the size requested by it.
+ *
+ * @tparam TupleType .. the type of the buffered tuples
+ */
+template <typename TupleType>
+class InsertBuffer {
+    // the buffer of a thread, kept on its own cache line
+    struct alignas(64) Buffer {
+        std::vector<TupleType> tuples;
+    };
+
+    std::size_t numBuffers;
+    std::unique_ptr<Buffer[]> buffers;
+
+public:
+    InsertBuffer()
+            : numBuffers(std::max<std::size_t>(1, MAX_THREADS)),
+              buffers(std::make_unique<Buffer[]>(numBuffers)) {}
+
+    InsertBuffer(const InsertBuffer&) = delete;
+    InsertBuffer& operator=(const InsertBuffer&) = delete;
+
+    /**
+     * Obtains the buffer of the calling thread.
+     */
+    std::vector<TupleType>& local() {
+#ifdef IS_PARALLEL
+        std::size_t thread = omp_get_thread_num();
+        assert(thread < numBuffers && "no buffer for thread");
+        return buffers[thread].tuples;
+#else
+        return buffers[0].tuples;
+#endif
+    }
+
+    /**
+     * Inserts the buffered tuples into the given relation, emptying the buffers.
+     */
+    template <typename Relation>
+    void flush(Relation& rel) {
+        std::vector<TupleType> tuples;
+        for (std::size_t i = 0; i < numBuffers; ++i) {
+            auto& cur = buffers[i].tuples;
+            tuples.insert(tuples.end(), cur.begin(), cur.end());
+            std::vector<TupleType>().swap(cur);
+        }
+        flush(rel, tuples, 0);
+    }
+
+private:
+    // merges the tuples into a relation providing a bulk insert
+    template <typename Relation>
+    static auto flush(Relation& rel, std::vector<TupleType>& tuples, int)
+            -> decltype(rel.insertBulk(tuples), void()) {
+        rel.insertBulk(tuples);
+    }
+
+    // inserts the tuples one by one into any other relation
+    template <typename Relation>
+    static void flush(Relation& rel, std::vector<TupleType>& tuples, long) {
+        std::sort(tuples.begin(), tuples.end());
+        tuples.erase(std::unique(tuples.begin(), tuples.end()), tuples.end());
+
+        auto ctxt = rel.createContext();
+        for (const auto& cur : tuples) {
+            rel.insert(cur, ctxt);
+        }
+    }
+};
+
+}  // namespace souffle
@@ -42,8 +42,7 @@ namespace detail {
  * @tparam Functor      .. a std::function that is called on successful (new) insert
  */
 template <typename Key, typename Comparator,
-        typename Allocator,  // is ignored so far - TODO: add support
-        unsigned blockSize, typename SearchStrategy, bool isSet, typename Functor,
+        typename Allocator, unsigned blockSize, typename SearchStrategy, bool isSet, typename Functor,
         typename WeakComparator = Comparator, typename Updater = detail::updater<Key>>
 class LambdaBTree : public btree<Key, Comparator, Allocator, blockSize, SearchStrategy, isSet, WeakComparator,
                             Updater> {
@@ -83,7 +82,7 @@ public:
             }
 
             // create new node
-            this->leftmost = new typename parenttype::leaf_node();
+            this->leftmost = parenttype::template createNode<typename parenttype::leaf_node>(this->arena);
             this->leftmost->numElements = 1;
             // call the functor as we've successfully inserted
             typename Functor::result_type res = f(k);
@@ -313,8 +312,8 @@ public:
 
                 // split this node
                 auto old_root = this->root;
-                idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(const_cast<typename parenttype::node**>(&this->root),
+                        this->root_lock, this->arena, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -367,7 +366,7 @@ public:
         // special handling for inserting first element
         if (this->empty()) {
             // create new node
-            this->leftmost = new typename parenttype::leaf_node();
+            this->leftmost = parenttype::template createNode<typename parenttype::leaf_node>(this->arena);
             this->leftmost->numElements = 1;
             // call the functor as we've successfully inserted
             typename Functor::result_type res = f(k);
@@ -444,8 +443,8 @@ public:
 
             if (cur->numElements >= parenttype::node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx);
+                idx -= cur->rebalance_or_split(const_cast<typename parenttype::node**>(&this->root),
+                        this->root_lock, this->arena, idx);
 
                 // insert element in right fragment
                 if (((typename parenttype::size_type)idx) > cur->numElements) {
@@ -476,19 +475,38 @@ public:
     }
 
     /**
-     * Inserts the given range of elements into this tree.
+     * Inserts the given range of elements into this tree one by one, calling the
+     * functor on each new element.
      */
     template <typename Iter>
-    void insert(const Iter& a, const Iter& b) {
-        // TODO: improve this beyond a naive insert
+    void insert(const Iter& a, const Iter& b, const Functor& f) {
         typename parenttype::operation_hints hints;
-        // a naive insert so far .. seems to work fine
         for (auto it = a; it != b; ++it) {
-            // use insert with hint
-            insert(*it, hints);
+            Key key = *it;
+            insert(key, hints, f);
         }
     }
 
+    /**
+     * Inserts the given range of elements into this tree, calling the functor on each
+     * new element. Sorted runs of elements beyond the maximum of this tree are appended
+     * to its rightmost nodes; all other elements are inserted one by one.
+     *
+     * Unlike insert(a, b, f), this operation must not be run concurrently with other
+     * operations on this tree.
+     */
+    template <typename Iter>
+    void insertSortedBulk(const Iter& a, const Iter& b, const Functor& f) {
+        typename parenttype::operation_hints hints;
+        this->insertRange(
+                a, b,
+                [&](const Key& k) {
+                    Key key = k;
+                    insert(key, hints, f);
+                },
+                [&](Key& k) { f(k); });
+    }
+
     /**
      * Swaps the content of this tree with the given tree. This
      * is a much more efficient operation than creating a copy and
@@ -498,6 +516,7 @@ public:
         // swap the content
         std::swap(this->root, other.root);
         std::swap(this->leftmost, other.leftmost);
+        this->arena.swap(other.arena);
     }
 
     // Implementation of the assignment operation for trees.
@@ -508,13 +527,15 @@ public:
         }
 
         // create a deep-copy of the content of the other tree
+        this->clear();
+
         // shortcut for empty sets
         if (other.empty()) {
             return *this;
         }
 
         // clone content (deep copy)
-        this->root = other.root->clone();
+        this->root = other.root->clone(this->arena);
 
         // update leftmost reference
         auto tmp = this->root;
@@ -570,7 +591,7 @@ public:
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
  */
 template <typename Key, typename Functor, typename Comparator = detail::comparator<Key>,
-        typename Allocator = std::allocator<Key>,  // is ignored so far
+        typename Allocator = std::allocator<Key>,
         unsigned blockSize = 256, typename SearchStrategy = typename detail::default_strategy<Key>::type>
 class LambdaBTreeSet
         : public detail::LambdaBTree<Key, Comparator, Allocator, blockSize, SearchStrategy, true, Functor> {
@@ -585,11 +606,11 @@ public:
     LambdaBTreeSet(const Comparator& comp = Comparator()) : super(comp) {}
 
     /**
-     * A constructor creating a set based on the given range.
+     * A constructor creating a set based on the given range, calling the functor on each element.
      */
     template <typename Iter>
-    LambdaBTreeSet(const Iter& a, const Iter& b) {
-        this->insert(a, b);
+    LambdaBTreeSet(const Iter& a, const Iter& b, const Functor& f) {
+        this->insertSortedBulk(a, b, f);
     }
 
     // A copy constructor.
@@ -598,12 +619,6 @@ public:
     // A move constructor.
     LambdaBTreeSet(LambdaBTreeSet&& other) : super(std::move(other)) {}
 
-private:
-    // A constructor required by the bulk-load facility.
-    template <typename s, typename n, typename l>
-    LambdaBTreeSet(s size, n* root, l* leftmost) : super::parenttype(size, root, leftmost) {}
-
-public:
     // Support for the assignment operator.
     LambdaBTreeSet& operator=(const LambdaBTreeSet& other) {
         super::operator=(other);
@@ -3,6 +3,7 @@
 #include "souffle/utility/ParallelUtil.h"
 #include <array>
 #include <atomic>
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include <iterator>
@@ -108,6 +109,20 @@ public:
         freeList();
         numElements.store(0);
     }
+
+    /**
+     * Obtains the number of bytes occupied by this list, including its allocated blocks.
+     */
+    size_t getMemoryUsage() const {
+        size_t res = sizeof(*this);
+        for (size_t i = 0; i < maxContainers; ++i) {
+            if (blockLookupTable[i].load() != nullptr) {
+                res += (INITIALBLOCKSIZE << i) * sizeof(T);
+            }
+        }
+        return res;
+    }
+
     const size_t BLOCKBITS = 16ul;
     const size_t INITIALBLOCKSIZE = (1ul << BLOCKBITS);
 
@@ -0,0 +1,197 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SlabArena.h
+ *
+ * An arena allocating memory from per-thread slabs, released all at once.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/SpillUtil.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * An arena handing out memory from slabs obtained from the given allocator.
+ *
+ * Each thread allocates from the current slab of its own pool by bumping a
+ * pointer; the slabs of a pool double in size up to a limit. Memory is never
+ * returned individually -- clear() releases all slabs at once, in a number of
+ * steps linear in the number of slabs. Objects placed in the arena are not
+ * destructed by it.
+ *
+ * The slabs may be spilled into the file of the process receiving spilled memory,
+ * which keeps the memory handed out in place while letting the operating system
+ * page it out, see SpillFile.
+ *
+ * Allocations may be conducted concurrently; clearing, spilling, swapping and
+ * destructing the arena may not.
+ *
+ * @tparam Allocator .. the allocator the slabs are obtained from
+ */
+template <typename Allocator = std::allocator<char>>
+class SlabArena {
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+    using allocator_traits = std::allocator_traits<allocator_type>;
+
+    // the size of the first slab of a pool, and the limit of the slab size
+    static constexpr std::size_t MIN_SLAB_SIZE = 1 << 10;
+    static constexpr std::size_t MAX_SLAB_SIZE = 1 << 20;
+
+    struct Slab {
+        char* begin;
+        std::size_t size;
+        // the offset of the slab in the spill file, or -1 if it has not been spilled
+        int64_t spilled;
+    };
+
+    // the allocation state of a thread, kept on its own cache line
+    struct alignas(64) Pool {
+        SpinLock lock;
+        char* cur = nullptr;
+        char* end = nullptr;
+        std::size_t nextSlabSize = MIN_SLAB_SIZE;
+    };
+
+    allocator_type allocator;
+
+    // the pools of the threads, threads beyond their number share pools
+    std::size_t numPools;
+    std::unique_ptr<Pool[]> pools;
+
+    // all slabs obtained so far
+    std::vector<Slab> slabs;
+    SpinLock slabsLock;
+
+    Pool& getPool() {
+#ifdef IS_PARALLEL
+        return pools[omp_get_thread_num() % numPools];
+#else
+        return pools[0];
+#endif
+    }
+
+    // aligns the given pointer upwards, null if the result would exceed the given end
+    static char* align(char* pos, const char* end, std::size_t alignment) {
+        if (pos == nullptr) {
+            return nullptr;
+        }
+        auto address = reinterpret_cast<std::uintptr_t>(pos);
+        auto offset = (alignment - address % alignment) % alignment;
+        return (offset <= static_cast<std::size_t>(end - pos)) ? pos + offset : nullptr;
+    }
+
+public:
+    SlabArena(const Allocator& allocator = Allocator())
+            : allocator(allocator), numPools(std::max<std::size_t>(1, MAX_THREADS)),
+              pools(std::make_unique<Pool[]>(numPools)) {}
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    ~SlabArena() {
+        clear();
+    }
+
+    /**
+     * Obtains uninitialised memory of the given size and alignment.
+     */
+    void* allocate(std::size_t size, std::size_t alignment) {
+        assert(alignment <= alignof(std::max_align_t) && "over-aligned allocations are not supported");
+        Pool& pool = getPool();
+        pool.lock.lock();
+
+        char* pos = align(pool.cur, pool.end, alignment);
+        if (pos == nullptr || static_cast<std::size_t>(pool.end - pos) < size) {
+            // start a new slab, large enough for the requested memory
+            std::size_t slabSize = std::max(pool.nextSlabSize, size);
+            pool.nextSlabSize = std::min(2 * pool.nextSlabSize, MAX_SLAB_SIZE);
+            pool.cur = allocator_traits::allocate(allocator, slabSize);
+            pool.end = pool.cur + slabSize;
+            slabsLock.lock();
+            slabs.push_back({pool.cur, slabSize, -1});
+            slabsLock.unlock();
+            pos = pool.cur;
+        }
+
+        pool.cur = pos + size;
+        pool.lock.unlock();
+        return pos;
+    }
+
+    /**
+     * Releases all memory handed out by this arena.
+     */
+    void clear() {
+        for (const auto& slab : slabs) {
+            if (slab.spilled >= 0) {
+                SpillFile::instance().restore(slab.begin, slab.size, slab.spilled);
+            }
+            allocator_traits::deallocate(allocator, slab.begin, slab.size);
+        }
+        slabs.clear();
+        for (std::size_t i = 0; i < numPools; ++i) {
+            pools[i].cur = nullptr;
+            pools[i].end = nullptr;
+            pools[i].nextSlabSize = MIN_SLAB_SIZE;
+        }
+    }
+
+    /**
+     * Spills all slabs not spilled yet. The memory handed out so far remains valid.
+     */
+    void spill() {
+        for (auto& slab : slabs) {
+            if (slab.spilled < 0) {
+                slab.spilled = SpillFile::instance().spill(slab.begin, slab.size);
+            }
+        }
+    }
+
+    /**
+     * Exchanges the memory of this arena with the memory of the given arena.
+     */
+    void swap(SlabArena& other) {
+        std::swap(allocator, other.allocator);
+        std::swap(numPools, other.numPools);
+        std::swap(pools, other.pools);
+        std::swap(slabs, other.slabs);
+    }
+
+    /**
+     * Obtains the number of slabs obtained by this arena.
+     */
+    std::size_t getNumSlabs() const {
+        return slabs.size();
+    }
+
+    /**
+     * Obtains the number of bytes obtained by this arena.
+     */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = 0;
+        for (const auto& slab : slabs) {
+            res += slab.size;
+        }
+        return res;
+    }
+};
+
+}  // namespace souffle
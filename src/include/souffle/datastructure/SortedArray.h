@@ -0,0 +1,393 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SortedArray.h
+ *
+ * A compact set of keys in a sorted array, for sets that are only read.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/datastructure/BTree.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/SpillUtil.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A set of keys stored in ascending order in a single array, without any per-key
+ * overhead: the read-only counterpart of a B-tree set.
+ *
+ * Searches gallop forward from the position found by the previous search of the
+ * same operation hints, such that a sequence of searches for ascending keys costs
+ * a number of steps logarithmic in the distances between their results. Searches
+ * without a preceding result first consult a sparse directory holding every
+ * DIRECTORY_STRIDE-th key, which is small enough to remain in cache, and then
+ * the block of the array the directory points to. The directory is only kept for
+ * sets of at least MIN_DIRECTORY_SIZE keys.
+ *
+ * Keys are expected to be added in ascending order, e.g. by copying another
+ * ordered set; adding a key in between others moves all subsequent keys. The set
+ * may be read concurrently; modifying it may not be conducted concurrently with
+ * any other operation.
+ *
+ * @tparam Key .. the type of the stored keys
+ * @tparam Comparator .. a comparator providing a less operation on keys
+ */
+template <typename Key, typename Comparator = detail::comparator<Key>>
+class SortedArray {
+    // the distance of the keys held by the directory
+    static constexpr std::size_t DIRECTORY_STRIDE = 64;
+
+    // the number of keys from which on the directory is kept
+    static constexpr std::size_t MIN_DIRECTORY_SIZE = 1 << 12;
+
+public:
+    using element_type = Key;
+    using iterator = const Key*;
+    using const_iterator = iterator;
+    using chunk = range<iterator>;
+
+    /**
+     * The state of a sequence of searches: the position of the last result.
+     */
+    struct operation_hints {
+        std::size_t last = 0;
+    };
+
+    SortedArray() = default;
+
+    SortedArray(const SortedArray& other) : keys(other.keys), directory(other.directory) {}
+
+    SortedArray(SortedArray&& other) {
+        swap(other);
+    }
+
+    ~SortedArray() {
+        clear();
+    }
+
+    SortedArray& operator=(SortedArray other) {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * Tests whether this set is empty.
+     */
+    bool empty() const {
+        return keys.empty();
+    }
+
+    /**
+     * Obtains the number of keys in this set.
+     */
+    std::size_t size() const {
+        return keys.size();
+    }
+
+    iterator begin() const {
+        return keys.data();
+    }
+
+    iterator end() const {
+        return keys.data() + keys.size();
+    }
+
+    /**
+     * Reserves memory for the given number of keys, such that adding them in
+     * ascending order does not move the array.
+     */
+    void reserve(std::size_t n) {
+        reload();
+        keys.reserve(n);
+    }
+
+    /**
+     * Adds the given key unless it is present. Returns whether it has been added.
+     */
+    bool insert(const Key& k) {
+        operation_hints hints;
+        return insert(k, hints);
+    }
+
+    /**
+     * Adds the given key unless it is present, utilising and updating the given
+     * hints. Returns whether it has been added.
+     */
+    bool insert(const Key& k, operation_hints& hints) {
+        if (keys.empty() || comp.less(keys.back(), k)) {
+            reload();
+            keys.push_back(k);
+            if (!directory.empty() && (keys.size() - 1) % DIRECTORY_STRIDE == 0) {
+                directory.push_back(k);
+            }
+            updateDirectory();
+            hints.last = keys.size() - 1;
+            return true;
+        }
+        std::size_t pos = bound<false>(k, hints);
+        if (comp.equal(keys[pos], k)) {
+            return false;
+        }
+        reload();
+        keys.insert(keys.begin() + pos, k);
+        directory.clear();
+        updateDirectory();
+        return true;
+    }
+
+    /**
+     * Adds the given keys, ordered by the comparator of this set.
+     */
+    template <typename Iter>
+    void insert(const Iter& a, const Iter& b) {
+        operation_hints hints;
+        for (Iter cur = a; cur != b; ++cur) {
+            insert(*cur, hints);
+        }
+    }
+
+    /**
+     * Adds all keys of the given set.
+     */
+    void insertAll(const SortedArray& other) {
+        if (other.empty()) {
+            return;
+        }
+        if (empty() || comp.less(keys.back(), other.keys.front())) {
+            reserve(keys.size() + other.size());
+            insert(other.begin(), other.end());
+            return;
+        }
+        std::vector<Key> merged;
+        merged.reserve(keys.size() + other.size());
+        std::set_union(begin(), end(), other.begin(), other.end(), std::back_inserter(merged),
+                [&](const Key& a, const Key& b) { return comp.less(a, b); });
+        clear();
+        keys.swap(merged);
+        updateDirectory();
+    }
+
+    /**
+     * Tests whether the given key is present.
+     */
+    bool contains(const Key& k) const {
+        operation_hints hints;
+        return contains(k, hints);
+    }
+
+    /**
+     * Tests whether the given key is present, utilising and updating the given hints.
+     */
+    bool contains(const Key& k, operation_hints& hints) const {
+        std::size_t pos = bound<false>(k, hints);
+        return pos < keys.size() && comp.equal(keys[pos], k);
+    }
+
+    /**
+     * Obtains an iterator referencing the given key, or the end if it is not present.
+     */
+    iterator find(const Key& k) const {
+        operation_hints hints;
+        std::size_t pos = bound<false>(k, hints);
+        return (pos < keys.size() && comp.equal(keys[pos], k)) ? begin() + pos : end();
+    }
+
+    /**
+     * Obtains an iterator referencing the first key not less than the given key.
+     */
+    iterator lower_bound(const Key& k) const {
+        operation_hints hints;
+        return lower_bound(k, hints);
+    }
+
+    /**
+     * Obtains an iterator referencing the first key not less than the given key,
+     * utilising and updating the given hints.
+     */
+    iterator lower_bound(const Key& k, operation_hints& hints) const {
+        return begin() + bound<false>(k, hints);
+    }
+
+    /**
+     * Obtains an iterator referencing the first key greater than the given key.
+     */
+    iterator upper_bound(const Key& k) const {
+        operation_hints hints;
+        return upper_bound(k, hints);
+    }
+
+    /**
+     * Obtains an iterator referencing the first key greater than the given key,
+     * utilising and updating the given hints.
+     */
+    iterator upper_bound(const Key& k, operation_hints& hints) const {
+        return begin() + bound<true>(k, hints);
+    }
+
+    /**
+     * Partitions this set into the given number of chunks of equal size.
+     */
+    std::vector<chunk> partition(std::size_t num) const {
+        std::vector<chunk> res;
+        if (empty()) {
+            return res;
+        }
+        num = std::max<std::size_t>(1, std::min(num, keys.size()));
+        res.reserve(num);
+        for (std::size_t i = 0; i < num; ++i) {
+            res.push_back(make_range(begin() + keys.size() * i / num, begin() + keys.size() * (i + 1) / num));
+        }
+        return res;
+    }
+
+    std::vector<chunk> getChunks(std::size_t num) const {
+        return partition(num);
+    }
+
+    /**
+     * Removes all keys, releasing the memory of this set.
+     */
+    void clear() {
+        release();
+        std::vector<Key>().swap(keys);
+        std::vector<Key>().swap(directory);
+    }
+
+    /**
+     * Spills the keys of this set, see SpillFile; the directory remains in memory.
+     * The set remains usable; its keys are paged in from the spill file as they
+     * are accessed.
+     */
+    void spill() {
+        if (spilled < 0 && !keys.empty()) {
+            spilled = SpillFile::instance().spill(
+                    reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(Key));
+        }
+    }
+
+    /**
+     * Exchanges the content of this set with the given set.
+     */
+    void swap(SortedArray& other) {
+        keys.swap(other.keys);
+        directory.swap(other.directory);
+        std::swap(spilled, other.spilled);
+    }
+
+    /**
+     * Obtains the number of bytes occupied by this set.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + (keys.capacity() + directory.capacity()) * sizeof(Key);
+    }
+
+private:
+    // the keys, in ascending order
+    std::vector<Key> keys;
+
+    // every DIRECTORY_STRIDE-th key, if the directory is kept
+    std::vector<Key> directory;
+
+    // the offset of the keys in the spill file, or -1 if they have not been spilled
+    int64_t spilled = -1;
+
+    Comparator comp;
+
+    // discards the spilled keys in the spill file before the array is released
+    void release() {
+        if (spilled >= 0) {
+            SpillFile::instance().restore(
+                    reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(Key), spilled);
+            spilled = -1;
+        }
+    }
+
+    // moves spilled keys to anonymous memory before the array is modified
+    void reload() {
+        if (spilled >= 0) {
+            std::vector<Key> copy;
+            copy.reserve(keys.capacity());
+            copy.assign(keys.begin(), keys.end());
+            release();
+            keys.swap(copy);
+        }
+    }
+
+    // builds the directory if it is to be kept, but is not
+    void updateDirectory() {
+        if (keys.size() < MIN_DIRECTORY_SIZE || !directory.empty()) {
+            return;
+        }
+        directory.reserve(keys.size() / DIRECTORY_STRIDE + 1);
+        for (std::size_t i = 0; i < keys.size(); i += DIRECTORY_STRIDE) {
+            directory.push_back(keys[i]);
+        }
+    }
+
+    // tests whether the given element precedes the position of the lower or upper bound of the given key
+    template <bool Upper>
+    bool precedes(const Key& element, const Key& k) const {
+        return Upper ? !comp.less(k, element) : comp.less(element, k);
+    }
+
+    // obtains the position of the lower or upper bound of the given key
+    template <bool Upper>
+    std::size_t bound(const Key& k, operation_hints& hints) const {
+        const std::size_t n = keys.size();
+        std::size_t lo = 0;
+        std::size_t hi = n;
+        std::size_t last = hints.last;
+
+        if (last < n && precedes<Upper>(keys[last], k)) {
+            // gallop forward from the last result
+            std::size_t step = 1;
+            lo = last + 1;
+            while (lo + step - 1 < n && precedes<Upper>(keys[lo + step - 1], k)) {
+                lo += step;
+                step *= 2;
+            }
+            hi = std::min(n, lo + step - 1);
+        } else if (last < n && (last == 0 || precedes<Upper>(keys[last - 1], k))) {
+            // the last result is the result again
+            return last;
+        } else {
+            // the result is before the last result, if any; find its block in the directory
+            if (last < n) {
+                hi = last - 1;
+            }
+            if (!directory.empty() && hi > DIRECTORY_STRIDE) {
+                auto pos = std::partition_point(directory.begin(), directory.end(),
+                        [&](const Key& cur) { return precedes<Upper>(cur, k); });
+                std::size_t block = static_cast<std::size_t>(pos - directory.begin());
+                if (block > 0) {
+                    lo = (block - 1) * DIRECTORY_STRIDE + 1;
+                }
+                hi = std::min(hi, block * DIRECTORY_STRIDE);
+            }
+        }
+
+        auto res = std::partition_point(keys.begin() + lo, keys.begin() + hi,
+                [&](const Key& cur) { return precedes<Upper>(cur, k); });
+        hints.last = static_cast<std::size_t>(res - keys.begin());
+        return hints.last;
+    }
+};
+
+}  // namespace souffle
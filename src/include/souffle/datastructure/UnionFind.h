@@ -18,6 +18,8 @@
 
 #include "souffle/datastructure/LambdaBTree.h"
 #include "souffle/datastructure/PiggyList.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -44,12 +46,34 @@ constexpr block_t rank_mask = (1ul << split_size) - 1;
 
 /**
  * Structure that emulates a Disjoint Set, i.e. a data structure that supports efficient union-find operations
+ *
+ * Besides the parent and rank of each node, the members of each set are linked in a cyclic list and the
+ * root of each set keeps the number of its members. Both are updated when two sets are joined, such that
+ * the sets can be enumerated and the number of pairs within sets is known without a rebuild. Finding the
+ * root of a node is lock-free; joining two sets locks the two roots involved.
  */
 class DisjointSet {
     template <typename TupleType>
     friend class EquivalenceRelation;
 
-    PiggyList<std::atomic<block_t>> a_blocks;
+    // the state of a node
+    struct Node {
+        // the parent and rank of the node
+        std::atomic<block_t> block;
+        // the next member of the set of the node, forming a cycle through all members
+        std::atomic<parent_t> next;
+        // the number of members of the set, only maintained for roots
+        std::atomic<size_t> size;
+    };
+
+    PiggyList<Node> a_nodes;
+
+    // the number of pairs of members of the same set, i.e. the sum of the squared set sizes
+    std::atomic<size_t> numPairs{0};
+
+    // the locks guarding the roots when sets are joined, selected by the index of the root
+    static constexpr size_t numRootLocks = 256;
+    std::array<SpinLock, numRootLocks> rootLocks;
 
 public:
     DisjointSet() = default;
@@ -68,17 +92,46 @@ public:
      * Return the number of elements in this disjoint set (not the number of pairs)
      */
     inline size_t size() {
-        auto sz = a_blocks.size();
+        auto sz = a_nodes.size();
         return sz;
     };
 
+    /**
+     * Return the number of pairs of nodes within the same set, i.e. the sum of the squared set sizes
+     */
+    inline size_t pairCount() const {
+        return numPairs.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the number of nodes in the set of the given root node
+     */
+    inline size_t setSize(parent_t root) const {
+        return a_nodes.get(root).size.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the next node of the set of the given node; following the nodes from any node of a set
+     * enumerates the whole set before returning to that node
+     */
+    inline parent_t nextMember(parent_t node) const {
+        return a_nodes.get(node).next.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Check whether the given node is the root of its set
+     */
+    inline bool isRoot(parent_t node) const {
+        return b2p(get(node)) == node;
+    }
+
     /**
      * Yield reference to the node by its node index
      * @param node node to be searched
      * @return the parent block of the specified node
      */
     inline std::atomic<block_t>& get(parent_t node) const {
-        auto& ret = a_blocks.get(node);
+        auto& ret = a_nodes.get(node).block;
         return ret;
     };
 
@@ -132,7 +185,8 @@ public:
      * Invalidates all iterators
      */
     void clear() {
-        a_blocks.clear();
+        a_nodes.clear();
+        numPairs.store(0);
     }
 
     /**
@@ -172,16 +226,40 @@ public:
                 std::swap(x, y);
                 std::swap(xrank, yrank);
             }
-            // join the trees together
-            // perhaps we can optimise the use of compare_exchange_strong here, as we're in a pessimistic loop
-            if (!updateRoot(x, xrank, y, yrank)) {
-                continue;
-            }
-            // make sure that the ranks are orderable
-            if (xrank == yrank) {
-                updateRoot(y, yrank, y, yrank + 1);
+
+            // lock both roots, in a fixed order to avoid dead-locks
+            SpinLock& xlock = rootLocks[x % numRootLocks];
+            SpinLock& ylock = rootLocks[y % numRootLocks];
+            SpinLock& first = (&xlock < &ylock) ? xlock : ylock;
+            SpinLock& second = (&xlock < &ylock) ? ylock : xlock;
+            first.lock();
+            if (&first != &second) second.lock();
+
+            // join the trees together, unless either root has been joined in the interim
+            bool joined = isRoot(y) && updateRoot(x, xrank, y, yrank);
+            if (joined) {
+                // make sure that the ranks are orderable
+                if (xrank == yrank) {
+                    updateRoot(y, yrank, y, yrank + 1);
+                }
+
+                // account for the pairs between the two sets
+                Node& xnode = a_nodes.get(x);
+                Node& ynode = a_nodes.get(y);
+                size_t xsize = xnode.size.load(std::memory_order_relaxed);
+                size_t ysize = ynode.size.load(std::memory_order_relaxed);
+                ynode.size.store(xsize + ysize, std::memory_order_release);
+                numPairs.fetch_add(2 * xsize * ysize, std::memory_order_acq_rel);
+
+                // splice the two cycles of members into one
+                parent_t xnext = xnode.next.load(std::memory_order_relaxed);
+                xnode.next.store(ynode.next.load(std::memory_order_relaxed), std::memory_order_release);
+                ynode.next.store(xnext, std::memory_order_release);
             }
-            break;
+
+            if (&first != &second) second.unlock();
+            first.unlock();
+            if (joined) break;
         }
     }
 
@@ -191,11 +269,16 @@ public:
      */
     inline block_t makeNode() {
         // make node and find out where we've added it
-        size_t nodeDetails = a_blocks.createNode();
+        size_t nodeDetails = a_nodes.createNode();
 
-        a_blocks.get(nodeDetails).store(pr2b(nodeDetails, 0));
+        // the node forms a set of its own, contributing the pair of itself
+        Node& node = a_nodes.get(nodeDetails);
+        node.next.store(nodeDetails, std::memory_order_relaxed);
+        node.size.store(1, std::memory_order_relaxed);
+        node.block.store(pr2b(nodeDetails, 0));
+        numPairs.fetch_add(1, std::memory_order_acq_rel);
 
-        return a_blocks.get(nodeDetails).load();
+        return node.block.load();
     };
 
     /**
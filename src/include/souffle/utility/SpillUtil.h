@@ -0,0 +1,184 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SpillUtil.h
+ *
+ * Utilities for moving memory of the evaluation into files under a memory budget.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace souffle {
+
+/**
+ * Obtains the number of bytes of memory resident for this process. Where the current
+ * resident set size is not available, the peak resident set size is reported.
+ */
+inline std::size_t getResidentMemory() {
+#if defined(__linux__)
+    std::size_t size = 0;
+    std::size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm >> size >> resident) {
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#elif !defined(_WIN32)
+    struct rusage ru {};
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return static_cast<std::size_t>(ru.ru_maxrss);
+#else
+    return static_cast<std::size_t>(ru.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * A file receiving memory spilled by this process.
+ *
+ * Spilling a region of memory writes the whole pages within the region into the
+ * file and maps them, at the same addresses, from the file instead of anonymous
+ * memory: pointers into the region remain valid, while the operating system may
+ * page the region out to the file and in on access, rather than keeping it
+ * resident. Regions are spilled in place, without being copied into memory
+ * managed by the file, hence the memory of a region need not be obtained in any
+ * particular way; the partial pages at its boundaries simply remain in memory.
+ *
+ * The file is created, and immediately unlinked, in the directory given by the
+ * TMPDIR environment variable, or /tmp, on the first spill; it is closed when the
+ * process exits. Spilling is not supported on Windows.
+ */
+class SpillFile {
+public:
+    /**
+     * Obtains the file shared by all spilled memory of this process.
+     */
+    static SpillFile& instance() {
+        // never destructed, as spilled memory may be restored by destructors of static objects
+        static auto* file = new SpillFile();
+        return *file;
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    /**
+     * Spills the whole pages within the given region. Returns the offset of the
+     * pages in the file, or -1 if there are none or they could not be spilled,
+     * in which case they remain in memory unchanged.
+     */
+    int64_t spill(char* begin, std::size_t size) {
+#ifndef _WIN32
+        auto pages = getPages(begin, size);
+        if (pages.second == 0) {
+            return -1;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (!open()) {
+            return -1;
+        }
+        int64_t offset = end;
+        for (std::size_t done = 0; done < pages.second;) {
+            auto res = pwrite(fd, pages.first + done, pages.second - done, offset + done);
+            if (res <= 0) {
+                return -1;
+            }
+            done += static_cast<std::size_t>(res);
+        }
+        // the mapping of the file replaces the anonymous memory holding the same content
+        if (mmap(pages.first, pages.second, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, offset) ==
+                MAP_FAILED) {
+            return -1;
+        }
+        end += pages.second;
+        return offset;
+#else
+        (void)begin;
+        (void)size;
+        return -1;
+#endif
+    }
+
+    /**
+     * Returns the pages of the given region, spilled to the given offset, to zeroed
+     * anonymous memory, such that the region may be released to its allocator.
+     */
+    void restore(char* begin, std::size_t size, int64_t offset) {
+#ifndef _WIN32
+        auto pages = getPages(begin, size);
+        mmap(pages.first, pages.second, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+                0);
+#ifdef FALLOC_FL_PUNCH_HOLE
+        std::lock_guard<std::mutex> guard(lock);
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, pages.second);
+#else
+        (void)offset;
+#endif
+#else
+        (void)begin;
+        (void)size;
+        (void)offset;
+#endif
+    }
+
+private:
+    SpillFile() = default;
+
+#ifndef _WIN32
+    // creates the file unless it exists
+    bool open() {
+        if (fd < 0) {
+            const char* dir = std::getenv("TMPDIR");
+            std::string templ = std::string(dir != nullptr ? dir : "/tmp") + "/souffle-spill-XXXXXX";
+            fd = mkstemp(&templ[0]);
+            if (fd >= 0) {
+                unlink(templ.c_str());
+            }
+        }
+        return fd >= 0;
+    }
+
+    // obtains the whole pages within the given region
+    static std::pair<char*, std::size_t> getPages(char* begin, std::size_t size) {
+        static const auto pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto first = (reinterpret_cast<std::uintptr_t>(begin) + pageSize - 1) / pageSize * pageSize;
+        auto last = (reinterpret_cast<std::uintptr_t>(begin) + size) / pageSize * pageSize;
+        if (last <= first) {
+            return {nullptr, 0};
+        }
+        return {reinterpret_cast<char*>(first), last - first};
+    }
+
+    std::mutex lock;
+    int fd = -1;
+    int64_t end = 0;
+#endif
+};
+
+}  // namespace souffle
@@ -18,11 +18,13 @@
 #include "souffle/CompiledTuple.h"
 #include "souffle/RamTypes.h"
 #include "souffle/datastructure/BTree.h"
+#include "souffle/datastructure/SortedArray.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <ostream>
+#include <utility>
 #include <vector>
 
 namespace souffle {
@@ -31,45 +33,170 @@ namespace souffle {
 template <std::size_t Arity>
 using comparator = typename index_utils::get_full_index<Arity>::type::comparator;
 
+// The search strategy to be used for B-tree nodes, comparing the columns of an index.
+// Without vector instructions the SIMD search degrades to a strided scalar count,
+// which is slower than a binary search; the interpreter is not built for the host.
+template <typename Index>
+struct search_strategy;
+
+template <unsigned... Columns>
+struct search_strategy<index<Columns...>> {
+#if defined(__AVX2__) || defined(__SSE4_2__)
+    using type = detail::simd_search<Columns...>;
+#else
+    using type = detail::binary_search;
+#endif
+};
+
+template <std::size_t Arity>
+using strategy = typename search_strategy<typename index_utils::get_full_index<Arity>::type>::type;
+
 // Node type
 template <std::size_t Arity>
 using t_tuple = typename souffle::Tuple<RamDomain, Arity>;
 
+// The B-tree type, searching nodes through SIMD instructions for small arities if available; counted
+// B-trees cache the sizes of their sub-trees
+template <std::size_t Arity, bool Counted = false>
+using t_btree = btree_set<t_tuple<Arity>, comparator<Arity>, std::allocator<t_tuple<Arity>>, 256,
+        strategy<Arity>, comparator<Arity>, detail::updater<t_tuple<Arity>>, Counted>;
+
+// The sorted array type holding the content of B-trees that are only read
+template <std::size_t Arity>
+using t_sorted_array = SortedArray<t_tuple<Arity>, comparator<Arity>>;
+
 /**
- * A index adapter for B-trees, using the generic index adapter.
+ * An index adapter for sorted arrays, holding the content of a frozen B-tree index.
  */
 template <std::size_t Arity>
-class BTreeIndex : public GenericIndex<btree_set<t_tuple<Arity>, comparator<Arity>>> {
+class FrozenIndex : public GenericIndex<t_sorted_array<Arity>> {
+    using Hints = typename t_sorted_array<Arity>::operation_hints;
+
 public:
-    using GenericIndex<btree_set<t_tuple<Arity>, comparator<Arity>>>::GenericIndex;
+    template <bool Counted>
+    FrozenIndex(Order order, const t_btree<Arity, Counted>& src)
+            : GenericIndex<t_sorted_array<Arity>>(std::move(order)) {
+        this->data.reserve(src.size());
+        this->data.insert(src.begin(), src.end());
+    }
+
+    void spill() override {
+        this->data.spill();
+    }
+
+protected:
+    // obtains the last element within the given bounds as the element before their end
+    bool boundary(const TupleRef& low, const TupleRef& high, bool last, Hints& hints,
+            RamDomain* res) const override {
+        auto range = this->bounds(low, high, hints);
+        if (range.empty()) {
+            return false;
+        }
+        this->decode(last ? *(range.end() - 1) : *range.begin(), res);
+        return true;
+    }
 };
 
-Own<InterpreterIndex> createBTreeIndex(const Order& order) {
+/**
+ * A index adapter for B-trees, using the generic index adapter. Counted B-tree
+ * indexes count the elements of a range in logarithmic time.
+ */
+template <std::size_t Arity, bool Counted>
+class BTreeIndex : public GenericIndex<t_btree<Arity, Counted>> {
+    using Hints = typename t_btree<Arity, Counted>::operation_hints;
+
+public:
+    using GenericIndex<t_btree<Arity, Counted>>::GenericIndex;
+
+    void spill() override {
+        this->data.spill();
+    }
+
+    Own<InterpreterIndex> freeze() const override {
+        return mk<FrozenIndex<Arity>>(this->order, this->data);
+    }
+
+protected:
+    // counts the elements within the given bounds through the difference of their ranks if counted
+    std::size_t count(const TupleRef& low, const TupleRef& high, Hints& hints) const override {
+        if constexpr (!Counted) {
+            return GenericIndex<t_btree<Arity, Counted>>::count(low, high, hints);
+        } else {
+            auto range = this->bounds(low, high, hints);
+            std::size_t begin = this->data.rank(range.begin());
+            std::size_t end = this->data.rank(range.end());
+            return (begin < end) ? end - begin : 0;
+        }
+    }
+
+    // obtains the last element within the given bounds as the predecessor of their end
+    bool boundary(const TupleRef& low, const TupleRef& high, bool last, Hints& hints,
+            RamDomain* res) const override {
+        auto range = this->bounds(low, high, hints);
+        if (range.empty()) {
+            return false;
+        }
+        this->decode(last ? *this->data.predecessor(range.end()) : *range.begin(), res);
+        return true;
+    }
+};
+
+namespace {
+
+template <bool Counted>
+Own<InterpreterIndex> createBTreeIndexOfArity(const Order& order) {
     switch (order.size()) {
         case 0: return mk<NullaryIndex>();
-        case 1: return mk<BTreeIndex<1>>(order);
-        case 2: return mk<BTreeIndex<2>>(order);
-        case 3: return mk<BTreeIndex<3>>(order);
-        case 4: return mk<BTreeIndex<4>>(order);
-        case 5: return mk<BTreeIndex<5>>(order);
-        case 6: return mk<BTreeIndex<6>>(order);
-        case 7: return mk<BTreeIndex<7>>(order);
-        case 8: return mk<BTreeIndex<8>>(order);
-        case 9: return mk<BTreeIndex<9>>(order);
-        case 10: return mk<BTreeIndex<10>>(order);
-        case 11: return mk<BTreeIndex<11>>(order);
-        case 12: return mk<BTreeIndex<12>>(order);
-        case 13: return mk<BTreeIndex<13>>(order);
-        case 14: return mk<BTreeIndex<14>>(order);
-        case 15: return mk<BTreeIndex<15>>(order);
-        case 16: return mk<BTreeIndex<16>>(order);
-        case 17: return mk<BTreeIndex<17>>(order);
-        case 18: return mk<BTreeIndex<18>>(order);
-        case 19: return mk<BTreeIndex<19>>(order);
-        case 20: return mk<BTreeIndex<20>>(order);
+        case 1: return mk<BTreeIndex<1, Counted>>(order);
+        case 2: return mk<BTreeIndex<2, Counted>>(order);
+        case 3: return mk<BTreeIndex<3, Counted>>(order);
+        case 4: return mk<BTreeIndex<4, Counted>>(order);
+        case 5: return mk<BTreeIndex<5, Counted>>(order);
+        case 6: return mk<BTreeIndex<6, Counted>>(order);
+        case 7: return mk<BTreeIndex<7, Counted>>(order);
+        case 8: return mk<BTreeIndex<8, Counted>>(order);
+        case 9: return mk<BTreeIndex<9, Counted>>(order);
+        case 10: return mk<BTreeIndex<10, Counted>>(order);
+        case 11: return mk<BTreeIndex<11, Counted>>(order);
+        case 12: return mk<BTreeIndex<12, Counted>>(order);
+        case 13: return mk<BTreeIndex<13, Counted>>(order);
+        case 14: return mk<BTreeIndex<14, Counted>>(order);
+        case 15: return mk<BTreeIndex<15, Counted>>(order);
+        case 16: return mk<BTreeIndex<16, Counted>>(order);
+        case 17: return mk<BTreeIndex<17, Counted>>(order);
+        case 18: return mk<BTreeIndex<18, Counted>>(order);
+        case 19: return mk<BTreeIndex<19, Counted>>(order);
+        case 20: return mk<BTreeIndex<20, Counted>>(order);
+    }
+
+    // Larger arities are stored inline in padded entries of the next supported arity
+    if (order.size() <= 24) {
+        return mk<BTreeIndex<24, Counted>>(order);
+    }
+    if (order.size() <= 32) {
+        return mk<BTreeIndex<32, Counted>>(order);
+    }
+    if (order.size() <= 40) {
+        return mk<BTreeIndex<40, Counted>>(order);
+    }
+    if (order.size() <= 48) {
+        return mk<BTreeIndex<48, Counted>>(order);
+    }
+    if (order.size() <= 64) {
+        return mk<BTreeIndex<64, Counted>>(order);
     }
 
     fatal("Requested arity not yet supported. Feel free to add it.");
 }
 
+}  // namespace
+
+Own<InterpreterIndex> createBTreeIndex(const Order& order) {
+    return createBTreeIndexOfArity<false>(order);
+}
+
+Own<InterpreterIndex> createCountedBTreeIndex(const Order& order) {
+    return createBTreeIndexOfArity<true>(order);
+}
+
 }  // namespace souffle
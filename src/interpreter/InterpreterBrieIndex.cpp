@@ -58,6 +58,17 @@ Own<InterpreterIndex> createBrieIndex(const Order& order) {
         case 20: return mk<BrieIndex<20>>(order);
     }
 
+    // Larger arities are stored inline in padded entries of the next supported arity
+    if (order.size() <= 24) {
+        return mk<BrieIndex<24>>(order);
+    }
+    if (order.size() <= 32) {
+        return mk<BrieIndex<32>>(order);
+    }
+    if (order.size() <= 40) {
+        return mk<BrieIndex<40>>(order);
+    }
+
     fatal("Requested arity not yet supported. Feel free to add it.");
 }
 
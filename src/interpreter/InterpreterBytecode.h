@@ -0,0 +1,275 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InterpreterBytecode.h
+ *
+ * Declares the flat, register-based bytecode the interpreter can execute
+ * instead of walking the InterpreterNode tree.
+ *
+ * An operation tree (e.g. the body of a query) is lowered by the NodeGenerator
+ * into a linear array of instructions. Values live in virtual registers,
+ * loops are expressed with stream slots and jumps, and conditions are compiled
+ * into conditional branches. Sub-trees without a bytecode equivalent are kept
+ * as ordinary interpreter nodes and invoked through fallback instructions.
+ ***********************************************************************/
+
+#pragma once
+
+#include "interpreter/InterpreterNode.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Instruction set of the bytecode. The order of the enumerators must match the
+ * dispatch table in InterpreterEngine::executeBytecode.
+ */
+enum BytecodeOpcode : uint8_t {
+    /** reg[a] = value */
+    BC_Constant,
+    /** reg[a] = ctxt[b][c] */
+    BC_TupleElement,
+    /** reg[a] = execute(node) */
+    BC_Eval,
+    /** reg[a] = reg[b] */
+    BC_Move,
+    /** reg[a] = reg[b] + reg[c] (two's complement, signed and unsigned alike) */
+    BC_Add,
+    /** reg[a] = reg[b] - reg[c] */
+    BC_Sub,
+    /** reg[a] = reg[b] * reg[c] */
+    BC_Mul,
+    /** reg[a] = reg[b] & reg[c] */
+    BC_BitAnd,
+    /** reg[a] = reg[b] | reg[c] */
+    BC_BitOr,
+    /** reg[a] = reg[b] ^ reg[c] */
+    BC_BitXor,
+    /** reg[a] = -reg[b] */
+    BC_Neg,
+    /** reg[a] = float(reg[b]) + float(reg[c]) */
+    BC_FAdd,
+    /** reg[a] = float(reg[b]) - float(reg[c]) */
+    BC_FSub,
+    /** reg[a] = float(reg[b]) * float(reg[c]) */
+    BC_FMul,
+    /** unconditional jump */
+    BC_Jump,
+    /** conditional jumps comparing reg[a] and reg[b] */
+    BC_Eq,
+    BC_Ne,
+    BC_Lt,
+    BC_Le,
+    BC_Gt,
+    BC_Ge,
+    BC_ULt,
+    BC_ULe,
+    BC_UGt,
+    BC_UGe,
+    BC_FEq,
+    BC_FNe,
+    BC_FLt,
+    BC_FLe,
+    BC_FGt,
+    BC_FGe,
+    /** conditional jump on execute(node) */
+    BC_Test,
+    /** conditional jump on the existence of tuple reg[a..a+c) in view b, consulting the filter of relation */
+    BC_ExistsTotal,
+    /** conditional jump on a tuple in view b between reg[a..a+c) and reg[a+c..a+2c), see BC_ExistsTotal */
+    BC_ExistsRange,
+    /** stream a = full scan of relation */
+    BC_Scan,
+    /** stream a = range of view b between reg[c..c+d) and reg[c+d..c+2d) */
+    BC_Range,
+    /** if stream a is exhausted jump, otherwise ctxt[b] = current element of stream a */
+    BC_Load,
+    /** advance stream a and jump */
+    BC_Next,
+    /** unpack record reg[a] of arity c into ctxt[b]; jump if it is nil */
+    BC_Unpack,
+    /** insert reg[a..) into relation */
+    BC_Insert,
+    /** execute(node) as a nested operation; jump if it requests a break */
+    BC_Exec,
+    /** terminate the program, returning value */
+    BC_Return
+};
+
+/**
+ * A single bytecode instruction. The meaning of the operands depends on the opcode.
+ */
+struct BytecodeInstruction {
+    BytecodeInstruction(BytecodeOpcode opcode) : opcode(opcode) {}
+
+    BytecodeOpcode opcode;
+    /** conditional jumps are taken on a true (instead of a false) outcome */
+    bool jumpIfTrue = false;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    uint32_t d = 0;
+    /** jump target */
+    uint32_t target = 0;
+    /** immediate value */
+    RamDomain value = 0;
+    /** tree node evaluated by fallback instructions */
+    const InterpreterNode* node = nullptr;
+    /** relation scanned or inserted into, or whose Bloom filter an existence check consults */
+    InterpreterNode::RelationHandle* relation = nullptr;
+};
+
+/**
+ * @class InterpreterBytecode
+ * @brief Interpreter node holding an operation that has been lowered into bytecode.
+ *
+ * The node owns the tree nodes used by fallback instructions.
+ */
+class InterpreterBytecode : public InterpreterNode {
+public:
+    InterpreterBytecode(enum InterpreterNodeType ty, const ram::Node* sdw,
+            std::vector<BytecodeInstruction> code, VecOwn<InterpreterNode> fallbacks, size_t numRegisters,
+            size_t numStreams)
+            : InterpreterNode(ty, sdw), code(std::move(code)), fallbacks(std::move(fallbacks)),
+              numRegisters(numRegisters), numStreams(numStreams) {}
+
+    /** @brief get instructions */
+    const std::vector<BytecodeInstruction>& getCode() const {
+        return code;
+    }
+
+    /** @brief get number of registers used by the program */
+    size_t getNumRegisters() const {
+        return numRegisters;
+    }
+
+    /** @brief get number of stream slots used by the program */
+    size_t getNumStreams() const {
+        return numStreams;
+    }
+
+protected:
+    const std::vector<BytecodeInstruction> code;
+    const VecOwn<InterpreterNode> fallbacks;
+    const size_t numRegisters;
+    const size_t numStreams;
+};
+
+/**
+ * @class BytecodeBuilder
+ * @brief Incrementally assembles a bytecode program.
+ *
+ * Jump targets are emitted as labels and resolved when the program is built.
+ * Constants are hoisted into a prologue that runs once per program invocation.
+ */
+class BytecodeBuilder {
+public:
+    /** @brief Append an instruction */
+    BytecodeInstruction& emit(BytecodeOpcode opcode) {
+        code.emplace_back(opcode);
+        return code.back();
+    }
+
+    /** @brief Append a jump (or a conditional jump) to the given label */
+    BytecodeInstruction& emitJump(BytecodeOpcode opcode, size_t label, bool jumpIfTrue = false) {
+        auto& inst = emit(opcode);
+        inst.target = label;
+        inst.jumpIfTrue = jumpIfTrue;
+        return inst;
+    }
+
+    /** @brief Load a constant into a register once per invocation */
+    void emitConstant(size_t reg, RamDomain value) {
+        prologue.emplace_back(BC_Constant);
+        prologue.back().a = reg;
+        prologue.back().value = value;
+    }
+
+    /** @brief Create a new label */
+    size_t newLabel() {
+        labels.push_back(0);
+        return labels.size() - 1;
+    }
+
+    /** @brief Bind a label to the position of the next instruction */
+    void placeLabel(size_t label) {
+        labels[label] = code.size();
+    }
+
+    /** @brief Allocate consecutive registers; return the first one */
+    size_t newRegisters(size_t count = 1) {
+        size_t reg = numRegisters;
+        numRegisters += count;
+        return reg;
+    }
+
+    /** @brief Allocate a stream slot */
+    size_t newStream() {
+        return numStreams++;
+    }
+
+    /** @brief Take ownership of a tree node used by a fallback instruction */
+    const InterpreterNode* addFallback(Own<InterpreterNode> node) {
+        fallbacks.push_back(std::move(node));
+        return fallbacks.back().get();
+    }
+
+    /** @brief Resolve labels and create the interpreter node */
+    Own<InterpreterBytecode> build(enum InterpreterNodeType ty, const ram::Node* sdw) {
+        std::vector<BytecodeInstruction> program(prologue);
+        for (auto inst : code) {
+            if (isJump(inst.opcode)) {
+                inst.target = labels[inst.target] + prologue.size();
+            }
+            program.push_back(inst);
+        }
+        return mk<InterpreterBytecode>(
+                ty, sdw, std::move(program), std::move(fallbacks), numRegisters, numStreams);
+    }
+
+private:
+    static bool isJump(BytecodeOpcode opcode) {
+        switch (opcode) {
+            case BC_Constant:
+            case BC_TupleElement:
+            case BC_Eval:
+            case BC_Move:
+            case BC_Add:
+            case BC_Sub:
+            case BC_Mul:
+            case BC_BitAnd:
+            case BC_BitOr:
+            case BC_BitXor:
+            case BC_Neg:
+            case BC_FAdd:
+            case BC_FSub:
+            case BC_FMul:
+            case BC_Scan:
+            case BC_Range:
+            case BC_Insert:
+            case BC_Return: return false;
+            default: return true;
+        }
+    }
+
+    std::vector<BytecodeInstruction> prologue;
+    std::vector<BytecodeInstruction> code;
+    std::vector<size_t> labels;
+    VecOwn<InterpreterNode> fallbacks;
+    size_t numRegisters = 0;
+    size_t numStreams = 0;
+};
+
+}  // namespace souffle
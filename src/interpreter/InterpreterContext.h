@@ -19,14 +19,156 @@
 #include "interpreter/InterpreterIndex.h"
 #include "interpreter/InterpreterRelation.h"
 #include "souffle/RamTypes.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <deque>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace souffle {
 
+/**
+ * @class InterpreterContextArena
+ * @brief Memory of an evaluation context that is retained after the context ends.
+ *
+ * An arena keeps the index views and temporary tuples of a context, such that the
+ * next context using the arena resets them instead of allocating them again. Views
+ * are kept by the identifier of their index, which is never reused, and must be
+ * dropped before their index is destroyed.
+ */
+class InterpreterContextArena {
+public:
+    /** @brief Return a view on the index, reusing a released view of the same index if possible */
+    Own<IndexView> acquireView(const InterpreterIndex& index) {
+        auto& released = views[index.getId()];
+        if (released.empty()) {
+            return index.createView();
+        }
+        Own<IndexView> view = std::move(released.back());
+        released.pop_back();
+        // the index may have changed since the view was released
+        view->reset();
+        return view;
+    }
+
+    /** @brief Keep a view on the index of the given identifier that is no longer used for later reuse */
+    void releaseView(size_t indexId, Own<IndexView> view) {
+        views[indexId].push_back(std::move(view));
+    }
+
+    /** @brief Drop the released views on the indexes of the given identifiers */
+    void dropViews(const std::vector<size_t>& indexIds) {
+        for (size_t indexId : indexIds) {
+            views.erase(indexId);
+        }
+    }
+
+    /** @brief Drop the released views on the given retired indexes not dropped by an earlier call */
+    void dropRetiredViews(const std::vector<size_t>& retired) {
+        for (; numRetired < retired.size(); ++numRetired) {
+            views.erase(retired[numRetired]);
+        }
+    }
+
+    /** @brief Allocate a temporary tuple, valid until releaseTuples is called */
+    RamDomain* allocateTuple(size_t size) {
+        while (curBlock < blocks.size() && blockOffset + size > blocks[curBlock].size) {
+            ++curBlock;
+            blockOffset = 0;
+        }
+        if (curBlock == blocks.size()) {
+            size_t blockSize = std::max(size, BLOCK_SIZE);
+            blocks.push_back({Own<RamDomain[]>(new RamDomain[blockSize]), blockSize});
+            blockOffset = 0;
+        }
+        RamDomain* tuple = blocks[curBlock].data.get() + blockOffset;
+        blockOffset += size;
+        return tuple;
+    }
+
+    /** @brief Release all temporary tuples, keeping their blocks for later allocations */
+    void releaseTuples() {
+        curBlock = 0;
+        blockOffset = 0;
+    }
+
+    /** @brief Storage of the run-time values of a context */
+    std::vector<const RamDomain*>& getData() {
+        return data;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 1024;
+
+    struct Block {
+        Own<RamDomain[]> data;
+        size_t size;
+    };
+
+    /** released views, by the identifier of their index */
+    std::unordered_map<size_t, VecOwn<IndexView>> views;
+    /** number of retired indexes whose views have been dropped */
+    size_t numRetired = 0;
+    /** blocks of temporary tuples */
+    std::vector<Block> blocks;
+    /** block and offset of the next temporary tuple */
+    size_t curBlock = 0;
+    size_t blockOffset = 0;
+    /** run-time values */
+    std::vector<const RamDomain*> data;
+};
+
+/**
+ * @class InterpreterContextArenas
+ * @brief The arenas of an engine, each used by at most one context at a time.
+ *
+ * A context entering a parallel region takes an arena that is not in use, so that
+ * every thread effectively works in its own arena without any per-thread setup.
+ */
+class InterpreterContextArenas {
+public:
+    /** @brief Take an arena that is not in use */
+    Own<InterpreterContextArena> acquire() {
+        auto lease = access.acquire();
+        if (available.empty()) {
+            return mk<InterpreterContextArena>();
+        }
+        Own<InterpreterContextArena> arena = std::move(available.back());
+        available.pop_back();
+        return arena;
+    }
+
+    /** @brief Return an arena once its context ends */
+    void release(Own<InterpreterContextArena> arena) {
+        auto lease = access.acquire();
+        arena->dropRetiredViews(retired);
+        available.push_back(std::move(arena));
+    }
+
+    /**
+     * @brief Drop the views on the indexes of the given identifiers, which are about to be destroyed.
+     * Arenas in use drop them once they are returned; their contexts must not use these views.
+     */
+    void retire(const std::vector<size_t>& indexIds) {
+        auto lease = access.acquire();
+        retired.insert(retired.end(), indexIds.begin(), indexIds.end());
+        for (auto& arena : available) {
+            arena->dropRetiredViews(retired);
+        }
+    }
+
+private:
+    Lock access;
+    VecOwn<InterpreterContextArena> available;
+    /** identifiers of the indexes whose views are dropped */
+    std::vector<size_t> retired;
+};
+
 /**
  * Evaluation context for Interpreter operations
  */
@@ -43,14 +185,48 @@ class InterpreterContext {
     VecOwn<RamDomain[]> allocatedDataContainer;
     /** @brief Views */
     VecOwn<IndexView> views;
+    /** @brief Identifiers of the indexes of the views */
+    std::vector<size_t> viewIndexIds;
+    /** @brief Source of arenas, passed on to nested contexts */
+    InterpreterContextArenas* arenas = nullptr;
+    /** @brief Arena holding views and temporary tuples; none for standalone contexts */
+    Own<InterpreterContextArena> arena;
+    /** @brief Stream slots of bytecode programs, handed out in stack order */
+    std::deque<Stream> streams;
+    /** @brief Number of stream slots in use */
+    size_t streamsInUse = 0;
 
 public:
     InterpreterContext(size_t size = 0) : data(size) {}
 
+    /** This constructor creates a context drawing its memory from an arena */
+    explicit InterpreterContext(InterpreterContextArenas& arenas) : arenas(&arenas), arena(arenas.acquire()) {
+        data.swap(arena->getData());
+    }
+
     /** This constructor is used when program enter a new scope.
-     * Only Subroutine value needs to be copied */
-    InterpreterContext(InterpreterContext& ctxt) : returnValues(ctxt.returnValues), args(ctxt.args) {}
-    virtual ~InterpreterContext() = default;
+     * Only Subroutine value and the source of arenas need to be copied */
+    InterpreterContext(InterpreterContext& ctxt)
+            : returnValues(ctxt.returnValues), args(ctxt.args), arenas(ctxt.arenas) {
+        if (arenas != nullptr) {
+            arena = arenas->acquire();
+            data.swap(arena->getData());
+        }
+    }
+
+    virtual ~InterpreterContext() {
+        if (arena == nullptr) {
+            return;
+        }
+        for (size_t i = 0; i < views.size(); ++i) {
+            if (views[i] != nullptr) {
+                arena->releaseView(viewIndexIds[i], std::move(views[i]));
+            }
+        }
+        arena->releaseTuples();
+        data.swap(arena->getData());
+        arenas->release(std::move(arena));
+    }
 
     const RamDomain*& operator[](size_t index) {
         if (index >= data.size()) {
@@ -66,6 +242,9 @@ public:
     /** @brief Allocate a tuple.
      *  allocatedDataContainer has the ownership of those tuples. */
     RamDomain* allocateNewTuple(size_t size) {
+        if (arena != nullptr) {
+            return arena->allocateTuple(size);
+        }
         Own<RamDomain[]> newTuple(new RamDomain[size]);
         allocatedDataContainer.push_back(std::move(newTuple));
 
@@ -105,13 +284,39 @@ public:
         return (*args)[i];
     }
 
-    /** @brief Create a view in the environment */
+    /** @brief Create a view in the environment; a view created before in the arena is reused */
     void createView(const InterpreterRelation& rel, size_t indexPos, size_t viewPos) {
-        ViewPtr view;
         if (views.size() < viewPos + 1) {
             views.resize(viewPos + 1);
+            viewIndexIds.resize(viewPos + 1);
+        }
+        const InterpreterIndex& index = rel.getIndex(indexPos);
+        if (arena == nullptr) {
+            views[viewPos] = index.createView();
+            viewIndexIds[viewPos] = index.getId();
+            return;
+        }
+        if (views[viewPos] != nullptr) {
+            if (viewIndexIds[viewPos] == index.getId()) {
+                views[viewPos]->reset();
+                return;
+            }
+            arena->releaseView(viewIndexIds[viewPos], std::move(views[viewPos]));
+        }
+        views[viewPos] = arena->acquireView(index);
+        viewIndexIds[viewPos] = index.getId();
+    }
+
+    /** @brief Drop the views on the indexes of the given identifiers, including those kept by the arena */
+    void dropViews(const std::vector<size_t>& indexIds) {
+        for (size_t i = 0; i < views.size(); ++i) {
+            if (views[i] != nullptr && contains(indexIds, viewIndexIds[i])) {
+                views[i] = nullptr;
+            }
+        }
+        if (arena != nullptr) {
+            arena->dropViews(indexIds);
         }
-        views[viewPos] = rel.getView(indexPos);
     }
 
     /** @brief Return a view */
@@ -119,6 +324,30 @@ public:
         assert(id < views.size());
         return views[id];
     }
+
+    /** @brief Reserve stream slots for a bytecode program; return the position of the first slot */
+    size_t allocateStreams(size_t count) {
+        size_t base = streamsInUse;
+        streamsInUse += count;
+        while (streams.size() < streamsInUse) {
+            streams.emplace_back();
+        }
+        return base;
+    }
+
+    /** @brief Release all stream slots from the given position onwards */
+    void releaseStreams(size_t base) {
+        for (size_t i = base; i < streamsInUse; ++i) {
+            streams[i] = Stream();
+        }
+        streamsInUse = base;
+    }
+
+    /** @brief Return a stream slot */
+    Stream& getStream(size_t pos) {
+        assert(pos < streamsInUse);
+        return streams[pos];
+    }
 };
 
 }  // end of namespace souffle
@@ -17,6 +17,7 @@
 #include "AggregateOp.h"
 #include "FunctorOps.h"
 #include "Global.h"
+#include "interpreter/InterpreterBytecode.h"
 #include "interpreter/InterpreterContext.h"
 #include "interpreter/InterpreterGenerator.h"
 #include "interpreter/InterpreterIndex.h"
@@ -39,15 +40,20 @@
 #include "ram/Extend.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/IO.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexMinMax.h"
 #include "ram/IndexScan.h"
 #include "ram/IntrinsicOperator.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/PackRecord.h"
@@ -66,6 +72,8 @@
 #include "ram/RelationSize.h"
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -78,6 +86,7 @@
 #include "ram/UserDefinedOperator.h"
 #include "ram/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/PatternCache.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SignalHandler.h"
@@ -91,23 +100,24 @@
 #include "souffle/utility/EvaluatorUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/SpillUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <iostream>
 #include <iterator>
 #include <map>
 #include <memory>
-#include <regex>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <dlfcn.h>
@@ -137,9 +147,238 @@ using namespace ram;
 
 #define FFI_Symbol ffi_type_pointer
 
+/**
+ * Call interface of a user-defined functor, prepared once for all of its calls.
+ */
+struct InterpreterFunctorCall {
+    /** function provided by a loaded library; null if there is none */
+    void (*function)() = nullptr;
+    /** argument types; the cif refers to them */
+    std::vector<ffi_type*> argTypes;
+    ffi_cif cif;
+    /** why the call interface could not be prepared, reported when the functor is called */
+    std::string error;
+};
+
 namespace {
 constexpr RamDomain RAM_BIT_SHIFT_MASK = RAM_DOMAIN_SIZE - 1;
+
+/**
+ * Adds its own lifetime to the execution time of a query, if one is given.
+ */
+template <typename QueryTime>
+class QueryTimer {
+public:
+    QueryTimer(QueryTime* time) : time(time) {
+        if (time != nullptr) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~QueryTimer() {
+        if (time != nullptr) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            time->nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            ++time->executions;
+        }
+    }
+
+private:
+    QueryTime* time;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Call func with the given arity as a compile-time constant. Arities without
+ * specialised indexes are passed as 0 and must be handled at runtime.
+ */
+template <typename Func>
+auto dispatchArity(size_t arity, Func&& func) {
+    switch (arity) {
+        case 1: return func(std::integral_constant<size_t, 1>());
+        case 2: return func(std::integral_constant<size_t, 2>());
+        case 3: return func(std::integral_constant<size_t, 3>());
+        case 4: return func(std::integral_constant<size_t, 4>());
+        case 5: return func(std::integral_constant<size_t, 5>());
+        case 6: return func(std::integral_constant<size_t, 6>());
+        case 7: return func(std::integral_constant<size_t, 7>());
+        case 8: return func(std::integral_constant<size_t, 8>());
+        case 9: return func(std::integral_constant<size_t, 9>());
+        case 10: return func(std::integral_constant<size_t, 10>());
+        case 11: return func(std::integral_constant<size_t, 11>());
+        case 12: return func(std::integral_constant<size_t, 12>());
+        case 13: return func(std::integral_constant<size_t, 13>());
+        case 14: return func(std::integral_constant<size_t, 14>());
+        case 15: return func(std::integral_constant<size_t, 15>());
+        case 16: return func(std::integral_constant<size_t, 16>());
+        case 17: return func(std::integral_constant<size_t, 17>());
+        case 18: return func(std::integral_constant<size_t, 18>());
+        case 19: return func(std::integral_constant<size_t, 19>());
+        case 20: return func(std::integral_constant<size_t, 20>());
+        default: return func(std::integral_constant<size_t, 0>());
+    }
+}
+
+/** Store the values of an operand of a batch predicate for the selected tuples of a batch */
+void gatherBatchOperand(const InterpreterContext& ctxt, const InterpreterBatchPredicate::Operand& operand,
+        const TupleRef* batch, const uint32_t* selection, size_t count, RamDomain* values) {
+    if (operand.kind == InterpreterBatchPredicate::Operand::COLUMN) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = batch[selection[i]][operand.element];
+        }
+        return;
+    }
+    RamDomain value = operand.kind == InterpreterBatchPredicate::Operand::CONSTANT
+                              ? operand.value
+                              : ctxt[operand.tupleId][operand.element];
+    std::fill_n(values, count, value);
+}
+
+/**
+ * Evaluate a batch predicate for the selected tuples of a batch, and keep the
+ * tuples satisfying it in the selection; return the number of tuples kept.
+ */
+template <typename T, typename Compare>
+size_t selectBatch(const InterpreterContext& ctxt, const InterpreterBatchPredicate& predicate,
+        const TupleRef* batch, uint32_t* selection, size_t count, Compare compare) {
+    // gather the operands into contiguous arrays so that the comparison can be vectorised
+    RamDomain lhs[Stream::BUFFER_SIZE];
+    RamDomain rhs[Stream::BUFFER_SIZE];
+    bool keep[Stream::BUFFER_SIZE];
+    gatherBatchOperand(ctxt, predicate.lhs, batch, selection, count, lhs);
+    gatherBatchOperand(ctxt, predicate.rhs, batch, selection, count, rhs);
+    for (size_t i = 0; i < count; ++i) {
+        keep[i] = compare(ramBitCast<T>(lhs[i]), ramBitCast<T>(rhs[i]));
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        selection[kept] = selection[i];
+        kept += keep[i];
+    }
+    return kept;
+}
+
+size_t selectBatch(const InterpreterContext& ctxt, const InterpreterBatchPredicate& predicate,
+        const TupleRef* batch, uint32_t* selection, size_t count) {
+#define SELECT(ty, cmp) return selectBatch<ty>(ctxt, predicate, batch, selection, count, cmp<ty>())
+    switch (predicate.op) {
+        case BinaryConstraintOp::EQ: SELECT(RamDomain, std::equal_to);
+        case BinaryConstraintOp::NE: SELECT(RamDomain, std::not_equal_to);
+        case BinaryConstraintOp::LT: SELECT(RamSigned, std::less);
+        case BinaryConstraintOp::LE: SELECT(RamSigned, std::less_equal);
+        case BinaryConstraintOp::GT: SELECT(RamSigned, std::greater);
+        case BinaryConstraintOp::GE: SELECT(RamSigned, std::greater_equal);
+        case BinaryConstraintOp::ULT: SELECT(RamUnsigned, std::less);
+        case BinaryConstraintOp::ULE: SELECT(RamUnsigned, std::less_equal);
+        case BinaryConstraintOp::UGT: SELECT(RamUnsigned, std::greater);
+        case BinaryConstraintOp::UGE: SELECT(RamUnsigned, std::greater_equal);
+        case BinaryConstraintOp::FEQ: SELECT(RamFloat, std::equal_to);
+        case BinaryConstraintOp::FNE: SELECT(RamFloat, std::not_equal_to);
+        case BinaryConstraintOp::FLT: SELECT(RamFloat, std::less);
+        case BinaryConstraintOp::FLE: SELECT(RamFloat, std::less_equal);
+        case BinaryConstraintOp::FGT: SELECT(RamFloat, std::greater);
+        case BinaryConstraintOp::FGE: SELECT(RamFloat, std::greater_equal);
+        default: fatal("unsupported batch predicate");
+    }
+#undef SELECT
 }
+}  // namespace
+
+/**
+ * Serves the relation accesses of a query compiled to native code from a context,
+ * as the interpreter does for the operations and conditions they stand for.
+ */
+class InterpreterEngine::NativeQueryAdapter : public NativeQueryContext {
+public:
+    NativeQueryAdapter(InterpreterEngine& engine, InterpreterContext& ctxt,
+            const InterpreterNativeQuery& query, InterpreterViewContext& viewContext)
+            : engine(engine), ctxt(ctxt), query(query), viewContext(viewContext) {}
+
+    void scan(size_t access, Visitor visitor, void* closure) override {
+        const auto& info = query.getAccess(access);
+        const InterpreterRelation& rel = **info.relation;
+        if (info.kind == InterpreterNativeAccess::ParallelScan) {
+            visitPartitions(rel.partitionScan(engine.numOfThreads), visitor, closure);
+            return;
+        }
+        for (const RamDomain* tuple : rel) {
+            if (!visitor(closure, *this, tuple)) {
+                break;
+            }
+        }
+    }
+
+    void range(size_t access, const RamDomain* low, const RamDomain* high, Visitor visitor,
+            void* closure) override {
+        const auto& info = query.getAccess(access);
+        const InterpreterRelation& rel = **info.relation;
+        TupleRef lowRef(low, rel.getArity());
+        TupleRef highRef(high, rel.getArity());
+        if (info.kind == InterpreterNativeAccess::ParallelRange) {
+            visitPartitions(
+                    rel.partitionRange(info.view, lowRef, highRef, engine.numOfThreads), visitor, closure);
+            return;
+        }
+        for (auto data : ctxt.getView(info.view)->range(lowRef, highRef)) {
+            if (!visitor(closure, *this, &data[0])) {
+                break;
+            }
+        }
+    }
+
+    bool contains(size_t access, const RamDomain* tuple) override {
+        const auto& info = query.getAccess(access);
+        const InterpreterRelation& rel = **info.relation;
+        // tuples the Bloom filter rules out need not be searched for
+        return (!info.filtered || rel.mayContain(tuple)) &&
+               ctxt.getView(info.view)->contains(TupleRef(tuple, rel.getArity()));
+    }
+
+    bool contains(size_t access, const RamDomain* low, const RamDomain* high) override {
+        const auto& info = query.getAccess(access);
+        const InterpreterRelation& rel = **info.relation;
+        TupleRef lowRef(low, rel.getArity());
+        TupleRef highRef(high, rel.getArity());
+        return (!info.filtered || rel.mayContain(low)) && ctxt.getView(info.view)->contains(lowRef, highRef);
+    }
+
+    bool empty(size_t access) override {
+        return (*query.getAccess(access).relation)->empty();
+    }
+
+    void insert(size_t access, const RamDomain* tuple) override {
+        const auto& info = query.getAccess(access);
+        if (info.buffer != nullptr) {
+            info.buffer->push(tuple);
+        } else {
+            (*info.relation)->insert(tuple);
+        }
+    }
+
+private:
+    /** Visit the partitions of a parallel scan or range search, with views of each thread */
+    void visitPartitions(PartitionedStream pStream, Visitor visitor, void* closure) {
+        PARALLEL_START
+            InterpreterContext newCtxt(ctxt);
+            for (const auto& info : viewContext.getViewInfoForNested()) {
+                newCtxt.createView(*engine.getRelationHandle(info[0]), info[1], info[2]);
+            }
+            NativeQueryAdapter adapter(engine, newCtxt, query, viewContext);
+            pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+                for (const TupleRef& val : *it) {
+                    if (!visitor(closure, adapter, val.getBase())) {
+                        break;
+                    }
+                }
+            }
+        PARALLEL_END
+    }
+
+    InterpreterEngine& engine;
+    InterpreterContext& ctxt;
+    const InterpreterNativeQuery& query;
+    InterpreterViewContext& viewContext;
+};
 
 InterpreterEngine::RelationHandle& InterpreterEngine::getRelationHandle(const size_t idx) {
     return generator.getRelationHandle(idx);
@@ -178,6 +417,51 @@ void* InterpreterEngine::getMethodHandle(const std::string& method) {
     return nullptr;
 }
 
+std::shared_ptr<InterpreterFunctorCall> InterpreterEngine::prepareFunctorCall(
+        const UserDefinedOperator& op) {
+    auto call = std::make_shared<InterpreterFunctorCall>();
+    call->function = reinterpret_cast<void (*)()>(getMethodHandle(op.getName()));
+    ffi_type* codomain = &FFI_RamSigned;
+    if (op.isStateful()) {
+        // symbol table and record table, followed by the arguments
+        call->argTypes.assign(2, &ffi_type_pointer);
+        call->argTypes.insert(call->argTypes.end(), op.getArguments().size(), &FFI_RamSigned);
+    } else {
+        auto getFFIType = [](TypeAttribute type) -> ffi_type* {
+            switch (type) {
+                case TypeAttribute::Symbol: return &FFI_Symbol;
+                case TypeAttribute::Signed: return &FFI_RamSigned;
+                case TypeAttribute::Unsigned: return &FFI_RamUnsigned;
+                case TypeAttribute::Float: return &FFI_RamFloat;
+                case TypeAttribute::ADT:
+                case TypeAttribute::Record: return nullptr;
+            }
+            UNREACHABLE_BAD_CASE_ANALYSIS
+        };
+        // types without a foreign representation leave the call interface unprepared
+        for (TypeAttribute type : op.getArgsTypes()) {
+            call->argTypes.push_back(getFFIType(type));
+            if (call->argTypes.back() == nullptr) {
+                call->error = (type == TypeAttribute::ADT) ? "ADT support is not implemented"
+                                                           : "Record support is not implemented";
+                return call;
+            }
+        }
+        codomain = getFFIType(op.getReturnType());
+        if (codomain == nullptr) {
+            call->error = "Not implemented";
+            return call;
+        }
+    }
+    const auto prepStatus = ffi_prep_cif(
+            &call->cif, FFI_DEFAULT_ABI, call->argTypes.size(), codomain, call->argTypes.data());
+    if (prepStatus != FFI_OK) {
+        call->error = tfm::format("Failed to prepare CIF for user-defined operator `%s`; error code = %d",
+                op.getName(), prepStatus);
+    }
+    return call;
+}
+
 VecOwn<InterpreterEngine::RelationHandle>& InterpreterEngine::getRelationMap() {
     return generator.getRelations();
 }
@@ -249,18 +533,14 @@ void InterpreterEngine::executeMain() {
     InterpreterContext ctxt;
 
     if (!profileEnabled) {
-        InterpreterContext ctxt;
+        InterpreterContext ctxt(contextArenas);
         execute(main.get(), ctxt);
     } else {
         ProfileEventSingleton::instance().setOutputFile(Global::config().get("profile"));
-        // Prepare the frequency table for threaded use
+        // Prepare the counters for the slots assigned during generation
         const Program& program = tUnit.getProgram();
-        visitDepthFirst(program, [&](const TupleOperation& node) {
-            if (!node.getProfileText().empty()) {
-                frequencies.emplace(node.getProfileText(), std::deque<std::atomic<size_t>>());
-                frequencies[node.getProfileText()].emplace_back(0);
-            }
-        });
+        frequencies.init(generator.getFrequencySlots().size());
+        reads.init(generator.getReadSlots().size());
         // Enable profiling for execution of main
         ProfileEventSingleton::instance().startTimer();
         ProfileEventSingleton::instance().makeTimeEvent("@time;starttime");
@@ -273,7 +553,6 @@ void InterpreterEngine::executeMain() {
         for (auto rel : tUnit.getProgram().getRelations()) {
             if (rel->getName()[0] != '@') {
                 ++relationCount;
-                reads[rel->getName()] = 0;
             }
         }
         ProfileEventSingleton::instance().makeConfigRecord("relationCount", std::to_string(relationCount));
@@ -283,19 +562,31 @@ void InterpreterEngine::executeMain() {
         visitDepthFirst(program, [&](const Query&) { ++ruleCount; });
         ProfileEventSingleton::instance().makeConfigRecord("ruleCount", std::to_string(ruleCount));
 
-        InterpreterContext ctxt;
+        InterpreterContext ctxt(contextArenas);
         execute(main.get(), ctxt);
         ProfileEventSingleton::instance().stopTimer();
-        for (auto const& cur : frequencies) {
-            for (size_t i = 0; i < cur.second.size(); ++i) {
-                ProfileEventSingleton::instance().makeQuantityEvent(cur.first, cur.second[i], i);
+        frequencies.merge(getIterationNumber());
+        reads.merge(0);
+        for (auto const& cur : generator.getFrequencySlots().getSlots()) {
+            const auto& counts = frequencies.getTotals(cur.second);
+            for (size_t i = 0; i < counts.size(); ++i) {
+                ProfileEventSingleton::instance().makeQuantityEvent(cur.first, counts[i], i);
             }
         }
-        for (auto const& cur : reads) {
-            ProfileEventSingleton::instance().makeQuantityEvent(
-                    "@relation-reads;" + cur.first, cur.second, 0);
+        const auto& readSlots = generator.getReadSlots().getSlots();
+        for (auto rel : program.getRelations()) {
+            if (rel->getName()[0] != '@') {
+                auto slot = readSlots.find(rel->getName());
+                size_t count = slot == readSlots.end() ? 0 : reads.getTotals(slot->second)[0];
+                ProfileEventSingleton::instance().makeQuantityEvent(
+                        "@relation-reads;" + rel->getName(), count, 0);
+            }
         }
     }
+    if (hotQueriesEnabled) {
+        // the report is diagnostic output, and must not mix with relations printed to stdout
+        reportHotQueries(std::cerr);
+    }
     SignalHandler::instance()->reset();
 }
 
@@ -308,12 +599,48 @@ void InterpreterEngine::generateIR() {
     }
     if (main == nullptr) {
         main = generator.generateTree(program.getMain(), program);
+        // Compile constant patterns of match constraints ahead of evaluation
+        visitDepthFirst(program, [&](const Constraint& constraint) {
+            auto op = constraint.getOperator();
+            if (op != BinaryConstraintOp::MATCH && op != BinaryConstraintOp::NOT_MATCH) {
+                return;
+            }
+            if (const auto* pattern = dynamic_cast<const SignedConstant*>(&constraint.getLHS())) {
+                patternCache.pin(pattern->getConstant());
+            }
+        });
+    }
+    if (hotQueriesEnabled && queryTimes.empty()) {
+        // Prepare the time table for threaded use
+        visitDepthFirst(program, [&](const Query& query) { queryTimes[&query]; });
+    }
+}
+
+void InterpreterEngine::reportHotQueries(std::ostream& os) const {
+    std::vector<std::pair<const Query*, const QueryTime*>> hot;
+    for (const auto& cur : queryTimes) {
+        if (cur.second.executions > 0) {
+            hot.emplace_back(cur.first, &cur.second);
+        }
+    }
+    std::stable_sort(hot.begin(), hot.end(),
+            [](const auto& a, const auto& b) { return a.second->nanoseconds > b.second->nanoseconds; });
+    size_t limit = std::stoul(Global::config().get("hot-queries"));
+    if (hot.size() > limit) {
+        hot.resize(limit);
+    }
+
+    os << "Hot queries:\n";
+    for (const auto& cur : hot) {
+        os << "Query Time: " << cur.second->nanoseconds / 1e9 << "sec in " << cur.second->executions
+           << " executions\n";
+        os << *cur.first;
     }
 }
 
 void InterpreterEngine::executeSubroutine(
         const std::string& name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret) {
-    InterpreterContext ctxt;
+    InterpreterContext ctxt(contextArenas);
     ctxt.setReturnValues(ret);
     ctxt.setArguments(args);
     generateIR();
@@ -323,6 +650,136 @@ void InterpreterEngine::executeSubroutine(
     execute(subroutine[i].get(), ctxt);
 }
 
+size_t InterpreterEngine::waitForNativeQueries() {
+    return tier != nullptr ? tier->wait() : 0;
+}
+
+bool InterpreterEngine::executeBatch(InterpreterContext& ctxt, Stream& stream, size_t tupleId,
+        const std::vector<InterpreterBatchPredicate>& predicates, const InterpreterNode& nested) {
+    uint32_t selection[Stream::BUFFER_SIZE];
+    for (; stream.getBatchSize() > 0; stream.nextBatch()) {
+        const TupleRef* batch = stream.getBatch();
+        size_t count = stream.getBatchSize();
+        for (size_t i = 0; i < count; ++i) {
+            selection[i] = i;
+        }
+        for (const auto& predicate : predicates) {
+            count = selectBatch(ctxt, predicate, batch, selection, count);
+        }
+        // run the nested operation for the remaining tuples
+        for (size_t i = 0; i < count; ++i) {
+            ctxt[tupleId] = batch[selection[i]].getBase();
+            if (!execute(&nested, ctxt)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <size_t Arity, bool Generic>
+void InterpreterEngine::fillSuperTuple(RamDomain* tuple, const std::vector<RamDomain>& constants,
+        const std::vector<std::array<size_t, 3>>& tupleElements,
+        const std::vector<std::pair<size_t, Own<InterpreterNode>>>& exprs, InterpreterContext& ctxt) {
+    if constexpr (Arity == 0) {
+        std::copy(constants.begin(), constants.end(), tuple);
+    } else {
+        std::copy_n(constants.begin(), Arity, tuple);
+    }
+    for (const auto& tupleElement : tupleElements) {
+        tuple[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
+    }
+    if constexpr (Generic) {
+        for (const auto& expr : exprs) {
+            tuple[expr.first] = execute(expr.second.get(), ctxt);
+        }
+    }
+}
+
+template <typename Func>
+auto InterpreterEngine::evalSuperTuple(
+        const InterpreterSuperInstruction& superInfo, InterpreterContext& ctxt, Func&& func) {
+    // a constant tuple is passed as encoded
+    if (superInfo.shape == InterpreterSuperInstruction::Shape::CONSTANT) {
+        return func(superInfo.first.data());
+    }
+    // tuples of constants and tuple elements are copied without evaluating expressions
+    bool generic = superInfo.shape != InterpreterSuperInstruction::Shape::TUPLE_ELEMENT;
+    return dispatchArity(superInfo.first.size(), [&](auto arity) {
+        constexpr size_t Arity = decltype(arity)::value;
+        if constexpr (Arity == 0) {
+            RamDomain tuple[superInfo.first.size()];
+            if (generic) {
+                fillSuperTuple<0, true>(
+                        tuple, superInfo.first, superInfo.tupleFirst, superInfo.exprFirst, ctxt);
+            } else {
+                fillSuperTuple<0, false>(
+                        tuple, superInfo.first, superInfo.tupleFirst, superInfo.exprFirst, ctxt);
+            }
+            return func(static_cast<const RamDomain*>(tuple));
+        } else {
+            std::array<RamDomain, Arity> tuple;
+            if (generic) {
+                fillSuperTuple<Arity, true>(
+                        tuple.data(), superInfo.first, superInfo.tupleFirst, superInfo.exprFirst, ctxt);
+            } else {
+                fillSuperTuple<Arity, false>(
+                        tuple.data(), superInfo.first, superInfo.tupleFirst, superInfo.exprFirst, ctxt);
+            }
+            return func(static_cast<const RamDomain*>(tuple.data()));
+        }
+    });
+}
+
+template <bool Mirror, typename Func>
+auto InterpreterEngine::evalSuperBounds(
+        const InterpreterSuperInstruction& superInfo, InterpreterContext& ctxt, Func&& func) {
+    size_t arity = superInfo.first.size();
+    // constant bounds are passed as encoded
+    if (superInfo.shape == InterpreterSuperInstruction::Shape::CONSTANT) {
+        return func(TupleRef(superInfo.first.data(), arity), TupleRef(superInfo.second.data(), arity));
+    }
+    auto fillShape = [&](RamDomain* low, RamDomain* high, auto arity, auto generic) {
+        constexpr size_t Arity = decltype(arity)::value;
+        constexpr bool Generic = decltype(generic)::value;
+        fillSuperTuple<Arity, Generic>(low, superInfo.first, superInfo.tupleFirst, superInfo.exprFirst, ctxt);
+        fillSuperTuple<Arity, Generic>(
+                high, superInfo.second, superInfo.tupleSecond, superInfo.exprSecond, ctxt);
+        if constexpr (Mirror) {
+            for (const auto& tupleElement : superInfo.tupleFirst) {
+                high[tupleElement[0]] = low[tupleElement[0]];
+            }
+            if constexpr (Generic) {
+                for (const auto& expr : superInfo.exprFirst) {
+                    high[expr.first] = low[expr.first];
+                }
+            }
+        }
+    };
+    // bounds of constants and tuple elements are copied without evaluating expressions
+    auto fill = [&](RamDomain* low, RamDomain* high, auto arity) {
+        if (superInfo.shape == InterpreterSuperInstruction::Shape::TUPLE_ELEMENT) {
+            fillShape(low, high, arity, std::false_type());
+        } else {
+            fillShape(low, high, arity, std::true_type());
+        }
+    };
+    return dispatchArity(arity, [&](auto constArity) {
+        constexpr size_t Arity = decltype(constArity)::value;
+        if constexpr (Arity == 0) {
+            RamDomain low[arity];
+            RamDomain high[arity];
+            fill(low, high, constArity);
+            return func(TupleRef(low, arity), TupleRef(high, arity));
+        } else {
+            std::array<RamDomain, Arity> low;
+            std::array<RamDomain, Arity> high;
+            fill(low.data(), high.data(), constArity);
+            return func(TupleRef(low.data(), Arity), TupleRef(high.data(), Arity));
+        }
+    });
+}
+
 RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterContext& ctxt) {
 #define DEBUG(Kind) std::cout << "Running Node: " << #Kind << "\n";
 #define EVAL_CHILD(ty, idx) ramBitCast<ty>(execute(shadow.getChild(idx), ctxt))
@@ -587,105 +1044,55 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(NestedIntrinsicOperator)
 
         CASE(UserDefinedOperator)
-            const std::string& name = cur.getName();
-
-            auto fn = reinterpret_cast<void (*)()>(getMethodHandle(name));
-            if (fn == nullptr) fatal("cannot find user-defined operator `%s`", name);
+            // the function and its call interface were resolved when the node was generated
+            InterpreterFunctorCall& call = shadow.getCall();
+            auto fn = call.function;
+            if (fn == nullptr) fatal("cannot find user-defined operator `%s`", cur.getName());
+            if (!call.error.empty()) fatal("%s", call.error);
             size_t arity = cur.getArguments().size();
 
             if (cur.isStateful()) {
                 // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity + 2];
                 void* values[arity + 2];
                 RamDomain intVal[arity];
                 ffi_arg rc;
 
                 /* Initialize arguments for ffi-call */
-                args[0] = args[1] = &ffi_type_pointer;
                 void* symbolTable = (void*)&getSymbolTable();
                 values[0] = &symbolTable;
                 void* recordTable = (void*)&getRecordTable();
                 values[1] = &recordTable;
                 for (size_t i = 0; i < arity; i++) {
                     intVal[i] = execute(shadow.getChild(i), ctxt);
-                    args[i + 2] = &FFI_RamSigned;
                     values[i + 2] = &intVal[i];
                 }
 
-                // Set codomain.
-                auto codomain = &FFI_RamSigned;
-
                 // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity + 2, codomain, args);
-                if (prepStatus != FFI_OK) {
-                    fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
-                }
-                ffi_call(&cif, fn, &rc, values);
+                ffi_call(&call.cif, fn, &rc, values);
                 return static_cast<RamDomain>(rc);
             } else {
                 // get name and type
                 const std::vector<TypeAttribute>& type = cur.getArgsTypes();
 
                 // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity];
                 void* values[arity];
                 RamDomain intVal[arity];
-                RamUnsigned uintVal[arity];
-                RamFloat floatVal[arity];
                 const char* strVal[arity];
                 ffi_arg rc;
 
-                /* Initialize arguments for ffi-call */
+                /* Initialize arguments for ffi-call; numbers are passed by their bit pattern */
                 for (size_t i = 0; i < arity; i++) {
-                    RamDomain arg = execute(shadow.getChild(i), ctxt);
-                    switch (type[i]) {
-                        case TypeAttribute::Symbol:
-                            args[i] = &FFI_Symbol;
-                            strVal[i] = getSymbolTable().resolve(arg).c_str();
-                            values[i] = &strVal[i];
-                            break;
-                        case TypeAttribute::Signed:
-                            args[i] = &FFI_RamSigned;
-                            intVal[i] = arg;
-                            values[i] = &intVal[i];
-                            break;
-                        case TypeAttribute::Unsigned:
-                            args[i] = &FFI_RamUnsigned;
-                            uintVal[i] = ramBitCast<RamUnsigned>(arg);
-                            values[i] = &uintVal[i];
-                            break;
-                        case TypeAttribute::Float:
-                            args[i] = &FFI_RamFloat;
-                            floatVal[i] = ramBitCast<RamFloat>(arg);
-                            values[i] = &floatVal[i];
-                            break;
-                        case TypeAttribute::ADT: fatal("ADT support is not implemented");
-                        case TypeAttribute::Record: fatal("Record support is not implemented");
+                    intVal[i] = execute(shadow.getChild(i), ctxt);
+                    if (type[i] == TypeAttribute::Symbol) {
+                        strVal[i] = getSymbolTable().resolve(intVal[i]).c_str();
+                        values[i] = &strVal[i];
+                    } else {
+                        values[i] = &intVal[i];
                     }
                 }
 
-                // Get codomain.
-                auto codomain = &FFI_RamSigned;
-                switch (cur.getReturnType()) {
-                    // initialize for string value.
-                    case TypeAttribute::Symbol: codomain = &FFI_Symbol; break;
-                    case TypeAttribute::Signed: codomain = &FFI_RamSigned; break;
-                    case TypeAttribute::Unsigned: codomain = &FFI_RamUnsigned; break;
-                    case TypeAttribute::Float: codomain = &FFI_RamFloat; break;
-                    case TypeAttribute::ADT: fatal("Not implemented");
-                    case TypeAttribute::Record: fatal("Not implemented");
-                }
-
                 // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, codomain, args);
-                if (prepStatus != FFI_OK) {
-                    fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
-                }
-                ffi_call(&cif, fn, &rc, values);
+                ffi_call(&call.cif, fn, &rc, values);
 
                 switch (cur.getReturnType()) {
                     case TypeAttribute::Signed: return static_cast<RamDomain>(rc);
@@ -699,7 +1106,6 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                 }
                 fatal("Unsupported user defined operator");
             }
-
         ESAC(UserDefinedOperator)
 
         CASE(PackRecord)
@@ -746,44 +1152,28 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
 
             size_t viewPos = shadow.getViewId();
 
-            if (profileEnabled && !cur.getRelation().isTemp()) {
-                reads[cur.getRelation().getName()]++;
+            if (profileEnabled) {
+                reads.increment(shadow.getProfileSlot());
             }
 
             const auto& superInfo = shadow.getSuperInst();
+            auto& view = ctxt.getView(viewPos);
+            // tuples the Bloom filter rules out need not be searched for
+            auto mayContain = [&](const RamDomain* tuple) {
+                return !shadow.isFiltered() || node->getRelation()->mayContain(tuple);
+            };
+
             // for total we use the exists test
             if (shadow.isTotalSearch()) {
-                RamDomain tuple[arity];
-                memcpy(tuple, superInfo.first.data(), sizeof(tuple));
-                /* TupleElement */
-                for (const auto& tupleElement : superInfo.tupleFirst) {
-                    tuple[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
-                }
-                /* Generic */
-                for (const auto& expr : superInfo.exprFirst) {
-                    tuple[expr.first] = execute(expr.second.get(), ctxt);
-                }
-                return ctxt.getView(viewPos)->contains(TupleRef(tuple, arity));
+                return evalSuperTuple(superInfo, ctxt, [&](const RamDomain* tuple) {
+                    return mayContain(tuple) && view->contains(TupleRef(tuple, arity));
+                });
             }
 
             // for partial we search for lower and upper boundaries
-            RamDomain low[arity];
-            RamDomain high[arity];
-            memcpy(low, superInfo.first.data(), sizeof(low));
-            memcpy(high, superInfo.second.data(), sizeof(high));
-
-            /* TupleElement */
-            for (const auto& tupleElement : superInfo.tupleFirst) {
-                low[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
-                high[tupleElement[0]] = low[tupleElement[0]];
-            }
-            /* Generic */
-            for (const auto& expr : superInfo.exprFirst) {
-                low[expr.first] = execute(expr.second.get(), ctxt);
-                high[expr.first] = low[expr.first];
-            }
-
-            return ctxt.getView(viewPos)->contains(TupleRef(low, arity), TupleRef(high, arity));
+            return evalSuperBounds<true>(superInfo, ctxt, [&](TupleRef low, TupleRef high) {
+                return mayContain(low.getBase()) && view->contains(low, high);
+            });
         ESAC(ExistenceCheck)
 
         CASE(ProvenanceExistenceCheck)
@@ -791,35 +1181,18 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             const auto& superInfo = shadow.getSuperInst();
             size_t arity = cur.getRelation().getArity();
 
-            // for partial we search for lower and upper boundaries
-            RamDomain low[arity];
-            RamDomain high[arity];
-            memcpy(low, superInfo.first.data(), sizeof(low));
-            memcpy(high, superInfo.second.data(), sizeof(high));
-
-            /* TupleElement */
-            for (const auto& tupleElement : superInfo.tupleFirst) {
-                low[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
-                high[tupleElement[0]] = low[tupleElement[0]];
-            }
-            /* Generic */
-            for (const auto& expr : superInfo.exprFirst) {
-                assert(expr.second.get() != nullptr &&
-                        "ProvenanceExistenceCheck should always be specified for payload");
-                low[expr.first] = execute(expr.second.get(), ctxt);
-                high[expr.first] = low[expr.first];
-            }
-
-            low[arity - 2] = MIN_RAM_SIGNED;
-            low[arity - 1] = MIN_RAM_SIGNED;
-            high[arity - 2] = MAX_RAM_SIGNED;
-            high[arity - 1] = MAX_RAM_SIGNED;
-
             // obtain view
             size_t viewPos = shadow.getViewId();
+            auto& view = ctxt.getView(viewPos);
 
-            // get an equalRange
-            auto equalRange = ctxt.getView(viewPos)->range(TupleRef(low, arity), TupleRef(high, arity));
+            // get an equalRange; the generator leaves the provenance annotations unbounded
+            // tuples the Bloom filter rules out need not be searched for
+            auto equalRange = evalSuperBounds<true>(superInfo, ctxt, [&](TupleRef low, TupleRef high) {
+                if (shadow.isFiltered() && !node->getRelation()->mayContain(low.getBase())) {
+                    return Stream();
+                }
+                return view->range(low, high);
+            });
 
             // if range is empty
             if (equalRange.begin() == equalRange.end()) {
@@ -855,48 +1228,17 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                 COMPARE(GT, >)
                 COMPARE(GE, >=)
 
-                case BinaryConstraintOp::MATCH: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().resolve(left);
-                    const std::string& text = getSymbolTable().resolve(right);
-                    bool result = false;
-                    try {
-                        result = std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
-                }
-                case BinaryConstraintOp::NOT_MATCH: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().resolve(left);
-                    const std::string& text = getSymbolTable().resolve(right);
-                    bool result = false;
-                    try {
-                        result = !std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for !match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
-                }
-                case BinaryConstraintOp::CONTAINS: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().resolve(left);
-                    const std::string& text = getSymbolTable().resolve(right);
-                    return text.find(pattern) != std::string::npos;
-                }
-                case BinaryConstraintOp::NOT_CONTAINS: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().resolve(left);
-                    const std::string& text = getSymbolTable().resolve(right);
-                    return text.find(pattern) == std::string::npos;
-                }
+                case BinaryConstraintOp::MATCH:
+                    return patternCache.match(execute(shadow.getLhs(), ctxt), execute(shadow.getRhs(), ctxt));
+                case BinaryConstraintOp::NOT_MATCH:
+                    return patternCache.notMatch(
+                            execute(shadow.getLhs(), ctxt), execute(shadow.getRhs(), ctxt));
+                case BinaryConstraintOp::CONTAINS:
+                    return patternCache.contains(
+                            execute(shadow.getLhs(), ctxt), execute(shadow.getRhs(), ctxt));
+                case BinaryConstraintOp::NOT_CONTAINS:
+                    return !patternCache.contains(
+                            execute(shadow.getLhs(), ctxt), execute(shadow.getRhs(), ctxt));
             }
 
             { UNREACHABLE_BAD_CASE_ANALYSIS }
@@ -910,12 +1252,8 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         CASE(TupleOperation)
             bool result = execute(shadow.getChild(), ctxt);
 
-            if (profileEnabled && !cur.getProfileText().empty()) {
-                auto& currentFrequencies = frequencies[cur.getProfileText()];
-                while (currentFrequencies.size() <= getIterationNumber()) {
-                    currentFrequencies.emplace_back(0);
-                }
-                frequencies[cur.getProfileText()][getIterationNumber()]++;
+            if (profileEnabled) {
+                frequencies.increment(shadow.getProfileSlot());
             }
             return result;
         ESAC(TupleOperation)
@@ -924,6 +1262,14 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             // get the targeted relation
             auto& rel = *node->getRelation();
 
+            // evaluate nested filters over batches
+            if (!shadow.getBatchPredicates().empty()) {
+                auto stream = rel.scan();
+                executeBatch(ctxt, stream, cur.getTupleId(), shadow.getBatchPredicates(),
+                        *shadow.getNestedOperation());
+                return true;
+            }
+
             // use simple iterator
             for (const RamDomain* tuple : rel) {
                 ctxt[cur.getTupleId()] = tuple;
@@ -947,6 +1293,11 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                     newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
                 }
                 pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+                    if (!shadow.getBatchPredicates().empty()) {
+                        executeBatch(newCtxt, *it, cur.getTupleId(), shadow.getBatchPredicates(),
+                                *shadow.getNestedOperation());
+                        continue;
+                    }
                     for (const TupleRef& val : *it) {
                         newCtxt[cur.getTupleId()] = val.getBase();
                         if (!execute(shadow.getNestedOperation(), newCtxt)) {
@@ -959,17 +1310,19 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(ParallelScan)
 
         CASE(IndexScan)
-            // create pattern tuple for range query
-            size_t arity = cur.getRelation().getArity();
-            const auto& superInfo = shadow.getSuperInst();
-            RamDomain low[arity];
-            RamDomain high[arity];
-            CAL_SEARCH_BOUND(superInfo, low, high);
-
             size_t viewId = shadow.getViewId();
             auto& view = ctxt.getView(viewId);
-            // conduct range query
-            for (auto data : view->range(TupleRef(low, arity), TupleRef(high, arity))) {
+            // create pattern tuple and conduct range query
+            auto range = evalSuperBounds<false>(shadow.getSuperInst(), ctxt,
+                    [&](TupleRef low, TupleRef high) { return view->range(low, high); });
+
+            // evaluate nested filters over batches
+            if (!shadow.getBatchPredicates().empty()) {
+                executeBatch(ctxt, range, cur.getTupleId(), shadow.getBatchPredicates(),
+                        *shadow.getNestedOperation());
+                return true;
+            }
+            for (auto data : range) {
                 ctxt[cur.getTupleId()] = &data[0];
                 if (!execute(shadow.getNestedOperation(), ctxt)) {
                     break;
@@ -983,15 +1336,11 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             auto& rel = *node->getRelation();
 
             // create pattern tuple for range query
-            size_t arity = rel.getArity();
-            const auto& superInfo = shadow.getSuperInst();
-            RamDomain low[arity];
-            RamDomain high[arity];
-            CAL_SEARCH_BOUND(superInfo, low, high);
-
             size_t indexPos = shadow.getViewId();
-            auto pStream =
-                    rel.partitionRange(indexPos, TupleRef(low, arity), TupleRef(high, arity), numOfThreads);
+            const auto& superInfo = shadow.getSuperInst();
+            auto pStream = evalSuperBounds<false>(superInfo, ctxt, [&](TupleRef low, TupleRef high) {
+                return rel.partitionRange(indexPos, low, high, numOfThreads);
+            });
 
             PARALLEL_START
                 InterpreterContext newCtxt(ctxt);
@@ -1000,6 +1349,11 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                     newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
                 }
                 pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+                    if (!shadow.getBatchPredicates().empty()) {
+                        executeBatch(newCtxt, *it, cur.getTupleId(), shadow.getBatchPredicates(),
+                                *shadow.getNestedOperation());
+                        continue;
+                    }
                     for (const TupleRef& val : *it) {
                         newCtxt[cur.getTupleId()] = val.getBase();
                         if (!execute(shadow.getNestedOperation(), newCtxt)) {
@@ -1129,16 +1483,9 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(UnpackRecord)
 
         CASE(ParallelAggregate)
-            // TODO (rdowavic): make parallel
-            auto viewContext = shadow.getViewContext();
-
-            InterpreterContext newCtxt(ctxt);
-            auto viewInfo = viewContext->getViewInfoForNested();
-            for (const auto& info : viewInfo) {
-                newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
-            }
-            return executeAggregate(newCtxt, cur, *shadow.getCondition(), shadow.getExpr(),
-                    *shadow.getNestedOperation(), node->getRelation()->scan());
+            return executeParallelAggregate(ctxt, cur, *shadow.getCondition(), shadow.getExpr(),
+                    *shadow.getNestedOperation(), *shadow.getViewContext(),
+                    node->getRelation()->partitionScan(numOfThreads));
         ESAC(ParallelAggregate)
 
         CASE(Aggregate)
@@ -1147,30 +1494,32 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(Aggregate)
 
         CASE(ParallelIndexAggregate)
-            // TODO (rdowavic): make parallel
-            auto viewContext = shadow.getViewContext();
+            auto& rel = *node->getRelation();
+            size_t indexPos = shadow.getViewId();
+            const auto& superInfo = shadow.getSuperInst();
+            auto pStream = evalSuperBounds<false>(superInfo, ctxt, [&](TupleRef low, TupleRef high) {
+                return rel.partitionRange(indexPos, low, high, numOfThreads);
+            });
+            return executeParallelAggregate(ctxt, cur, *shadow.getCondition(), shadow.getExpr(),
+                    *shadow.getNestedOperation(), *shadow.getViewContext(), std::move(pStream));
+        ESAC(ParallelIndexAggregate)
 
-            InterpreterContext newCtxt(ctxt);
-            auto viewInfo = viewContext->getViewInfoForNested();
-            for (const auto& info : viewInfo) {
-                newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
-            }
+        CASE(IndexAggregate)
             // init temporary tuple for this level
             size_t arity = cur.getRelation().getArity();
             const auto& superInfo = shadow.getSuperInst();
-            // get lower and upper boundaries for iteration
             RamDomain low[arity];
             RamDomain high[arity];
-            CAL_SEARCH_BOUND(superInfo, low, high);
+            CAL_SEARCH_BOUND(superInfo, low, high)
 
             size_t viewId = shadow.getViewId();
-            auto& view = newCtxt.getView(viewId);
+            auto& view = ctxt.getView(viewId);
 
-            return executeAggregate(newCtxt, cur, *shadow.getCondition(), shadow.getExpr(),
+            return executeAggregate(ctxt, cur, *shadow.getCondition(), shadow.getExpr(),
                     *shadow.getNestedOperation(), view->range(TupleRef(low, arity), TupleRef(high, arity)));
-        ESAC(ParallelIndexAggregate)
+        ESAC(IndexAggregate)
 
-        CASE(IndexAggregate)
+        CASE(IndexCount)
             // init temporary tuple for this level
             size_t arity = cur.getRelation().getArity();
             const auto& superInfo = shadow.getSuperInst();
@@ -1181,9 +1530,118 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             size_t viewId = shadow.getViewId();
             auto& view = ctxt.getView(viewId);
 
-            return executeAggregate(ctxt, cur, *shadow.getCondition(), shadow.getExpr(),
-                    *shadow.getNestedOperation(), view->range(TupleRef(low, arity), TupleRef(high, arity)));
-        ESAC(IndexAggregate)
+            // the size of the range is obtained from the index
+            AggregatePartial partial = initAggregate(AggregateOp::COUNT);
+            partial.result = view->count(TupleRef(low, arity), TupleRef(high, arity));
+            return finishAggregate(ctxt, cur, *shadow.getNestedOperation(), partial);
+        ESAC(IndexCount)
+
+        CASE(IndexMinMax)
+            // init temporary tuple for this level
+            size_t arity = cur.getRelation().getArity();
+            const auto& superInfo = shadow.getSuperInst();
+            RamDomain low[arity];
+            RamDomain high[arity];
+            CAL_SEARCH_BOUND(superInfo, low, high)
+
+            size_t viewId = shadow.getViewId();
+            auto& view = ctxt.getView(viewId);
+
+            // the minimum or maximum is taken from the first or last tuple of the range
+            AggregatePartial partial = initAggregate(cur.getFunction());
+            RamDomain boundary[arity];
+            if (view->boundary(TupleRef(low, arity), TupleRef(high, arity), cur.isLast(), boundary)) {
+                partial.result = boundary[cur.getColumn()];
+                partial.shouldRunNested = true;
+            }
+            return finishAggregate(ctxt, cur, *shadow.getNestedOperation(), partial);
+        ESAC(IndexMinMax)
+
+        CASE(IndexIntersection)
+            const auto& inputs = shadow.getInputs();
+            size_t numInputs = inputs.size();
+
+            // compute the bounds of the ranges of the inputs
+            std::vector<std::vector<RamDomain>> lows(numInputs);
+            std::vector<std::vector<RamDomain>> highs(numInputs);
+            for (size_t i = 0; i < numInputs; ++i) {
+                evalSuperBounds<false>(inputs[i].superInst, ctxt, [&](TupleRef low, TupleRef high) {
+                    lows[i].assign(low.getBase(), low.getBase() + low.size());
+                    highs[i].assign(high.getBase(), high.getBase() + high.size());
+                });
+            }
+
+            // the values of the attribute in the ranges of inputs whose index does not order it are
+            // collected once, in ascending order without duplicates, such that seeks do not rescan them
+            std::vector<std::vector<RamDomain>> values(numInputs);
+            std::vector<size_t> positions(numInputs, 0);
+            for (size_t i = 0; i < numInputs; ++i) {
+                const auto& input = inputs[i];
+                if (input.ordered) {
+                    continue;
+                }
+                auto& view = ctxt.getView(input.viewId);
+                TupleRef lowRef(lows[i].data(), lows[i].size());
+                TupleRef highRef(highs[i].data(), highs[i].size());
+                for (const TupleRef& tuple : view->range(lowRef, highRef)) {
+                    values[i].push_back(tuple[input.column]);
+                }
+                std::sort(values[i].begin(), values[i].end());
+                values[i].erase(std::unique(values[i].begin(), values[i].end()), values[i].end());
+            }
+
+            // obtains the least value of the attribute in the range of an input not below the given one
+            std::vector<RamDomain> boundary;
+            auto seek = [&](size_t i, RamDomain from, RamDomain& res) -> bool {
+                const auto& input = inputs[i];
+                if (!input.ordered) {
+                    // the values sought never decrease, so the search resumes from the last position
+                    const auto& candidates = values[i];
+                    auto pos = std::lower_bound(candidates.begin() + positions[i], candidates.end(), from);
+                    positions[i] = pos - candidates.begin();
+                    if (pos == candidates.end()) {
+                        return false;
+                    }
+                    res = *pos;
+                    return true;
+                }
+                auto& view = ctxt.getView(input.viewId);
+                std::vector<RamDomain>& low = lows[i];
+                low[input.column] = from;
+                boundary.resize(low.size());
+                if (!view->boundary(TupleRef(low.data(), low.size()), TupleRef(highs[i].data(), highs[i].size()),
+                            false, boundary.data())) {
+                    return false;
+                }
+                res = boundary[input.column];
+                return true;
+            };
+
+            // leapfrog over the inputs until all of them agree on a value
+            RamDomain value = MIN_RAM_SIGNED;
+            ctxt[cur.getTupleId()] = &value;
+            size_t agreed = 0;
+            for (size_t i = 0;; i = (i + 1) % numInputs) {
+                RamDomain next;
+                if (!seek(i, value, next)) {
+                    break;
+                }
+                if (next == value) {
+                    ++agreed;
+                } else {
+                    value = next;
+                    agreed = 1;
+                }
+                if (agreed == numInputs) {
+                    if (!execute(shadow.getNestedOperation(), ctxt) || value == MAX_RAM_SIGNED) {
+                        break;
+                    }
+                    ++value;
+                    agreed = 0;
+                }
+            }
+            return true;
+        ESAC(IndexIntersection)
 
         CASE(Break)
             // check condition
@@ -1201,33 +1659,22 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                 result = execute(shadow.getNestedOperation(), ctxt);
             }
 
-            if (profileEnabled && !cur.getProfileText().empty()) {
-                auto& currentFrequencies = frequencies[cur.getProfileText()];
-                while (currentFrequencies.size() <= getIterationNumber()) {
-                    currentFrequencies.emplace_back(0);
-                }
-                frequencies[cur.getProfileText()][getIterationNumber()]++;
+            if (profileEnabled) {
+                frequencies.increment(shadow.getProfileSlot());
             }
             return result;
         ESAC(Filter)
 
         CASE(Project)
-            const auto& superInfo = shadow.getSuperInst();
-            size_t arity = cur.getRelation().getArity();
-            RamDomain tuple[arity];
-            memcpy(tuple, superInfo.first.data(), sizeof(tuple));
-            /* TupleElement */
-            for (const auto& tupleElement : superInfo.tupleFirst) {
-                tuple[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
-            }
-            /* Generic */
-            for (const auto& expr : superInfo.exprFirst) {
-                tuple[expr.first] = execute(expr.second.get(), ctxt);
+            // collect the tuple in the buffer of the thread, merged into the relation by the query
+            if (InterpreterInsertBuffer* buffer = shadow.getInsertBuffer()) {
+                evalSuperTuple(
+                        shadow.getSuperInst(), ctxt, [&](const RamDomain* tuple) { buffer->push(tuple); });
+                return true;
             }
-
             // insert in target relation
             InterpreterRelation& rel = *node->getRelation();
-            rel.insert(tuple);
+            evalSuperTuple(shadow.getSuperInst(), ctxt, [&](const RamDomain* tuple) { rel.insert(tuple); });
             return true;
         ESAC(Project)
 
@@ -1252,7 +1699,34 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(Sequence)
 
         CASE(Parallel)
-            for (const auto& child : shadow.getChildren()) {
+            const auto& children = shadow.getChildren();
+#ifdef _OPENMP
+            // Run the children as concurrent tasks, unless this statement is already nested in a
+            // parallel region. The profile counters are atomic and the profile events are
+            // synchronised, as for the parallel sections of synthesised programs.
+            const size_t numThreads = numOfThreads > 0 ? numOfThreads : omp_get_max_threads();
+            if (children.size() > 1 && numThreads > 1 && omp_get_level() == 0) {
+                // Split the threads fairly between the tasks; the threads of a task are used by the
+                // parallel operations nested in it.
+                const size_t numTasks = std::min(children.size(), numThreads);
+                const int maxActiveLevels = omp_get_max_active_levels();
+                omp_set_max_active_levels(std::max(maxActiveLevels, 2));
+                std::atomic<bool> result{true};
+#pragma omp parallel for schedule(dynamic) num_threads(numTasks)
+                for (size_t i = 0; i < children.size(); ++i) {
+                    const size_t task = omp_get_thread_num();
+                    omp_set_num_threads(numThreads / numTasks + (task < numThreads % numTasks ? 1 : 0));
+                    // each task creates its own views
+                    InterpreterContext taskCtxt(ctxt);
+                    if (!execute(children[i].get(), taskCtxt)) {
+                        result = false;
+                    }
+                }
+                omp_set_max_active_levels(maxActiveLevels);
+                return result.load();
+            }
+#endif
+            for (const auto& child : children) {
                 if (!execute(child.get(), ctxt)) {
                     return false;
                 }
@@ -1262,7 +1736,14 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
 
         CASE(Loop)
             resetIterationNumber();
-            while (execute(shadow.getChild(), ctxt)) {
+            while (true) {
+                bool proceed = execute(shadow.getChild(), ctxt);
+                if (profileEnabled) {
+                    frequencies.merge(getIterationNumber());
+                }
+                if (!proceed) {
+                    break;
+                }
                 incIterationNumber();
             }
             resetIterationNumber();
@@ -1294,6 +1775,28 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             return true;
         ESAC(Clear)
 
+        CASE(Freeze)
+            VecOwn<InterpreterIndex> replaced = node->getRelation()->freeze();
+            // cached views on the replaced indexes are dropped before the indexes are released
+            std::vector<size_t> replacedIds;
+            for (const auto& index : replaced) {
+                replacedIds.push_back(index->getId());
+            }
+            ctxt.dropViews(replacedIds);
+            contextArenas.retire(replacedIds);
+            return true;
+        ESAC(Freeze)
+
+        CASE(Spill)
+            for (auto* rel : shadow.getRelations()) {
+                if (getResidentMemory() <= shadow.getMemoryLimit()) {
+                    break;
+                }
+                (*rel)->spill();
+            }
+            return true;
+        ESAC(Spill)
+
         CASE(Call)
             execute(subroutine[shadow.getSubroutineId()].get(), ctxt);
             return true;
@@ -1338,8 +1841,24 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
         ESAC(IO)
 
         CASE(Query)
+            QueryTimer<QueryTime> timer(hotQueriesEnabled ? &queryTimes.at(&cur) : nullptr);
             InterpreterViewContext* viewContext = shadow.getViewContext();
 
+            // Compile the query in the background once it got hot; it is interpreted until it is loaded.
+            InterpreterNativeQuery* native = (tier != nullptr) ? shadow.getNativeQuery() : nullptr;
+            if (native != nullptr && native->becameHot(tierThreshold)) {
+                tier->submit(*native);
+            }
+            QueryTimer<InterpreterNativeQuery> tierTimer(native);
+
+            // Build the deferred indexes searched by this query before any of its operations runs.
+            for (const auto& info : viewContext->getViewInfoForFilter()) {
+                getRelationHandle(info[0])->ensureIndex(info[1]);
+            }
+            for (const auto& info : viewContext->getViewInfoForNested()) {
+                getRelationHandle(info[0])->ensureIndex(info[1]);
+            }
+
             // Execute view-free operations in outer filter if any.
             auto& viewFreeOps = viewContext->getOuterFilterViewFreeOps();
             for (auto& op : viewFreeOps) {
@@ -1371,7 +1890,23 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
                     ctxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
                 }
             }
-            execute(shadow.getChild(), ctxt);
+            auto& insertBuffers = viewContext->getInsertBuffers();
+            for (auto& buffer : insertBuffers) {
+                buffer->reserve(MAX_THREADS);
+            }
+            if (NativeQueryFunction function = (native != nullptr) ? native->getFunction() : nullptr) {
+                NativeQueryAdapter adapter(*this, ctxt, *native, *viewContext);
+                function(adapter);
+            } else {
+                execute(shadow.getChild(), ctxt);
+            }
+
+            // Merge the tuples buffered by the threads into their relations.
+            for (auto& buffer : insertBuffers) {
+                InterpreterRelation& rel = *buffer->getRelation();
+                std::vector<RamDomain> tuples = buffer->collect();
+                rel.insert(tuples.data(), tuples.size() / rel.getArity());
+            }
             return true;
         ESAC(Query)
 
@@ -1383,10 +1918,19 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
             return true;
         ESAC(Extend)
 
+        CASE(Merge)
+            InterpreterRelation& src = *getRelationHandle(shadow.getSourceId());
+            InterpreterRelation& trg = *getRelationHandle(shadow.getTargetId());
+            trg.insert(src);
+            return true;
+        ESAC(Merge)
+
         CASE(Swap)
             swapRelation(shadow.getSourceId(), shadow.getTargetId());
             return true;
         ESAC(Swap)
+
+        case I_Bytecode: return executeBytecode(*static_cast<const InterpreterBytecode*>(node), ctxt);
     }
 
     UNREACHABLE_BAD_CASE_ANALYSIS
@@ -1395,51 +1939,264 @@ RamDomain InterpreterEngine::execute(const InterpreterNode* node, InterpreterCon
 #undef DEBUG
 }  // namespace souffle
 
-template <typename Aggregate>
-RamDomain InterpreterEngine::executeAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
-        const InterpreterNode& filter, const InterpreterNode* expression,
-        const InterpreterNode& nestedOperation, Stream stream) {
-    bool shouldRunNested = false;
+RamDomain InterpreterEngine::executeBytecode(const InterpreterBytecode& program, InterpreterContext& ctxt) {
+    const BytecodeInstruction* const code = program.getCode().data();
+    const BytecodeInstruction* ip = code;
+    RamDomain reg[program.getNumRegisters() + 1];
+    const size_t streamBase = ctxt.allocateStreams(program.getNumStreams());
+    RamDomain result = true;
+
+#define REG(x) reg[ip->x]
+#define STREAM(x) ctxt.getStream(streamBase + ip->x)
+#define SIGNED(x) ramBitCast<RamSigned>(reg[ip->x])
+#define UNSIGNED(x) ramBitCast<RamUnsigned>(reg[ip->x])
+#define FLOAT(x) ramBitCast<RamFloat>(reg[ip->x])
+// whether the Bloom filter of the relation of an existence check, if any, admits the tuple in reg[x..)
+#define MAY_CONTAIN(x) (ip->relation == nullptr || (*ip->relation)->mayContain(&reg[ip->x]))
+
+// Dispatch through computed gotos (threaded code) where the compiler supports
+// them, and through a switch in a loop otherwise.
+#ifdef __GNUC__
+    static void* const dispatchTable[] = {&&L_BC_Constant, &&L_BC_TupleElement, &&L_BC_Eval, &&L_BC_Move,
+            &&L_BC_Add, &&L_BC_Sub, &&L_BC_Mul, &&L_BC_BitAnd, &&L_BC_BitOr, &&L_BC_BitXor, &&L_BC_Neg,
+            &&L_BC_FAdd, &&L_BC_FSub, &&L_BC_FMul, &&L_BC_Jump, &&L_BC_Eq, &&L_BC_Ne, &&L_BC_Lt, &&L_BC_Le,
+            &&L_BC_Gt, &&L_BC_Ge, &&L_BC_ULt, &&L_BC_ULe, &&L_BC_UGt, &&L_BC_UGe, &&L_BC_FEq, &&L_BC_FNe,
+            &&L_BC_FLt, &&L_BC_FLe, &&L_BC_FGt, &&L_BC_FGe, &&L_BC_Test, &&L_BC_ExistsTotal,
+            &&L_BC_ExistsRange, &&L_BC_Scan, &&L_BC_Range, &&L_BC_Load, &&L_BC_Next, &&L_BC_Unpack,
+            &&L_BC_Insert, &&L_BC_Exec, &&L_BC_Return};
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == BC_Return + 1,
+            "dispatch table does not match the instruction set");
+#define OPCODE(Kind) L_##Kind:
+#define DISPATCH() goto* dispatchTable[ip->opcode]
+#else
+#define OPCODE(Kind) case Kind:
+#define DISPATCH() continue
+    for (;;) switch (ip->opcode) {
+#endif
+#define NEXT()  \
+    {           \
+        ++ip;   \
+        DISPATCH(); \
+    }
+#define JUMP()                      \
+    {                               \
+        ip = code + ip->target;     \
+        DISPATCH();                 \
+    }
+#define BRANCH(cond)                       \
+    {                                      \
+        if (bool(cond) == ip->jumpIfTrue) { \
+            JUMP();                        \
+        }                                  \
+        NEXT();                            \
+    }
+
+#ifdef __GNUC__
+    DISPATCH();
+#endif
+
+    // clang-format off
+    OPCODE(BC_Constant)    { REG(a) = ip->value; NEXT(); }
+    OPCODE(BC_TupleElement) { REG(a) = ctxt[ip->b][ip->c]; NEXT(); }
+    OPCODE(BC_Eval)        { REG(a) = execute(ip->node, ctxt); NEXT(); }
+    OPCODE(BC_Move)        { REG(a) = REG(b); NEXT(); }
+    OPCODE(BC_Add)         { REG(a) = ramBitCast(static_cast<RamUnsigned>(UNSIGNED(b) + UNSIGNED(c))); NEXT(); }
+    OPCODE(BC_Sub)         { REG(a) = ramBitCast(static_cast<RamUnsigned>(UNSIGNED(b) - UNSIGNED(c))); NEXT(); }
+    OPCODE(BC_Mul)         { REG(a) = ramBitCast(static_cast<RamUnsigned>(UNSIGNED(b) * UNSIGNED(c))); NEXT(); }
+    OPCODE(BC_BitAnd)      { REG(a) = REG(b) & REG(c); NEXT(); }
+    OPCODE(BC_BitOr)       { REG(a) = REG(b) | REG(c); NEXT(); }
+    OPCODE(BC_BitXor)      { REG(a) = REG(b) ^ REG(c); NEXT(); }
+    OPCODE(BC_Neg)         { REG(a) = ramBitCast(static_cast<RamUnsigned>(-UNSIGNED(b))); NEXT(); }
+    OPCODE(BC_FAdd)        { REG(a) = ramBitCast(static_cast<RamFloat>(FLOAT(b) + FLOAT(c))); NEXT(); }
+    OPCODE(BC_FSub)        { REG(a) = ramBitCast(static_cast<RamFloat>(FLOAT(b) - FLOAT(c))); NEXT(); }
+    OPCODE(BC_FMul)        { REG(a) = ramBitCast(static_cast<RamFloat>(FLOAT(b) * FLOAT(c))); NEXT(); }
+    OPCODE(BC_Jump)        { JUMP(); }
+    OPCODE(BC_Eq)          BRANCH(REG(a) == REG(b))
+    OPCODE(BC_Ne)          BRANCH(REG(a) != REG(b))
+    OPCODE(BC_Lt)          BRANCH(SIGNED(a) < SIGNED(b))
+    OPCODE(BC_Le)          BRANCH(SIGNED(a) <= SIGNED(b))
+    OPCODE(BC_Gt)          BRANCH(SIGNED(a) > SIGNED(b))
+    OPCODE(BC_Ge)          BRANCH(SIGNED(a) >= SIGNED(b))
+    OPCODE(BC_ULt)         BRANCH(UNSIGNED(a) < UNSIGNED(b))
+    OPCODE(BC_ULe)         BRANCH(UNSIGNED(a) <= UNSIGNED(b))
+    OPCODE(BC_UGt)         BRANCH(UNSIGNED(a) > UNSIGNED(b))
+    OPCODE(BC_UGe)         BRANCH(UNSIGNED(a) >= UNSIGNED(b))
+    OPCODE(BC_FEq)         BRANCH(FLOAT(a) == FLOAT(b))
+    OPCODE(BC_FNe)         BRANCH(FLOAT(a) != FLOAT(b))
+    OPCODE(BC_FLt)         BRANCH(FLOAT(a) < FLOAT(b))
+    OPCODE(BC_FLe)         BRANCH(FLOAT(a) <= FLOAT(b))
+    OPCODE(BC_FGt)         BRANCH(FLOAT(a) > FLOAT(b))
+    OPCODE(BC_FGe)         BRANCH(FLOAT(a) >= FLOAT(b))
+    OPCODE(BC_Test)        BRANCH(execute(ip->node, ctxt))
+    OPCODE(BC_ExistsTotal) BRANCH(MAY_CONTAIN(a) && ctxt.getView(ip->b)->contains(TupleRef(&REG(a), ip->c)))
+    OPCODE(BC_ExistsRange) BRANCH(MAY_CONTAIN(a) && ctxt.getView(ip->b)->contains(
+                                   TupleRef(&REG(a), ip->c), TupleRef(&REG(a) + ip->c, ip->c)))
+    // clang-format on
+
+    OPCODE(BC_Scan) {
+        STREAM(a) = (*ip->relation)->scan();
+        NEXT();
+    }
+
+    OPCODE(BC_Range) {
+        STREAM(a) = ctxt.getView(ip->b)->range(TupleRef(&REG(c), ip->d), TupleRef(&REG(c) + ip->d, ip->d));
+        NEXT();
+    }
+
+    OPCODE(BC_Load) {
+        // the current element stays valid until the stream is advanced by BC_Next
+        auto& stream = STREAM(a);
+        auto it = stream.begin();
+        if (it == stream.end()) {
+            JUMP();
+        }
+        ctxt[ip->b] = (*it).getBase();
+        NEXT();
+    }
+
+    OPCODE(BC_Next) {
+        ++STREAM(a).begin();
+        JUMP();
+    }
+
+    OPCODE(BC_Unpack) {
+        RamDomain ref = REG(a);
+        if (ref == 0) {
+            JUMP();
+        }
+        ctxt[ip->b] = getRecordTable().unpack(ref, ip->c);
+        NEXT();
+    }
+
+    OPCODE(BC_Insert) {
+        (*ip->relation)->insert(&REG(a));
+        NEXT();
+    }
+
+    OPCODE(BC_Exec) {
+        if (!execute(ip->node, ctxt)) {
+            JUMP();
+        }
+        NEXT();
+    }
+
+    OPCODE(BC_Return) {
+        result = ip->value;
+        goto done;
+    }
 
-    // initialize result
-    RamDomain res = 0;
+#ifndef __GNUC__
+    }
+#endif
 
-    // Use for calculating mean.
-    std::pair<RamFloat, RamFloat> accumulateMean;
+done:
+    ctxt.releaseStreams(streamBase);
+    return result;
+
+#undef REG
+#undef STREAM
+#undef SIGNED
+#undef UNSIGNED
+#undef FLOAT
+#undef MAY_CONTAIN
+#undef OPCODE
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef BRANCH
+}
 
-    switch (aggregate.getFunction()) {
-        case AggregateOp::MIN: res = ramBitCast(MAX_RAM_SIGNED); break;
-        case AggregateOp::UMIN: res = ramBitCast(MAX_RAM_UNSIGNED); break;
-        case AggregateOp::FMIN: res = ramBitCast(MAX_RAM_FLOAT); break;
+InterpreterEngine::AggregatePartial InterpreterEngine::initAggregate(AggregateOp function) {
+    AggregatePartial partial;
+    switch (function) {
+        case AggregateOp::MIN: partial.result = ramBitCast(MAX_RAM_SIGNED); break;
+        case AggregateOp::UMIN: partial.result = ramBitCast(MAX_RAM_UNSIGNED); break;
+        case AggregateOp::FMIN: partial.result = ramBitCast(MAX_RAM_FLOAT); break;
 
-        case AggregateOp::MAX: res = ramBitCast(MIN_RAM_SIGNED); break;
-        case AggregateOp::UMAX: res = ramBitCast(MIN_RAM_UNSIGNED); break;
-        case AggregateOp::FMAX: res = ramBitCast(MIN_RAM_FLOAT); break;
+        case AggregateOp::MAX: partial.result = ramBitCast(MIN_RAM_SIGNED); break;
+        case AggregateOp::UMAX: partial.result = ramBitCast(MIN_RAM_UNSIGNED); break;
+        case AggregateOp::FMAX: partial.result = ramBitCast(MIN_RAM_FLOAT); break;
 
         case AggregateOp::SUM:
-            res = ramBitCast(static_cast<RamSigned>(0));
-            shouldRunNested = true;
+            partial.result = ramBitCast(static_cast<RamSigned>(0));
+            partial.shouldRunNested = true;
             break;
         case AggregateOp::USUM:
-            res = ramBitCast(static_cast<RamUnsigned>(0));
-            shouldRunNested = true;
+            partial.result = ramBitCast(static_cast<RamUnsigned>(0));
+            partial.shouldRunNested = true;
             break;
         case AggregateOp::FSUM:
-            res = ramBitCast(static_cast<RamFloat>(0));
-            shouldRunNested = true;
+            partial.result = ramBitCast(static_cast<RamFloat>(0));
+            partial.shouldRunNested = true;
             break;
 
         case AggregateOp::MEAN:
-            res = 0;
-            accumulateMean = {0, 0};
+            partial.result = 0;
+            partial.accumulateMean = {0, 0};
             break;
 
         case AggregateOp::COUNT:
-            res = 0;
-            shouldRunNested = true;
+            partial.result = 0;
+            partial.shouldRunNested = true;
             break;
     }
+    return partial;
+}
+
+void InterpreterEngine::addToAggregate(AggregateOp function, AggregatePartial& partial, RamDomain val) {
+    RamDomain& res = partial.result;
+    switch (function) {
+        case AggregateOp::MIN: res = std::min(res, val); break;
+        case AggregateOp::FMIN:
+            res = ramBitCast(std::min(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMIN:
+            res = ramBitCast(std::min(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
+
+        case AggregateOp::MAX: res = std::max(res, val); break;
+        case AggregateOp::FMAX:
+            res = ramBitCast(std::max(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMAX:
+            res = ramBitCast(std::max(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
 
+        case AggregateOp::SUM: res += val; break;
+        case AggregateOp::FSUM:
+            res = ramBitCast(ramBitCast<RamFloat>(res) + ramBitCast<RamFloat>(val));
+            break;
+        case AggregateOp::USUM:
+            res = ramBitCast(ramBitCast<RamUnsigned>(res) + ramBitCast<RamUnsigned>(val));
+            break;
+
+        case AggregateOp::MEAN:
+            partial.accumulateMean.first += ramBitCast<RamFloat>(val);
+            partial.accumulateMean.second++;
+            break;
+
+        case AggregateOp::COUNT: fatal("This should never be executed");
+    }
+}
+
+void InterpreterEngine::combineAggregate(
+        AggregateOp function, AggregatePartial& partial, const AggregatePartial& other) {
+    partial.shouldRunNested |= other.shouldRunNested;
+    switch (function) {
+        case AggregateOp::COUNT: partial.result += other.result; break;
+        case AggregateOp::MEAN:
+            partial.accumulateMean.first += other.accumulateMean.first;
+            partial.accumulateMean.second += other.accumulateMean.second;
+            break;
+        // the remaining aggregates are associative in their values
+        default: addToAggregate(function, partial, other.result);
+    }
+}
+
+template <typename Aggregate>
+void InterpreterEngine::accumulateAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+        const InterpreterNode& filter, const InterpreterNode* expression, Stream& stream,
+        AggregatePartial& partial) {
     for (auto ip : stream) {
         const RamDomain* data = &ip[0];
         ctxt[aggregate.getTupleId()] = data;
@@ -1448,54 +2205,26 @@ RamDomain InterpreterEngine::executeAggregate(InterpreterContext& ctxt, const Ag
             continue;
         }
 
-        shouldRunNested = true;
+        partial.shouldRunNested = true;
 
         // count is a special case.
         if (aggregate.getFunction() == AggregateOp::COUNT) {
-            ++res;
+            ++partial.result;
             continue;
         }
 
         // eval target expression
         assert(expression);  // only case where this is null is `COUNT`
-        RamDomain val = execute(expression, ctxt);
-
-        switch (aggregate.getFunction()) {
-            case AggregateOp::MIN: res = std::min(res, val); break;
-            case AggregateOp::FMIN:
-                res = ramBitCast(std::min(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
-                break;
-            case AggregateOp::UMIN:
-                res = ramBitCast(std::min(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
-                break;
-
-            case AggregateOp::MAX: res = std::max(res, val); break;
-            case AggregateOp::FMAX:
-                res = ramBitCast(std::max(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
-                break;
-            case AggregateOp::UMAX:
-                res = ramBitCast(std::max(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
-                break;
-
-            case AggregateOp::SUM: res += val; break;
-            case AggregateOp::FSUM:
-                res = ramBitCast(ramBitCast<RamFloat>(res) + ramBitCast<RamFloat>(val));
-                break;
-            case AggregateOp::USUM:
-                res = ramBitCast(ramBitCast<RamUnsigned>(res) + ramBitCast<RamUnsigned>(val));
-                break;
-
-            case AggregateOp::MEAN:
-                accumulateMean.first += ramBitCast<RamFloat>(val);
-                accumulateMean.second++;
-                break;
-
-            case AggregateOp::COUNT: fatal("This should never be executed");
-        }
+        addToAggregate(aggregate.getFunction(), partial, execute(expression, ctxt));
     }
+}
 
-    if (aggregate.getFunction() == AggregateOp::MEAN && accumulateMean.second != 0) {
-        res = ramBitCast(accumulateMean.first / accumulateMean.second);
+template <typename Aggregate>
+RamDomain InterpreterEngine::finishAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+        const InterpreterNode& nestedOperation, const AggregatePartial& partial) {
+    RamDomain res = partial.result;
+    if (aggregate.getFunction() == AggregateOp::MEAN && partial.accumulateMean.second != 0) {
+        res = ramBitCast(partial.accumulateMean.first / partial.accumulateMean.second);
     }
 
     // write result to environment
@@ -1503,11 +2232,55 @@ RamDomain InterpreterEngine::executeAggregate(InterpreterContext& ctxt, const Ag
     tuple[0] = res;
     ctxt[aggregate.getTupleId()] = tuple;
 
-    if (!shouldRunNested) {
+    if (!partial.shouldRunNested) {
         return true;
     } else {
         return execute(&nestedOperation, ctxt);
     }
 }
 
+template <typename Aggregate>
+RamDomain InterpreterEngine::executeAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+        const InterpreterNode& filter, const InterpreterNode* expression,
+        const InterpreterNode& nestedOperation, Stream stream) {
+    AggregatePartial partial = initAggregate(aggregate.getFunction());
+    accumulateAggregate(ctxt, aggregate, filter, expression, stream, partial);
+    return finishAggregate(ctxt, aggregate, nestedOperation, partial);
+}
+
+template <typename Aggregate>
+RamDomain InterpreterEngine::executeParallelAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+        const InterpreterNode& filter, const InterpreterNode* expression,
+        const InterpreterNode& nestedOperation, InterpreterViewContext& viewContext,
+        PartitionedStream pStream) {
+    const auto& viewInfo = viewContext.getViewInfoForNested();
+    const AggregatePartial init = initAggregate(aggregate.getFunction());
+
+    // compute a partial result per partition; the partials are combined in partition
+    // order so that the result does not depend on the thread schedule
+    std::vector<AggregatePartial> partials(std::distance(pStream.begin(), pStream.end()), init);
+    PARALLEL_START
+        InterpreterContext newCtxt(ctxt);
+        for (const auto& info : viewInfo) {
+            newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+        }
+        pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+            accumulateAggregate(newCtxt, aggregate, filter, expression, *it,
+                    partials[std::distance(pStream.begin(), it)]);
+        }
+    PARALLEL_END
+
+    AggregatePartial result = init;
+    for (const auto& partial : partials) {
+        combineAggregate(aggregate.getFunction(), result, partial);
+    }
+
+    // the nested operation runs sequentially
+    InterpreterContext newCtxt(ctxt);
+    for (const auto& info : viewInfo) {
+        newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+    }
+    return finishAggregate(newCtxt, aggregate, nestedOperation, result);
+}
+
 }  // namespace souffle
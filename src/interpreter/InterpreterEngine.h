@@ -16,24 +16,34 @@
 
 #pragma once
 
+#include "AggregateOp.h"
 #include "Global.h"
+#include "interpreter/InterpreterBytecode.h"
 #include "interpreter/InterpreterContext.h"
 #include "interpreter/InterpreterGenerator.h"
 #include "interpreter/InterpreterIndex.h"
 #include "interpreter/InterpreterNode.h"
+#include "interpreter/InterpreterProfile.h"
 #include "interpreter/InterpreterRelation.h"
+#include "interpreter/InterpreterTier.h"
+#include "ram/Query.h"
 #include "ram/TranslationUnit.h"
+#include "ram/analysis/BloomFilter.h"
 #include "ram/analysis/Index.h"
+#include "souffle/PatternCache.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/ContainerUtil.h"
+#include <array>
 #include <atomic>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
@@ -54,19 +64,29 @@ class InterpreterEngine {
 public:
     InterpreterEngine(ram::TranslationUnit& tUnit)
             : profileEnabled(Global::config().has("profile")),
+              hotQueriesEnabled(Global::config().has("hot-queries")),
               numOfThreads(std::stoi(Global::config().get("jobs"))), tUnit(tUnit),
-              isa(tUnit.getAnalysis<ram::analysis::IndexAnalysis>()), generator(isa) {
+              isa(tUnit.getAnalysis<ram::analysis::IndexAnalysis>()),
+              generator(isa, tUnit.getAnalysis<ram::analysis::BloomFilterAnalysis>(),
+                      [this](const ram::UserDefinedOperator& op) { return prepareFunctorCall(op); }),
+              patternCache(tUnit.getSymbolTable()) {
 #ifdef _OPENMP
         if (numOfThreads > 0) {
             omp_set_num_threads(numOfThreads);
         }
 #endif
+        if (Global::config().has("tiered") && !profileEnabled) {
+            tier = mk<InterpreterTier>(Global::config().get("tiered-compiler"));
+            tierThreshold = std::stoull(Global::config().get("tiered")) * 1000000;
+        }
     }
     /** @brief Execute the main program */
     void executeMain();
     /** @brief Execute the subroutine program */
     void executeSubroutine(
             const std::string& name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret);
+    /** @brief Wait until the hot queries are compiled, return the number of queries running native code */
+    size_t waitForNativeQueries();
 
 private:
     /** @brief Generate intermediate representation from RAM */
@@ -85,13 +105,67 @@ private:
     ram::TranslationUnit& getTranslationUnit();
     /** @brief Execute the program */
     RamDomain execute(const InterpreterNode*, InterpreterContext&);
+    /** @brief Execute an operation lowered into bytecode */
+    RamDomain executeBytecode(const InterpreterBytecode&, InterpreterContext&);
+    /** @brief Execute a nested operation for the tuples of a stream that satisfy the batch predicates.
+     *  Return false if the nested operation requested a break. */
+    bool executeBatch(InterpreterContext& ctxt, Stream& stream, size_t tupleId,
+            const std::vector<InterpreterBatchPredicate>& predicates, const InterpreterNode& nested);
+    /** @brief Build the tuple encoded by a super-instruction and pass it to func */
+    template <typename Func>
+    auto evalSuperTuple(const InterpreterSuperInstruction& superInfo, InterpreterContext& ctxt, Func&& func);
+    /** @brief Build the bounds encoded by a super-instruction and pass them to func.
+     *  If Mirror is set, the upper bound repeats the non-constant values of the lower bound. */
+    template <bool Mirror, typename Func>
+    auto evalSuperBounds(const InterpreterSuperInstruction& superInfo, InterpreterContext& ctxt, Func&& func);
+    /** @brief Fill a tuple of the given arity (0: runtime arity) with encoded values.
+     *  Unless Generic is set, only constants and tuple elements are copied, expressions are ignored. */
+    template <size_t Arity, bool Generic>
+    void fillSuperTuple(RamDomain* tuple, const std::vector<RamDomain>& constants,
+            const std::vector<std::array<size_t, 3>>& tupleElements,
+            const std::vector<std::pair<size_t, Own<InterpreterNode>>>& exprs, InterpreterContext& ctxt);
+    /** Partial result of an aggregate over a part of its input */
+    struct AggregatePartial {
+        RamDomain result = 0;
+        /** Sum and number of values, for calculating mean */
+        std::pair<RamFloat, RamFloat> accumulateMean{0, 0};
+        bool shouldRunNested = false;
+    };
+    /** @brief Return the partial result of an aggregate over no input */
+    static AggregatePartial initAggregate(AggregateOp function);
+    /** @brief Add a value to the partial result of an aggregate */
+    static void addToAggregate(AggregateOp function, AggregatePartial& partial, RamDomain val);
+    /** @brief Combine two partial results of an aggregate */
+    static void combineAggregate(
+            AggregateOp function, AggregatePartial& partial, const AggregatePartial& other);
+    /** @brief Aggregate the elements of a stream into a partial result */
+    template <typename Aggregate>
+    void accumulateAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+            const InterpreterNode& filter, const InterpreterNode* expression, Stream& stream,
+            AggregatePartial& partial);
+    /** @brief Bind the result of an aggregate and execute the nested operation */
+    template <typename Aggregate>
+    RamDomain finishAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+            const InterpreterNode& nestedOperation, const AggregatePartial& partial);
     /** Execute helper. Common part of Aggregate & AggregateIndex. */
     template <typename Aggregate>
     RamDomain executeAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
             const InterpreterNode& filter, const InterpreterNode* expression,
             const InterpreterNode& nestedOperation, Stream stream);
+    /** Execute helper. Common part of ParallelAggregate & ParallelIndexAggregate. */
+    template <typename Aggregate>
+    RamDomain executeParallelAggregate(InterpreterContext& ctxt, const Aggregate& aggregate,
+            const InterpreterNode& filter, const InterpreterNode* expression,
+            const InterpreterNode& nestedOperation, InterpreterViewContext& viewContext,
+            PartitionedStream pStream);
+    /** Accesses the relations of a query compiled to native code */
+    class NativeQueryAdapter;
+    /** @brief Print the queries with the largest accumulated execution time */
+    void reportHotQueries(std::ostream& os) const;
     /** @brief Return method handler */
     void* getMethodHandle(const std::string& method);
+    /** @brief Resolve a user-defined functor and prepare its call interface */
+    std::shared_ptr<InterpreterFunctorCall> prepareFunctorCall(const ram::UserDefinedOperator& op);
     /** @brief Load DLL */
     const std::vector<void*>& loadDLL();
     /** @brief Return current iteration number for loop operation */
@@ -107,6 +181,8 @@ private:
 
     /** If profile is enable in this program */
     const bool profileEnabled;
+    /** If execution times of queries are recorded */
+    const bool hotQueriesEnabled;
     /** subroutines */
     VecOwn<InterpreterNode> subroutine;
     /** main program */
@@ -118,9 +194,16 @@ private:
     /** Loop iteration counter */
     size_t iteration = 0;
     /** Profile for rule frequencies */
-    std::map<std::string, std::deque<std::atomic<size_t>>> frequencies;
+    InterpreterProfileCounters frequencies;
     /** Profile for relation reads */
-    std::map<std::string, std::atomic<size_t>> reads;
+    InterpreterProfileCounters reads;
+    /** Accumulated execution time of a query */
+    struct QueryTime {
+        std::atomic<uint64_t> nanoseconds{0};
+        std::atomic<size_t> executions{0};
+    };
+    /** Execution times of queries, if enabled */
+    std::map<const ram::Query*, QueryTime> queryTimes;
     /** DLL */
     std::vector<void*> dll;
     /** Program */
@@ -129,8 +212,16 @@ private:
     ram::analysis::IndexAnalysis* isa;
     /** Interpreter program generator */
     NodeGenerator generator;
+    /** Compiled patterns and outcomes of string constraints */
+    PatternCache patternCache;
     /** Record Table*/
     RecordTable recordTable;
+    /** Arenas of evaluation contexts */
+    InterpreterContextArenas contextArenas;
+    /** Compiler of hot queries, if enabled; destroyed before the queries it compiled */
+    Own<InterpreterTier> tier;
+    /** Execution time in nanoseconds after which a query is compiled */
+    uint64_t tierThreshold = 0;
 };
 
 }  // namespace souffle
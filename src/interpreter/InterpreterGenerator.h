@@ -17,11 +17,15 @@
 
 #pragma once
 
+#include "FunctorOps.h"
 #include "Global.h"
 #include "RelationTag.h"
+#include "interpreter/InterpreterBytecode.h"
 #include "interpreter/InterpreterIndex.h"
 #include "interpreter/InterpreterNode.h"
+#include "interpreter/InterpreterProfile.h"
 #include "interpreter/InterpreterRelation.h"
+#include "interpreter/InterpreterTier.h"
 #include "interpreter/InterpreterViewContext.h"
 #include "ram/AbstractExistenceCheck.h"
 #include "ram/AbstractParallel.h"
@@ -43,9 +47,13 @@
 #include "ram/Extend.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/IO.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexMinMax.h"
 #include "ram/IndexOperation.h"
 #include "ram/IndexScan.h"
 #include "ram/IntrinsicOperator.h"
@@ -53,6 +61,7 @@
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
@@ -71,9 +80,11 @@
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Query.h"
 #include "ram/Relation.h"
+#include "ram/RelationOperation.h"
 #include "ram/RelationSize.h"
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -86,17 +97,21 @@
 #include "ram/UserDefinedOperator.h"
 #include "ram/Utils.h"
 #include "ram/Visitor.h"
+#include "ram/analysis/BloomFilter.h"
 #include "ram/analysis/Index.h"
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <typeinfo>
 #include <unordered_map>
@@ -116,9 +131,19 @@ class NodeGenerator : public ram::Visitor<Own<InterpreterNode>> {
     using RelationHandle = Own<InterpreterRelation>;
 
 public:
-    NodeGenerator(ram::analysis::IndexAnalysis* isa)
-            : isa(isa), isProvenance(Global::config().has("provenance")),
-              profileEnabled(Global::config().has("profile")) {}
+    NodeGenerator(ram::analysis::IndexAnalysis* isa, ram::analysis::BloomFilterAnalysis* bfa,
+            std::function<std::shared_ptr<InterpreterFunctorCall>(const ram::UserDefinedOperator&)>
+                    functorResolver)
+            : isa(isa), bfa(bfa), functorResolver(std::move(functorResolver)),
+              isProvenance(Global::config().has("provenance")),
+              profileEnabled(Global::config().has("profile")),
+              useBytecode(Global::config().has("bytecode") && !profileEnabled),
+              tiered(Global::config().has("tiered") && !profileEnabled),
+              bufferedInserts(Global::config().has("buffered-inserts")),
+              deferredIndexes(Global::config().has("deferred-indexes")),
+              memoryLimit(Global::config().has("memory-limit")
+                                  ? std::stoull(Global::config().get("memory-limit"))
+                                  : 0) {}
 
     /**
      * @brief Generate the tree based on given entry.
@@ -140,6 +165,11 @@ public:
             } else if (const auto* provExists = dynamic_cast<const ram::ProvenanceExistenceCheck*>(&node)) {
                 encodeIndexPos(*provExists);
                 encodeView(provExists);
+            } else if (const auto* intersection = dynamic_cast<const ram::IndexIntersection*>(&node)) {
+                for (size_t i = 0; i < intersection->getNumInputs(); ++i) {
+                    encodeIndexPos(*intersection, i);
+                    encodeView(&intersection->getRelationReference(i));
+                }
             }
         });
         // Parse program
@@ -171,7 +201,8 @@ public:
         for (const auto& arg : op.getArguments()) {
             children.push_back(visit(arg));
         }
-        return mk<InterpreterUserDefinedOperator>(I_UserDefinedOperator, &op, std::move(children));
+        return mk<InterpreterUserDefinedOperator>(
+                I_UserDefinedOperator, &op, std::move(children), functorResolver(op));
     }
 
     NodePtr visitNestedIntrinsicOperator(const ram::NestedIntrinsicOperator& op) override {
@@ -233,14 +264,33 @@ public:
                 isTotal = false;
             }
         }
-        return mk<InterpreterExistenceCheck>(
-                I_ExistenceCheck, &exists, isTotal, encodeView(&exists), std::move(superOp));
+        size_t readSlot = 0;
+        if (profileEnabled && !exists.getRelation().isTemp()) {
+            readSlot = readSlots.getSlot(exists.getRelation().getName());
+        }
+        return mk<InterpreterExistenceCheck>(I_ExistenceCheck, &exists, isTotal, encodeView(&exists),
+                std::move(superOp), readSlot, getFilteredRelation(exists));
     }
 
     NodePtr visitProvenanceExistenceCheck(const ram::ProvenanceExistenceCheck& provExists) override {
         InterpreterSuperInstruction superOp = getExistenceSuperInstInfo(provExists);
+        // The provenance annotations (rule number and height) are not part of the search
+        size_t arity = provExists.getRelation().getArity();
+        for (size_t i = arity - 2; i < arity; ++i) {
+            superOp.first[i] = MIN_RAM_SIGNED;
+            superOp.second[i] = MAX_RAM_SIGNED;
+        }
+        auto isAnnotation = [&](size_t column) { return column >= arity - 2; };
+        superOp.tupleFirst.erase(std::remove_if(superOp.tupleFirst.begin(), superOp.tupleFirst.end(),
+                                         [&](const auto& tuple) { return isAnnotation(tuple[0]); }),
+                superOp.tupleFirst.end());
+        superOp.exprFirst.erase(std::remove_if(superOp.exprFirst.begin(), superOp.exprFirst.end(),
+                                        [&](const auto& expr) { return isAnnotation(expr.first); }),
+                superOp.exprFirst.end());
+        superOp.computeShape();
         return mk<InterpreterProvenanceExistenceCheck>(I_ProvenanceExistenceCheck, &provExists,
-                visit(provExists.getChildNodes().back()), encodeView(&provExists), std::move(superOp));
+                visit(provExists.getChildNodes().back()), encodeView(&provExists), std::move(superOp),
+                getFilteredRelation(provExists));
     }
 
     // -- comparison operators --
@@ -254,39 +304,47 @@ public:
 
     NodePtr visitTupleOperation(const ram::TupleOperation& search) override {
         if (profileEnabled) {
-            return mk<InterpreterTupleOperation>(I_TupleOperation, &search, visit(search.getOperation()));
+            return mk<InterpreterTupleOperation>(I_TupleOperation, &search, visit(search.getOperation()),
+                    frequencySlots.getSlot(search.getProfileText()));
         }
-        return visit(search.getOperation());
+        return generateOperation(search.getOperation());
     }
 
     NodePtr visitScan(const ram::Scan& scan) override {
         size_t relId = encodeRelation(scan.getRelation());
         auto rel = relations[relId].get();
-        return mk<InterpreterScan>(I_Scan, &scan, rel, visitTupleOperation(scan));
+        std::vector<InterpreterBatchPredicate> predicates;
+        auto nested = visitBatchOperation(scan, predicates);
+        return mk<InterpreterScan>(I_Scan, &scan, rel, std::move(nested), std::move(predicates));
     }
 
     NodePtr visitParallelScan(const ram::ParallelScan& pScan) override {
         size_t relId = encodeRelation(pScan.getRelation());
         auto rel = relations[relId].get();
-        auto res = mk<InterpreterParallelScan>(I_ParallelScan, &pScan, rel, visitTupleOperation(pScan));
+        std::vector<InterpreterBatchPredicate> predicates;
+        auto nested = visitBatchOperation(pScan, predicates);
+        auto res = mk<InterpreterParallelScan>(
+                I_ParallelScan, &pScan, rel, std::move(nested), std::move(predicates));
         res->setViewContext(parentQueryViewContext);
         return res;
     }
 
     NodePtr visitIndexScan(const ram::IndexScan& scan) override {
         InterpreterSuperInstruction indexOperation = getIndexSuperInstInfo(scan);
-        NodePtrVec children;
-        children.push_back(visitTupleOperation(scan));
-        return mk<InterpreterIndexScan>(I_IndexScan, &scan, nullptr, visitTupleOperation(scan),
-                encodeView(&scan), std::move(indexOperation));
+        std::vector<InterpreterBatchPredicate> predicates;
+        auto nested = visitBatchOperation(scan, predicates);
+        return mk<InterpreterIndexScan>(I_IndexScan, &scan, nullptr, std::move(nested), encodeView(&scan),
+                std::move(indexOperation), std::move(predicates));
     }
 
     NodePtr visitParallelIndexScan(const ram::ParallelIndexScan& piscan) override {
         size_t relId = encodeRelation(piscan.getRelation());
         auto rel = relations[relId].get();
         InterpreterSuperInstruction indexOperation = getIndexSuperInstInfo(piscan);
-        auto res = mk<InterpreterParallelIndexScan>(I_ParallelIndexScan, &piscan, rel,
-                visitTupleOperation(piscan), encodeIndexPos(piscan), std::move(indexOperation));
+        std::vector<InterpreterBatchPredicate> predicates;
+        auto nested = visitBatchOperation(piscan, predicates);
+        auto res = mk<InterpreterParallelIndexScan>(I_ParallelIndexScan, &piscan, rel, std::move(nested),
+                encodeIndexPos(piscan), std::move(indexOperation), std::move(predicates));
         res->setViewContext(parentQueryViewContext);
         return res;
     }
@@ -361,26 +419,89 @@ public:
         auto rel = relations[relId].get();
         auto res = mk<InterpreterParallelIndexAggregate>(I_ParallelIndexAggregate, &aggregate, rel,
                 visit(aggregate.getExpression()), visit(aggregate.getCondition()),
-                visitTupleOperation(aggregate), encodeView(&aggregate), std::move(indexOperation));
+                visitTupleOperation(aggregate), encodeIndexPos(aggregate), std::move(indexOperation));
         res->setViewContext(parentQueryViewContext);
         return res;
     }
 
+    NodePtr visitIndexCount(const ram::IndexCount& count) override {
+        InterpreterSuperInstruction indexOperation = getIndexSuperInstInfo(count);
+        size_t relId = encodeRelation(count.getRelation());
+        auto rel = relations[relId].get();
+        return mk<InterpreterIndexCount>(I_IndexCount, &count, rel, visit(count.getExpression()),
+                visit(count.getCondition()), visitTupleOperation(count), encodeView(&count),
+                std::move(indexOperation));
+    }
+
+    NodePtr visitIndexMinMax(const ram::IndexMinMax& minMax) override {
+        // the shortcut requires a b-tree index ordered by the aggregated attribute after the bound ones
+        const ram::Relation& ramRel = minMax.getRelation();
+        RelationRepresentation representation = isa->getRepresentation(ramRel);
+        if (isProvenance || (representation != RelationRepresentation::BTREE &&
+                                    representation != RelationRepresentation::DEFAULT)) {
+            return visitIndexAggregate(minMax);
+        }
+        ram::analysis::SearchSignature signature = isa->getSearchSignature(&minMax);
+        size_t bound = 0;
+        for (size_t i = 0; i < signature.arity(); ++i) {
+            if (signature[i] == ram::analysis::AttributeConstraint::Equal) {
+                ++bound;
+            }
+        }
+        const auto& lexOrder = isa->getIndexes(ramRel).getLexOrder(signature);
+        if (lexOrder.size() <= bound || lexOrder[bound] != minMax.getColumn()) {
+            return visitIndexAggregate(minMax);
+        }
+
+        InterpreterSuperInstruction indexOperation = getIndexSuperInstInfo(minMax);
+        size_t relId = encodeRelation(ramRel);
+        auto rel = relations[relId].get();
+        return mk<InterpreterIndexMinMax>(I_IndexMinMax, &minMax, rel, visit(minMax.getExpression()),
+                visit(minMax.getCondition()), visitTupleOperation(minMax), encodeView(&minMax),
+                std::move(indexOperation));
+    }
+
+    NodePtr visitIndexIntersection(const ram::IndexIntersection& intersection) override {
+        std::vector<InterpreterIndexIntersection::Input> inputs;
+        for (size_t i = 0; i < intersection.getNumInputs(); ++i) {
+            // values are leapfrogged over if the index orders the attribute after the bound ones
+            const ram::Relation& ramRel = intersection.getRelation(i);
+            ram::analysis::SearchSignature signature = isa->getSearchSignature(&intersection, i);
+            size_t bound = 0;
+            for (size_t j = 0; j < signature.arity(); ++j) {
+                if (signature[j] == ram::analysis::AttributeConstraint::Equal) {
+                    ++bound;
+                }
+            }
+            const auto& lexOrder = isa->getIndexes(ramRel).getLexOrder(signature);
+            bool ordered = !isProvenance && lexOrder.size() > bound &&
+                           lexOrder[bound] == intersection.getColumn(i);
+            encodeRelation(ramRel);
+            inputs.push_back({encodeView(&intersection.getRelationReference(i)), intersection.getColumn(i),
+                    ordered, getRangeSuperInstInfo(intersection.getRangePattern(i))});
+        }
+        return mk<InterpreterIndexIntersection>(
+                I_IndexIntersection, &intersection, std::move(inputs), visitTupleOperation(intersection));
+    }
+
     NodePtr visitBreak(const ram::Break& breakOp) override {
         return mk<InterpreterBreak>(
                 I_Break, &breakOp, visit(breakOp.getCondition()), visit(breakOp.getOperation()));
     }
 
     NodePtr visitFilter(const ram::Filter& filter) override {
-        return mk<InterpreterFilter>(
-                I_Filter, &filter, visit(filter.getCondition()), visit(filter.getOperation()));
+        size_t profileSlot = profileEnabled ? frequencySlots.getSlot(filter.getProfileText()) : 0;
+        return mk<InterpreterFilter>(I_Filter, &filter, visit(filter.getCondition()),
+                visit(filter.getOperation()), profileSlot);
     }
 
     NodePtr visitProject(const ram::Project& project) override {
         InterpreterSuperInstruction superOp = getProjectSuperInstInfo(project);
         size_t relId = encodeRelation(project.getRelation());
         auto rel = relations[relId].get();
-        return mk<InterpreterProject>(I_Project, &project, rel, std::move(superOp));
+        auto pos = insertBuffers.find(&project.getRelation());
+        auto buffer = (pos != insertBuffers.end()) ? pos->second : nullptr;
+        return mk<InterpreterProject>(I_Project, &project, rel, std::move(superOp), std::move(buffer));
     }
 
     // -- return from subroutine --
@@ -454,6 +575,20 @@ public:
         return mk<InterpreterClear>(I_Clear, &clear, rel);
     }
 
+    NodePtr visitFreeze(const ram::Freeze& freeze) override {
+        size_t relId = encodeRelation(freeze.getRelation());
+        auto rel = relations[relId].get();
+        return mk<InterpreterFreeze>(I_Freeze, &freeze, rel);
+    }
+
+    NodePtr visitSpill(const ram::Spill& spill) override {
+        std::vector<RelationHandle*> rels;
+        for (const auto* rel : spill.getRelations()) {
+            rels.push_back(relations[encodeRelation(*rel)].get());
+        }
+        return mk<InterpreterSpill>(I_Spill, &spill, std::move(rels), memoryLimit);
+    }
+
     NodePtr visitLogSize(const ram::LogSize& size) override {
         size_t relId = encodeRelation(size.getRelation());
         auto rel = relations[relId].get();
@@ -504,14 +639,55 @@ public:
                 viewContext->addViewInfoForNested(encodeRelation(rel), indexTable[&node], encodeView(&node));
             };
         });
+        visitDepthFirst(*next, [&](const ram::IndexIntersection& intersection) {
+            for (size_t i = 0; i < intersection.getNumInputs(); ++i) {
+                const auto* input = &intersection.getRelationReference(i);
+                viewContext->addViewInfoForNested(
+                        encodeRelation(intersection.getRelation(i)), indexTable[input], encodeView(input));
+            }
+        });
 
         visitDepthFirst(*next, [&](const ram::AbstractParallel&) { viewContext->isParallel = true; });
 
+        // Let the threads of a parallel query collect the tuples projected into relations the query
+        // does not read in buffers of their own, merged into the relations once the query has finished.
+        insertBuffers.clear();
+        if (bufferedInserts && viewContext->isParallel) {
+            std::set<const ram::Relation*> read;
+            visitDepthFirst(*next, [&](const ram::Node& node) {
+                if (const auto* op = dynamic_cast<const ram::RelationOperation*>(&node)) {
+                    read.insert(&op->getRelation());
+                } else if (const auto* check = dynamic_cast<const ram::AbstractExistenceCheck*>(&node)) {
+                    read.insert(&check->getRelation());
+                } else if (const auto* check = dynamic_cast<const ram::EmptinessCheck*>(&node)) {
+                    read.insert(&check->getRelation());
+                } else if (const auto* size = dynamic_cast<const ram::RelationSize*>(&node)) {
+                    read.insert(&size->getRelation());
+                } else if (const auto* intersection = dynamic_cast<const ram::IndexIntersection*>(&node)) {
+                    for (size_t i = 0; i < intersection->getNumInputs(); ++i) {
+                        read.insert(&intersection->getRelation(i));
+                    }
+                }
+            });
+            visitDepthFirst(*next, [&](const ram::Project& project) {
+                const ram::Relation* rel = &project.getRelation();
+                if (rel->getArity() > 0 && !contains(read, rel) && !contains(insertBuffers, rel)) {
+                    auto buffer = std::make_shared<InterpreterInsertBuffer>(
+                            relations[encodeRelation(*rel)].get(), rel->getArity());
+                    viewContext->addInsertBuffer(buffer);
+                    insertBuffers[rel] = std::move(buffer);
+                }
+            });
+        }
+
         NodePtrVec children;
         children.push_back(visit(*next));
 
-        auto res = mk<InterpreterQuery>(I_Query, &query, visit(*next));
+        auto res = mk<InterpreterQuery>(I_Query, &query, generateOperation(*next));
         res->setViewContext(parentQueryViewContext);
+        if (tiered) {
+            res->setNativeQuery(encodeNativeQuery(*next));
+        }
         return res;
     }
 
@@ -521,6 +697,12 @@ public:
         return mk<InterpreterExtend>(I_Extend, &extend, src, target);
     }
 
+    NodePtr visitMerge(const ram::Merge& merge) override {
+        size_t src = encodeRelation(merge.getSourceRelation());
+        size_t target = encodeRelation(merge.getTargetRelation());
+        return mk<InterpreterMerge>(I_Merge, &merge, src, target);
+    }
+
     NodePtr visitSwap(const ram::Swap& swap) override {
         size_t src = encodeRelation(swap.getFirstRelation());
         size_t target = encodeRelation(swap.getSecondRelation());
@@ -546,11 +728,25 @@ public:
         return *relations[idx];
     }
 
+    /** @brief Return the profile slots for rule frequencies */
+    const InterpreterProfileSlots& getFrequencySlots() const {
+        return frequencySlots;
+    }
+
+    /** @brief Return the profile slots for relation reads, keyed by relation name */
+    const InterpreterProfileSlots& getReadSlots() const {
+        return readSlots;
+    }
+
 private:
     /** Environment encoding, store a mapping from ram::Node to its operation index id. */
     std::unordered_map<const ram::Node*, size_t> indexTable;
     /** Used by index encoding */
     ram::analysis::IndexAnalysis* isa;
+    /** Selects the relations maintaining Bloom filters */
+    ram::analysis::BloomFilterAnalysis* bfa;
+    /** Resolve a user-defined functor and prepare its call interface */
+    std::function<std::shared_ptr<InterpreterFunctorCall>(const ram::UserDefinedOperator&)> functorResolver;
     /** Points to the current viewContext during the generation.
      * It is used to passing viewContext between parent query and its nested parallel operation.
      * As parallel operation requires its own view information. */
@@ -569,6 +765,22 @@ private:
     const bool isProvenance;
     /** If profile is enable in this program */
     const bool profileEnabled;
+    /** If operations are lowered into bytecode */
+    const bool useBytecode;
+    /** If hot queries are compiled to native code */
+    const bool tiered;
+    /** If parallel queries buffer their projected tuples in thread-local buffers */
+    const bool bufferedInserts;
+    /** If temporary relations build their secondary indexes when they are first searched */
+    const bool deferredIndexes;
+    /** The number of resident bytes up to which spill statements do not spill relations */
+    const std::size_t memoryLimit;
+    /** The buffers collecting the tuples projected by the current query, by relation */
+    std::map<const ram::Relation*, std::shared_ptr<InterpreterInsertBuffer>> insertBuffers;
+    /** Profile counter slots for rule frequencies */
+    InterpreterProfileSlots frequencySlots;
+    /** Profile counter slots for relation reads */
+    InterpreterProfileSlots readSlots;
     /** ram::Program */
     ram::Program* program;
 
@@ -602,6 +814,15 @@ private:
         return i;
     };
 
+    /** @brief Return the index id of an input of an intersection from the result of indexAnalysis */
+    size_t encodeIndexPos(const ram::IndexIntersection& intersection, size_t input) {
+        const ram::Relation& rel = intersection.getRelation(input);
+        ram::analysis::SearchSignature signature = isa->getSearchSignature(&intersection, input);
+        auto i = isa->getIndexes(rel).getLexOrderNum(signature);
+        indexTable[&intersection.getRelationReference(input)] = i;
+        return i;
+    }
+
     /** @brief Encode and return the View id of an operation. */
     size_t encodeView(const ram::Node* node) {
         auto pos = viewTable.find(node);
@@ -625,6 +846,53 @@ private:
         return id;
     }
 
+    /**
+     * @brief Generate the code of the operation of a query, with the relation accesses it refers to.
+     * Return null if the operation can not be compiled.
+     */
+    std::shared_ptr<InterpreterNativeQuery> encodeNativeQuery(const ram::Operation& op) {
+        std::string code;
+        std::vector<const ram::Node*> nodes;
+        if (!generateNativeQuery(op, code, nodes)) {
+            return nullptr;
+        }
+        std::vector<InterpreterNativeAccess> accesses;
+        for (const ram::Node* node : nodes) {
+            InterpreterNativeAccess access;
+            if (const auto* piscan = dynamic_cast<const ram::ParallelIndexScan*>(node)) {
+                access.kind = InterpreterNativeAccess::ParallelRange;
+                access.relation = relations[encodeRelation(piscan->getRelation())].get();
+                access.view = encodeIndexPos(*piscan);
+            } else if (const auto* iscan = dynamic_cast<const ram::IndexScan*>(node)) {
+                access.kind = InterpreterNativeAccess::Range;
+                access.relation = relations[encodeRelation(iscan->getRelation())].get();
+                access.view = encodeView(iscan);
+            } else if (const auto* pscan = dynamic_cast<const ram::ParallelScan*>(node)) {
+                access.kind = InterpreterNativeAccess::ParallelScan;
+                access.relation = relations[encodeRelation(pscan->getRelation())].get();
+            } else if (const auto* scan = dynamic_cast<const ram::Scan*>(node)) {
+                access.kind = InterpreterNativeAccess::Scan;
+                access.relation = relations[encodeRelation(scan->getRelation())].get();
+            } else if (const auto* exists = dynamic_cast<const ram::ExistenceCheck*>(node)) {
+                access.kind = InterpreterNativeAccess::Contains;
+                access.relation = relations[encodeRelation(exists->getRelation())].get();
+                access.view = encodeView(exists);
+                access.filtered = bfa->isFiltered(*exists);
+            } else if (const auto* emptiness = dynamic_cast<const ram::EmptinessCheck*>(node)) {
+                access.kind = InterpreterNativeAccess::Empty;
+                access.relation = relations[encodeRelation(emptiness->getRelation())].get();
+            } else {
+                const auto& project = *as<ram::Project>(node);
+                access.kind = InterpreterNativeAccess::Insert;
+                access.relation = relations[encodeRelation(project.getRelation())].get();
+                auto pos = insertBuffers.find(&project.getRelation());
+                access.buffer = (pos != insertBuffers.end()) ? pos->second : nullptr;
+            }
+            accesses.push_back(std::move(access));
+        }
+        return std::make_shared<InterpreterNativeQuery>(std::move(code), std::move(accesses));
+    }
+
     /**
      * @brief Find all operations under the root node that requires a view.
      * Return a list of InterpreterNodes.
@@ -699,9 +967,13 @@ private:
         if (relations.size() < idx + 1) {
             relations.resize(idx + 1);
         }
-        if (id.getRepresentation() == RelationRepresentation::EQREL) {
+        RelationRepresentation representation = isa->getRepresentation(id);
+        if (representation == RelationRepresentation::EQREL) {
             res = mk<InterpreterEqRelation>(id.getArity(), id.getAuxiliaryArity(), id.getName(),
                     std::vector<std::string>(), orderSet);
+        } else if (representation == RelationRepresentation::HASHSET && !isProvenance) {
+            res = mk<InterpreterHashsetRelation>(id.getArity(), id.getAuxiliaryArity(), id.getName(),
+                    std::vector<std::string>(), orderSet);
         } else {
             if (isProvenance) {
                 res = mk<InterpreterRelation>(id.getArity(), id.getAuxiliaryArity(), id.getName(),
@@ -709,18 +981,49 @@ private:
             } else {
                 res = mk<InterpreterRelation>(id.getArity(), id.getAuxiliaryArity(), id.getName(),
                         std::vector<std::string>(), orderSet);
+                // indexes whose ranges are counted cache the sizes of their sub-trees
+                for (size_t i = 0; i < orderSet.getAllOrders().size(); ++i) {
+                    if (orderSet.isCounted(i)) {
+                        res->replaceIndex(i, createCountedBTreeIndex);
+                    }
+                }
+                // the secondary indexes of temporary relations are mostly read after they are filled
+                if (deferredIndexes && id.isTemp()) {
+                    res->deferIndexes();
+                }
             }
         }
+        if (bfa->hasFilter(id)) {
+            res->enableFilter(bfa->getCapacity(id));
+        }
         relations[idx] = mk<RelationHandle>(std::move(res));
     }
 
+    /**
+     * @brief Get the handle of the relation of an existence check if the check consults its Bloom filter
+     */
+    RelationHandle* getFilteredRelation(const ram::AbstractExistenceCheck& exists) {
+        if (!bfa->isFiltered(exists)) {
+            return nullptr;
+        }
+        return relations[encodeRelation(exists.getRelation())].get();
+    }
+
     /**
      * @brief Encode and return the super-instruction information about a index operation.
      */
     InterpreterSuperInstruction getIndexSuperInstInfo(const ram::IndexOperation& ramIndex) {
-        size_t arity = ramIndex.getRelation().getArity();
+        return getRangeSuperInstInfo(ramIndex.getRangePattern());
+    }
+
+    /**
+     * @brief Encode and return the super-instruction information about the bounds of a range.
+     */
+    InterpreterSuperInstruction getRangeSuperInstInfo(
+            const std::pair<std::vector<ram::Expression*>, std::vector<ram::Expression*>>& pattern) {
+        size_t arity = pattern.first.size();
         InterpreterSuperInstruction indexOperation(arity);
-        const auto& first = ramIndex.getRangePattern().first;
+        const auto& first = pattern.first;
         for (size_t i = 0; i < arity; ++i) {
             auto& low = first[i];
             // Unbounded
@@ -746,7 +1049,7 @@ private:
             // Generic expression
             indexOperation.exprFirst.push_back(std::pair<size_t, Own<InterpreterNode>>(i, visit(low)));
         }
-        const auto& second = ramIndex.getRangePattern().second;
+        const auto& second = pattern.second;
         for (size_t i = 0; i < arity; ++i) {
             auto& hig = second[i];
             // Unbounded
@@ -772,6 +1075,7 @@ private:
             // Generic expression
             indexOperation.exprSecond.push_back(std::pair<size_t, Own<InterpreterNode>>(i, visit(hig)));
         }
+        indexOperation.computeShape();
         return indexOperation;
     }
 
@@ -808,6 +1112,7 @@ private:
             // Generic expression
             superOp.exprFirst.push_back(std::pair<size_t, Own<InterpreterNode>>(i, visit(child)));
         }
+        superOp.computeShape();
         return superOp;
     }
 
@@ -836,7 +1141,331 @@ private:
             // Generic expression
             superOp.exprFirst.push_back(std::pair<size_t, Own<InterpreterNode>>(i, visit(child)));
         }
+        superOp.computeShape();
         return superOp;
     }
+
+    /**
+     * @brief Generate the nested operation of a scan.
+     * The numeric constraints of the filters directly nested in the scan are encoded as
+     * predicates evaluated over batches of tuples, and the filters are skipped. Filters are
+     * only absorbed as a whole; the chain stops at the first filter with another condition.
+     */
+    NodePtr visitBatchOperation(
+            const ram::TupleOperation& scan, std::vector<InterpreterBatchPredicate>& predicates) {
+        if (profileEnabled) {
+            return visitTupleOperation(scan);
+        }
+        const ram::Operation* nested = &scan.getOperation();
+        while (const auto* filter = dynamic_cast<const ram::Filter*>(nested)) {
+            std::vector<InterpreterBatchPredicate> filterPredicates;
+            if (!getBatchPredicates(filter->getCondition(), scan.getTupleId(), filterPredicates)) {
+                break;
+            }
+            predicates.insert(predicates.end(), filterPredicates.begin(), filterPredicates.end());
+            nested = &filter->getOperation();
+        }
+        return generateOperation(*nested);
+    }
+
+    /**
+     * @brief Encode a condition as predicates over the tuple with the given id.
+     * Return false if the condition has parts that cannot be evaluated over batches.
+     */
+    static bool getBatchPredicates(
+            const ram::Condition& cond, size_t tupleId, std::vector<InterpreterBatchPredicate>& predicates) {
+        if (const auto* conj = dynamic_cast<const ram::Conjunction*>(&cond)) {
+            return getBatchPredicates(conj->getLHS(), tupleId, predicates) &&
+                   getBatchPredicates(conj->getRHS(), tupleId, predicates);
+        }
+        // only numeric comparisons, i.e. those with a bytecode equivalent
+        const auto* constraint = dynamic_cast<const ram::Constraint*>(&cond);
+        if (constraint == nullptr || getCompareOpcode(constraint->getOperator()) == BC_Test) {
+            return false;
+        }
+        InterpreterBatchPredicate predicate;
+        predicate.op = constraint->getOperator();
+        if (!getBatchOperand(constraint->getLHS(), tupleId, predicate.lhs) ||
+                !getBatchOperand(constraint->getRHS(), tupleId, predicate.rhs)) {
+            return false;
+        }
+        predicates.push_back(predicate);
+        return true;
+    }
+
+    /** @brief Encode an operand of a batch predicate; fail unless it is a constant or tuple element */
+    static bool getBatchOperand(
+            const ram::Expression& expr, size_t tupleId, InterpreterBatchPredicate::Operand& operand) {
+        if (const auto* constant = dynamic_cast<const ram::Constant*>(&expr)) {
+            operand.kind = InterpreterBatchPredicate::Operand::CONSTANT;
+            operand.value = constant->getConstant();
+            return true;
+        }
+        if (const auto* element = dynamic_cast<const ram::TupleElement*>(&expr)) {
+            bool isScanned = static_cast<size_t>(element->getTupleId()) == tupleId;
+            operand.kind = isScanned ? InterpreterBatchPredicate::Operand::COLUMN
+                                     : InterpreterBatchPredicate::Operand::TUPLE_ELEMENT;
+            operand.tupleId = element->getTupleId();
+            operand.element = element->getElement();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Generate the node of an operation.
+     * Operations are lowered into bytecode if enabled; operations without a bytecode
+     * equivalent (e.g. parallel operations) remain tree nodes, and their nested
+     * operations are lowered in turn.
+     */
+    NodePtr generateOperation(const ram::Operation& op) {
+        if (!useBytecode || isA<ram::AbstractParallel>(&op)) {
+            return visit(op);
+        }
+        if (isA<ram::Scan>(&op) || isA<ram::IndexScan>(&op) || isA<ram::Filter>(&op) ||
+                isA<ram::Break>(&op) || isA<ram::Project>(&op) || isA<ram::UnpackRecord>(&op)) {
+            BytecodeBuilder bc;
+            size_t breakLabel = bc.newLabel();
+            lowerOperation(bc, op, breakLabel);
+            bc.emit(BC_Return).value = true;
+            bc.placeLabel(breakLabel);
+            bc.emit(BC_Return).value = false;
+            return bc.build(I_Bytecode, &op);
+        }
+        return visit(op);
+    }
+
+    /**
+     * @brief Lower an operation into bytecode.
+     * A nested operation requesting a break jumps to breakLabel.
+     */
+    void lowerOperation(BytecodeBuilder& bc, const ram::Operation& op, size_t breakLabel) {
+        if (const auto* filter = dynamic_cast<const ram::Filter*>(&op)) {
+            size_t end = bc.newLabel();
+            lowerCondition(bc, filter->getCondition(), end, false);
+            lowerOperation(bc, filter->getOperation(), breakLabel);
+            bc.placeLabel(end);
+        } else if (const auto* breakOp = dynamic_cast<const ram::Break*>(&op)) {
+            lowerCondition(bc, breakOp->getCondition(), breakLabel, true);
+            lowerOperation(bc, breakOp->getOperation(), breakLabel);
+        } else if (const auto* project = dynamic_cast<const ram::Project*>(&op);
+                   project != nullptr && !contains(insertBuffers, &project->getRelation())) {
+            const auto& values = project->getValues();
+            size_t tuple = bc.newRegisters(values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                lowerExpression(bc, *values[i], tuple + i);
+            }
+            auto* rel = relations[encodeRelation(project->getRelation())].get();
+            auto& insert = bc.emit(BC_Insert);
+            insert.a = tuple;
+            insert.relation = rel;
+        } else if (isA<ram::AbstractParallel>(&op)) {
+            const InterpreterNode* node = bc.addFallback(visit(op));
+            bc.emitJump(BC_Exec, breakLabel).node = node;
+        } else if (const auto* scan = dynamic_cast<const ram::Scan*>(&op)) {
+            auto* rel = relations[encodeRelation(scan->getRelation())].get();
+            size_t stream = bc.newStream();
+            auto& init = bc.emit(BC_Scan);
+            init.a = stream;
+            init.relation = rel;
+            lowerLoop(bc, *scan, stream);
+        } else if (const auto* indexScan = dynamic_cast<const ram::IndexScan*>(&op)) {
+            size_t arity = indexScan->getRelation().getArity();
+            size_t bounds = bc.newRegisters(2 * arity);
+            const auto& pattern = indexScan->getRangePattern();
+            for (size_t i = 0; i < arity; ++i) {
+                lowerBound(bc, pattern.first[i], bounds + i, MIN_RAM_SIGNED);
+                lowerBound(bc, pattern.second[i], bounds + arity + i, MAX_RAM_SIGNED);
+            }
+            size_t view = encodeView(indexScan);
+            size_t stream = bc.newStream();
+            auto& init = bc.emit(BC_Range);
+            init.a = stream;
+            init.b = view;
+            init.c = bounds;
+            init.d = arity;
+            lowerLoop(bc, *indexScan, stream);
+        } else if (const auto* unpack = dynamic_cast<const ram::UnpackRecord*>(&op)) {
+            size_t ref = bc.newRegisters();
+            lowerExpression(bc, unpack->getExpression(), ref);
+            size_t end = bc.newLabel();
+            auto& inst = bc.emitJump(BC_Unpack, end);
+            inst.a = ref;
+            inst.b = unpack->getTupleId();
+            inst.c = unpack->getArity();
+            lowerOperation(bc, unpack->getOperation(), breakLabel);
+            bc.placeLabel(end);
+        } else {
+            // remaining operations, and projections into buffers, are executed by their nodes
+            const InterpreterNode* node = bc.addFallback(visit(op));
+            bc.emitJump(BC_Exec, breakLabel).node = node;
+        }
+    }
+
+    /** @brief Lower the loop over the elements of a stream slot */
+    void lowerLoop(BytecodeBuilder& bc, const ram::TupleOperation& op, size_t stream) {
+        size_t head = bc.newLabel();
+        size_t exit = bc.newLabel();
+        bc.placeLabel(head);
+        auto& load = bc.emitJump(BC_Load, exit);
+        load.a = stream;
+        load.b = op.getTupleId();
+        lowerOperation(bc, op.getOperation(), exit);
+        bc.emitJump(BC_Next, head).a = stream;
+        bc.placeLabel(exit);
+    }
+
+    /**
+     * @brief Lower a condition into conditional jumps.
+     * Control jumps to label if the condition evaluates to jumpIfTrue, and falls through otherwise.
+     */
+    void lowerCondition(BytecodeBuilder& bc, const ram::Condition& cond, size_t label, bool jumpIfTrue) {
+        if (const auto* conj = dynamic_cast<const ram::Conjunction*>(&cond)) {
+            if (jumpIfTrue) {
+                size_t skip = bc.newLabel();
+                lowerCondition(bc, conj->getLHS(), skip, false);
+                lowerCondition(bc, conj->getRHS(), label, true);
+                bc.placeLabel(skip);
+            } else {
+                lowerCondition(bc, conj->getLHS(), label, false);
+                lowerCondition(bc, conj->getRHS(), label, false);
+            }
+        } else if (const auto* neg = dynamic_cast<const ram::Negation*>(&cond)) {
+            lowerCondition(bc, neg->getOperand(), label, !jumpIfTrue);
+        } else if (isA<ram::True>(&cond)) {
+            if (jumpIfTrue) {
+                bc.emitJump(BC_Jump, label);
+            }
+        } else if (isA<ram::False>(&cond)) {
+            if (!jumpIfTrue) {
+                bc.emitJump(BC_Jump, label);
+            }
+        } else if (const auto* constraint = dynamic_cast<const ram::Constraint*>(&cond);
+                   constraint != nullptr && getCompareOpcode(constraint->getOperator()) != BC_Test) {
+            size_t lhs = bc.newRegisters();
+            lowerExpression(bc, constraint->getLHS(), lhs);
+            size_t rhs = bc.newRegisters();
+            lowerExpression(bc, constraint->getRHS(), rhs);
+            auto& inst = bc.emitJump(getCompareOpcode(constraint->getOperator()), label, jumpIfTrue);
+            inst.a = lhs;
+            inst.b = rhs;
+        } else if (const auto* exists = dynamic_cast<const ram::ExistenceCheck*>(&cond)) {
+            const auto& values = exists->getValues();
+            size_t arity = values.size();
+            bool isTotal = std::none_of(
+                    values.begin(), values.end(), [](const ram::Expression* e) { return isUndefValue(e); });
+            size_t pattern = bc.newRegisters(isTotal ? arity : 2 * arity);
+            for (size_t i = 0; i < arity; ++i) {
+                if (isTotal) {
+                    lowerExpression(bc, *values[i], pattern + i);
+                } else if (isUndefValue(values[i])) {
+                    bc.emitConstant(pattern + i, MIN_RAM_SIGNED);
+                    bc.emitConstant(pattern + arity + i, MAX_RAM_SIGNED);
+                } else {
+                    lowerExpression(bc, *values[i], pattern + i);
+                    auto& move = bc.emit(BC_Move);
+                    move.a = pattern + arity + i;
+                    move.b = pattern + i;
+                }
+            }
+            size_t view = encodeView(exists);
+            auto& inst = bc.emitJump(isTotal ? BC_ExistsTotal : BC_ExistsRange, label, jumpIfTrue);
+            inst.a = pattern;
+            inst.b = view;
+            inst.c = arity;
+            inst.relation = getFilteredRelation(*exists);
+        } else {
+            const InterpreterNode* node = bc.addFallback(visit(cond));
+            bc.emitJump(BC_Test, label, jumpIfTrue).node = node;
+        }
+    }
+
+    /** @brief Lower an expression, storing its value in register dst */
+    void lowerExpression(BytecodeBuilder& bc, const ram::Expression& expr, size_t dst) {
+        if (const auto* constant = dynamic_cast<const ram::Constant*>(&expr)) {
+            bc.emitConstant(dst, constant->getConstant());
+        } else if (const auto* element = dynamic_cast<const ram::TupleElement*>(&expr)) {
+            auto& inst = bc.emit(BC_TupleElement);
+            inst.a = dst;
+            inst.b = element->getTupleId();
+            inst.c = element->getElement();
+        } else if (const auto* op = dynamic_cast<const ram::IntrinsicOperator*>(&expr);
+                   op != nullptr && getArithmeticOpcode(*op) != BC_Eval) {
+            const auto& args = op->getArguments();
+            size_t operands = bc.newRegisters(args.size());
+            for (size_t i = 0; i < args.size(); ++i) {
+                lowerExpression(bc, *args[i], operands + i);
+            }
+            auto& inst = bc.emit(getArithmeticOpcode(*op));
+            inst.a = dst;
+            inst.b = operands;
+            inst.c = operands + 1;
+        } else {
+            const InterpreterNode* node = bc.addFallback(visit(expr));
+            auto& inst = bc.emit(BC_Eval);
+            inst.a = dst;
+            inst.node = node;
+        }
+    }
+
+    /** @brief Lower a bound of a range pattern; an undefined bound becomes the given constant */
+    void lowerBound(BytecodeBuilder& bc, const ram::Expression* bound, size_t dst, RamDomain unbounded) {
+        if (isUndefValue(bound)) {
+            bc.emitConstant(dst, unbounded);
+        } else {
+            lowerExpression(bc, *bound, dst);
+        }
+    }
+
+    /** @brief Return the opcode of an arithmetic functor, or BC_Eval if it has none */
+    static BytecodeOpcode getArithmeticOpcode(const ram::IntrinsicOperator& op) {
+        if (op.getArguments().size() == 1) {
+            return op.getOperator() == FunctorOp::NEG ? BC_Neg : BC_Eval;
+        }
+        if (op.getArguments().size() != 2) {
+            return BC_Eval;
+        }
+        switch (op.getOperator()) {
+            case FunctorOp::ADD:
+            case FunctorOp::UADD: return BC_Add;
+            case FunctorOp::SUB:
+            case FunctorOp::USUB: return BC_Sub;
+            case FunctorOp::MUL:
+            case FunctorOp::UMUL: return BC_Mul;
+            case FunctorOp::BAND:
+            case FunctorOp::UBAND: return BC_BitAnd;
+            case FunctorOp::BOR:
+            case FunctorOp::UBOR: return BC_BitOr;
+            case FunctorOp::BXOR:
+            case FunctorOp::UBXOR: return BC_BitXor;
+            case FunctorOp::FADD: return BC_FAdd;
+            case FunctorOp::FSUB: return BC_FSub;
+            case FunctorOp::FMUL: return BC_FMul;
+            default: return BC_Eval;
+        }
+    }
+
+    /** @brief Return the conditional jump of a numeric comparison, or BC_Test if it has none */
+    static BytecodeOpcode getCompareOpcode(BinaryConstraintOp op) {
+        switch (op) {
+            case BinaryConstraintOp::EQ: return BC_Eq;
+            case BinaryConstraintOp::NE: return BC_Ne;
+            case BinaryConstraintOp::LT: return BC_Lt;
+            case BinaryConstraintOp::LE: return BC_Le;
+            case BinaryConstraintOp::GT: return BC_Gt;
+            case BinaryConstraintOp::GE: return BC_Ge;
+            case BinaryConstraintOp::ULT: return BC_ULt;
+            case BinaryConstraintOp::ULE: return BC_ULe;
+            case BinaryConstraintOp::UGT: return BC_UGt;
+            case BinaryConstraintOp::UGE: return BC_UGe;
+            case BinaryConstraintOp::FEQ: return BC_FEq;
+            case BinaryConstraintOp::FNE: return BC_FNe;
+            case BinaryConstraintOp::FLT: return BC_FLt;
+            case BinaryConstraintOp::FLE: return BC_FLe;
+            case BinaryConstraintOp::FGT: return BC_FGt;
+            case BinaryConstraintOp::FGE: return BC_FGe;
+            default: return BC_Test;
+        }
+    }
 };
 }  // namespace souffle
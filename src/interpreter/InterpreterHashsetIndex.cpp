@@ -0,0 +1,369 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InterpreterHashsetIndex.cpp
+ *
+ * Interpreter index with generic interface.
+ *
+ ***********************************************************************/
+
+#include "interpreter/InterpreterIndex.h"
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/HashSet.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * An index adapter for hash sets. Tuples are stored in their original attribute
+ * order; the hash set is keyed on the given number of leading attributes of the
+ * simulated order. Lookups binding all key attributes to single values follow
+ * the chain of the key, all other lookups scan the tuples.
+ *
+ * Relations of arities without a dedicated instantiation are stored in entries
+ * of the next larger arity, padded with zeros.
+ */
+template <std::size_t Arity>
+class HashsetIndex : public InterpreterIndex {
+    using Set = HashSet<Arity>;
+    using Entry = typename Set::element_type;
+    using Attributes = typename Set::attribute_set;
+
+    // the simulated order and the arity of the stored tuples
+    Order order;
+    std::size_t arity;
+
+    // the internal data structure
+    Set data;
+
+    /** A lookup for the tuples within the bounds of a range */
+    struct Lookup {
+        Entry low{};
+        Entry high{};
+
+        // the attributes bound to single values; the padding components are always bound
+        Attributes equal;
+
+        // whether some attribute is bounded without being bound to a single value
+        bool filtered = false;
+
+        Lookup(const TupleRef& lowRef, const TupleRef& highRef, std::size_t arity) {
+            for (std::size_t i = 0; i < Arity; ++i) {
+                if (i >= arity || lowRef[i] == highRef[i]) {
+                    equal.set(i);
+                }
+                if (i < arity) {
+                    low[i] = lowRef[i];
+                    high[i] = highRef[i];
+                    filtered |= lowRef[i] != highRef[i] &&
+                                (lowRef[i] != MIN_RAM_SIGNED || highRef[i] != MAX_RAM_SIGNED);
+                }
+            }
+        }
+
+        bool within(const Entry& tuple) const {
+            for (std::size_t i = 0; i < Arity; ++i) {
+                if (tuple[i] < low[i] || high[i] < tuple[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // a source adapter for streaming through data, optionally filtered by the bounds of a lookup
+    template <typename Iter>
+    class Source : public Stream::Source {
+        std::size_t arity;
+
+        // the begin and end of the stream
+        Iter cur;
+        Iter end;
+
+        // the bounds to filter by, if any
+        std::shared_ptr<const Lookup> lookup;
+
+        // references to the elements of the current batch
+        std::array<TupleRef, Stream::BUFFER_SIZE> buffer;
+
+    public:
+        Source(std::size_t arity, Iter begin, Iter end, std::shared_ptr<const Lookup> lookup = nullptr)
+                : arity(arity), cur(std::move(begin)), end(std::move(end)), lookup(std::move(lookup)) {}
+
+        int load(TupleRef* out, int max) override {
+            int c = 0;
+            for (; cur != end && c < max; ++cur) {
+                if (lookup == nullptr || lookup->within(*cur)) {
+                    buffer[c] = TupleRef(&(*cur)[0], arity);
+                    out[c] = buffer[c];
+                    ++c;
+                }
+            }
+            return c;
+        }
+
+        int reload(TupleRef* out, int max) override {
+            max = std::min(max, Stream::BUFFER_SIZE);
+            std::copy(buffer.begin(), buffer.begin() + max, out);
+            return max;
+        }
+
+        Own<Stream::Source> clone() override {
+            auto source = mk<Source>(arity, cur, end, lookup);
+            source->buffer = buffer;
+            return source;
+        }
+    };
+
+    // The hash index view -- does not require any hints.
+    struct HashsetIndexView : public IndexView {
+        const HashsetIndex& index;
+
+        HashsetIndexView(const HashsetIndex& index) : index(index) {}
+
+        bool contains(const TupleRef& tuple) const override {
+            return index.contains(tuple);
+        }
+
+        bool contains(const TupleRef& low, const TupleRef& high) const override {
+            return index.contains(low, high);
+        }
+
+        Stream range(const TupleRef& low, const TupleRef& high) const override {
+            return index.range(low, high);
+        }
+
+        bool boundary(const TupleRef& low, const TupleRef& high, bool last, RamDomain* res) const override {
+            return index.boundary(low, high, last, res);
+        }
+
+        size_t getArity() const override {
+            return index.getArity();
+        }
+    };
+
+    // pads a tuple with zeros to an entry
+    Entry pad(const TupleRef& tuple) const {
+        if (tuple.size() == Arity) {
+            return tuple.asTuple<Arity>();
+        }
+        assert(tuple.size() == arity && arity < Arity);
+        Entry res{};
+        std::copy(tuple.getBase(), tuple.getBase() + arity, &res[0]);
+        return res;
+    }
+
+    // whether the first tuple precedes the second one in the simulated order
+    bool precedes(const Entry& a, const Entry& b) const {
+        for (std::size_t attribute : order.getOrder()) {
+            if (a[attribute] != b[attribute]) {
+                return a[attribute] < b[attribute];
+            }
+        }
+        return false;
+    }
+
+    // the least or greatest tuple of a range in the simulated order, which is not kept by the hash set
+    template <typename Range>
+    const Entry* boundaryOf(const Range& range, const Lookup& lookup, bool filtered, bool last) const {
+        const Entry* res = nullptr;
+        for (const auto& cur : range) {
+            if (filtered && !lookup.within(cur)) {
+                continue;
+            }
+            if (res == nullptr || (last ? precedes(*res, cur) : precedes(cur, *res))) {
+                res = &cur;
+            }
+        }
+        return res;
+    }
+
+    bool boundary(const TupleRef& low, const TupleRef& high, bool last, RamDomain* res) const {
+        Lookup lookup(low, high, arity);
+        const Entry* found = isKeyed(lookup) ? boundaryOf(data.equalRange(lookup.low, lookup.equal), lookup,
+                                                       lookup.filtered, last)
+                                             : boundaryOf(data, lookup, true, last);
+        if (found == nullptr) {
+            return false;
+        }
+        std::copy(&(*found)[0], &(*found)[0] + arity, res);
+        return true;
+    }
+
+    // whether a lookup can follow the chains of the hash set
+    bool isKeyed(const Lookup& lookup) const {
+        return lookup.equal.all() || (lookup.equal & data.getKey()) == data.getKey();
+    }
+
+    // the key of a hash set keyed on the given number of leading attributes of an order
+    static std::vector<std::size_t> getKey(const Order& order, std::size_t keySize) {
+        if (keySize >= order.size()) {
+            return Set::allAttributes();
+        }
+        const auto& attributes = order.getOrder();
+        return std::vector<std::size_t>(attributes.begin(), attributes.begin() + keySize);
+    }
+
+public:
+    HashsetIndex(Order order, std::size_t keySize)
+            : order(order), arity(order.size()), data(getKey(order, keySize)) {}
+
+    IndexViewPtr createView() const override {
+        return mk<HashsetIndexView>(*this);
+    }
+
+    size_t getArity() const override {
+        return arity;
+    }
+
+    bool empty() const override {
+        return data.empty();
+    }
+
+    std::size_t size() const override {
+        return data.size();
+    }
+
+    bool insert(const TupleRef& tuple) override {
+        return data.insert(pad(tuple));
+    }
+
+    void insert(const InterpreterIndex& src) override {
+        // the tuples of hash sets are stored in their original order, whatever their key
+        if (const auto* other = dynamic_cast<const HashsetIndex*>(&src)) {
+            data.insertAll(other->data);
+            return;
+        }
+        for (const auto& cur : src.scan()) {
+            insert(cur);
+        }
+    }
+
+    bool contains(const TupleRef& tuple) const override {
+        return data.contains(pad(tuple));
+    }
+
+    bool contains(const TupleRef& low, const TupleRef& high) const override {
+        Lookup lookup(low, high, arity);
+        if (isKeyed(lookup)) {
+            for (const auto& cur : data.equalRange(lookup.low, lookup.equal)) {
+                if (!lookup.filtered || lookup.within(cur)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return std::any_of(data.begin(), data.end(), [&](const Entry& cur) { return lookup.within(cur); });
+    }
+
+    Stream scan() const override {
+        return mk<Source<typename Set::iterator>>(arity, data.begin(), data.end());
+    }
+
+    PartitionedStream partitionScan(int partitionCount) const override {
+        std::vector<Stream> res;
+        for (const auto& cur : data.partition(partitionCount)) {
+            res.push_back(mk<Source<typename Set::iterator>>(arity, cur.begin(), cur.end()));
+        }
+        return res;
+    }
+
+    Stream range(const TupleRef& low, const TupleRef& high) const override {
+        auto lookup = std::make_shared<const Lookup>(low, high, arity);
+        if (isKeyed(*lookup)) {
+            auto range = data.equalRange(lookup->low, lookup->equal);
+            return mk<Source<typename Set::equal_iterator>>(
+                    arity, range.begin(), range.end(), lookup->filtered ? lookup : nullptr);
+        }
+        return mk<Source<typename Set::iterator>>(arity, data.begin(), data.end(), lookup);
+    }
+
+    PartitionedStream partitionRange(
+            const TupleRef& low, const TupleRef& high, int partitionCount) const override {
+        auto lookup = std::make_shared<const Lookup>(low, high, arity);
+        std::vector<Stream> res;
+        if (isKeyed(*lookup)) {
+            auto range = data.equalRange(lookup->low, lookup->equal);
+            for (const auto& cur : range.partition(partitionCount)) {
+                res.push_back(mk<Source<typename Set::equal_iterator>>(
+                        arity, cur.begin(), cur.end(), lookup->filtered ? lookup : nullptr));
+            }
+        } else {
+            for (const auto& cur : data.partition(partitionCount)) {
+                res.push_back(mk<Source<typename Set::iterator>>(arity, cur.begin(), cur.end(), lookup));
+            }
+        }
+        return res;
+    }
+
+    void clear() override {
+        data.clear();
+    }
+};
+
+Own<InterpreterIndex> createHashsetIndex(const Order& order) {
+    return createHashsetIndex(order, order.size());
+}
+
+Own<InterpreterIndex> createHashsetIndex(const Order& order, std::size_t keySize) {
+    switch (order.size()) {
+        case 0: return mk<NullaryIndex>();
+        case 1: return mk<HashsetIndex<1>>(order, keySize);
+        case 2: return mk<HashsetIndex<2>>(order, keySize);
+        case 3: return mk<HashsetIndex<3>>(order, keySize);
+        case 4: return mk<HashsetIndex<4>>(order, keySize);
+        case 5: return mk<HashsetIndex<5>>(order, keySize);
+        case 6: return mk<HashsetIndex<6>>(order, keySize);
+        case 7: return mk<HashsetIndex<7>>(order, keySize);
+        case 8: return mk<HashsetIndex<8>>(order, keySize);
+        case 9: return mk<HashsetIndex<9>>(order, keySize);
+        case 10: return mk<HashsetIndex<10>>(order, keySize);
+        case 11: return mk<HashsetIndex<11>>(order, keySize);
+        case 12: return mk<HashsetIndex<12>>(order, keySize);
+        case 13: return mk<HashsetIndex<13>>(order, keySize);
+        case 14: return mk<HashsetIndex<14>>(order, keySize);
+        case 15: return mk<HashsetIndex<15>>(order, keySize);
+        case 16: return mk<HashsetIndex<16>>(order, keySize);
+        case 17: return mk<HashsetIndex<17>>(order, keySize);
+        case 18: return mk<HashsetIndex<18>>(order, keySize);
+        case 19: return mk<HashsetIndex<19>>(order, keySize);
+        case 20: return mk<HashsetIndex<20>>(order, keySize);
+    }
+
+    // Larger arities are stored inline in padded entries of the next supported arity
+    if (order.size() <= 24) {
+        return mk<HashsetIndex<24>>(order, keySize);
+    }
+    if (order.size() <= 32) {
+        return mk<HashsetIndex<32>>(order, keySize);
+    }
+    if (order.size() <= 40) {
+        return mk<HashsetIndex<40>>(order, keySize);
+    }
+    if (order.size() <= 48) {
+        return mk<HashsetIndex<48>>(order, keySize);
+    }
+    if (order.size() <= 64) {
+        return mk<HashsetIndex<64>>(order, keySize);
+    }
+
+    fatal("Requested arity not yet supported. Feel free to add it.");
+}
+
+}  // namespace souffle
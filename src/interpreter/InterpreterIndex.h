@@ -18,6 +18,7 @@
 #include "souffle/CompiledTuple.h"
 #include "souffle/RamTypes.h"
 #include "souffle/utility/ContainerUtil.h"
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
@@ -321,6 +322,33 @@ public:
         return Iterator();
     }
 
+    // -- support for batch processing --
+
+    /**
+     * Obtains the number of elements in the current batch, i.e. the elements
+     * buffered but not yet consumed; 0 if the end has been reached.
+     */
+    int getBatchSize() const {
+        return limit - cur;
+    }
+
+    /**
+     * Provides access to the elements of the current batch. They remain
+     * valid until the stream is advanced.
+     */
+    const TupleRef* getBatch() const {
+        return &buffer[cur];
+    }
+
+    /**
+     * Consumes the current batch and retrieves the next one.
+     */
+    void nextBatch() {
+        if (source != nullptr) {
+            loadNext();
+        }
+    }
+
 private:
     /**
      * Retrieves the next chunk of elements from the source.
@@ -378,11 +406,44 @@ public:
      */
     virtual Stream range(const TupleRef& low, const TupleRef& high) const = 0;
 
+    /**
+     * Counts the elements in the given range within this index. By default, the
+     * elements of the range are enumerated.
+     */
+    virtual std::size_t count(const TupleRef& low, const TupleRef& high) const {
+        Stream stream = range(low, high);
+        return std::distance(stream.begin(), stream.end());
+    }
+
+    /**
+     * Obtains the first, or the last, element in the given range within this index,
+     * written to the given buffer. Returns false if the range is empty. By default,
+     * the elements of the range are enumerated.
+     */
+    virtual bool boundary(const TupleRef& low, const TupleRef& high, bool last, RamDomain* res) const {
+        bool found = false;
+        for (const TupleRef& tuple : range(low, high)) {
+            for (std::size_t i = 0; i < tuple.size(); ++i) {
+                res[i] = tuple[i];
+            }
+            found = true;
+            if (!last) {
+                break;
+            }
+        }
+        return found;
+    }
+
     /**
      * Return arity size of the index
      */
     virtual size_t getArity() const = 0;
 
+    /**
+     * Drops all operation hints, such that the view can be reused after the index changed.
+     */
+    virtual void reset() {}
+
     virtual ~IndexView() = default;
 };
 
@@ -396,6 +457,14 @@ class InterpreterIndex {
 public:
     virtual ~InterpreterIndex() = default;
 
+    /**
+     * Obtains the identifier of this index. Identifiers are never reused, not even
+     * those of indexes that have been destroyed.
+     */
+    std::size_t getId() const {
+        return id;
+    }
+
     /**
      * Requests the creation of a view on this index.
      */
@@ -426,6 +495,16 @@ public:
      */
     virtual void insert(const InterpreterIndex& src) = 0;
 
+    /**
+     * Inserts the given number of tuples, stored one after another in the given array.
+     */
+    virtual void insert(const RamDomain* tuples, std::size_t count) {
+        const std::size_t arity = getArity();
+        for (std::size_t i = 0; i < count; ++i) {
+            insert(TupleRef(tuples + i * arity, arity));
+        }
+    }
+
     /**
      * Tests whether the given tuple is present in this index or not.
      */
@@ -462,6 +541,20 @@ public:
      */
     virtual void clear() = 0;
 
+    /**
+     * Spills the content of this index to a file, retaining it. Indexes not
+     * supporting spilling keep their content in memory.
+     */
+    virtual void spill() {}
+
+    /**
+     * Creates an index holding the content of this index in a compact representation
+     * for indexes that are only read, or null if this kind of index has none.
+     */
+    virtual Own<InterpreterIndex> freeze() const {
+        return nullptr;
+    }
+
     /**
      * Extend another index.
      *
@@ -472,6 +565,13 @@ public:
      * explicitly inserted this relation.
      */
     virtual void extend(InterpreterIndex*) {}
+
+private:
+    // the identifier of the next index to be created
+    static inline std::atomic<std::size_t> nextId{0};
+
+    // the identifier of this index
+    const std::size_t id = nextId++;
 };
 
 /**
@@ -688,6 +788,11 @@ public:
  * level order conversion as well as iteration through nested
  * data structures.
  *
+ * The entries of the structure may have more components than the order
+ * has attributes, such that relations of any arity can be stored inline
+ * in a structure of the next larger supported arity. The surplus
+ * components of all entries are zero and thus do not affect the order.
+ *
  * @tparam Structure the structure to be utilized
  */
 template <typename Structure>
@@ -695,7 +800,7 @@ class GenericIndex : public InterpreterIndex {
 protected:
     using Entry = typename Structure::element_type;
     using Hints = typename Structure::operation_hints;
-    static constexpr int Arity = Entry::arity;
+    static constexpr std::size_t Arity = Entry::arity;
 
     // the order to be simulated
     Order order;
@@ -709,6 +814,9 @@ protected:
     class Source : public Stream::Source {
         const Order& order;
 
+        // the arity of the decoded tuples
+        std::size_t arity;
+
         // the begin and end of the stream
         iter cur;
         iter end;
@@ -718,13 +826,20 @@ protected:
 
     public:
         Source(const Order& order, iter begin, iter end)
-                : order(order), cur(std::move(begin)), end(std::move(end)) {}
+                : order(order), arity(order.size()), cur(std::move(begin)), end(std::move(end)) {}
 
         int load(TupleRef* out, int max) override {
             int c = 0;
             while (cur != end && c < max) {
-                buffer[c] = order.decode(*cur);
-                out[c] = buffer[c];
+                if (arity == Arity) {
+                    buffer[c] = order.decode(*cur);
+                } else {
+                    const auto& attributes = order.getOrder();
+                    for (std::size_t i = 0; i < arity; ++i) {
+                        buffer[c][attributes[i]] = (*cur)[i];
+                    }
+                }
+                out[c] = TupleRef(&buffer[c][0], arity);
                 ++cur;
                 ++c;
             }
@@ -735,7 +850,7 @@ protected:
             int c = 0;
             max = std::min(max, Stream::BUFFER_SIZE);
             while (c < max) {
-                out[c] = buffer[c];
+                out[c] = TupleRef(&buffer[c][0], arity);
                 ++c;
             }
             return c;
@@ -748,12 +863,66 @@ protected:
         }
     };
 
+    // encodes a tuple into an entry, padding the entry with zeros
+    Entry encode(const TupleRef& tuple) const {
+        if (tuple.size() == Arity) {
+            return order.encode(tuple.asTuple<Arity>());
+        }
+        assert(tuple.size() == order.size() && tuple.size() < Arity);
+        Entry res{};
+        const auto& attributes = order.getOrder();
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            res[i] = tuple[attributes[i]];
+        }
+        return res;
+    }
+
     virtual souffle::range<iter> bounds(const TupleRef& low, const TupleRef& high, Hints& hints) const {
-        Entry a = order.encode(low.asTuple<Arity>());
-        Entry b = order.encode(high.asTuple<Arity>());
+        Entry a = encode(low);
+        Entry b = encode(high);
         return {data.lower_bound(a, hints), data.upper_bound(b, hints)};
     }
 
+    // counts the elements within the given bounds, by enumerating them unless overridden
+    virtual std::size_t count(const TupleRef& low, const TupleRef& high, Hints& hints) const {
+        auto range = bounds(low, high, hints);
+        return std::distance(range.begin(), range.end());
+    }
+
+    // decodes an entry into a tuple of the arity of the order
+    void decode(const Entry& entry, RamDomain* res) const {
+        const auto& attributes = order.getOrder();
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            res[attributes[i]] = entry[i];
+        }
+    }
+
+    // inserts the given entries in sorted order, keeping the operation hints effective
+    void insertSorted(std::vector<Entry>& entries) {
+        std::sort(entries.begin(), entries.end());
+        Hints hints;
+        for (const auto& entry : entries) {
+            data.insert(entry, hints);
+        }
+    }
+
+    // obtains the first or last element within the given bounds, by enumerating them unless overridden
+    virtual bool boundary(
+            const TupleRef& low, const TupleRef& high, bool last, Hints& hints, RamDomain* res) const {
+        auto range = bounds(low, high, hints);
+        if (range.empty()) {
+            return false;
+        }
+        iter pos = range.begin();
+        if (last) {
+            for (iter next = pos; ++next != range.end();) {
+                pos = next;
+            }
+        }
+        decode(*pos, res);
+        return true;
+    }
+
     // The index view associated to this view type.
     struct GenericIndexView : public IndexView {
         const GenericIndex& index;
@@ -762,7 +931,7 @@ protected:
         GenericIndexView(const GenericIndex& index) : index(index) {}
 
         bool contains(const TupleRef& tuple) const override {
-            return index.data.contains(index.order.encode(tuple.asTuple<Arity>()), hints);
+            return index.data.contains(index.encode(tuple), hints);
         }
 
         bool contains(const TupleRef& low, const TupleRef& high) const override {
@@ -774,8 +943,20 @@ protected:
             return mk<Source>(index.order, range.begin(), range.end());
         }
 
+        std::size_t count(const TupleRef& low, const TupleRef& high) const override {
+            return index.count(low, high, hints);
+        }
+
+        bool boundary(const TupleRef& low, const TupleRef& high, bool last, RamDomain* res) const override {
+            return index.boundary(low, high, last, hints, res);
+        }
+
         size_t getArity() const override {
-            return Arity;
+            return index.getArity();
+        }
+
+        void reset() override {
+            hints = Hints();
         }
     };
 
@@ -787,7 +968,7 @@ public:
     }
 
     size_t getArity() const override {
-        return Arity;
+        return order.size();
     }
 
     bool empty() const override {
@@ -799,14 +980,34 @@ public:
     }
 
     bool insert(const TupleRef& tuple) override {
-        return data.insert(order.encode(tuple.asTuple<Arity>()));
+        return data.insert(encode(tuple));
     }
 
     void insert(const InterpreterIndex& src) override {
-        // TODO: make smarter
+        // merge the underlying data structures if the source simulates the same order
+        if (const auto* other = dynamic_cast<const GenericIndex*>(&src)) {
+            if (other->order == order) {
+                data.insertAll(other->data);
+                return;
+            }
+        }
+
+        // otherwise insert the re-ordered tuples in sorted order
+        std::vector<Entry> entries;
         for (const auto& cur : src.scan()) {
-            insert(cur);
+            entries.push_back(encode(cur));
+        }
+        insertSorted(entries);
+    }
+
+    void insert(const RamDomain* tuples, std::size_t count) override {
+        const std::size_t arity = getArity();
+        std::vector<Entry> entries;
+        entries.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            entries.push_back(encode(TupleRef(tuples + i * arity, arity)));
         }
+        insertSorted(entries);
     }
 
     bool contains(const TupleRef& tuple) const override {
@@ -858,6 +1059,9 @@ using IndexFactory = Own<InterpreterIndex> (*)(const Order&);
 // A factory for BTree based index.
 Own<InterpreterIndex> createBTreeIndex(const Order&);
 
+// A factory for BTree based index caching the sizes of sub-trees, counting ranges in logarithmic time.
+Own<InterpreterIndex> createCountedBTreeIndex(const Order&);
+
 // A factory for BTree provenance index.
 Own<InterpreterIndex> createBTreeProvenanceIndex(const Order&);
 
@@ -870,4 +1074,10 @@ Own<InterpreterIndex> createIndirectIndex(const Order&);
 // A factory for Eqrel index.
 Own<InterpreterIndex> createEqrelIndex(const Order&);
 
+// A factory for hash set based index, keyed on all attributes.
+Own<InterpreterIndex> createHashsetIndex(const Order&);
+
+// A factory for hash set based index, keyed on the given number of leading attributes of the order.
+Own<InterpreterIndex> createHashsetIndex(const Order&, std::size_t keySize);
+
 }  // end of namespace souffle
@@ -136,6 +136,10 @@ public:
         size_t getArity() const override {
             return index.getArity();
         }
+
+        void reset() override {
+            hints = Hints();
+        }
     };
 
     IndirectIndex(AttributeOrder order)
@@ -202,6 +206,10 @@ public:
         set.clear();
     }
 
+    void spill() override {
+        set.spill();
+    }
+
 private:
     /** retain the index order used to construct an object of this class */
     const AttributeOrder theOrder;
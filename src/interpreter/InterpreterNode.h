@@ -23,8 +23,10 @@
 
 #pragma once
 
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
 #include "souffle/utility/ContainerUtil.h"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
@@ -32,9 +34,14 @@
 #include <utility>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace souffle {
 class InterpreterViewContext;
 class InterpreterRelation;
+class InterpreterNativeQuery;
 
 namespace ram {
 class Node;
@@ -72,6 +79,9 @@ enum InterpreterNodeType {
     I_ParallelAggregate,
     I_IndexAggregate,
     I_ParallelIndexAggregate,
+    I_IndexCount,
+    I_IndexMinMax,
+    I_IndexIntersection,
     I_Break,
     I_Filter,
     I_Project,
@@ -84,12 +94,16 @@ enum InterpreterNodeType {
     I_LogTimer,
     I_DebugInfo,
     I_Clear,
+    I_Spill,
+    I_Freeze,
     I_LogSize,
     I_IO,
     I_Query,
     I_Extend,
+    I_Merge,
     I_Swap,
-    I_Call
+    I_Call,
+    I_Bytecode
 };
 
 /**
@@ -226,6 +240,28 @@ public:
     std::vector<std::pair<size_t, Own<InterpreterNode>>> exprFirst;
     /** @brief Generic expressions in the upper bound */
     std::vector<std::pair<size_t, Own<InterpreterNode>>> exprSecond;
+
+    /** @brief Shape of the encoded values, selecting a specialised evaluation in the engine */
+    enum class Shape {
+        /** only constant (or unbounded) values; no tuple needs to be built at runtime */
+        CONSTANT,
+        /** constants and tuple elements only */
+        TUPLE_ELEMENT,
+        /** at least one generic expression */
+        GENERIC
+    };
+    Shape shape = Shape::GENERIC;
+
+    /** @brief Derive the shape from the encoded values; called once all values are encoded */
+    void computeShape() {
+        if (!exprFirst.empty() || !exprSecond.empty()) {
+            shape = Shape::GENERIC;
+        } else if (!tupleFirst.empty() || !tupleSecond.empty()) {
+            shape = Shape::TUPLE_ELEMENT;
+        } else {
+            shape = Shape::CONSTANT;
+        }
+    }
 };
 
 /**
@@ -245,6 +281,48 @@ protected:
     const InterpreterSuperInstruction superInst;
 };
 
+/**
+ * @class InterpreterBatchPredicate
+ * @brief This class encodes a numeric comparison that is evaluated for a batch of
+ *        scanned tuples at once. Operands are constants, columns of the scanned tuple,
+ *        or elements of enclosing tuples, which are invariant during the scan.
+ */
+struct InterpreterBatchPredicate {
+    struct Operand {
+        enum Kind { CONSTANT, COLUMN, TUPLE_ELEMENT };
+        Kind kind = CONSTANT;
+        /** @brief constant value */
+        RamDomain value = 0;
+        /** @brief tuple id of an enclosing tuple */
+        size_t tupleId = 0;
+        /** @brief element of the scanned or enclosing tuple */
+        size_t element = 0;
+    };
+
+    BinaryConstraintOp op;
+    Operand lhs;
+    Operand rhs;
+};
+
+/**
+ * @class InterpreterBatchOperation
+ * @brief Interpreter scans that evaluate the filters directly nested in them over
+ *        batches of tuples should inherit from this class. E.g. Scan, IndexScan
+ */
+class InterpreterBatchOperation {
+public:
+    InterpreterBatchOperation(std::vector<InterpreterBatchPredicate> predicates)
+            : batchPredicates(std::move(predicates)) {}
+
+    /** @brief get predicates evaluated over batches; empty if tuples are processed one at a time */
+    const std::vector<InterpreterBatchPredicate>& getBatchPredicates() const {
+        return batchPredicates;
+    }
+
+protected:
+    const std::vector<InterpreterBatchPredicate> batchPredicates;
+};
+
 /**
  * @class InterpreterAbstractParallel
  * @brief Interpreter node that utilizes parallel execution should inherit from this class.
@@ -283,10 +361,27 @@ protected:
     size_t viewId;
 };
 
+/**
+ * @class InterpreterProfiledOperation
+ * @brief Encode the profile counter an operation counts its executions in.
+ */
+class InterpreterProfiledOperation {
+public:
+    InterpreterProfiledOperation(size_t slot) : profileSlot(slot) {}
+
+    /** @brief get the slot of the profile counter; 0 if the operation is not profiled */
+    inline size_t getProfileSlot() const {
+        return profileSlot;
+    }
+
+protected:
+    const size_t profileSlot;
+};
+
 /**
  * @class InterpreterBinRelOperation
  * @brief Interpreter operation that involves with two relations should inherit from this class.
- *        E.g. Swap, Extend
+ *        E.g. Swap, Extend, Merge
  */
 class InterpreterBinRelOperation {
 public:
@@ -365,11 +460,25 @@ class InterpreterIntrinsicOperator : public InterpreterCompoundNode {
     using InterpreterCompoundNode::InterpreterCompoundNode;
 };
 
+/** Call interface of a user-defined functor, prepared by the engine and opaque to the nodes */
+struct InterpreterFunctorCall;
+
 /**
  * @class InterpreterUserDefinedOperator
  */
 class InterpreterUserDefinedOperator : public InterpreterCompoundNode {
-    using InterpreterCompoundNode::InterpreterCompoundNode;
+public:
+    InterpreterUserDefinedOperator(enum InterpreterNodeType ty, const ram::Node* sdw,
+            VecOwn<InterpreterNode> children, std::shared_ptr<InterpreterFunctorCall> call)
+            : InterpreterCompoundNode(ty, sdw, std::move(children)), call(std::move(call)) {}
+
+    /** @brief get the prepared call interface */
+    InterpreterFunctorCall& getCall() const {
+        return *call;
+    }
+
+protected:
+    const std::shared_ptr<InterpreterFunctorCall> call;
 };
 
 /**
@@ -440,17 +549,25 @@ class InterpreterRelationSize : public InterpreterNode {
  */
 class InterpreterExistenceCheck : public InterpreterNode,
                                   public InterpreterSuperOperation,
-                                  public InterpreterViewOperation {
+                                  public InterpreterViewOperation,
+                                  public InterpreterProfiledOperation {
 public:
     InterpreterExistenceCheck(enum InterpreterNodeType ty, const ram::Node* sdw, bool totalSearch,
-            size_t viewId, InterpreterSuperInstruction superInst)
-            : InterpreterNode(ty, sdw), InterpreterSuperOperation(std::move(superInst)),
-              InterpreterViewOperation(viewId), totalSearch(totalSearch) {}
+            size_t viewId, InterpreterSuperInstruction superInst, size_t readSlot = 0,
+            RelationHandle* filteredRel = nullptr)
+            : InterpreterNode(ty, sdw, filteredRel), InterpreterSuperOperation(std::move(superInst)),
+              InterpreterViewOperation(viewId), InterpreterProfiledOperation(readSlot),
+              totalSearch(totalSearch) {}
 
     bool isTotalSearch() const {
         return totalSearch;
     }
 
+    /** @brief Whether the Bloom filter of the relation is consulted before its index */
+    bool isFiltered() const {
+        return relHandle != nullptr;
+    }
+
 private:
     const bool totalSearch;
 };
@@ -463,9 +580,15 @@ class InterpreterProvenanceExistenceCheck : public InterpreterUnaryNode,
                                             public InterpreterViewOperation {
 public:
     InterpreterProvenanceExistenceCheck(enum InterpreterNodeType ty, const ram::Node* sdw,
-            Own<InterpreterNode> child, size_t viewId, InterpreterSuperInstruction superInst)
-            : InterpreterUnaryNode(ty, sdw, std::move(child)),
+            Own<InterpreterNode> child, size_t viewId, InterpreterSuperInstruction superInst,
+            RelationHandle* filteredRel = nullptr)
+            : InterpreterUnaryNode(ty, sdw, std::move(child), filteredRel),
               InterpreterSuperOperation(std::move(superInst)), InterpreterViewOperation(viewId) {}
+
+    /** @brief Whether the Bloom filter of the relation is consulted before its index */
+    bool isFiltered() const {
+        return relHandle != nullptr;
+    }
 };
 
 /**
@@ -478,18 +601,24 @@ class InterpreterConstraint : public InterpreterBinaryNode {
 /**
  * @class InterpreterTupleOperation
  */
-class InterpreterTupleOperation : public InterpreterUnaryNode {
-    using InterpreterUnaryNode::InterpreterUnaryNode;
+class InterpreterTupleOperation : public InterpreterUnaryNode, public InterpreterProfiledOperation {
+public:
+    InterpreterTupleOperation(
+            enum InterpreterNodeType ty, const ram::Node* sdw, Own<InterpreterNode> child, size_t profileSlot)
+            : InterpreterUnaryNode(ty, sdw, std::move(child)), InterpreterProfiledOperation(profileSlot) {}
 };
 
 /**
  * @class InterpreterScan
  */
-class InterpreterScan : public InterpreterNode, public InterpreterNestedOperation {
+class InterpreterScan : public InterpreterNode,
+                        public InterpreterNestedOperation,
+                        public InterpreterBatchOperation {
 public:
     InterpreterScan(enum InterpreterNodeType ty, const ram::Node* sdw, RelationHandle* relHandle,
-            Own<InterpreterNode> nested)
-            : InterpreterNode(ty, sdw, relHandle), InterpreterNestedOperation(std::move(nested)) {}
+            Own<InterpreterNode> nested, std::vector<InterpreterBatchPredicate> predicates = {})
+            : InterpreterNode(ty, sdw, relHandle), InterpreterNestedOperation(std::move(nested)),
+              InterpreterBatchOperation(std::move(predicates)) {}
 };
 
 /**
@@ -507,8 +636,9 @@ class InterpreterIndexScan : public InterpreterScan,
                              public InterpreterViewOperation {
 public:
     InterpreterIndexScan(enum InterpreterNodeType ty, const ram::Node* sdw, RelationHandle* relHandle,
-            Own<InterpreterNode> nested, size_t viewId, InterpreterSuperInstruction superInst)
-            : InterpreterScan(ty, sdw, relHandle, std::move(nested)),
+            Own<InterpreterNode> nested, size_t viewId, InterpreterSuperInstruction superInst,
+            std::vector<InterpreterBatchPredicate> predicates = {})
+            : InterpreterScan(ty, sdw, relHandle, std::move(nested), std::move(predicates)),
               InterpreterSuperOperation(std::move(superInst)), InterpreterViewOperation(viewId) {}
 };
 
@@ -628,6 +758,47 @@ class InterpreterParallelIndexAggregate : public InterpreterIndexAggregate,
     using InterpreterIndexAggregate::InterpreterIndexAggregate;
 };
 
+/**
+ * @class InterpreterIndexCount
+ */
+class InterpreterIndexCount : public InterpreterIndexAggregate {
+    using InterpreterIndexAggregate::InterpreterIndexAggregate;
+};
+
+/**
+ * @class InterpreterIndexMinMax
+ */
+class InterpreterIndexMinMax : public InterpreterIndexAggregate {
+    using InterpreterIndexAggregate::InterpreterIndexAggregate;
+};
+
+/**
+ * @class InterpreterIndexIntersection
+ */
+class InterpreterIndexIntersection : public InterpreterNode, public InterpreterNestedOperation {
+public:
+    /** @brief An input of the intersection, searching a view for the values of an attribute */
+    struct Input {
+        size_t viewId;
+        size_t column;
+        /** whether the index orders the attribute right after the attributes bound by equalities */
+        bool ordered;
+        InterpreterSuperInstruction superInst;
+    };
+
+    InterpreterIndexIntersection(enum InterpreterNodeType ty, const ram::Node* sdw, std::vector<Input> inputs,
+            Own<InterpreterNode> nested)
+            : InterpreterNode(ty, sdw), InterpreterNestedOperation(std::move(nested)),
+              inputs(std::move(inputs)) {}
+
+    inline const std::vector<Input>& getInputs() const {
+        return inputs;
+    }
+
+protected:
+    std::vector<Input> inputs;
+};
+
 /**
  * @class InterpreterBreak
  */
@@ -646,12 +817,87 @@ public:
  */
 class InterpreterFilter : public InterpreterNode,
                           public InterpreterConditionalOperation,
-                          public InterpreterNestedOperation {
+                          public InterpreterNestedOperation,
+                          public InterpreterProfiledOperation {
 public:
     InterpreterFilter(enum InterpreterNodeType ty, const ram::Node* sdw, Own<InterpreterNode> cond,
-            Own<InterpreterNode> nested)
+            Own<InterpreterNode> nested, size_t profileSlot = 0)
             : InterpreterNode(ty, sdw, nullptr), InterpreterConditionalOperation(std::move(cond)),
-              InterpreterNestedOperation(std::move(nested)) {}
+              InterpreterNestedOperation(std::move(nested)), InterpreterProfiledOperation(profileSlot) {}
+};
+
+/**
+ * @class InterpreterInsertBuffer
+ * @brief Collects the tuples projected into a relation by the threads of a parallel query.
+ *
+ * Each thread appends to a buffer of its own; the buffered tuples are merged into the
+ * relation in bulk once the query has finished.
+ */
+class InterpreterInsertBuffer {
+    using RelationHandle = Own<InterpreterRelation>;
+
+public:
+    InterpreterInsertBuffer(RelationHandle* relHandle, size_t arity) : relHandle(relHandle), arity(arity) {
+        assert(arity > 0 && "nullary relations can not be buffered");
+    }
+
+    /** @brief Get the relation the buffered tuples belong to */
+    inline InterpreterRelation* getRelation() const {
+        return relHandle->get();
+    }
+
+    /** @brief Provide a buffer for each thread of a team of the given size */
+    void reserve(size_t numThreads) {
+        if (buffers.size() < numThreads) {
+            buffers.resize(numThreads);
+        }
+    }
+
+    /** @brief Append a tuple to the buffer of the calling thread */
+    void push(const RamDomain* tuple) {
+        size_t thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        assert(thread < buffers.size() && "no buffer reserved for thread");
+        auto& tuples = buffers[thread].tuples;
+        tuples.insert(tuples.end(), tuple, tuple + arity);
+    }
+
+    /** @brief Take the buffered tuples, sorted and free of duplicates, leaving the buffers empty */
+    std::vector<RamDomain> collect() {
+        std::vector<const RamDomain*> order;
+        for (const auto& buffer : buffers) {
+            for (size_t i = 0; i < buffer.tuples.size(); i += arity) {
+                order.push_back(&buffer.tuples[i]);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](const RamDomain* a, const RamDomain* b) {
+            return std::lexicographical_compare(a, a + arity, b, b + arity);
+        });
+        auto last = std::unique(order.begin(), order.end(),
+                [&](const RamDomain* a, const RamDomain* b) { return std::equal(a, a + arity, b); });
+
+        std::vector<RamDomain> res;
+        res.reserve((last - order.begin()) * arity);
+        for (auto cur = order.begin(); cur != last; ++cur) {
+            res.insert(res.end(), *cur, *cur + arity);
+        }
+        for (auto& buffer : buffers) {
+            std::vector<RamDomain>().swap(buffer.tuples);
+        }
+        return res;
+    }
+
+private:
+    // the buffer of a thread, kept on its own cache line
+    struct alignas(64) Buffer {
+        std::vector<RamDomain> tuples;
+    };
+
+    RelationHandle* const relHandle;
+    const size_t arity;
+    std::vector<Buffer> buffers;
 };
 
 /**
@@ -660,8 +906,17 @@ public:
 class InterpreterProject : public InterpreterNode, public InterpreterSuperOperation {
 public:
     InterpreterProject(enum InterpreterNodeType ty, const ram::Node* sdw, RelationHandle* relHandle,
-            InterpreterSuperInstruction superInst)
-            : InterpreterNode(ty, sdw, relHandle), InterpreterSuperOperation(std::move(superInst)) {}
+            InterpreterSuperInstruction superInst, std::shared_ptr<InterpreterInsertBuffer> buffer = nullptr)
+            : InterpreterNode(ty, sdw, relHandle), InterpreterSuperOperation(std::move(superInst)),
+              buffer(std::move(buffer)) {}
+
+    /** @brief Get the buffer collecting the projected tuples, null if they are inserted directly */
+    inline InterpreterInsertBuffer* getInsertBuffer() const {
+        return buffer.get();
+    }
+
+protected:
+    std::shared_ptr<InterpreterInsertBuffer> buffer;
 };
 
 /**
@@ -727,6 +982,37 @@ class InterpreterClear : public InterpreterNode {
     using InterpreterNode::InterpreterNode;
 };
 
+/**
+ * @class InterpreterFreeze
+ */
+class InterpreterFreeze : public InterpreterNode {
+    using InterpreterNode::InterpreterNode;
+};
+
+/**
+ * @class InterpreterSpill
+ */
+class InterpreterSpill : public InterpreterNode {
+public:
+    InterpreterSpill(enum InterpreterNodeType ty, const ram::Node* sdw,
+            std::vector<RelationHandle*> relations, std::size_t memoryLimit)
+            : InterpreterNode(ty, sdw), relations(std::move(relations)), memoryLimit(memoryLimit) {}
+
+    /** @brief Get the relations, in the order they are spilled */
+    const std::vector<RelationHandle*>& getRelations() const {
+        return relations;
+    }
+
+    /** @brief Get the number of resident bytes up to which no further relation is spilled */
+    std::size_t getMemoryLimit() const {
+        return memoryLimit;
+    }
+
+private:
+    const std::vector<RelationHandle*> relations;
+    const std::size_t memoryLimit;
+};
+
 /**
  * @class InterpreterCall
  */
@@ -761,7 +1047,21 @@ class InterpreterIO : public InterpreterNode {
  * @class InterpreterQuery
  */
 class InterpreterQuery : public InterpreterUnaryNode, public InterpreterAbstractParallel {
+public:
     using InterpreterUnaryNode::InterpreterUnaryNode;
+
+    /** @brief Get the code the query may be compiled to, if any */
+    inline InterpreterNativeQuery* getNativeQuery() const {
+        return nativeQuery.get();
+    }
+
+    /** @brief Set the code the query may be compiled to */
+    inline void setNativeQuery(std::shared_ptr<InterpreterNativeQuery> q) {
+        nativeQuery = std::move(q);
+    }
+
+protected:
+    std::shared_ptr<InterpreterNativeQuery> nativeQuery = nullptr;
 };
 
 /**
@@ -773,6 +1073,15 @@ public:
             : InterpreterNode(ty, sdw), InterpreterBinRelOperation(src, target) {}
 };
 
+/**
+ * @class InterpreterMerge
+ */
+class InterpreterMerge : public InterpreterNode, public InterpreterBinRelOperation {
+public:
+    InterpreterMerge(enum InterpreterNodeType ty, const ram::Node* sdw, size_t src, size_t target)
+            : InterpreterNode(ty, sdw), InterpreterBinRelOperation(src, target) {}
+};
+
 /**
  * @class InterpreterSwap
  */
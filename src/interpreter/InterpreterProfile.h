@@ -0,0 +1,135 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InterpreterProfile.h
+ *
+ * Declares the counters the interpreter maintains while profiling.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+/**
+ * @class InterpreterProfileSlots
+ * @brief Assigns dense counter slots to profile texts.
+ *
+ * Slots are assigned by the NodeGenerator and stored on the interpreter nodes,
+ * so that counting an event needs no lookup. Slot 0 is shared by all operations
+ * without a profile text and is never reported.
+ */
+class InterpreterProfileSlots {
+public:
+    /** @brief Return the slot of a profile text, assigning a new slot if needed */
+    size_t getSlot(const std::string& text) {
+        if (text.empty()) {
+            return 0;
+        }
+        auto res = slots.emplace(text, slots.size() + 1);
+        return res.first->second;
+    }
+
+    /** @brief Return the number of slots, including slot 0 */
+    size_t size() const {
+        return slots.size() + 1;
+    }
+
+    /** @brief Return the profile texts and their slots */
+    const std::map<std::string, size_t>& getSlots() const {
+        return slots;
+    }
+
+private:
+    std::map<std::string, size_t> slots;
+};
+
+/**
+ * @class InterpreterProfileCounters
+ * @brief Event counters indexed by profile slot.
+ *
+ * Each thread counts in the shard of its thread number, padded to whole cache
+ * lines, so that threads of the same team do not share cache lines in the hot
+ * path. Threads of nested teams may share a shard, so increments are atomic.
+ * The shards are merged into per-iteration totals at the end of every loop
+ * iteration.
+ */
+class InterpreterProfileCounters {
+public:
+    /** @brief Allocate zeroed counters for the given number of slots */
+    void init(size_t numSlots) {
+        size_t numThreads = 1;
+#ifdef _OPENMP
+        numThreads = omp_get_max_threads();
+#endif
+        shards.clear();
+        for (size_t i = 0; i < numThreads; ++i) {
+            shards.emplace_back((numSlots + COUNTERS_PER_LINE - 1) / COUNTERS_PER_LINE);
+        }
+        totals = std::vector<std::vector<size_t>>(numSlots, std::vector<size_t>(1, 0));
+    }
+
+    /** @brief Count an event in the given slot */
+    void increment(size_t slot) {
+        size_t thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num() % shards.size();
+#endif
+        auto& counter = shards[thread][slot / COUNTERS_PER_LINE].counters[slot % COUNTERS_PER_LINE];
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** @brief Add the counts of all shards to the totals of an iteration and reset the shards */
+    void merge(size_t iteration) {
+        for (auto& shard : shards) {
+            for (size_t slot = 0; slot < totals.size(); ++slot) {
+                auto& counter = shard[slot / COUNTERS_PER_LINE].counters[slot % COUNTERS_PER_LINE];
+                size_t count = counter.exchange(0, std::memory_order_relaxed);
+                if (count == 0) {
+                    continue;
+                }
+                auto& total = totals[slot];
+                if (total.size() <= iteration) {
+                    total.resize(iteration + 1, 0);
+                }
+                total[iteration] += count;
+            }
+        }
+    }
+
+    /** @brief Return the merged counts of a slot, indexed by iteration */
+    const std::vector<size_t>& getTotals(size_t slot) const {
+        return totals[slot];
+    }
+
+private:
+    static constexpr size_t COUNTERS_PER_LINE = 8;
+
+    struct alignas(64) CacheLine {
+        std::atomic<size_t> counters[COUNTERS_PER_LINE] = {};
+    };
+
+    /** counters of each thread since the last merge */
+    std::vector<std::vector<CacheLine>> shards;
+    /** merged counters of each slot and iteration */
+    std::vector<std::vector<size_t>> totals;
+};
+
+}  // namespace souffle
@@ -55,6 +55,10 @@ public:
     using GenericIndex<btree_set<t_tuple<Arity>, comparator<Arity>, std::allocator<t_tuple<Arity>>, 256,
             typename detail::default_strategy<t_tuple<Arity>>::type, comparator<Arity - 2>,
             InterpreterProvenanceUpdater<Arity>>>::GenericIndex;
+
+    void spill() override {
+        this->data.spill();
+    }
 };
 
 Own<InterpreterIndex> createBTreeProvenanceIndex(const Order& order) {
@@ -18,6 +18,7 @@
 #include "ram/analysis/Index.h"
 #include <algorithm>
 #include <cassert>
+#include <mutex>
 #include <set>
 #include <utility>
 
@@ -38,7 +39,8 @@ InterpreterRelation::InterpreterRelation(std::size_t arity, std::size_t auxiliar
                 order.push_back(i);
             }
         }
-        indexes.push_back(factory(Order(order)));
+        orders.emplace_back(order);
+        indexes.push_back(factory(orders.back()));
     }
 
     // Use the first index as default main index
@@ -51,8 +53,49 @@ void InterpreterRelation::removeIndex(const size_t& indexPos) {
     indexes[indexPos].reset(nullptr);
 }
 
+void InterpreterRelation::replaceIndex(const size_t& indexPos, IndexFactory factory) {
+    assert(empty() && "only the indexes of empty relations can be replaced");
+    auto index = factory(orders[indexPos]);
+    if (main == indexes[indexPos].get()) {
+        main = index.get();
+    }
+    indexes[indexPos] = std::move(index);
+}
+
+void InterpreterRelation::deferIndexes() {
+    assert(empty() && "only the indexes of empty relations can be deferred");
+    deferring = true;
+    indexesDeferred = indexes.size() > 1;
+}
+
+void InterpreterRelation::ensureIndex(const size_t& indexPos) {
+    if (isReadable(indexPos)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(buildLock);
+    if (!indexesDeferred) {
+        return;
+    }
+
+    // Each secondary index is built on its own from the sorted tuples of the main index
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (indexes[i] != nullptr && indexes[i].get() != main) {
+            indexes[i]->clear();
+            indexes[i]->insert(*main);
+        }
+    }
+    indexesDeferred = false;
+}
+
+void InterpreterRelation::enableFilter(size_t capacity) {
+    assert(empty() && "only empty relations can enable a filter");
+    filter = mk<BloomFilter>(capacity);
+}
+
 IndexViewPtr InterpreterRelation::getView(const size_t& indexPos) const {
     assert(indexPos < indexes.size());
+    assert(isReadable(indexPos) && "index deferred");
     return indexes[indexPos]->createView();
 }
 
@@ -60,6 +103,10 @@ bool InterpreterRelation::insert(const TupleRef& tuple) {
     if (!main->insert(tuple)) {
         return false;
     }
+    addToFilter(tuple.getBase());
+    if (indexesDeferred) {
+        return true;
+    }
     for (const auto& cur : indexes) {
         if (cur.get() == main) {
             continue;
@@ -70,9 +117,63 @@ bool InterpreterRelation::insert(const TupleRef& tuple) {
 }
 
 void InterpreterRelation::insert(const InterpreterRelation& other) {
-    // TODO: cover this in a smarter way
-    for (const auto& cur : other.scan()) {
-        insert(cur);
+    if (other.empty()) {
+        return;
+    }
+
+    // Inserting tuple by tuple updates the provenance annotations in the main index only
+    if (auxiliaryArity > 0) {
+        for (const auto& cur : other.scan()) {
+            insert(cur);
+        }
+        return;
+    }
+
+    if (filter != nullptr) {
+        for (const auto& cur : other.scan()) {
+            addToFilter(cur.getBase());
+        }
+    }
+
+    // All indexes hold the same tuples, hence each can be merged on its own with the index
+    // of the other relation simulating the same order, or with its main index otherwise;
+    // deferred indexes neither receive nor provide tuples
+#pragma omp parallel for schedule(dynamic) if (indexes.size() > 1)
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (!isReadable(i)) {
+            continue;
+        }
+        const InterpreterIndex* src = other.main;
+        for (size_t j = 0; j < other.orders.size(); ++j) {
+            if (other.orders[j] == orders[i] && other.isReadable(j)) {
+                src = other.indexes[j].get();
+                break;
+            }
+        }
+        indexes[i]->insert(*src);
+    }
+}
+
+void InterpreterRelation::insert(const RamDomain* tuples, size_t count) {
+    // Inserting tuple by tuple updates the provenance annotations in the main index only
+    if (auxiliaryArity > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            insert(tuples + i * arity);
+        }
+        return;
+    }
+
+    if (filter != nullptr) {
+        for (size_t i = 0; i < count; ++i) {
+            addToFilter(tuples + i * arity);
+        }
+    }
+
+#pragma omp parallel for schedule(dynamic) if (indexes.size() > 1)
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (isReadable(i)) {
+            indexes[i]->insert(tuples, count);
+        }
     }
 }
 
@@ -81,6 +182,7 @@ bool InterpreterRelation::contains(const TupleRef& tuple) const {
 }
 
 bool InterpreterRelation::contains(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const {
+    assert(isReadable(indexPos) && "index deferred");
     return indexes[indexPos]->contains(low, high);
 }
 
@@ -93,18 +195,23 @@ PartitionedStream InterpreterRelation::partitionScan(size_t partitionCount) cons
 }
 
 Stream InterpreterRelation::range(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const {
+    assert(isReadable(indexPos) && "index deferred");
     auto& pos = indexes[indexPos];
     return pos->range(low, high);
 }
 
 PartitionedStream InterpreterRelation::partitionRange(
         const size_t& indexPos, const TupleRef& low, const TupleRef& high, size_t partitionCount) const {
+    assert(isReadable(indexPos) && "index deferred");
     auto& pos = indexes[indexPos];
     return pos->partitionRange(low, high, partitionCount);
 }
 
 void InterpreterRelation::swap(InterpreterRelation& other) {
     indexes.swap(other.indexes);
+    filter.swap(other.filter);
+    std::swap(deferring, other.deferring);
+    indexesDeferred = other.indexesDeferred.exchange(indexesDeferred);
 }
 
 size_t InterpreterRelation::getLevel() const {
@@ -135,6 +242,36 @@ void InterpreterRelation::purge() {
     for (auto& index : indexes) {
         index->clear();
     }
+    if (filter != nullptr) {
+        filter->clear();
+    }
+    indexesDeferred = deferring && indexes.size() > 1;
+}
+
+void InterpreterRelation::spill() {
+    for (auto& index : indexes) {
+        index->spill();
+    }
+}
+
+VecOwn<InterpreterIndex> InterpreterRelation::freeze() {
+    VecOwn<InterpreterIndex> replaced;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        // deferred indexes are built from the main index once they are searched
+        if (indexes[i] == nullptr || !isReadable(i)) {
+            continue;
+        }
+        auto frozen = indexes[i]->freeze();
+        if (frozen == nullptr) {
+            continue;
+        }
+        if (main == indexes[i].get()) {
+            main = frozen.get();
+        }
+        replaced.push_back(std::move(indexes[i]));
+        indexes[i] = std::move(frozen);
+    }
+    return replaced;
 }
 
 bool InterpreterRelation::exists(const TupleRef& tuple) const {
@@ -156,6 +293,20 @@ void InterpreterEqRelation::extend(const InterpreterRelation& rel) {
     this->main->extend(otherEqRel->main);
 }
 
+InterpreterHashsetRelation::InterpreterHashsetRelation(size_t arity, size_t auxiliaryArity,
+        const std::string& name, const std::vector<std::string>& attributeTypes,
+        const MinIndexSelection& orderSet)
+        : InterpreterRelation(arity, auxiliaryArity, name, attributeTypes, orderSet, createHashsetIndex) {
+    // Key each index on the leading attributes bound by all searches it covers
+    for (size_t indexPos = 0; indexPos < indexes.size(); ++indexPos) {
+        size_t keySize = orderSet.getKeySize(indexPos);
+        if (keySize < arity) {
+            indexes[indexPos] = createHashsetIndex(orders[indexPos], keySize);
+        }
+    }
+    main = indexes[0].get();
+}
+
 InterpreterIndirectRelation::InterpreterIndirectRelation(size_t arity, size_t auxiliaryArity,
         const std::string& name, const std::vector<std::string>& attributeTypes,
         const MinIndexSelection& orderSet)
@@ -182,6 +333,7 @@ bool InterpreterIndirectRelation::insert(const TupleRef& tuple) {
     for (auto& cur : indexes) {
         cur->insert(TupleRef(newTuple, arity));
     }
+    addToFilter(newTuple);
 
     // increment relation size
     numTuples++;
@@ -193,11 +345,26 @@ bool InterpreterIndirectRelation::insert(const RamDomain* tuple) {
     return this->insert(TupleRef(tuple, arity));
 }
 
+void InterpreterIndirectRelation::insert(const InterpreterRelation& other) {
+    for (const auto& cur : other.scan()) {
+        insert(cur);
+    }
+}
+
+void InterpreterIndirectRelation::insert(const RamDomain* tuples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        insert(tuples + i * arity);
+    }
+}
+
 void InterpreterIndirectRelation::purge() {
     blockList.clear();
     for (auto& cur : indexes) {
         cur->clear();
     }
+    if (filter != nullptr) {
+        filter->clear();
+    }
     numTuples = 0;
 }
 
@@ -18,11 +18,15 @@
 
 #include "interpreter/InterpreterIndex.h"
 #include "ram/analysis/Index.h"
+#include "souffle/datastructure/BloomFilter.h"
+#include <atomic>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -95,11 +99,56 @@ public:
      */
     void removeIndex(const size_t& indexPos);
 
+    /**
+     * Replaces an index of this empty relation by one created by the given factory,
+     * before any view of the index is created.
+     */
+    void replaceIndex(const size_t& indexPos, IndexFactory factory);
+
+    /**
+     * Defers the maintenance of the secondary indexes of this empty relation:
+     * inserted tuples are only added to the main index, and the other indexes
+     * are built in bulk by ensureIndex(). Purging the relation defers them again.
+     */
+    void deferIndexes();
+
+    /**
+     * Prepares the given index for reading, building all secondary indexes
+     * from the main index if their maintenance has been deferred. From then on,
+     * the secondary indexes are maintained by inserts until the relation is purged.
+     */
+    void ensureIndex(const size_t& indexPos);
+
+    /**
+     * Maintains a Bloom filter of the tuples of this relation, identified by their
+     * attributes excluding the auxiliary ones, initially sized for the given number
+     * of tuples. Enabled for empty relations only.
+     */
+    void enableFilter(size_t capacity);
+
+    /**
+     * Tests whether this relation may contain a tuple starting with the given
+     * attributes, excluding the auxiliary ones: if not, the relation contains no
+     * such tuple. Without a filter, any tuple may be contained.
+     */
+    bool mayContain(const RamDomain* tuple) const {
+        return filter == nullptr || filter->mayContain(BloomFilter::hash(tuple, arity - auxiliaryArity));
+    }
+
     /**
      * Obtains a view on an index of this relation, facilitating hint-supported accesses.
      */
     IndexViewPtr getView(const size_t& indexPos) const;
 
+    /**
+     * Obtains an index of this relation.
+     */
+    const InterpreterIndex& getIndex(const size_t& indexPos) const {
+        assert(indexPos < indexes.size());
+        assert(isReadable(indexPos) && "index deferred");
+        return *indexes[indexPos];
+    }
+
     /**
      * Add the given tuple to this relation.
      */
@@ -113,9 +162,16 @@ public:
     }
 
     /**
-     * Add all entries of the given relation to this relation.
+     * Add all entries of the given relation to this relation, merging the
+     * indexes of both relations in bulk.
+     */
+    virtual void insert(const InterpreterRelation& other);
+
+    /**
+     * Add the given number of tuples, stored one after another in the given
+     * array, to this relation, inserting them into each index in bulk.
      */
-    void insert(const InterpreterRelation& other);
+    virtual void insert(const RamDomain* tuples, size_t count);
 
     /**
      * Tests whether this relation contains the given tuple.
@@ -203,6 +259,18 @@ public:
      */
     virtual void purge();
 
+    /**
+     * Spill all indexes to a file, retaining their content
+     */
+    void spill();
+
+    /**
+     * Replace the indexes by compact ones for relations that are only read.
+     * Returns the replaced indexes, such that views on them can be dropped
+     * before they are released.
+     */
+    VecOwn<InterpreterIndex> freeze();
+
     /**
      * Check if a tuple exists in relation
      */
@@ -214,6 +282,18 @@ public:
     virtual void extend(const InterpreterRelation& rel);
 
 protected:
+    // tests whether the given index holds all tuples of this relation
+    bool isReadable(size_t indexPos) const {
+        return !indexesDeferred || indexes[indexPos].get() == main;
+    }
+
+    // adds the given tuple to the Bloom filter, if any
+    void addToFilter(const RamDomain* tuple) {
+        if (filter != nullptr) {
+            filter->insert(BloomFilter::hash(tuple, arity - auxiliaryArity));
+        }
+    }
+
     // Relation name
     std::string relName;
 
@@ -229,9 +309,24 @@ protected:
     // a map of managed indexes
     VecOwn<InterpreterIndex> indexes;
 
+    // the orders simulated by the managed indexes
+    std::vector<Order> orders;
+
     // a pointer to the main index within the managed index
     InterpreterIndex* main;
 
+    // whether the maintenance of the secondary indexes is deferred after purging
+    bool deferring = false;
+
+    // whether the secondary indexes are currently not maintained
+    std::atomic<bool> indexesDeferred{false};
+
+    // serialises building the deferred indexes
+    std::mutex buildLock;
+
+    // the Bloom filter of the tuples, if maintained
+    Own<BloomFilter> filter;
+
     // relation level
     size_t level = 0;
 };  // namespace souffle
@@ -248,6 +343,15 @@ public:
     void extend(const InterpreterRelation& rel) override;
 };
 
+/**
+ * Interpreter Hash Set Relation
+ */
+class InterpreterHashsetRelation : public InterpreterRelation {
+public:
+    InterpreterHashsetRelation(size_t arity, size_t auxiliaryArity, const std::string& relName,
+            const std::vector<std::string>& attributeTypes, const ram::analysis::MinIndexSelection& orderSet);
+};
+
 /**
  * Interpreter Indirect Relation
  */
@@ -260,6 +364,12 @@ public:
 
     bool insert(const RamDomain* tuple) override;
 
+    /** Insert all tuples of a relation; tuples are copied into the blocks of this relation */
+    void insert(const InterpreterRelation& other) override;
+
+    /** Insert an array of tuples; tuples are copied into the blocks of this relation */
+    void insert(const RamDomain* tuples, size_t count) override;
+
     /** Clear all indexes */
     void purge() override;
 
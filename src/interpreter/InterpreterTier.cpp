@@ -0,0 +1,468 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InterpreterTier.cpp
+ *
+ * Generates C++ code for queries of the interpreter, and compiles and loads
+ * it in the background.
+ *
+ ***********************************************************************/
+
+#include "interpreter/InterpreterTier.h"
+#include "FunctorOps.h"
+#include "ram/Break.h"
+#include "ram/Condition.h"
+#include "ram/Conjunction.h"
+#include "ram/Constant.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/False.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/IntrinsicOperator.h"
+#include "ram/Negation.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Project.h"
+#include "ram/Scan.h"
+#include "ram/True.h"
+#include "ram/TupleElement.h"
+#include "ram/TupleOperation.h"
+#include "ram/Utils.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace souffle {
+
+namespace {
+
+/**
+ * @class NativeQueryGenerator
+ * @brief Generates C++ code running an operation through a NativeQueryContext.
+ *
+ * An operation becomes a sequence of statements returning false if the operation
+ * requests a break, like the interpreter; the nested operation of a scan becomes
+ * the visitor of the tuples of the scan, binding them to env<tuple id>. Generating
+ * functions return false if they meet anything that is not compiled.
+ */
+class NativeQueryGenerator {
+public:
+    NativeQueryGenerator(std::ostream& out, std::vector<const ram::Node*>& accesses)
+            : out(out), accesses(accesses) {}
+
+    bool operation(const ram::Operation& op) {
+        if (const auto* filter = dynamic_cast<const ram::Filter*>(&op)) {
+            out << "if (!";
+            if (!condition(filter->getCondition())) {
+                return false;
+            }
+            out << ") {\nreturn true;\n}\n";
+            return operation(filter->getOperation());
+        } else if (const auto* breakOp = dynamic_cast<const ram::Break*>(&op)) {
+            out << "if (";
+            if (!condition(breakOp->getCondition())) {
+                return false;
+            }
+            out << ") {\nreturn false;\n}\n";
+            return operation(breakOp->getOperation());
+        } else if (const auto* project = dynamic_cast<const ram::Project*>(&op)) {
+            out << "ctxt.insert(" << access(*project) << ", ";
+            if (!tuple(project->getValues())) {
+                return false;
+            }
+            out << ");\nreturn true;\n";
+            return true;
+        } else if (const auto* indexScan = dynamic_cast<const ram::IndexScan*>(&op)) {
+            const auto& pattern = indexScan->getRangePattern();
+            out << "ctxt.forEachInRange(" << access(*indexScan) << ", ";
+            if (!bounds(pattern.first, MIN_RAM_SIGNED)) {
+                return false;
+            }
+            out << ", ";
+            if (!bounds(pattern.second, MAX_RAM_SIGNED)) {
+                return false;
+            }
+            out << ", ";
+            return loop(*indexScan);
+        } else if (const auto* scan = dynamic_cast<const ram::Scan*>(&op)) {
+            out << "ctxt.forEach(" << access(*scan) << ", ";
+            return loop(*scan);
+        }
+        return false;
+    }
+
+private:
+    /** Generate the visitor running the nested operation of a scan, and finish the scan */
+    bool loop(const ram::TupleOperation& op) {
+        out << "[&](NativeQueryContext& ctxt, const RamDomain* env" << op.getTupleId() << ") -> bool {\n";
+        if (!operation(op.getOperation())) {
+            return false;
+        }
+        out << "});\nreturn true;\n";
+        return true;
+    }
+
+    bool condition(const ram::Condition& cond) {
+        if (const auto* conj = dynamic_cast<const ram::Conjunction*>(&cond)) {
+            out << "(";
+            if (!condition(conj->getLHS())) {
+                return false;
+            }
+            out << " && ";
+            if (!condition(conj->getRHS())) {
+                return false;
+            }
+            out << ")";
+        } else if (const auto* neg = dynamic_cast<const ram::Negation*>(&cond)) {
+            out << "!";
+            return condition(neg->getOperand());
+        } else if (isA<ram::True>(&cond)) {
+            out << "true";
+        } else if (isA<ram::False>(&cond)) {
+            out << "false";
+        } else if (const auto* constraint = dynamic_cast<const ram::Constraint*>(&cond)) {
+            const char* type = nullptr;
+            const char* symbol = comparison(constraint->getOperator(), type);
+            if (symbol == nullptr) {
+                return false;
+            }
+            out << "(";
+            if (!cast(type, constraint->getLHS())) {
+                return false;
+            }
+            out << " " << symbol << " ";
+            if (!cast(type, constraint->getRHS())) {
+                return false;
+            }
+            out << ")";
+        } else if (const auto* exists = dynamic_cast<const ram::ExistenceCheck*>(&cond)) {
+            const auto& values = exists->getValues();
+            bool isTotal = std::none_of(
+                    values.begin(), values.end(), [](const ram::Expression* e) { return isUndefValue(e); });
+            out << "ctxt.contains(" << access(*exists) << ", ";
+            if (isTotal) {
+                if (!tuple(values)) {
+                    return false;
+                }
+            } else {
+                if (!bounds(values, MIN_RAM_SIGNED)) {
+                    return false;
+                }
+                out << ", ";
+                if (!bounds(values, MAX_RAM_SIGNED)) {
+                    return false;
+                }
+            }
+            out << ")";
+        } else if (const auto* emptiness = dynamic_cast<const ram::EmptinessCheck*>(&cond)) {
+            out << "ctxt.empty(" << access(*emptiness) << ")";
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool expression(const ram::Expression& expr) {
+        if (const auto* constant = dynamic_cast<const ram::Constant*>(&expr)) {
+            if (constant->getConstant() == MIN_RAM_SIGNED) {
+                // the literal of the smallest value does not fit its type
+                out << "MIN_RAM_SIGNED";
+            } else {
+                out << "RamDomain(" << constant->getConstant() << ")";
+            }
+        } else if (const auto* element = dynamic_cast<const ram::TupleElement*>(&expr)) {
+            out << "env" << element->getTupleId() << "[" << element->getElement() << "]";
+        } else if (const auto* op = dynamic_cast<const ram::IntrinsicOperator*>(&expr)) {
+            const auto& args = op->getArguments();
+            if (args.size() == 1 && op->getOperator() == FunctorOp::NEG) {
+                out << "RamDomain(-";
+                if (!expression(*args[0])) {
+                    return false;
+                }
+                out << ")";
+                return true;
+            }
+            const char* type = nullptr;
+            const char* symbol = arithmetic(op->getOperator(), type);
+            if (args.size() != 2 || symbol == nullptr) {
+                return false;
+            }
+            out << "ramBitCast(static_cast<" << type << ">(";
+            if (!cast(type, *args[0])) {
+                return false;
+            }
+            out << " " << symbol << " ";
+            if (!cast(type, *args[1])) {
+                return false;
+            }
+            out << "))";
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /** Generate an expression reinterpreted as the given type */
+    bool cast(const char* type, const ram::Expression& expr) {
+        out << "ramBitCast<" << type << ">(";
+        if (!expression(expr)) {
+            return false;
+        }
+        out << ")";
+        return true;
+    }
+
+    /** Generate a pointer to a tuple of the given values, living until the end of the statement */
+    bool tuple(const std::vector<ram::Expression*>& values) {
+        out << "std::array<RamDomain, " << values.size() << ">{";
+        for (size_t i = 0; i < values.size(); ++i) {
+            out << (i > 0 ? ", " : "");
+            if (!expression(*values[i])) {
+                return false;
+            }
+        }
+        out << "}.data()";
+        return true;
+    }
+
+    /** Generate a bound of a range; undefined values become the given constant */
+    bool bounds(const std::vector<ram::Expression*>& values, RamDomain unbounded) {
+        out << "std::array<RamDomain, " << values.size() << ">{";
+        for (size_t i = 0; i < values.size(); ++i) {
+            out << (i > 0 ? ", " : "");
+            if (isUndefValue(values[i])) {
+                out << (unbounded == MIN_RAM_SIGNED ? "MIN_RAM_SIGNED" : "MAX_RAM_SIGNED");
+            } else if (!expression(*values[i])) {
+                return false;
+            }
+        }
+        out << "}.data()";
+        return true;
+    }
+
+    size_t access(const ram::Node& node) {
+        accesses.push_back(&node);
+        return accesses.size() - 1;
+    }
+
+    /** Return the C++ operator of a numeric comparison and set the type it compares, or return null */
+    static const char* comparison(BinaryConstraintOp op, const char*& type) {
+        switch (op) {
+            case BinaryConstraintOp::EQ: type = "RamDomain"; return "==";
+            case BinaryConstraintOp::NE: type = "RamDomain"; return "!=";
+            case BinaryConstraintOp::LT: type = "RamSigned"; return "<";
+            case BinaryConstraintOp::LE: type = "RamSigned"; return "<=";
+            case BinaryConstraintOp::GT: type = "RamSigned"; return ">";
+            case BinaryConstraintOp::GE: type = "RamSigned"; return ">=";
+            case BinaryConstraintOp::ULT: type = "RamUnsigned"; return "<";
+            case BinaryConstraintOp::ULE: type = "RamUnsigned"; return "<=";
+            case BinaryConstraintOp::UGT: type = "RamUnsigned"; return ">";
+            case BinaryConstraintOp::UGE: type = "RamUnsigned"; return ">=";
+            case BinaryConstraintOp::FEQ: type = "RamFloat"; return "==";
+            case BinaryConstraintOp::FNE: type = "RamFloat"; return "!=";
+            case BinaryConstraintOp::FLT: type = "RamFloat"; return "<";
+            case BinaryConstraintOp::FLE: type = "RamFloat"; return "<=";
+            case BinaryConstraintOp::FGT: type = "RamFloat"; return ">";
+            case BinaryConstraintOp::FGE: type = "RamFloat"; return ">=";
+            default: return nullptr;
+        }
+    }
+
+    /** Return the C++ operator of an arithmetic functor and set the type it computes in, or return null */
+    static const char* arithmetic(FunctorOp op, const char*& type) {
+        switch (op) {
+            case FunctorOp::ADD: type = "RamSigned"; return "+";
+            case FunctorOp::SUB: type = "RamSigned"; return "-";
+            case FunctorOp::MUL: type = "RamSigned"; return "*";
+            case FunctorOp::BAND: type = "RamSigned"; return "&";
+            case FunctorOp::BOR: type = "RamSigned"; return "|";
+            case FunctorOp::BXOR: type = "RamSigned"; return "^";
+            case FunctorOp::UADD: type = "RamUnsigned"; return "+";
+            case FunctorOp::USUB: type = "RamUnsigned"; return "-";
+            case FunctorOp::UMUL: type = "RamUnsigned"; return "*";
+            case FunctorOp::UBAND: type = "RamUnsigned"; return "&";
+            case FunctorOp::UBOR: type = "RamUnsigned"; return "|";
+            case FunctorOp::UBXOR: type = "RamUnsigned"; return "^";
+            case FunctorOp::FADD: type = "RamFloat"; return "+";
+            case FunctorOp::FSUB: type = "RamFloat"; return "-";
+            case FunctorOp::FMUL: type = "RamFloat"; return "*";
+            default: return nullptr;
+        }
+    }
+
+    std::ostream& out;
+    std::vector<const ram::Node*>& accesses;
+};
+
+}  // namespace
+
+bool generateNativeQuery(
+        const ram::Operation& op, std::string& code, std::vector<const ram::Node*>& accesses) {
+    std::stringstream body;
+    NativeQueryGenerator generator(body, accesses);
+    if (!generator.operation(op)) {
+        accesses.clear();
+        return false;
+    }
+
+    std::stringstream out;
+    // the domain size is part of the interface to the interpreter
+    out << "#ifndef RAM_DOMAIN_SIZE\n";
+    out << "#define RAM_DOMAIN_SIZE " << RAM_DOMAIN_SIZE << "\n";
+    out << "#endif\n";
+    out << "#include \"souffle/NativeQuery.h\"\n";
+    out << "#include <array>\n\n";
+    out << "static_assert(RAM_DOMAIN_SIZE == " << RAM_DOMAIN_SIZE
+        << ", \"domain size of the interpreter\");\n\n";
+    out << "extern \"C\" void " << NATIVE_QUERY_SYMBOL << "(souffle::NativeQueryContext& ctxt) {\n";
+    out << "using namespace souffle;\n";
+    out << "[&]() -> bool {\n";
+    out << body.str();
+    out << "}();\n";
+    out << "}\n";
+    code = out.str();
+    return true;
+}
+
+InterpreterTier::~InterpreterTier() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        if (child != 0) {
+            kill(-child, SIGTERM);
+        }
+        changed.notify_all();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (void* library : libraries) {
+        dlclose(library);
+    }
+    if (!dir.empty()) {
+        rmdir(dir.c_str());
+    }
+}
+
+void InterpreterTier::submit(InterpreterNativeQuery& query) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(&query);
+    ++pending;
+    if (!worker.joinable()) {
+        worker = std::thread([this]() { run(); });
+    }
+    changed.notify_all();
+}
+
+size_t InterpreterTier::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return pending == 0 || stopping; });
+    return loaded;
+}
+
+void InterpreterTier::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [&]() { return stopping || !queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        InterpreterNativeQuery* query = queue.front();
+        queue.pop_front();
+        size_t id = compiled++;
+        lock.unlock();
+        bool success = compile(*query, id);
+        lock.lock();
+        loaded += success ? 1 : 0;
+        --pending;
+        changed.notify_all();
+    }
+}
+
+bool InterpreterTier::compile(InterpreterNativeQuery& query, size_t id) {
+    if (dir.empty()) {
+        const char* tmp = std::getenv("TMPDIR");
+        std::string templ = std::string(tmp != nullptr ? tmp : "/tmp") + "/souffleXXXXXX";
+        if (mkdtemp(&templ[0]) == nullptr) {
+            return false;
+        }
+        dir = templ;
+    }
+    std::string base = dir + "/query" + std::to_string(id);
+    std::ofstream(base + ".cpp") << query.getCode();
+
+    bool loaded = false;
+    if (runCommand(compiler + " -d '" + base + ".cpp' >'" + base + ".log' 2>&1")) {
+        if (void* library = dlopen((base + ".so").c_str(), RTLD_NOW | RTLD_LOCAL)) {
+            if (void* function = dlsym(library, NATIVE_QUERY_SYMBOL)) {
+                libraries.push_back(library);
+                query.setFunction(reinterpret_cast<NativeQueryFunction>(function));
+                loaded = true;
+            } else {
+                dlclose(library);
+            }
+        }
+    }
+    // the library stays mapped once loaded
+    for (const char* ext : {".cpp", ".so", ".log"}) {
+        std::remove((base + ext).c_str());
+    }
+    return loaded;
+}
+
+bool InterpreterTier::runCommand(const std::string& cmd) {
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+    std::string shell = "sh";
+    std::string option = "-c";
+    std::string command = cmd;
+    char* argv[] = {&shell[0], &option[0], &command[0], nullptr};
+    pid_t pid = 0;
+    int error = posix_spawn(&pid, "/bin/sh", nullptr, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+    if (error != 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        child = pid;
+        if (stopping) {
+            kill(-pid, SIGTERM);
+        }
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        child = 0;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,168 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InterpreterTier.h
+ *
+ * Declares the classes compiling hot queries of the interpreter to native
+ * code in the background.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "interpreter/InterpreterNode.h"
+#include "interpreter/InterpreterRelation.h"
+#include "souffle/NativeQuery.h"
+#include "souffle/utility/MiscUtil.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+namespace souffle {
+
+namespace ram {
+class Node;
+class Operation;
+}  // namespace ram
+
+/**
+ * @class InterpreterNativeAccess
+ * @brief A relation access of a query compiled to native code, see NativeQueryContext.
+ */
+struct InterpreterNativeAccess {
+    enum Kind { Scan, ParallelScan, Range, ParallelRange, Contains, Empty, Insert };
+
+    Kind kind;
+    /** The accessed relation */
+    Own<InterpreterRelation>* relation;
+    /** The view of a range search or existence check, or the index of a parallel range search */
+    size_t view = 0;
+    /** If an existence check consults the Bloom filter of the relation */
+    bool filtered = false;
+    /** The buffer a projection collects its tuples in, if any */
+    std::shared_ptr<InterpreterInsertBuffer> buffer = nullptr;
+};
+
+/**
+ * @class InterpreterNativeQuery
+ * @brief The C++ code of the operation of a query, and its native code once compiled and loaded.
+ */
+class InterpreterNativeQuery {
+public:
+    InterpreterNativeQuery(std::string code, std::vector<InterpreterNativeAccess> accesses)
+            : code(std::move(code)), accesses(std::move(accesses)) {}
+
+    /** @brief Get the C++ code of the query */
+    const std::string& getCode() const {
+        return code;
+    }
+
+    /** @brief Get the access of the given number */
+    const InterpreterNativeAccess& getAccess(size_t i) const {
+        return accesses[i];
+    }
+
+    /** @brief Get the native code of the query; null while it is interpreted */
+    NativeQueryFunction getFunction() const {
+        return function.load(std::memory_order_acquire);
+    }
+
+    /** @brief Switch the query to the given native code */
+    void setFunction(NativeQueryFunction f) {
+        function.store(f, std::memory_order_release);
+    }
+
+    /** @brief Return true exactly once, when the execution time of the query first exceeds the threshold */
+    bool becameHot(uint64_t threshold) {
+        return nanoseconds >= threshold && !submitted.exchange(true);
+    }
+
+    /** Accumulated execution time, maintained by the interpreter */
+    std::atomic<uint64_t> nanoseconds{0};
+    /** Number of executions, maintained by the interpreter */
+    std::atomic<size_t> executions{0};
+
+private:
+    const std::string code;
+    const std::vector<InterpreterNativeAccess> accesses;
+    std::atomic<NativeQueryFunction> function{nullptr};
+    std::atomic<bool> submitted{false};
+};
+
+/**
+ * @brief Generate the C++ code of the operation of a query.
+ *
+ * The operations and conditions accessing relations are appended to accesses, in
+ * the order of their access numbers. Return false if the operation uses anything
+ * that is not compiled, such as aggregates, records, functors on symbols or
+ * user-defined functors; such queries remain interpreted.
+ */
+bool generateNativeQuery(
+        const ram::Operation& op, std::string& code, std::vector<const ram::Node*>& accesses);
+
+/**
+ * @class InterpreterTier
+ * @brief Compiles queries by souffle-compile in a background thread and loads them.
+ *
+ * A query is switched to its native code once the shared library holding it is
+ * loaded; the query keeps being interpreted until then, and for good if it fails
+ * to compile. A compiler still running when the tier is destroyed is killed.
+ */
+class InterpreterTier {
+public:
+    /** @param compiler the souffle-compile command */
+    InterpreterTier(std::string compiler) : compiler(std::move(compiler)) {}
+    ~InterpreterTier();
+
+    /** @brief Queue a query for compilation */
+    void submit(InterpreterNativeQuery& query);
+
+    /** @brief Wait until the queued queries are compiled or failed to; return the number loaded */
+    size_t wait();
+
+private:
+    /** @brief Compile queued queries until the tier is destroyed */
+    void run();
+
+    /** @brief Compile and load a query, return false if it failed */
+    bool compile(InterpreterNativeQuery& query, size_t id);
+
+    /** @brief Run a shell command in a process group of its own, return true if it succeeded */
+    bool runCommand(const std::string& cmd);
+
+    const std::string compiler;
+    /** Directory holding the sources and libraries; created by the first compilation */
+    std::string dir;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<InterpreterNativeQuery*> queue;
+    /** Number of queries queued or being compiled */
+    size_t pending = 0;
+    /** Number of queries compiled so far, naming their files */
+    size_t compiled = 0;
+    /** Number of queries switched to native code */
+    size_t loaded = 0;
+    bool stopping = false;
+    /** Process group of the running compiler, if any */
+    pid_t child = 0;
+    std::thread worker;
+    /** Loaded shared libraries */
+    std::vector<void*> libraries;
+};
+
+}  // end of namespace souffle
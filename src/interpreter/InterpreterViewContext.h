@@ -81,6 +81,16 @@ public:
         viewInfoForNested.push_back({relId, indexPos, viewPos});
     }
 
+    /** @brief Add a buffer collecting the tuples projected by the threads of the query. */
+    void addInsertBuffer(std::shared_ptr<InterpreterInsertBuffer> buffer) {
+        insertBuffers.push_back(std::move(buffer));
+    }
+
+    /** @brief Return the buffers to be merged into their relations once the query has finished */
+    const std::vector<std::shared_ptr<InterpreterInsertBuffer>>& getInsertBuffers() const {
+        return insertBuffers;
+    }
+
     /** If this context has information for parallel operation.  */
     bool isParallel = false;
 
@@ -95,6 +105,8 @@ private:
     std::vector<std::array<size_t, 3>> viewInfoForFilter;
     /** Vector of View information in nested operations */
     std::vector<std::array<size_t, 3>> viewInfoForNested;
+    /** Vector of buffers of projected tuples */
+    std::vector<std::shared_ptr<InterpreterInsertBuffer>> insertBuffers;
 };
 
 }  // namespace souffle
@@ -0,0 +1,487 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file interpreter_bytecode_test.cpp
+ *
+ * Tests the bytecode execution mode of the interpreter against the tree-walking mode.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "AggregateOp.h"
+#include "FunctorOps.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/InterpreterEngine.h"
+#include "ram/Aggregate.h"
+#include "ram/Break.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexAggregate.h"
+#include "ram/IndexScan.h"
+#include "ram/IntrinsicOperator.h"
+#include "ram/Negation.h"
+#include "ram/ParallelAggregate.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/ParallelScan.h"
+#include "ram/Program.h"
+#include "ram/Project.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/SubroutineReturn.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::test {
+
+using namespace souffle::ram;
+
+Own<Expression> binary(FunctorOp op, Own<Expression> lhs, Own<Expression> rhs) {
+    VecOwn<Expression> args;
+    args.push_back(std::move(lhs));
+    args.push_back(std::move(rhs));
+    return mk<IntrinsicOperator>(op, std::move(args));
+}
+
+Own<Expression> element(size_t tuple, size_t elem) {
+    return mk<TupleElement>(tuple, elem);
+}
+
+Own<Expression> constant(RamDomain value) {
+    return mk<SignedConstant>(value);
+}
+
+template <typename... Exprs>
+VecOwn<Expression> values(Own<Exprs>... exprs) {
+    VecOwn<Expression> res;
+    (res.push_back(std::move(exprs)), ...);
+    return res;
+}
+
+Own<Relation> relation(const std::string& name, size_t arity) {
+    std::vector<std::string> attributeNames;
+    for (size_t i = 0; i < arity; ++i) {
+        attributeNames.push_back("x" + std::to_string(i));
+    }
+    return mk<Relation>(name, arity, 0, attributeNames, std::vector<std::string>(arity, "i"),
+            RelationRepresentation::BTREE);
+}
+
+Own<RelationReference> ref(const Relation* rel) {
+    return mk<RelationReference>(rel);
+}
+
+/** A pattern binding the leading attribute of a binary relation to the given value */
+RamPattern prefix(Own<Expression> value) {
+    RamPattern pattern;
+    pattern.first = values(clone(value), mk<UndefValue>());
+    pattern.second = values(std::move(value), mk<UndefValue>());
+    return pattern;
+}
+
+/**
+ * Run the statements as a subroutine in the given mode and with the given number of
+ * threads, returning the values it returns.
+ */
+std::vector<RamDomain> execute(
+        VecOwn<Relation> rels, VecOwn<Statement> stmts, bool bytecode, const std::string& jobs = "1") {
+    Global::config().set("jobs", jobs);
+    if (bytecode) {
+        Global::config().set("bytecode");
+    } else {
+        Global::config().unset("bytecode");
+    }
+
+    std::map<std::string, Own<Statement>> subs;
+    subs.insert(std::make_pair("test", mk<Sequence>(std::move(stmts))));
+    Own<Program> prog = mk<Program>(std::move(rels), mk<Sequence>(), std::move(subs));
+
+    SymbolTable symTab;
+    ErrorReport errReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(std::move(prog), symTab, errReport, debugReport);
+    Own<InterpreterEngine> interpreter = mk<InterpreterEngine>(translationUnit);
+
+    std::vector<RamDomain> ret;
+    interpreter->executeSubroutine("test", {}, ret);
+    Global::config().unset("bytecode");
+    Global::config().set("jobs", "1");
+    return ret;
+}
+
+/** Insert A(i % 20, (i * 37) % 101 - 50) for all i below the given number */
+void fill(VecOwn<Statement>& stmts, const Relation* A, RamDomain numTuples) {
+    for (RamDomain i = 0; i < numTuples; ++i) {
+        stmts.push_back(
+                mk<Query>(mk<Project>(ref(A), values(constant(i % 20), constant((i * 37) % 101 - 50)))));
+    }
+}
+
+/** Return all tuples of the ternary relation C, in the order of its index */
+void returnAll(VecOwn<Statement>& stmts, const Relation* C) {
+    stmts.push_back(mk<Query>(mk<Scan>(
+            ref(C), 0, mk<SubroutineReturn>(values(element(0, 0), element(0, 1), element(0, 2))))));
+}
+
+/**
+ * Run a subroutine joining relations A and B into C and returning the contents
+ * of C, followed by a prefix of A cut off by a break.
+ */
+std::vector<RamDomain> runJoin(bool bytecode) {
+    VecOwn<Relation> rels;
+    rels.push_back(mk<Relation>("A", 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE));
+    rels.push_back(mk<Relation>("B", 1, 0, std::vector<std::string>{"x"}, std::vector<std::string>{"i"},
+            RelationRepresentation::BTREE));
+    rels.push_back(mk<Relation>("C", 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+    const Relation* C = rels[2].get();
+
+    VecOwn<Statement> stmts;
+    for (RamDomain i = 0; i < 50; ++i) {
+        stmts.push_back(mk<Query>(mk<Project>(ref(A), values(constant(i), constant((i * 7) % 13)))));
+        if (i % 3 == 0) {
+            stmts.push_back(mk<Query>(mk<Project>(ref(B), values(constant(i)))));
+        }
+    }
+
+    // C(x, 2 * w - y) :- A(x, y), A(y, w), x + w < 40, !B(y).
+    RamPattern pattern;
+    pattern.first = values(element(0, 1), mk<UndefValue>());
+    pattern.second = values(element(0, 1), mk<UndefValue>());
+    auto cond = mk<Conjunction>(mk<Constraint>(BinaryConstraintOp::LT,
+                                        binary(FunctorOp::ADD, element(0, 0), element(1, 1)), constant(40)),
+            mk<Negation>(mk<ExistenceCheck>(ref(B), values(element(1, 0)))));
+    auto project = mk<Project>(ref(C), values(element(0, 0),
+                                               binary(FunctorOp::SUB,
+                                                       binary(FunctorOp::MUL, constant(2), element(1, 1)),
+                                                       element(0, 1))));
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<IndexScan>(ref(A), 1, std::move(pattern), mk<Filter>(std::move(cond), std::move(project))))));
+
+    // return C(x, y) if some C(x, _) with x >= 5 exists
+    stmts.push_back(mk<Query>(mk<Scan>(ref(C), 0,
+            mk<Filter>(mk<ExistenceCheck>(ref(C), values(element(0, 0), mk<UndefValue>())),
+                    mk<Filter>(mk<Constraint>(BinaryConstraintOp::GE, element(0, 0), constant(5)),
+                            mk<SubroutineReturn>(values(element(0, 0), element(0, 1))))))));
+
+    // return A(x, _) until x > 20
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<Break>(mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(20)),
+                    mk<SubroutineReturn>(values(element(0, 0)))))));
+
+    return execute(std::move(rels), std::move(stmts), bytecode);
+}
+
+/**
+ * Run a subroutine whose scans carry filters on constants and outer tuples; the
+ * tree-walking mode evaluates them over batches of tuples. A holds enough tuples
+ * to span several batches.
+ */
+std::vector<RamDomain> runFilteredScan(bool bytecode) {
+    VecOwn<Relation> rels;
+    rels.push_back(mk<Relation>("A", 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE));
+    rels.push_back(mk<Relation>("B", 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+
+    VecOwn<Statement> stmts;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        stmts.push_back(
+                mk<Query>(mk<Project>(ref(A), values(constant(i % 50), constant((i * 37) % 1001 - 500)))));
+    }
+
+    // B(x, w) :- A(x, y), y > -200, x != 3, x < 40 (unsigned), A(x, w), w < y.
+    RamPattern pattern;
+    pattern.first = values(element(0, 0), mk<UndefValue>());
+    pattern.second = values(element(0, 0), mk<UndefValue>());
+    auto outer = mk<Conjunction>(mk<Constraint>(BinaryConstraintOp::GT, element(0, 1), constant(-200)),
+            mk<Constraint>(BinaryConstraintOp::NE, element(0, 0), constant(3)));
+    auto inner = mk<IndexScan>(ref(A), 1, std::move(pattern),
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT, element(1, 1), element(0, 1)),
+                    mk<Project>(ref(B), values(element(0, 0), element(1, 1)))));
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<Filter>(std::move(outer), mk<Filter>(mk<Constraint>(BinaryConstraintOp::ULT, element(0, 0),
+                                                            constant(40)),
+                                                 std::move(inner))))));
+
+    stmts.push_back(
+            mk<Query>(mk<Scan>(ref(B), 0, mk<SubroutineReturn>(values(element(0, 0), element(0, 1))))));
+
+    // return A(x, y) with y >= 100 until x > 20
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::GE, element(0, 1), constant(100)),
+                    mk<Break>(mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(20)),
+                            mk<SubroutineReturn>(values(element(0, 0), element(0, 1))))))));
+
+    return execute(std::move(rels), std::move(stmts), bytecode);
+}
+
+/**
+ * Run a subroutine aggregating the tuples of A, over ranges bound by the tuples of B
+ * and over the whole relation, into C(x, aggregate, result).
+ */
+std::vector<RamDomain> runAggregates(bool bytecode) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("B", 1));
+    rels.push_back(relation("C", 3));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+    const Relation* C = rels[2].get();
+
+    VecOwn<Statement> stmts;
+    fill(stmts, A, 200);
+    for (RamDomain i = 0; i < 25; ++i) {
+        stmts.push_back(mk<Query>(mk<Project>(ref(B), values(constant(i)))));
+    }
+
+    // C(x, k, r) :- B(x), r = f_k y : { A(x, y), y > 0 }, where no tuple qualifies for x >= 20
+    std::vector<AggregateOp> functions = {
+            AggregateOp::COUNT, AggregateOp::SUM, AggregateOp::MIN, AggregateOp::MAX, AggregateOp::MEAN};
+    for (size_t k = 0; k < functions.size(); ++k) {
+        Own<Expression> target = mk<UndefValue>();
+        if (functions[k] != AggregateOp::COUNT) {
+            target = element(1, 1);
+        }
+        auto project = mk<Project>(ref(C), values(element(0, 0), constant(k), element(1, 0)));
+        stmts.push_back(mk<Query>(mk<Scan>(ref(B), 0,
+                mk<IndexAggregate>(std::move(project), functions[k], ref(A), std::move(target),
+                        mk<Constraint>(BinaryConstraintOp::GT, element(1, 1), constant(0)),
+                        prefix(element(0, 0)), 1))));
+    }
+
+    // C(-1, k, r) :- r = f_k y : { A(x, y), x < y }
+    for (size_t k = 0; k < functions.size(); ++k) {
+        Own<Expression> target = mk<UndefValue>();
+        if (functions[k] != AggregateOp::COUNT) {
+            target = element(0, 1);
+        }
+        auto project = mk<Project>(ref(C), values(constant(-1), constant(k), element(0, 0)));
+        stmts.push_back(mk<Query>(mk<Aggregate>(std::move(project), functions[k], ref(A), std::move(target),
+                mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), element(0, 1)), 0)));
+    }
+
+    returnAll(stmts, C);
+    return execute(std::move(rels), std::move(stmts), bytecode);
+}
+
+/**
+ * Run a subroutine filtering the tuples of A by existence checks, negated or not,
+ * on full tuples and on prefixes, into C(k, x, y) for the k-th filter.
+ */
+std::vector<RamDomain> runExistenceChecks(bool bytecode) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("B", 1));
+    rels.push_back(relation("C", 3));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+    const Relation* C = rels[2].get();
+
+    VecOwn<Statement> stmts;
+    fill(stmts, A, 300);
+    for (RamDomain i = -50; i < 50; i += 3) {
+        stmts.push_back(mk<Query>(mk<Project>(ref(B), values(constant(i)))));
+    }
+
+    VecOwn<Condition> filters;
+    // B(y)
+    filters.push_back(mk<ExistenceCheck>(ref(B), values(element(0, 1))));
+    // !B(y)
+    filters.push_back(mk<Negation>(mk<ExistenceCheck>(ref(B), values(element(0, 1)))));
+    // A(y, _)
+    filters.push_back(mk<ExistenceCheck>(ref(A), values(element(0, 1), mk<UndefValue>())));
+    // !A(y, _)
+    filters.push_back(mk<Negation>(mk<ExistenceCheck>(ref(A), values(element(0, 1), mk<UndefValue>()))));
+    // !A(y, x)
+    filters.push_back(mk<Negation>(mk<ExistenceCheck>(ref(A), values(element(0, 1), element(0, 0)))));
+    // !(B(x + y) and x < 10)
+    filters.push_back(mk<Negation>(mk<Conjunction>(
+            mk<ExistenceCheck>(ref(B), values(binary(FunctorOp::ADD, element(0, 0), element(0, 1)))),
+            mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), constant(10)))));
+
+    for (size_t k = 0; k < filters.size(); ++k) {
+        stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+                mk<Filter>(std::move(filters[k]),
+                        mk<Project>(ref(C), values(constant(k), element(0, 0), element(0, 1)))))));
+    }
+
+    returnAll(stmts, C);
+    return execute(std::move(rels), std::move(stmts), bytecode);
+}
+
+/**
+ * Run a subroutine whose queries are parallel scans, index scans and aggregates
+ * over A, projecting into C, with the given number of threads.
+ */
+std::vector<RamDomain> runParallel(bool bytecode, const std::string& jobs) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("C", 3));
+    const Relation* A = rels[0].get();
+    const Relation* C = rels[1].get();
+
+    VecOwn<Statement> stmts;
+    fill(stmts, A, 2000);
+
+    // C(0, x, z) :- A(x, y), A(y + 20, z), x < z.
+    stmts.push_back(mk<Query>(mk<ParallelScan>(ref(A), 0,
+            mk<IndexScan>(ref(A), 1, prefix(binary(FunctorOp::ADD, element(0, 1), constant(20))),
+                    mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), element(1, 1)),
+                            mk<Project>(ref(C), values(constant(0), element(0, 0), element(1, 1))))))));
+
+    // C(1, 7, y) :- A(7, y), !A(y, _).
+    stmts.push_back(mk<Query>(mk<ParallelIndexScan>(ref(A), 0, prefix(constant(7)),
+            mk<Filter>(mk<Negation>(mk<ExistenceCheck>(ref(A), values(element(0, 1), mk<UndefValue>()))),
+                    mk<Project>(ref(C), values(constant(1), element(0, 0), element(0, 1)))))));
+
+    // C(2, 0, n) :- n = count : { A(x, y), x + y > 10 }.
+    stmts.push_back(mk<Query>(mk<ParallelAggregate>(
+            mk<Project>(ref(C), values(constant(2), constant(0), element(0, 0))), AggregateOp::COUNT, ref(A),
+            mk<UndefValue>(),
+            mk<Constraint>(BinaryConstraintOp::GT, binary(FunctorOp::ADD, element(0, 0), element(0, 1)),
+                    constant(10)),
+            0)));
+
+    returnAll(stmts, C);
+    return execute(std::move(rels), std::move(stmts), bytecode, jobs);
+}
+
+/**
+ * Run a subroutine computing the two-hop paths over A, filtered by arithmetic
+ * conditions.
+ */
+std::vector<RamDomain> runPaths(bool bytecode) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("B", 1));
+    rels.push_back(relation("C", 3));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+    const Relation* C = rels[2].get();
+
+    VecOwn<Statement> stmts;
+    for (RamDomain i = 0; i < 500; ++i) {
+        stmts.push_back(mk<Query>(mk<Project>(ref(B), values(constant(i)))));
+    }
+
+    // A(x, y) :- B(x), B(y), (x * 31 + y * 17) band 127 < 5.
+    stmts.push_back(mk<Query>(mk<Scan>(ref(B), 0,
+            mk<Scan>(ref(B), 1,
+                    mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT,
+                                       binary(FunctorOp::BAND,
+                                               binary(FunctorOp::ADD,
+                                                       binary(FunctorOp::MUL, element(0, 0), constant(31)),
+                                                       binary(FunctorOp::MUL, element(1, 0), constant(17))),
+                                               constant(127)),
+                                       constant(5)),
+                            mk<Project>(ref(A), values(element(0, 0), element(1, 0))))))));
+
+    // C(x, y, z) :- A(x, y), A(y, z), x * 3 + z * 5 - y < 1000, x != z.
+    auto cond = mk<Conjunction>(
+            mk<Constraint>(BinaryConstraintOp::LT,
+                    binary(FunctorOp::SUB,
+                            binary(FunctorOp::ADD, binary(FunctorOp::MUL, element(0, 0), constant(3)),
+                                    binary(FunctorOp::MUL, element(1, 1), constant(5))),
+                            element(0, 1)),
+                    constant(1000)),
+            mk<Constraint>(BinaryConstraintOp::NE, element(0, 0), element(1, 1)));
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<IndexScan>(ref(A), 1, prefix(element(0, 1)),
+                    mk<Filter>(std::move(cond),
+                            mk<Project>(ref(C), values(element(0, 0), element(0, 1), element(1, 1))))))));
+
+    returnAll(stmts, C);
+    return execute(std::move(rels), std::move(stmts), bytecode);
+}
+
+TEST(Bytecode, Join) {
+    std::vector<RamDomain> tree = runJoin(false);
+    std::vector<RamDomain> bytecode = runJoin(true);
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+TEST(Bytecode, FilteredScan) {
+    std::vector<RamDomain> tree = runFilteredScan(false);
+    std::vector<RamDomain> bytecode = runFilteredScan(true);
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+TEST(Bytecode, Aggregates) {
+    std::vector<RamDomain> tree = runAggregates(false);
+    std::vector<RamDomain> bytecode = runAggregates(true);
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+TEST(Bytecode, ExistenceChecks) {
+    std::vector<RamDomain> tree = runExistenceChecks(false);
+    std::vector<RamDomain> bytecode = runExistenceChecks(true);
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+TEST(Bytecode, Parallel) {
+    // the results do not depend on the mode, nor on the number of threads
+    std::vector<RamDomain> sequential = runParallel(false, "1");
+    std::vector<RamDomain> tree = runParallel(false, "4");
+    std::vector<RamDomain> bytecode = runParallel(true, "4");
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(sequential.size(), tree.size());
+    EXPECT_TRUE(sequential == tree);
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+TEST(Bytecode, ArithmeticFilters) {
+    std::vector<RamDomain> tree = runPaths(false);
+    std::vector<RamDomain> bytecode = runPaths(true);
+
+    EXPECT_FALSE(tree.empty());
+    EXPECT_EQ(tree.size(), bytecode.size());
+    EXPECT_TRUE(tree == bytecode);
+}
+
+}  // namespace souffle::test
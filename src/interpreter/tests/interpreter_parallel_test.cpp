@@ -0,0 +1,356 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file interpreter_parallel_test.cpp
+ *
+ * Tests the parallel statements and operations of the interpreter against
+ * their sequential evaluation.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "AggregateOp.h"
+#include "FunctorOps.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/InterpreterEngine.h"
+#include "ram/Aggregate.h"
+#include "ram/Clear.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Exit.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/IntrinsicOperator.h"
+#include "ram/Loop.h"
+#include "ram/Merge.h"
+#include "ram/Negation.h"
+#include "ram/Parallel.h"
+#include "ram/ParallelAggregate.h"
+#include "ram/ParallelIndexAggregate.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/ParallelScan.h"
+#include "ram/Program.h"
+#include "ram/Project.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/SubroutineReturn.h"
+#include "ram/Swap.h"
+#include "ram/TranslationUnit.h"
+#include "ram/True.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::test {
+
+using namespace souffle::ram;
+
+Own<Expression> unary(FunctorOp op, Own<Expression> arg) {
+    VecOwn<Expression> args;
+    args.push_back(std::move(arg));
+    return mk<IntrinsicOperator>(op, std::move(args));
+}
+
+Own<Expression> element(size_t tuple, size_t elem) {
+    return mk<TupleElement>(tuple, elem);
+}
+
+Own<Expression> constant(RamDomain value) {
+    return mk<SignedConstant>(value);
+}
+
+template <typename... Exprs>
+VecOwn<Expression> values(Own<Exprs>... exprs) {
+    VecOwn<Expression> res;
+    (res.push_back(std::move(exprs)), ...);
+    return res;
+}
+
+Own<Relation> relation(const std::string& name, size_t arity) {
+    std::vector<std::string> attributeNames;
+    for (size_t i = 0; i < arity; ++i) {
+        attributeNames.push_back("x" + std::to_string(i));
+    }
+    return mk<Relation>(name, arity, 0, attributeNames, std::vector<std::string>(arity, "i"),
+            RelationRepresentation::BTREE);
+}
+
+Own<RelationReference> ref(const Relation* rel) {
+    return mk<RelationReference>(rel);
+}
+
+/** A pattern binding the leading attribute of a binary relation to the given value */
+RamPattern prefix(Own<Expression> value) {
+    RamPattern pattern;
+    pattern.first = values(clone(value), mk<UndefValue>());
+    pattern.second = values(std::move(value), mk<UndefValue>());
+    return pattern;
+}
+
+/**
+ * Run the statements as a subroutine with the given number of threads, returning
+ * the values it returns.
+ */
+std::vector<RamDomain> execute(VecOwn<Relation> rels, VecOwn<Statement> stmts, const std::string& jobs) {
+    Global::config().set("jobs", jobs);
+
+    std::map<std::string, Own<Statement>> subs;
+    subs.insert(std::make_pair("test", mk<Sequence>(std::move(stmts))));
+    Own<Program> prog = mk<Program>(std::move(rels), mk<Sequence>(), std::move(subs));
+
+    SymbolTable symTab;
+    ErrorReport errReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(std::move(prog), symTab, errReport, debugReport);
+    Own<InterpreterEngine> interpreter = mk<InterpreterEngine>(translationUnit);
+
+    std::vector<RamDomain> ret;
+    interpreter->executeSubroutine("test", {}, ret);
+    Global::config().set("jobs", "1");
+    return ret;
+}
+
+/** Return all tuples of the binary relation, in the order of its index, tagged by the given value */
+void returnAll(VecOwn<Statement>& stmts, const Relation* rel, RamDomain tag) {
+    stmts.push_back(mk<Query>(mk<Scan>(
+            ref(rel), 0, mk<SubroutineReturn>(values(constant(tag), element(0, 0), element(0, 1))))));
+}
+
+/**
+ * Run a subroutine computing the mutually recursive relations P and Q over the
+ * edges E with a fixpoint loop, as translated for a recursive stratum. The rules
+ * of an iteration are the children of a parallel statement; two of them write
+ * @new_P, and all of them nest parallel scans or index scans.
+ *
+ *   P(x, y) :- E(x, y).
+ *   P(x, z) :- P(x, y), E(y, z).
+ *   P(x, z) :- Q(x, y), E(y, z), x < z.
+ *   Q(y, x) :- E(x, y), y < 10.
+ *   Q(x, z) :- E(x, y), P(y, z).
+ *   Q(3, z) :- Q(3, y), P(y, z).
+ */
+std::vector<RamDomain> runRecursion(const std::string& jobs) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("E", 2));
+    rels.push_back(relation("P", 2));
+    rels.push_back(relation("@delta_P", 2));
+    rels.push_back(relation("@new_P", 2));
+    rels.push_back(relation("Q", 2));
+    rels.push_back(relation("@delta_Q", 2));
+    rels.push_back(relation("@new_Q", 2));
+    const Relation* E = rels[0].get();
+    const Relation* P = rels[1].get();
+    const Relation* deltaP = rels[2].get();
+    const Relation* newP = rels[3].get();
+    const Relation* Q = rels[4].get();
+    const Relation* deltaQ = rels[5].get();
+    const Relation* newQ = rels[6].get();
+
+    VecOwn<Statement> stmts;
+    // an acyclic graph: E(i, (i * 7 + 3) % 50) if i is the smaller, and E(i, i + 1) for some i
+    for (RamDomain i = 0; i < 50; ++i) {
+        if (i < (i * 7 + 3) % 50) {
+            stmts.push_back(mk<Query>(mk<Project>(ref(E), values(constant(i), constant((i * 7 + 3) % 50)))));
+        }
+        if (i < 40 && i % 5 != 0) {
+            stmts.push_back(mk<Query>(mk<Project>(ref(E), values(constant(i), constant(i + 1)))));
+        }
+    }
+
+    // non-recursive rules
+    stmts.push_back(
+            mk<Query>(mk<Scan>(ref(E), 0, mk<Project>(ref(P), values(element(0, 0), element(0, 1))))));
+    stmts.push_back(mk<Query>(mk<Scan>(ref(E), 0,
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT, element(0, 1), constant(10)),
+                    mk<Project>(ref(Q), values(element(0, 1), element(0, 0)))))));
+    stmts.push_back(mk<Merge>(ref(deltaP), ref(P)));
+    stmts.push_back(mk<Merge>(ref(deltaQ), ref(Q)));
+
+    // P(x, z) :- @delta_P(x, y), E(y, z), !P(x, z).
+    auto ruleP0 = mk<Query>(mk<ParallelScan>(ref(deltaP), 0,
+            mk<IndexScan>(ref(E), 1, prefix(element(0, 1)),
+                    mk<Filter>(mk<Negation>(mk<ExistenceCheck>(ref(P), values(element(0, 0), element(1, 1)))),
+                            mk<Project>(ref(newP), values(element(0, 0), element(1, 1)))))));
+
+    // P(x, z) :- @delta_Q(x, y), E(y, z), x < z, !P(x, z).
+    auto ruleP1 = mk<Query>(mk<ParallelScan>(ref(deltaQ), 0,
+            mk<IndexScan>(ref(E), 1, prefix(element(0, 1)),
+                    mk<Filter>(mk<Conjunction>(
+                                       mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), element(1, 1)),
+                                       mk<Negation>(mk<ExistenceCheck>(
+                                               ref(P), values(element(0, 0), element(1, 1))))),
+                            mk<Project>(ref(newP), values(element(0, 0), element(1, 1)))))));
+
+    // Q(x, z) :- E(x, y), @delta_P(y, z), !Q(x, z).
+    auto ruleQ0 = mk<Query>(mk<ParallelScan>(ref(E), 0,
+            mk<IndexScan>(ref(deltaP), 1, prefix(element(0, 1)),
+                    mk<Filter>(mk<Negation>(mk<ExistenceCheck>(ref(Q), values(element(0, 0), element(1, 1)))),
+                            mk<Project>(ref(newQ), values(element(0, 0), element(1, 1)))))));
+
+    // Q(3, z) :- @delta_Q(3, y), P(y, z), !Q(3, z).
+    auto ruleQ1 = mk<Query>(mk<ParallelIndexScan>(ref(deltaQ), 0, prefix(constant(3)),
+            mk<IndexScan>(ref(P), 1, prefix(element(0, 1)),
+                    mk<Filter>(mk<Negation>(mk<ExistenceCheck>(ref(Q), values(constant(3), element(1, 1)))),
+                            mk<Project>(ref(newQ), values(constant(3), element(1, 1)))))));
+
+    auto rules = mk<Parallel>(
+            std::move(ruleP0), std::move(ruleP1), mk<Sequence>(std::move(ruleQ0), std::move(ruleQ1)));
+    auto exitCond = mk<Conjunction>(mk<EmptinessCheck>(ref(newP)), mk<EmptinessCheck>(ref(newQ)));
+    auto update = mk<Sequence>(mk<Merge>(ref(P), ref(newP)), mk<Swap>(ref(deltaP), ref(newP)),
+            mk<Clear>(ref(newP)), mk<Merge>(ref(Q), ref(newQ)), mk<Swap>(ref(deltaQ), ref(newQ)),
+            mk<Clear>(ref(newQ)));
+    stmts.push_back(
+            mk<Loop>(mk<Sequence>(std::move(rules), mk<Exit>(std::move(exitCond)), std::move(update))));
+    stmts.push_back(mk<Clear>(ref(deltaP)));
+    stmts.push_back(mk<Clear>(ref(newP)));
+    stmts.push_back(mk<Clear>(ref(deltaQ)));
+    stmts.push_back(mk<Clear>(ref(newQ)));
+
+    returnAll(stmts, P, 0);
+    returnAll(stmts, Q, 1);
+    return execute(std::move(rels), std::move(stmts), jobs);
+}
+
+/** The tuples A(i % 20, (i * 37) % 101 - 50) for all i below 2000 */
+std::set<std::pair<RamDomain, RamDomain>> tuplesOfA() {
+    std::set<std::pair<RamDomain, RamDomain>> tuples;
+    for (RamDomain i = 0; i < 2000; ++i) {
+        tuples.emplace(i % 20, (i * 37) % 101 - 50);
+    }
+    return tuples;
+}
+
+/**
+ * Run a subroutine computing aggregates over A by parallel aggregates, projecting
+ * C(k, n) for the k-th aggregate with result n, if any, and returning C.
+ */
+std::vector<RamDomain> runAggregates(const std::string& jobs) {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("C", 2));
+    const Relation* A = rels[0].get();
+    const Relation* C = rels[1].get();
+
+    VecOwn<Statement> stmts;
+    for (const auto& tuple : tuplesOfA()) {
+        stmts.push_back(
+                mk<Query>(mk<Project>(ref(A), values(constant(tuple.first), constant(tuple.second)))));
+    }
+
+    size_t k = 0;
+    auto aggregate = [&](AggregateOp op, Own<Expression> expr, Own<Condition> cond) {
+        auto project = mk<Project>(ref(C), values(constant(k++), element(0, 0)));
+        stmts.push_back(mk<Query>(
+                mk<ParallelAggregate>(std::move(project), op, ref(A), std::move(expr), std::move(cond), 0)));
+    };
+    auto indexAggregate = [&](AggregateOp op, Own<Expression> expr, RamDomain x) {
+        auto project = mk<Project>(ref(C), values(constant(k++), element(0, 0)));
+        stmts.push_back(mk<Query>(mk<ParallelIndexAggregate>(std::move(project), op, ref(A), std::move(expr),
+                mk<True>(), prefix(constant(x)), 0)));
+    };
+
+    // C(0, n) :- n = min y : { A(x, y), x > 3 }.
+    aggregate(AggregateOp::MIN, element(0, 1),
+            mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(3)));
+    // C(1, n) :- n = max y : { A(x, y), x < 15 }.
+    aggregate(AggregateOp::MAX, element(0, 1),
+            mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), constant(15)));
+    // C(2, n) :- n = sum y : { A(x, y), x != 7 }.
+    aggregate(AggregateOp::SUM, element(0, 1),
+            mk<Constraint>(BinaryConstraintOp::NE, element(0, 0), constant(7)));
+    // C(3, n) :- n = mean to_float(y) : { A(x, y), y > -20 }.
+    aggregate(AggregateOp::MEAN, unary(FunctorOp::I2F, element(0, 1)),
+            mk<Constraint>(BinaryConstraintOp::GT, element(0, 1), constant(-20)));
+    // C(4, n) :- n = count : { A(x, y), x < y }.
+    aggregate(AggregateOp::COUNT, mk<UndefValue>(),
+            mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), element(0, 1)));
+
+    // C(5, n) to C(9, n) over the empty range of A(1000, y)
+    indexAggregate(AggregateOp::MIN, element(0, 1), 1000);
+    indexAggregate(AggregateOp::MAX, element(0, 1), 1000);
+    indexAggregate(AggregateOp::SUM, element(0, 1), 1000);
+    indexAggregate(AggregateOp::MEAN, unary(FunctorOp::I2F, element(0, 1)), 1000);
+    indexAggregate(AggregateOp::COUNT, mk<UndefValue>(), 1000);
+
+    // C(10, n) and C(11, n) over no matching tuples of A
+    aggregate(AggregateOp::MAX, element(0, 1),
+            mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(100)));
+    aggregate(AggregateOp::SUM, element(0, 1),
+            mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(100)));
+
+    returnAll(stmts, C, 0);
+    return execute(std::move(rels), std::move(stmts), jobs);
+}
+
+/** The values returned by runAggregates, computed directly */
+std::vector<RamDomain> expectedAggregates() {
+    RamDomain min = MAX_RAM_SIGNED;
+    RamDomain max = MIN_RAM_SIGNED;
+    RamDomain sum = 0;
+    RamFloat meanSum = 0;
+    RamFloat meanCount = 0;
+    RamDomain count = 0;
+    for (const auto& tuple : tuplesOfA()) {
+        RamDomain x = tuple.first;
+        RamDomain y = tuple.second;
+        min = x > 3 ? std::min(min, y) : min;
+        max = x < 15 ? std::max(max, y) : max;
+        sum += x != 7 ? y : 0;
+        meanSum += y > -20 ? static_cast<RamFloat>(y) : 0;
+        meanCount += y > -20 ? 1 : 0;
+        count += x < y ? 1 : 0;
+    }
+    // the min, max and mean of no values are not defined, while their sum and count are 0
+    return {0, 0, min, 0, 1, max, 0, 2, sum, 0, 3, ramBitCast(meanSum / meanCount), 0, 4, count, 0, 7, 0, 0,
+            9, 0, 0, 11, 0};
+}
+
+TEST(InterpreterParallel, Statement) {
+    // the results do not depend on the number of threads, nor on how they are split between tasks
+    std::vector<RamDomain> sequential = runRecursion("1");
+    EXPECT_FALSE(sequential.empty());
+    for (const char* jobs : {"2", "3", "4", "8"}) {
+        std::vector<RamDomain> parallel = runRecursion(jobs);
+        EXPECT_EQ(sequential.size(), parallel.size());
+        EXPECT_TRUE(sequential == parallel);
+    }
+}
+
+TEST(InterpreterParallel, Aggregates) {
+    // the partial results of the partitions combine into those of a sequential evaluation
+    std::vector<RamDomain> expected = expectedAggregates();
+    for (const char* jobs : {"1", "2", "3", "4", "8"}) {
+        std::vector<RamDomain> parallel = runAggregates(jobs);
+        EXPECT_EQ(expected.size(), parallel.size());
+        EXPECT_TRUE(expected == parallel);
+    }
+}
+
+}  // namespace souffle::test
@@ -16,6 +16,7 @@
 
 #include "tests/test.h"
 
+#include "interpreter/InterpreterContext.h"
 #include "interpreter/InterpreterProgInterface.h"
 #include "interpreter/InterpreterRelation.h"
 #include "ram/analysis/Index.h"
@@ -24,10 +25,13 @@
 #include <iosfwd>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace souffle::test {
 
+using ram::analysis::AttributeConstraint;
 using ram::analysis::MinIndexSelection;
+using ram::analysis::SearchSignature;
 
 TEST(Relation0, Construction) {
     // create a nullary relation
@@ -167,4 +171,470 @@ TEST(IndependentCopying, Iteration) {
     EXPECT_EQ(1, (*it)[0]);
 }
 
+TEST(Merge, Indexes) {
+    // the target has an additional index on the second attribute
+    MinIndexSelection targetOrder{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    SearchSignature second(2);
+    second[1] = AttributeConstraint::Equal;
+    targetOrder.addSearch(first);
+    targetOrder.addSearch(second);
+    targetOrder.solve();
+    MinIndexSelection sourceOrder{};
+    sourceOrder.insertDefaultTotalIndex(2);
+    InterpreterRelation target(2, 0, "target", {"i", "i"}, targetOrder);
+    InterpreterRelation source(2, 0, "source", {"i", "i"}, sourceOrder);
+    EXPECT_EQ(2, targetOrder.getAllOrders().size());
+
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[2] = {i, i % 7};
+        if (i % 2 == 0) {
+            target.insert(tuple);
+        }
+        if (i % 3 == 0) {
+            source.insert(tuple);
+        }
+    }
+
+    // an empty target copies the source
+    InterpreterRelation copy(2, 0, "copy", {"i", "i"}, targetOrder);
+    copy.insert(source);
+    EXPECT_EQ(source.size(), copy.size());
+
+    target.insert(source);
+    EXPECT_EQ(667, target.size());
+
+    // all indexes of the target hold the merged tuples
+    for (size_t indexPos = 0; indexPos < 2; ++indexPos) {
+        RamDomain low[2] = {MIN_RAM_SIGNED, 3};
+        RamDomain high[2] = {MAX_RAM_SIGNED, 3};
+        size_t count = 0;
+        for (const auto& cur : target.range(indexPos, TupleRef(low, 2), TupleRef(high, 2))) {
+            if (cur[1] == 3) {
+                EXPECT_TRUE(cur[0] % 2 == 0 || cur[0] % 3 == 0);
+                ++count;
+            }
+        }
+        EXPECT_EQ(95, count);
+    }
+}
+
+TEST(LargeArity, Range) {
+    // a relation with an arity beyond the specialised indexes, searched on its last attribute
+    const size_t arity = 30;
+    MinIndexSelection order{};
+    SearchSignature last(arity);
+    last[arity - 1] = AttributeConstraint::Equal;
+    order.addSearch(last);
+    order.addSearch(SearchSignature::getFullSearchSignature(arity));
+    order.solve();
+    InterpreterRelation rel(arity, 0, "test", std::vector<std::string>(arity, "i"), order);
+
+    for (RamDomain i = 0; i < 100; ++i) {
+        RamDomain tuple[arity];
+        for (size_t j = 0; j < arity; ++j) {
+            tuple[j] = i * static_cast<RamDomain>(j);
+        }
+        tuple[arity - 1] = i % 5;
+        EXPECT_TRUE(rel.insert(tuple));
+        EXPECT_FALSE(rel.insert(tuple));
+    }
+    EXPECT_EQ(100, rel.size());
+
+    RamDomain low[arity];
+    RamDomain high[arity];
+    std::fill(low, low + arity, MIN_RAM_SIGNED);
+    std::fill(high, high + arity, MAX_RAM_SIGNED);
+    low[arity - 1] = high[arity - 1] = 2;
+    size_t count = 0;
+    for (const auto& cur : rel.range(0, TupleRef(low, arity), TupleRef(high, arity))) {
+        EXPECT_EQ(arity, cur.size());
+        EXPECT_EQ(2, cur[arity - 1]);
+        EXPECT_EQ(cur[1] * 7, cur[7]);
+        ++count;
+    }
+    EXPECT_EQ(20, count);
+
+    size_t total = 0;
+    for (const auto& cur : rel.scan()) {
+        EXPECT_TRUE(rel.contains(cur));
+        ++total;
+    }
+    EXPECT_EQ(100, total);
+}
+
+TEST(HashsetRelation, Range) {
+    // a hash set relation searched on its first attribute, and on its first and last attributes
+    MinIndexSelection order{};
+    SearchSignature first(3);
+    first[0] = AttributeConstraint::Equal;
+    SearchSignature outer(3);
+    outer[0] = AttributeConstraint::Equal;
+    outer[2] = AttributeConstraint::Equal;
+    order.addSearch(first);
+    order.addSearch(outer);
+    order.solve();
+    EXPECT_EQ(1, order.getKeySize(0));
+    InterpreterHashsetRelation rel(3, 0, "test", {"i", "i", "i"}, order);
+
+    for (RamDomain i = 0; i < 100; ++i) {
+        RamDomain tuple[3] = {i % 10, i, i % 2};
+        EXPECT_TRUE(rel.insert(tuple));
+        EXPECT_FALSE(rel.insert(tuple));
+    }
+    EXPECT_EQ(100, rel.size());
+
+    RamDomain low[3] = {3, MIN_RAM_SIGNED, 1};
+    RamDomain high[3] = {3, MAX_RAM_SIGNED, 1};
+    size_t count = 0;
+    for (const auto& cur : rel.range(0, TupleRef(low, 3), TupleRef(high, 3))) {
+        EXPECT_EQ(3, cur[0]);
+        EXPECT_EQ(1, cur[2]);
+        ++count;
+    }
+    EXPECT_EQ(10, count);
+
+    // searches not binding the key scan the relation
+    low[0] = MIN_RAM_SIGNED;
+    high[0] = MAX_RAM_SIGNED;
+    count = 0;
+    for (const auto& cur : rel.range(0, TupleRef(low, 3), TupleRef(high, 3))) {
+        EXPECT_EQ(1, cur[2]);
+        ++count;
+    }
+    EXPECT_EQ(50, count);
+
+    size_t total = 0;
+    for (const auto& cur : rel.scan()) {
+        EXPECT_TRUE(rel.contains(cur));
+        ++total;
+    }
+    EXPECT_EQ(100, total);
+}
+
+TEST(RangeCount, Indexes) {
+    // ranges are counted through the ranks of counted b-trees, and by enumerating other ranges
+    MinIndexSelection order{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    order.addCountedSearch(first);
+    order.solve();
+    EXPECT_TRUE(order.isCounted(0));
+    InterpreterRelation btree(2, 0, "btree", {"i", "i"}, order);
+    btree.replaceIndex(0, createCountedBTreeIndex);
+    InterpreterRelation plain(2, 0, "plain", {"i", "i"}, order);
+    InterpreterHashsetRelation hashset(2, 0, "hashset", {"i", "i"}, order);
+
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[2] = {i % 7, i};
+        btree.insert(tuple);
+        plain.insert(tuple);
+        hashset.insert(tuple);
+    }
+
+    RamDomain low[2] = {3, MIN_RAM_SIGNED};
+    RamDomain high[2] = {3, MAX_RAM_SIGNED};
+    EXPECT_EQ(143, btree.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    EXPECT_EQ(143, plain.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    EXPECT_EQ(143, hashset.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+
+    // the counts follow insertions
+    RamDomain tuple[2] = {3, 1000};
+    btree.insert(tuple);
+    EXPECT_EQ(144, btree.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+
+    // empty ranges
+    low[0] = high[0] = 7;
+    EXPECT_EQ(0, btree.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    low[0] = 5;
+    high[0] = 4;
+    EXPECT_EQ(0, btree.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+}
+
+TEST(RangeBoundary, Indexes) {
+    // the boundaries of b-tree ranges are located directly, those of hash set ranges by enumeration
+    MinIndexSelection order{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    first[1] = AttributeConstraint::Inequal;
+    order.addSearch(first);
+    order.solve();
+    InterpreterRelation btree(2, 0, "btree", {"i", "i"}, order);
+    InterpreterHashsetRelation hashset(2, 0, "hashset", {"i", "i"}, order);
+
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[2] = {i % 7, 500 - i};
+        btree.insert(tuple);
+        hashset.insert(tuple);
+    }
+
+    RamDomain low[2] = {3, MIN_RAM_SIGNED};
+    RamDomain high[2] = {3, MAX_RAM_SIGNED};
+    RamDomain res[2] = {0, 0};
+    EXPECT_TRUE(btree.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), false, res));
+    EXPECT_EQ(3, res[0]);
+    EXPECT_EQ(-497, res[1]);
+    EXPECT_TRUE(btree.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_EQ(3, res[0]);
+    EXPECT_EQ(497, res[1]);
+
+    // the range ends at the last tuple of the index
+    low[0] = high[0] = 6;
+    EXPECT_TRUE(btree.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_EQ(6, res[0]);
+    EXPECT_EQ(494, res[1]);
+
+    // hash set ranges are not ordered, yet their boundaries are those of the simulated order
+    low[0] = high[0] = 3;
+    EXPECT_TRUE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), false, res));
+    EXPECT_EQ(3, res[0]);
+    EXPECT_EQ(-497, res[1]);
+    EXPECT_TRUE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_EQ(3, res[0]);
+    EXPECT_EQ(497, res[1]);
+
+    // ranges filtering attributes not covered by the key of the hash set
+    low[0] = 2;
+    high[0] = 5;
+    low[1] = 0;
+    high[1] = 10;
+    EXPECT_TRUE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), false, res));
+    EXPECT_EQ(2, res[0]);
+    EXPECT_EQ(1, res[1]);
+    EXPECT_TRUE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_EQ(5, res[0]);
+    EXPECT_EQ(5, res[1]);
+
+    // empty ranges
+    low[0] = high[0] = 7;
+    low[1] = MIN_RAM_SIGNED;
+    high[1] = MAX_RAM_SIGNED;
+    EXPECT_FALSE(btree.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), false, res));
+    EXPECT_FALSE(btree.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_FALSE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), false, res));
+    EXPECT_FALSE(hashset.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+}
+
+TEST(BulkInsert, Indexes) {
+    // the relations have an additional index on the second attribute
+    MinIndexSelection order{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    SearchSignature second(2);
+    second[1] = AttributeConstraint::Equal;
+    order.addSearch(first);
+    order.addSearch(second);
+    order.solve();
+    InterpreterRelation btree(2, 0, "btree", {"i", "i"}, order);
+    InterpreterIndirectRelation indirect(2, 0, "indirect", {"i", "i"}, order);
+
+    for (RamDomain i = 0; i < 1000; i += 2) {
+        RamDomain tuple[2] = {i, i % 7};
+        btree.insert(tuple);
+        indirect.insert(tuple);
+    }
+
+    // insert an array of tuples, overlapping with the present ones and containing duplicates
+    std::vector<RamDomain> tuples;
+    for (RamDomain i = 999; i >= 0; i -= 3) {
+        tuples.push_back(i);
+        tuples.push_back(i % 7);
+        tuples.push_back(i);
+        tuples.push_back(i % 7);
+    }
+    btree.insert(tuples.data(), tuples.size() / 2);
+    indirect.insert(tuples.data(), tuples.size() / 2);
+    EXPECT_EQ(667, btree.size());
+    EXPECT_EQ(667, indirect.size());
+
+    // all indexes hold the inserted tuples
+    for (auto* rel : {&btree, static_cast<InterpreterRelation*>(&indirect)}) {
+        for (size_t indexPos = 0; indexPos < 2; ++indexPos) {
+            RamDomain low[2] = {MIN_RAM_SIGNED, 3};
+            RamDomain high[2] = {MAX_RAM_SIGNED, 3};
+            size_t count = 0;
+            for (const auto& cur : rel->range(indexPos, TupleRef(low, 2), TupleRef(high, 2))) {
+                if (cur[1] == 3) {
+                    EXPECT_TRUE(cur[0] % 2 == 0 || cur[0] % 3 == 0);
+                    ++count;
+                }
+            }
+            EXPECT_EQ(95, count);
+        }
+    }
+}
+
+TEST(DeferredIndexes, Build) {
+    // the relations have an additional index on the second attribute
+    MinIndexSelection order{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    SearchSignature second(2);
+    second[1] = AttributeConstraint::Equal;
+    order.addSearch(first);
+    order.addSearch(second);
+    order.solve();
+    InterpreterRelation deferred(2, 0, "deferred", {"i", "i"}, order);
+    InterpreterRelation plain(2, 0, "plain", {"i", "i"}, order);
+    deferred.deferIndexes();
+
+    // counts the tuples with the given second attribute through the given index
+    auto count = [](const InterpreterRelation& rel, size_t indexPos, RamDomain value) {
+        RamDomain low[2] = {MIN_RAM_SIGNED, value};
+        RamDomain high[2] = {MAX_RAM_SIGNED, value};
+        size_t res = 0;
+        for (const auto& cur : rel.range(indexPos, TupleRef(low, 2), TupleRef(high, 2))) {
+            res += (cur[1] == value) ? 1 : 0;
+        }
+        return res;
+    };
+
+    for (int round = 0; round < 2; ++round) {
+        // only the main index is maintained while the relation is filled
+        for (RamDomain i = 0; i < 1000; ++i) {
+            RamDomain tuple[2] = {i, i % 7};
+            deferred.insert(tuple);
+        }
+        EXPECT_EQ(1000, deferred.size());
+        EXPECT_EQ(143, count(deferred, 0, 3));
+
+        // the secondary index holds all tuples once built, and is maintained from then on
+        deferred.ensureIndex(1);
+        EXPECT_EQ(143, count(deferred, 1, 3));
+        RamDomain tuple[2] = {1000, 3};
+        deferred.insert(tuple);
+        EXPECT_EQ(144, count(deferred, 1, 3));
+
+        // a built relation is merged through all of its indexes
+        plain.purge();
+        plain.insert(deferred);
+        EXPECT_EQ(1001, plain.size());
+        EXPECT_EQ(144, count(plain, 1, 3));
+
+        // purging defers the secondary indexes again
+        deferred.purge();
+    }
+
+    // a deferred relation is merged through its main index, and merged into through its main index
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[2] = {i, i % 7};
+        deferred.insert(tuple);
+    }
+    plain.purge();
+    plain.insert(deferred);
+    EXPECT_EQ(1000, plain.size());
+    EXPECT_EQ(143, count(plain, 1, 3));
+
+    deferred.purge();
+    deferred.insert(plain);
+    EXPECT_EQ(1000, deferred.size());
+    deferred.ensureIndex(1);
+    EXPECT_EQ(143, count(deferred, 1, 3));
+}
+
+TEST(FrozenIndexes, Range) {
+    // the relations have an additional index on the second attribute
+    MinIndexSelection order{};
+    SearchSignature first(2);
+    first[0] = AttributeConstraint::Equal;
+    SearchSignature second(2);
+    second[1] = AttributeConstraint::Equal;
+    order.addSearch(first);
+    order.addSearch(second);
+    order.solve();
+    InterpreterRelation frozen(2, 0, "frozen", {"i", "i"}, order);
+    InterpreterRelation plain(2, 0, "plain", {"i", "i"}, order);
+
+    for (RamDomain i = 0; i < 10000; ++i) {
+        RamDomain tuple[2] = {i % 13, i};
+        frozen.insert(tuple);
+    }
+    frozen.freeze();
+    EXPECT_EQ(10000, frozen.size());
+
+    // all indexes are searched as before
+    RamDomain tuple[2] = {5, 18};
+    EXPECT_TRUE(frozen.contains(TupleRef(tuple, 2)));
+    tuple[1] = 19;
+    EXPECT_FALSE(frozen.contains(TupleRef(tuple, 2)));
+    RamDomain low[2] = {3, MIN_RAM_SIGNED};
+    RamDomain high[2] = {3, MAX_RAM_SIGNED};
+    EXPECT_EQ(769, frozen.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    RamDomain res[2] = {0, 0};
+    EXPECT_TRUE(frozen.getView(0)->boundary(TupleRef(low, 2), TupleRef(high, 2), true, res));
+    EXPECT_EQ(9987, res[1]);
+    low[0] = MIN_RAM_SIGNED;
+    high[0] = MAX_RAM_SIGNED;
+    low[1] = high[1] = 42;
+    size_t count = 0;
+    for (const auto& cur : frozen.range(1, TupleRef(low, 2), TupleRef(high, 2))) {
+        EXPECT_EQ(3, cur[0]);
+        ++count;
+    }
+    EXPECT_EQ(1, count);
+
+    // frozen relations are merged and scanned as before
+    plain.insert(frozen);
+    EXPECT_EQ(10000, plain.size());
+    count = 0;
+    for (auto& cur : frozen.partitionScan(8)) {
+        for (const auto& tuple : cur) {
+            EXPECT_TRUE(plain.contains(tuple));
+            ++count;
+        }
+    }
+    EXPECT_EQ(10000, count);
+
+    // frozen relations still accept tuples, and are purged as before
+    RamDomain extra[2] = {20, 20};
+    EXPECT_TRUE(frozen.insert(extra));
+    EXPECT_EQ(10001, frozen.size());
+    EXPECT_TRUE(frozen.contains(TupleRef(extra, 2)));
+    frozen.purge();
+    EXPECT_TRUE(frozen.empty());
+}
+
+TEST(ContextArenas, Views) {
+    InterpreterContextArenas arenas;
+    MinIndexSelection order{};
+    order.insertDefaultTotalIndex(2);
+    InterpreterRelation rel(2, 0, "rel", {"i", "i"}, order);
+    for (RamDomain i = 0; i < 100; ++i) {
+        RamDomain tuple[2] = {i, i};
+        rel.insert(tuple);
+    }
+    RamDomain low[2] = {MIN_RAM_SIGNED, MIN_RAM_SIGNED};
+    RamDomain high[2] = {MAX_RAM_SIGNED, MAX_RAM_SIGNED};
+    const size_t id = rel.getIndex(0).getId();
+
+    // views released by a context are reused by later contexts
+    {
+        InterpreterContext ctxt(arenas);
+        ctxt.createView(rel, 0, 0);
+        EXPECT_EQ(100, ctxt.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    }
+
+    // a context holding a view while the index is replaced drops it
+    InterpreterContext ctxt(arenas);
+    ctxt.createView(rel, 0, 0);
+    VecOwn<InterpreterIndex> replaced = rel.freeze();
+    EXPECT_EQ(1, replaced.size());
+    EXPECT_EQ(id, replaced[0]->getId());
+    EXPECT_NE(id, rel.getIndex(0).getId());
+    ctxt.dropViews({id});
+    arenas.retire({id});
+    EXPECT_EQ(nullptr, ctxt.getView(0));
+    replaced.clear();
+
+    // views are created on the replacing index
+    ctxt.createView(rel, 0, 0);
+    EXPECT_EQ(100, ctxt.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    {
+        InterpreterContext nested(arenas);
+        nested.createView(rel, 0, 0);
+        EXPECT_EQ(100, nested.getView(0)->count(TupleRef(low, 2), TupleRef(high, 2)));
+    }
+}
+
 }  // end namespace souffle::test
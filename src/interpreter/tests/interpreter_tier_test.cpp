@@ -0,0 +1,254 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file interpreter_tier_test.cpp
+ *
+ * Tests queries the interpreter compiled to native code while running
+ * against the interpreted queries.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "AggregateOp.h"
+#include "FunctorOps.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/InterpreterEngine.h"
+#include "interpreter/InterpreterTier.h"
+#include "ram/Aggregate.h"
+#include "ram/Break.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/IntrinsicOperator.h"
+#include "ram/Negation.h"
+#include "ram/NestedIntrinsicOperator.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/ParallelScan.h"
+#include "ram/Program.h"
+#include "ram/Project.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/SubroutineReturn.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::test {
+
+using namespace souffle::ram;
+
+Own<Expression> binary(FunctorOp op, Own<Expression> lhs, Own<Expression> rhs) {
+    VecOwn<Expression> args;
+    args.push_back(std::move(lhs));
+    args.push_back(std::move(rhs));
+    return mk<IntrinsicOperator>(op, std::move(args));
+}
+
+Own<Expression> element(size_t tuple, size_t elem) {
+    return mk<TupleElement>(tuple, elem);
+}
+
+Own<Expression> constant(RamDomain value) {
+    return mk<SignedConstant>(value);
+}
+
+template <typename... Exprs>
+VecOwn<Expression> values(Own<Exprs>... exprs) {
+    VecOwn<Expression> res;
+    (res.push_back(std::move(exprs)), ...);
+    return res;
+}
+
+Own<Relation> relation(const std::string& name, size_t arity) {
+    std::vector<std::string> attributeNames;
+    for (size_t i = 0; i < arity; ++i) {
+        attributeNames.push_back("x" + std::to_string(i));
+    }
+    return mk<Relation>(name, arity, 0, attributeNames, std::vector<std::string>(arity, "i"),
+            RelationRepresentation::BTREE);
+}
+
+Own<RelationReference> ref(const Relation* rel) {
+    return mk<RelationReference>(rel);
+}
+
+/** A pattern binding the leading attribute of a binary relation to the given value */
+RamPattern prefix(Own<Expression> value) {
+    RamPattern pattern;
+    pattern.first = values(clone(value), mk<UndefValue>());
+    pattern.second = values(std::move(value), mk<UndefValue>());
+    return pattern;
+}
+
+/**
+ * Build a subroutine over A, B and C returning the contents of C. Its queries are
+ * compiled, except for the ones filling A and B, the aggregate and the one
+ * returning C, which remain interpreted.
+ */
+Own<Program> makeProgram() {
+    VecOwn<Relation> rels;
+    rels.push_back(relation("A", 2));
+    rels.push_back(relation("B", 1));
+    rels.push_back(relation("C", 3));
+    const Relation* A = rels[0].get();
+    const Relation* B = rels[1].get();
+    const Relation* C = rels[2].get();
+
+    VecOwn<Statement> stmts;
+    // A(i % 20, (i * 37) % 101 - 50) :- i = range(0, 2000).
+    stmts.push_back(mk<Query>(mk<NestedIntrinsicOperator>(NestedIntrinsicOp::RANGE,
+            values(constant(0), constant(2000)),
+            mk<Project>(ref(A), values(binary(FunctorOp::MOD, element(0, 0), constant(20)),
+                                        binary(FunctorOp::SUB,
+                                                binary(FunctorOp::MOD,
+                                                        binary(FunctorOp::MUL, element(0, 0), constant(37)),
+                                                        constant(101)),
+                                                constant(50)))),
+            0)));
+    // B(3 * i - 50) :- i = range(0, 35).
+    stmts.push_back(mk<Query>(mk<NestedIntrinsicOperator>(NestedIntrinsicOp::RANGE,
+            values(constant(0), constant(35)),
+            mk<Project>(ref(B), values(binary(FunctorOp::SUB,
+                                                binary(FunctorOp::MUL, constant(3), element(0, 0)),
+                                                constant(50)))),
+            0)));
+
+    // C(0, x, 2 * w - y) :- A(x, y), A(y, w), x + w < 40, !B(y).
+    RamPattern pattern;
+    pattern.first = values(element(0, 1), mk<UndefValue>());
+    pattern.second = values(element(0, 1), mk<UndefValue>());
+    auto cond = mk<Conjunction>(mk<Constraint>(BinaryConstraintOp::LT,
+                                        binary(FunctorOp::ADD, element(0, 0), element(1, 1)), constant(40)),
+            mk<Negation>(mk<ExistenceCheck>(ref(B), values(element(1, 0)))));
+    auto project = mk<Project>(ref(C),
+            values(constant(0), element(0, 0),
+                    binary(FunctorOp::SUB, binary(FunctorOp::MUL, constant(2), element(1, 1)),
+                            element(0, 1))));
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<IndexScan>(ref(A), 1, std::move(pattern), mk<Filter>(std::move(cond), std::move(project))))));
+
+    // C(1, x, z) :- A(x, y), A(y + 20, z), x < z, B(_).
+    stmts.push_back(mk<Query>(mk<ParallelScan>(ref(A), 0,
+            mk<IndexScan>(ref(A), 1, prefix(binary(FunctorOp::ADD, element(0, 1), constant(20))),
+                    mk<Filter>(mk<Conjunction>(mk<Constraint>(BinaryConstraintOp::LT, element(0, 0),
+                                                       element(1, 1)),
+                                       mk<Negation>(mk<EmptinessCheck>(ref(B)))),
+                            mk<Project>(ref(C), values(constant(1), element(0, 0), element(1, 1))))))));
+
+    // C(2, 7, y) :- A(7, y), !A(y, _), y >= 0 (unsigned).
+    stmts.push_back(mk<Query>(mk<ParallelIndexScan>(ref(A), 0, prefix(constant(7)),
+            mk<Filter>(mk<Conjunction>(mk<Negation>(mk<ExistenceCheck>(
+                                               ref(A), values(element(0, 1), mk<UndefValue>()))),
+                               mk<Constraint>(BinaryConstraintOp::UGE, element(0, 1), constant(0))),
+                    mk<Project>(ref(C), values(constant(2), element(0, 0), element(0, 1)))))));
+
+    // C(3, 0, n) :- n = count : { A(x, y), x < y }.
+    stmts.push_back(mk<Query>(mk<Aggregate>(
+            mk<Project>(ref(C), values(constant(3), constant(0), element(0, 0))), AggregateOp::COUNT, ref(A),
+            mk<UndefValue>(), mk<Constraint>(BinaryConstraintOp::LT, element(0, 0), element(0, 1)), 0)));
+
+    // C(4, x, y) :- A(x, y), y >= 10, until x > 12.
+    stmts.push_back(mk<Query>(mk<Scan>(ref(A), 0,
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::GE, element(0, 1), constant(10)),
+                    mk<Break>(mk<Constraint>(BinaryConstraintOp::GT, element(0, 0), constant(12)),
+                            mk<Project>(ref(C), values(constant(4), element(0, 0), element(0, 1))))))));
+
+    // return C(k, x, y)
+    stmts.push_back(mk<Query>(mk<Scan>(
+            ref(C), 0, mk<SubroutineReturn>(values(element(0, 0), element(0, 1), element(0, 2))))));
+
+    std::map<std::string, Own<Statement>> subs;
+    subs.insert(std::make_pair("test", mk<Sequence>(std::move(stmts))));
+    return mk<Program>(std::move(rels), mk<Sequence>(), std::move(subs));
+}
+
+/**
+ * Run the subroutine interpreted, then, if tiered, again once its queries are
+ * compiled. Return the values returned by each run and the number of queries
+ * running native code.
+ */
+std::pair<std::vector<std::vector<RamDomain>>, size_t> execute(bool tiered, const std::string& jobs) {
+    Global::config().set("jobs", jobs);
+    if (tiered) {
+        Global::config().set("tiered", "0");
+        Global::config().set("tiered-compiler", SOUFFLE_COMPILE);
+    }
+
+    SymbolTable symTab;
+    ErrorReport errReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), symTab, errReport, debugReport);
+    Own<InterpreterEngine> interpreter = mk<InterpreterEngine>(translationUnit);
+
+    std::vector<std::vector<RamDomain>> results(1);
+    interpreter->executeSubroutine("test", {}, results.back());
+    size_t native = interpreter->waitForNativeQueries();
+    if (tiered) {
+        results.emplace_back();
+        interpreter->executeSubroutine("test", {}, results.back());
+    }
+
+    Global::config().unset("tiered");
+    Global::config().unset("tiered-compiler");
+    Global::config().set("jobs", "1");
+    return {results, native};
+}
+
+TEST(InterpreterTier, GenerateCode) {
+    Own<Program> prog = makeProgram();
+    const auto& sub = dynamic_cast<const Sequence&>(*prog->getSubroutines().at("test"));
+    std::vector<size_t> accessCounts;
+    for (const auto* stmt : sub.getStatements()) {
+        std::string code;
+        std::vector<const Node*> accesses;
+        bool compiled = generateNativeQuery(dynamic_cast<const Query*>(stmt)->getOperation(), code, accesses);
+        EXPECT_EQ(compiled, !code.empty());
+        accessCounts.push_back(compiled ? accesses.size() : 0);
+    }
+    // fills, join, parallel scan, parallel index scan, aggregate, break, and the returning scan
+    EXPECT_EQ((std::vector<size_t>{0, 0, 4, 4, 3, 0, 2, 0}), accessCounts);
+}
+
+TEST(InterpreterTier, Results) {
+    const auto interpreted = execute(false, "1");
+    EXPECT_EQ(1, interpreted.first.size());
+    EXPECT_EQ(0, interpreted.second);
+    for (const std::string jobs : {"1", "4"}) {
+        const auto tiered = execute(true, jobs);
+        // the join, parallel scan, parallel index scan and break are switched to native code
+        EXPECT_EQ(4, tiered.second);
+        EXPECT_EQ(2, tiered.first.size());
+        for (const auto& result : tiered.first) {
+            EXPECT_EQ(interpreted.first[0], result);
+        }
+    }
+}
+
+}  // namespace souffle::test
@@ -68,6 +68,7 @@
 #include "ram/transform/ChoiceConversion.h"
 #include "ram/transform/CollapseFilters.h"
 #include "ram/transform/Conditional.h"
+#include "ram/transform/CountConversion.h"
 #include "ram/transform/EliminateDuplicates.h"
 #include "ram/transform/ExpandFilter.h"
 #include "ram/transform/HoistAggregate.h"
@@ -76,12 +77,14 @@
 #include "ram/transform/IndexedInequality.h"
 #include "ram/transform/Loop.h"
 #include "ram/transform/MakeIndex.h"
+#include "ram/transform/MinMaxConversion.h"
 #include "ram/transform/Parallel.h"
 #include "ram/transform/ReorderConditions.h"
 #include "ram/transform/ReorderFilterBreak.h"
 #include "ram/transform/ReportIndex.h"
 #include "ram/transform/Sequence.h"
 #include "ram/transform/Transformer.h"
+#include "ram/transform/TrieJoin.h"
 #include "ram/transform/TupleId.h"
 #include "reports/DebugReport.h"
 #include "reports/ErrorReport.h"
@@ -95,6 +98,7 @@
 #include "souffle/utility/StringUtil.h"
 #include "synthesiser/Synthesiser.h"
 #include <cassert>
+#include <cctype>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
@@ -254,7 +258,36 @@ int main(int argc, char** argv) {
                         "", false, "Print selected program information."},
                 {"parse-errors", '\5', "", "", false, "Show parsing errors, if any, then exit."},
                 {"help", 'h', "", "", false, "Display this help message."},
-                {"legacy", '\6', "", "", false, "Enable legacy support."}};
+                {"legacy", '\6', "", "", false, "Enable legacy support."},
+                {"bytecode", '\7', "", "", false,
+                        "Run the interpreter on queries lowered into bytecode instead of on the node "
+                        "tree."},
+                {"hot-queries", '\10', "N", "", false,
+                        "Report the N queries the interpreter spent most time in to stderr."},
+                {"hashset-auto", '\11', "", "", false,
+                        "Represent relations that are searched by equalities only by hash sets."},
+                {"buffered-inserts", '\12', "", "", false,
+                        "Collect the tuples inserted by parallel queries in thread-local buffers, merged "
+                        "into their relations once a query has finished."},
+                {"deferred-indexes", '\13', "", "", false,
+                        "Maintain only the primary index of temporary relations while they are filled, "
+                        "building their other indexes when they are first searched."},
+                {"trie-join", '\14', "", "", false,
+                        "Evaluate rules whose bodies join atoms along a cycle as trie joins, intersecting "
+                        "the values of one variable at a time."},
+                {"bloom-filters", '\15', "", "", false,
+                        "Consult Bloom filters of relations before searching them for tuples in negations "
+                        "and existence checks, sized by the profile given by --profile-use, if any."},
+                {"memory-limit", '\16', "SIZE", "", false,
+                        "Spill relations retained for later strata to files while the memory resident for "
+                        "the evaluation exceeds the given number of bytes, which may be suffixed by K, M or "
+                        "G."},
+                {"freeze-relations", '\17', "", "", false,
+                        "Convert the indexes of relations retained for later strata into sorted arrays once "
+                        "their stratum completes, in the interpreter."},
+                {"tiered", '\20', "MS", "", false,
+                        "Compile queries the interpreter spent more than MS milliseconds in to native code "
+                        "in the background, and switch to the native code once it is loaded."}};
         Global::config().processArgs(argc, argv, header.str(), footer.str(), options);
 
         // ------ command line arguments -------------
@@ -317,6 +350,43 @@ int main(int argc, char** argv) {
         }
 #endif
 
+        /* the hot-queries option takes the number of queries to report */
+        if (Global::config().has("hot-queries")) {
+            const std::string& count = Global::config().get("hot-queries");
+            if (count.empty() || !isNumber(count.c_str())) {
+                throw std::runtime_error("--hot-queries may only be set to a non-negative integer.");
+            }
+        }
+
+        /* the tiered option takes the time after which a query is compiled */
+        if (Global::config().has("tiered")) {
+            const std::string& time = Global::config().get("tiered");
+            if (time.empty() || !isNumber(time.c_str())) {
+                throw std::runtime_error("--tiered may only be set to a non-negative integer.");
+            }
+        }
+
+        /* the memory-limit option is normalised to a number of bytes */
+        if (Global::config().has("memory-limit")) {
+            std::string limit = Global::config().get("memory-limit");
+            std::size_t shift = 0;
+            auto suffix = limit.empty() ? std::string::npos
+                                        : std::string("KMG").find(static_cast<char>(
+                                                  std::toupper(static_cast<unsigned char>(limit.back()))));
+            if (suffix != std::string::npos) {
+                shift = 10 * (suffix + 1);
+                limit.pop_back();
+            }
+            bool valid = !limit.empty() && limit.size() <= 18 &&
+                         limit.find_first_not_of("0123456789") == std::string::npos;
+            unsigned long long bytes = valid ? std::stoull(limit) : 0;
+            if (bytes == 0 || (bytes << shift >> shift) != bytes) {
+                throw std::runtime_error("--memory-limit may only be set to a positive integer, "
+                                         "optionally suffixed by K, M or G.");
+            }
+            Global::config().set("memory-limit", std::to_string(bytes << shift));
+        }
+
         /* if an output directory is given, check it exists */
         if (Global::config().has("output-dir") && !Global::config().has("output-dir", "-") &&
                 !existDir(Global::config().get("output-dir")) &&
@@ -601,10 +671,13 @@ int main(int argc, char** argv) {
                 mk<ExpandFilterTransformer>(), mk<HoistConditionsTransformer>(),
                 mk<CollapseFiltersTransformer>(), mk<EliminateDuplicatesTransformer>(),
                 mk<ReorderConditionsTransformer>(), mk<LoopTransformer>(mk<ReorderFilterBreak>()),
+                mk<ConditionalTransformer>([]() -> bool { return Global::config().has("trie-join"); },
+                        mk<TransformerSequence>(mk<TrieJoinTransformer>(), mk<TupleIdTransformer>())),
                 mk<ConditionalTransformer>(
                         // job count of 0 means all cores are used.
                         []() -> bool { return std::stoi(Global::config().get("jobs")) != 1; },
                         mk<ParallelTransformer>()),
+                mk<MinMaxConversionTransformer>(), mk<CountConversionTransformer>(),
                 mk<ReportIndexTransformer>());
 
         ramTransform->apply(*ramTranslationUnit);
@@ -631,6 +704,15 @@ int main(int argc, char** argv) {
                 profiler = std::thread([]() { profile::Tui().runProf(); });
             }
 
+            // hot queries are compiled by souffle-compile
+            if (Global::config().has("tiered")) {
+                auto cmd = ::findTool("souffle-compile", souffleExecutable, ".");
+                if (!isExecutable(cmd)) {
+                    throw std::runtime_error("failed to locate souffle-compile");
+                }
+                Global::config().set("tiered-compiler", cmd);
+            }
+
             // configure and execute interpreter
             Own<InterpreterEngine> interpreter(mk<InterpreterEngine>(*ramTranslationUnit));
             interpreter->executeMain();
@@ -0,0 +1,59 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Freeze.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Relation.h"
+#include "ram/RelationStatement.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class Freeze
+ * @brief Convert a relation into a compact representation for being read only
+ *
+ * The relation retains its content, but is stored such that it is read faster
+ * and takes less memory, at the expense of modifications. Relations are frozen
+ * once they are complete, i.e. once no further tuples are added to them.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FREEZE A
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Freeze : public RelationStatement {
+public:
+    Freeze(Own<RelationReference> relRef) : RelationStatement(std::move(relRef)) {}
+
+    Freeze* clone() const override {
+        return new Freeze(souffle::clone(relationRef));
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        const Relation& rel = getRelation();
+        os << times(" ", tabpos);
+        os << "FREEZE ";
+        os << rel.getName();
+        os << std::endl;
+    }
+};
+
+}  // namespace souffle::ram
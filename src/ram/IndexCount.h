@@ -0,0 +1,78 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexCount.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "AggregateOp.h"
+#include "ram/AbstractAggregate.h"
+#include "ram/Expression.h"
+#include "ram/IndexAggregate.h"
+#include "ram/IndexOperation.h"
+#include "ram/Operation.h"
+#include "ram/Relation.h"
+#include "ram/True.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class IndexCount
+ * @brief Counts the tuples of a relation within an index range
+ *
+ * Unlike a general count aggregate, the tuples are not enumerated;
+ * the size of the range is obtained from the index directly.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * t0.0=count RANGE t0 ∈ S ON INDEX t0.0 = number(1)
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class IndexCount : public IndexAggregate {
+public:
+    IndexCount(Own<Operation> nested, Own<RelationReference> relRef, Own<Expression> expression,
+            RamPattern queryPattern, int ident)
+            : IndexAggregate(std::move(nested), AggregateOp::COUNT, std::move(relRef), std::move(expression),
+                      mk<True>(), std::move(queryPattern), ident) {}
+
+    IndexCount* clone() const override {
+        RamPattern pattern;
+        for (const auto& i : queryPattern.first) {
+            pattern.first.emplace_back(i->clone());
+        }
+        for (const auto& i : queryPattern.second) {
+            pattern.second.emplace_back(i->clone());
+        }
+        return new IndexCount(souffle::clone(&getOperation()), souffle::clone(relationRef),
+                souffle::clone(expression), std::move(pattern), getTupleId());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "t" << getTupleId() << ".0=";
+        AbstractAggregate::print(os, tabpos);
+        os << "RANGE t" << getTupleId() << " ∈ " << getRelation().getName();
+        printIndex(os);
+        os << std::endl;
+        IndexOperation::print(os, tabpos + 1);
+    }
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,194 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexIntersection.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Expression.h"
+#include "ram/IndexOperation.h"
+#include "ram/Node.h"
+#include "ram/NodeMapper.h"
+#include "ram/Operation.h"
+#include "ram/Relation.h"
+#include "ram/TupleOperation.h"
+#include "ram/Utils.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class IndexIntersection
+ * @brief Enumerate the values an attribute takes in each of several index ranges
+ *
+ * Each input of the intersection is a range of a relation, bounding attributes by
+ * equalities, and an attribute of the relation, bounded by an unbounded inequality
+ * such that the index selection places it right after the attributes bound by the
+ * equalities. The tuple of the operation has a single element, which is bound to
+ * each value the attribute takes in all ranges, in ascending order; the values are
+ * found by leapfrogging over the ranges. Ranges of indexes ordering the attribute
+ * differently are enumerated once per evaluation, collecting their values in
+ * ascending order to leapfrog over. A nest of intersections, one per variable,
+ * evaluates a conjunction of atoms as a trie join.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN a.0 ∩ c.1
+ *    FOR t1 IN a.1 ON INDEX a.0 = t0.0 ∩ b.0
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class IndexIntersection : public TupleOperation {
+public:
+    IndexIntersection(VecOwn<RelationReference> relRefs, std::vector<size_t> columns,
+            std::vector<RamPattern> queryPatterns, int ident, Own<Operation> nested,
+            std::string profileText = "")
+            : TupleOperation(ident, std::move(nested), std::move(profileText)),
+              relationRefs(std::move(relRefs)), columns(std::move(columns)),
+              queryPatterns(std::move(queryPatterns)) {
+        assert(!relationRefs.empty() && "intersection without inputs");
+        assert(relationRefs.size() == this->columns.size() &&
+                relationRefs.size() == this->queryPatterns.size() && "inputs mismatch");
+        for (size_t i = 0; i < relationRefs.size(); ++i) {
+            assert(relationRefs[i] != nullptr && "relation reference is a null-pointer");
+            assert(this->columns[i] < getRelation(i).getArity() && "column out of range");
+            assert(this->queryPatterns[i].first.size() == getRelation(i).getArity() &&
+                    this->queryPatterns[i].second.size() == getRelation(i).getArity());
+        }
+    }
+
+    /** @brief Get the number of inputs */
+    size_t getNumInputs() const {
+        return relationRefs.size();
+    }
+
+    /** @brief Get the reference to the relation of an input */
+    const RelationReference& getRelationReference(size_t input) const {
+        return *relationRefs[input];
+    }
+
+    /** @brief Get the relation of an input */
+    const Relation& getRelation(size_t input) const {
+        return *relationRefs[input]->get();
+    }
+
+    /** @brief Get the intersected attribute of an input */
+    size_t getColumn(size_t input) const {
+        return columns[input];
+    }
+
+    /** @brief Get the range pattern of an input */
+    std::pair<std::vector<Expression*>, std::vector<Expression*>> getRangePattern(size_t input) const {
+        const auto& pattern = queryPatterns[input];
+        return std::make_pair(toPtrVector(pattern.first), toPtrVector(pattern.second));
+    }
+
+    std::vector<const Node*> getChildNodes() const override {
+        auto res = TupleOperation::getChildNodes();
+        for (size_t i = 0; i < relationRefs.size(); ++i) {
+            res.push_back(relationRefs[i].get());
+            for (const auto& pattern : queryPatterns[i].first) {
+                res.push_back(pattern.get());
+            }
+            for (const auto& pattern : queryPatterns[i].second) {
+                res.push_back(pattern.get());
+            }
+        }
+        return res;
+    }
+
+    void apply(const NodeMapper& map) override {
+        TupleOperation::apply(map);
+        for (size_t i = 0; i < relationRefs.size(); ++i) {
+            relationRefs[i] = map(std::move(relationRefs[i]));
+            for (auto& pattern : queryPatterns[i].first) {
+                pattern = map(std::move(pattern));
+            }
+            for (auto& pattern : queryPatterns[i].second) {
+                pattern = map(std::move(pattern));
+            }
+        }
+    }
+
+    IndexIntersection* clone() const override {
+        std::vector<RamPattern> resQueryPatterns;
+        for (const auto& pattern : queryPatterns) {
+            resQueryPatterns.emplace_back(souffle::clone(pattern.first), souffle::clone(pattern.second));
+        }
+        return new IndexIntersection(souffle::clone(relationRefs), columns, std::move(resQueryPatterns),
+                getTupleId(), souffle::clone(&getOperation()), getProfileText());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "FOR t" << getTupleId() << " IN ";
+        for (size_t i = 0; i < relationRefs.size(); ++i) {
+            const Relation& rel = getRelation(i);
+            if (i > 0) {
+                os << " ∩ ";
+            }
+            os << rel.getName() << "." << columns[i];
+
+            // print the equalities bounding the range
+            bool first = true;
+            for (size_t j = 0; j < rel.getArity(); ++j) {
+                const auto& lower = queryPatterns[i].first[j];
+                if (j == columns[i] || isUndefValue(lower.get())) {
+                    continue;
+                }
+                os << (first ? " ON INDEX " : " AND ");
+                os << rel.getName() << "." << j << " = " << *lower;
+                first = false;
+            }
+        }
+        os << std::endl;
+        TupleOperation::print(os, tabpos + 1);
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = static_cast<const IndexIntersection&>(node);
+        if (!TupleOperation::equal(other) || !equal_targets(relationRefs, other.relationRefs) ||
+                columns != other.columns || queryPatterns.size() != other.queryPatterns.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < queryPatterns.size(); ++i) {
+            if (!equal_targets(queryPatterns[i].first, other.queryPatterns[i].first) ||
+                    !equal_targets(queryPatterns[i].second, other.queryPatterns[i].second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Relations of the inputs */
+    VecOwn<RelationReference> relationRefs;
+
+    /** Intersected attribute of each input */
+    std::vector<size_t> columns;
+
+    /** Values of index per column of the relation of each input */
+    std::vector<RamPattern> queryPatterns;
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,93 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexMinMax.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "AggregateOp.h"
+#include "ram/AbstractAggregate.h"
+#include "ram/IndexAggregate.h"
+#include "ram/IndexOperation.h"
+#include "ram/Operation.h"
+#include "ram/Relation.h"
+#include "ram/True.h"
+#include "ram/TupleElement.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class IndexMinMax
+ * @brief Minimum or maximum of an attribute over an index range, ordered by the attribute
+ *
+ * The attribute follows the attributes bound by the range in the order of the
+ * index, such that the minimum is an attribute of the first tuple of the range
+ * and the maximum an attribute of the last tuple.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * t0.0=min t0.1 FIRST t0 ∈ S ON INDEX t0.0 = number(1)
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class IndexMinMax : public IndexAggregate {
+public:
+    IndexMinMax(Own<Operation> nested, AggregateOp fun, Own<RelationReference> relRef, size_t column,
+            RamPattern queryPattern, int ident)
+            : IndexAggregate(std::move(nested), fun, std::move(relRef), mk<TupleElement>(ident, column),
+                      mk<True>(), std::move(queryPattern), ident) {
+        assert((fun == AggregateOp::MIN || fun == AggregateOp::MAX) && "not a signed minimum or maximum");
+    }
+
+    /** @brief Get the aggregated attribute */
+    size_t getColumn() const {
+        return static_cast<const TupleElement&>(getExpression()).getElement();
+    }
+
+    /** @brief Determine whether the last tuple of the range is looked up */
+    bool isLast() const {
+        return function == AggregateOp::MAX;
+    }
+
+    IndexMinMax* clone() const override {
+        RamPattern pattern;
+        for (const auto& i : queryPattern.first) {
+            pattern.first.emplace_back(i->clone());
+        }
+        for (const auto& i : queryPattern.second) {
+            pattern.second.emplace_back(i->clone());
+        }
+        return new IndexMinMax(souffle::clone(&getOperation()), function, souffle::clone(relationRef),
+                getColumn(), std::move(pattern), getTupleId());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "t" << getTupleId() << ".0=";
+        AbstractAggregate::print(os, tabpos);
+        os << (isLast() ? "LAST" : "FIRST") << " t" << getTupleId() << " ∈ " << getRelation().getName();
+        printIndex(os);
+        os << std::endl;
+        IndexOperation::print(os, tabpos + 1);
+    }
+};
+
+}  // namespace souffle::ram
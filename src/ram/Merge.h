@@ -0,0 +1,72 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Merge.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/BinRelationStatement.h"
+#include "ram/Relation.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class Merge
+ * @brief Insert all tuples of a relation into another relation of the same arity.
+ *
+ * Unlike a scan of the source projecting into the target, a merge lets the
+ * backends combine the underlying data structures in bulk.
+ *
+ * The following example merges A into B:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * MERGE A INTO B
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Merge : public BinRelationStatement {
+public:
+    Merge(Own<RelationReference> tRef, Own<RelationReference> sRef)
+            : BinRelationStatement(std::move(sRef), std::move(tRef)) {
+        assert(getSourceRelation().getArity() == getTargetRelation().getArity() &&
+                "mismatching arities of merged relations");
+    }
+
+    /** @brief Get source relation */
+    const Relation& getSourceRelation() const {
+        return getFirstRelation();
+    }
+
+    /** @brief Get target relation */
+    const Relation& getTargetRelation() const {
+        return getSecondRelation();
+    }
+
+    Merge* clone() const override {
+        auto* res = new Merge(souffle::clone(second), souffle::clone(first));
+        return res;
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "MERGE " << getSourceRelation().getName() << " INTO " << getTargetRelation().getName();
+        os << std::endl;
+    }
+};
+
+}  // namespace souffle::ram
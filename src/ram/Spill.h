@@ -0,0 +1,103 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Spill.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Node.h"
+#include "ram/NodeMapper.h"
+#include "ram/Relation.h"
+#include "ram/Statement.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class Spill
+ * @brief Spill relations to files while the memory limit is exceeded
+ *
+ * The relations are spilled one after the other, in the given order, until the
+ * memory resident for the evaluation is within the limit given by the option
+ * memory-limit. Spilled relations retain their content, which is moved to files
+ * and read back as it is accessed; they must not be modified concurrently with
+ * the statement.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * SPILL A, B
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Spill : public Statement {
+public:
+    Spill(VecOwn<RelationReference> relRefs) : relationRefs(std::move(relRefs)) {
+        assert(!relationRefs.empty() && "spill without relations");
+        for (const auto& relRef : relationRefs) {
+            assert(relRef != nullptr && "relation reference is a null-pointer");
+        }
+    }
+
+    /** @brief Get the relations, in the order they are spilled */
+    std::vector<const Relation*> getRelations() const {
+        std::vector<const Relation*> res;
+        for (const auto& relRef : relationRefs) {
+            res.push_back(relRef->get());
+        }
+        return res;
+    }
+
+    std::vector<const Node*> getChildNodes() const override {
+        std::vector<const Node*> res;
+        for (const auto& relRef : relationRefs) {
+            res.push_back(relRef.get());
+        }
+        return res;
+    }
+
+    void apply(const NodeMapper& map) override {
+        for (auto& relRef : relationRefs) {
+            relRef = map(std::move(relRef));
+        }
+    }
+
+    Spill* clone() const override {
+        return new Spill(souffle::clone(relationRefs));
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "SPILL ";
+        for (std::size_t i = 0; i < relationRefs.size(); ++i) {
+            os << (i > 0 ? ", " : "") << relationRefs[i]->get()->getName();
+        }
+        os << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = static_cast<const Spill&>(node);
+        return equal_targets(relationRefs, other.relationRefs);
+    }
+
+    /** Relations, in the order they are spilled */
+    VecOwn<RelationReference> relationRefs;
+};
+
+}  // namespace souffle::ram
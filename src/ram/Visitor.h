@@ -39,10 +39,14 @@
 #include "ram/Extend.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/FloatConstant.h"
 #include "ram/IO.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexMinMax.h"
 #include "ram/IndexOperation.h"
 #include "ram/IndexScan.h"
 #include "ram/IntrinsicOperator.h"
@@ -51,6 +55,7 @@
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
@@ -75,6 +80,7 @@
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -186,16 +192,22 @@ struct Visitor : public ram_visitor_tag {
         FORWARD(ParallelAggregate);
         FORWARD(Aggregate);
         FORWARD(ParallelIndexAggregate);
+        FORWARD(IndexCount);
+        FORWARD(IndexMinMax);
         FORWARD(IndexAggregate);
+        FORWARD(IndexIntersection);
 
         // Statements
         FORWARD(IO);
         FORWARD(Query);
         FORWARD(Clear);
         FORWARD(LogSize);
+        FORWARD(Spill);
+        FORWARD(Freeze);
 
         FORWARD(Swap);
         FORWARD(Extend);
+        FORWARD(Merge);
 
         // Control-flow
         FORWARD(Program);
@@ -229,11 +241,14 @@ protected:
     LINK(Query, Statement);
     LINK(Clear, RelationStatement);
     LINK(LogSize, RelationStatement);
+    LINK(Spill, Statement);
+    LINK(Freeze, RelationStatement);
 
     LINK(RelationStatement, Statement);
 
     LINK(Swap, BinRelationStatement);
     LINK(Extend, BinRelationStatement);
+    LINK(Merge, BinRelationStatement);
     LINK(BinRelationStatement, Statement);
 
     LINK(Sequence, ListStatement);
@@ -266,7 +281,10 @@ protected:
     LINK(ParallelAggregate, Aggregate);
     LINK(IndexAggregate, IndexOperation);
     LINK(ParallelIndexAggregate, IndexAggregate);
+    LINK(IndexCount, IndexAggregate);
+    LINK(IndexMinMax, IndexAggregate);
     LINK(IndexOperation, RelationOperation);
+    LINK(IndexIntersection, TupleOperation);
     LINK(TupleOperation, NestedOperation);
     LINK(Filter, AbstractConditional);
     LINK(Break, AbstractConditional);
@@ -0,0 +1,101 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BloomFilter.cpp
+ *
+ * Implementation of RAM Bloom Filter Analysis
+ *
+ ***********************************************************************/
+
+#include "ram/analysis/BloomFilter.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Expression.h"
+#include "ram/Program.h"
+#include "ram/Swap.h"
+#include "ram/Utils.h"
+#include "ram/Visitor.h"
+#include "ram/analysis/Index.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Relation.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::ram::analysis {
+
+void BloomFilterAnalysis::run(const TranslationUnit& translationUnit) {
+    if (!Global::config().has("bloom-filters")) {
+        return;
+    }
+    auto* indexAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+
+    // select the relations subject to existence checks which bind their tuples
+    visitDepthFirst(translationUnit.getProgram(), [&](const AbstractExistenceCheck& check) {
+        const Relation& rel = check.getRelation();
+        RelationRepresentation representation = indexAnalysis->getRepresentation(rel);
+        if ((representation == RelationRepresentation::BTREE ||
+                    representation == RelationRepresentation::DEFAULT) &&
+                rel.getArity() > rel.getAuxiliaryArity() && bindsKey(check)) {
+            capacities[&rel] = 0;
+        }
+    });
+
+    // relations exchanging their content by swaps either both maintain filters or neither
+    visitDepthFirst(translationUnit.getProgram(), [&](const Swap& swap) {
+        const Relation& relA = swap.getFirstRelation();
+        const Relation& relB = swap.getSecondRelation();
+        if (hasFilter(relA) || hasFilter(relB)) {
+            capacities[&relA] = 0;
+            capacities[&relB] = 0;
+        }
+    });
+
+    // size the filters by the relation sizes of a previous run
+    if (!capacities.empty() && Global::config().has("profile-use")) {
+        auto programRun = std::make_shared<profile::ProgramRun>();
+        profile::Reader(Global::config().get("profile-use"), programRun).processFile();
+        for (auto& cur : capacities) {
+            if (const auto* profRel = programRun->getRelation(cur.first->getName())) {
+                cur.second = profRel->size();
+            }
+        }
+    }
+}
+
+std::size_t BloomFilterAnalysis::getCapacity(const Relation& rel) const {
+    auto pos = capacities.find(&rel);
+    return pos == capacities.end() ? 0 : pos->second;
+}
+
+bool BloomFilterAnalysis::isFiltered(const AbstractExistenceCheck& check) const {
+    return hasFilter(check.getRelation()) && bindsKey(check);
+}
+
+bool BloomFilterAnalysis::bindsKey(const AbstractExistenceCheck& check) {
+    const Relation& rel = check.getRelation();
+    auto values = check.getValues();
+    for (std::size_t i = 0; i < rel.getArity() - rel.getAuxiliaryArity(); ++i) {
+        if (isUndefValue(values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BloomFilterAnalysis::print(std::ostream& os) const {
+    for (const auto& cur : capacities) {
+        os << "Relation " << cur.first->getName() << "\n";
+        os << "\tFilter capacity: " << cur.second << "\n";
+    }
+}
+
+}  // namespace souffle::ram::analysis
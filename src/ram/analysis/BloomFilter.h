@@ -0,0 +1,73 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BloomFilter.h
+ *
+ * Determines the relations whose existence checks consult Bloom filters.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/Relation.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Analysis.h"
+#include <cstddef>
+#include <map>
+#include <ostream>
+
+namespace souffle::ram::analysis {
+
+/**
+ * @class BloomFilterAnalysis
+ * @brief A Ram Analysis selecting the relations maintaining Bloom filters
+ *
+ * A Bloom filter of a relation holds the tuples of the relation, identified by
+ * their attributes excluding the auxiliary ones. Existence checks binding all of
+ * these attributes consult the filter before searching the relation, which spares
+ * the search of the relation's index for most tuples not in the relation, as is
+ * typical for negations.
+ *
+ * Filters are maintained only if requested by the bloom-filters option, and only
+ * for relations represented by b-trees which are subject to such existence checks.
+ * The initial size of a filter is taken from the relation size recorded by the
+ * profile given by the profile-use option, if any; a filter grows with its relation.
+ */
+class BloomFilterAnalysis : public Analysis {
+public:
+    BloomFilterAnalysis(const char* id) : Analysis(id) {}
+
+    static constexpr const char* name = "bloom-filter-analysis";
+
+    void run(const TranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** @brief Whether a relation maintains a Bloom filter */
+    bool hasFilter(const Relation& rel) const {
+        return capacities.find(&rel) != capacities.end();
+    }
+
+    /** @brief Get the number of tuples the filter of a relation is sized for initially, if known */
+    std::size_t getCapacity(const Relation& rel) const;
+
+    /** @brief Whether an existence check consults the Bloom filter of its relation */
+    bool isFiltered(const AbstractExistenceCheck& check) const;
+
+private:
+    /** Whether an existence check binds all attributes identifying the tuples of its relation */
+    static bool bindsKey(const AbstractExistenceCheck& check);
+
+    /** Initial filter size per relation maintaining a filter; zero if unknown */
+    std::map<const Relation*, std::size_t> capacities;
+};
+
+}  // namespace souffle::ram::analysis
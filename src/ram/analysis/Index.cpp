@@ -18,6 +18,7 @@
 #include "Global.h"
 #include "RelationTag.h"
 #include "ram/Expression.h"
+#include "ram/IndexCount.h"
 #include "ram/Node.h"
 #include "ram/Program.h"
 #include "ram/Relation.h"
@@ -482,7 +483,10 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
 
     // visit all nodes to collect searches of each relation
     visitDepthFirst(translationUnit.getProgram(), [&](const Node& node) {
-        if (const auto* indexSearch = dynamic_cast<const IndexOperation*>(&node)) {
+        if (const auto* count = dynamic_cast<const IndexCount*>(&node)) {
+            MinIndexSelection& indexes = getIndexes(count->getRelation());
+            indexes.addCountedSearch(getSearchSignature(count));
+        } else if (const auto* indexSearch = dynamic_cast<const IndexOperation*>(&node)) {
             MinIndexSelection& indexes = getIndexes(indexSearch->getRelation());
             indexes.addSearch(getSearchSignature(indexSearch));
         } else if (const auto* exists = dynamic_cast<const ExistenceCheck*>(&node)) {
@@ -494,6 +498,11 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
         } else if (const auto* ramRel = dynamic_cast<const Relation*>(&node)) {
             MinIndexSelection& indexes = getIndexes(*ramRel);
             indexes.addSearch(getSearchSignature(ramRel));
+        } else if (const auto* intersection = dynamic_cast<const IndexIntersection*>(&node)) {
+            for (size_t i = 0; i < intersection->getNumInputs(); ++i) {
+                MinIndexSelection& indexes = getIndexes(intersection->getRelation(i));
+                indexes.addSearch(getSearchSignature(intersection, i));
+            }
         }
     });
 
@@ -514,11 +523,17 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
         for (const auto& signature : indexesA.getSearches()) {
             indexesB.addSearch(signature);
         }
+        for (const auto& signature : indexesA.getCountedSearches()) {
+            indexesB.addCountedSearch(signature);
+        }
 
         // Add all searchSignature of B into A
         for (const auto& signature : indexesB.getSearches()) {
             indexesA.addSearch(signature);
         }
+        for (const auto& signature : indexesB.getCountedSearches()) {
+            indexesA.addCountedSearch(signature);
+        }
     });
 
     // find optimal indexes for relations
@@ -547,6 +562,19 @@ MinIndexSelection& IndexAnalysis::getIndexes(const Relation& rel) {
     }
 }
 
+RelationRepresentation IndexAnalysis::getRepresentation(const Relation& rel) const {
+    RelationRepresentation representation = rel.getRepresentation();
+    if (representation != RelationRepresentation::DEFAULT || !Global::config().has("hashset-auto") ||
+            Global::config().has("provenance") || rel.getArity() == 0) {
+        return representation;
+    }
+    auto pos = minIndexCover.find(&rel);
+    if (pos != minIndexCover.end() && pos->second.hasOnlyEqualitySearches()) {
+        return RelationRepresentation::HASHSET;
+    }
+    return representation;
+}
+
 void IndexAnalysis::print(std::ostream& os) const {
     for (auto& cur : minIndexCover) {
         const Relation& rel = *cur.first;
@@ -598,13 +626,10 @@ template <typename Seq>
 SearchSignature searchSignature(size_t arity, Seq const& xs) {
     return searchSignature(arity, xs.begin(), xs.end());
 }
-}  // namespace
 
-SearchSignature IndexAnalysis::getSearchSignature(const IndexOperation* search) const {
-    size_t arity = search->getRelation().getArity();
-
-    auto lower = search->getRangePattern().first;
-    auto upper = search->getRangePattern().second;
+// handles equality and inequality constraints of a range pattern
+SearchSignature rangeSignature(
+        size_t arity, const std::vector<Expression*>& lower, const std::vector<Expression*>& upper) {
     SearchSignature keys(arity);
     for (size_t i = 0; i < arity; ++i) {
         // if both bounds are undefined
@@ -619,6 +644,17 @@ SearchSignature IndexAnalysis::getSearchSignature(const IndexOperation* search)
     }
     return keys;
 }
+}  // namespace
+
+SearchSignature IndexAnalysis::getSearchSignature(const IndexOperation* search) const {
+    auto pattern = search->getRangePattern();
+    return rangeSignature(search->getRelation().getArity(), pattern.first, pattern.second);
+}
+
+SearchSignature IndexAnalysis::getSearchSignature(const IndexIntersection* intersection, size_t input) const {
+    auto pattern = intersection->getRangePattern(input);
+    return rangeSignature(intersection->getRelation(input).getArity(), pattern.first, pattern.second);
+}
 
 SearchSignature IndexAnalysis::getSearchSignature(const ProvenanceExistenceCheck* provExistCheck) const {
     const auto values = provExistCheck->getValues();
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include "RelationTag.h"
 #include "ram/AbstractExistenceCheck.h"
 #include "ram/ExistenceCheck.h"
+#include "ram/IndexIntersection.h"
 #include "ram/IndexOperation.h"
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Relation.h"
@@ -28,6 +30,7 @@
 #include <cassert>
 #include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <map>
 #include <memory>
@@ -239,6 +242,14 @@ public:
         }
     }
 
+    /** @Brief Add a search whose ranges are counted, such that its index caches the sizes of sub-trees */
+    inline void addCountedSearch(SearchSignature cols) {
+        addSearch(cols);
+        if (!cols.empty()) {
+            countedSearches.insert(cols);
+        }
+    }
+
     MinIndexSelection() = default;
     ~MinIndexSelection() = default;
 
@@ -247,6 +258,21 @@ public:
         return searches;
     }
 
+    /** @Brief Get searches whose ranges are counted **/
+    const SearchSet& getCountedSearches() const {
+        return countedSearches;
+    }
+
+    /** @Brief Check whether the ranges of some search covered by an index are counted */
+    bool isCounted(size_t indexNum) const {
+        for (const auto& search : countedSearches) {
+            if (static_cast<size_t>(map(search)) == indexNum) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     /** @Brief Get index for a search */
     const LexOrder& getLexOrder(SearchSignature cols) const {
         int idx = map(cols);
@@ -268,6 +294,32 @@ public:
         return chainToOrder;
     }
 
+    /**
+     * @Brief Get the number of leading attributes of an index bound by all searches it covers;
+     * hash-based indexes are keyed on them
+     */
+    size_t getKeySize(size_t indexNum) const {
+        auto chain = chainToOrder.begin();
+        std::advance(chain, indexNum);
+        size_t res = orders[indexNum].size();
+        for (const auto& search : *chain) {
+            res = std::min(res, card(search));
+        }
+        return res;
+    }
+
+    /** @Brief Check whether all searches bind attributes by equalities only */
+    bool hasOnlyEqualitySearches() const {
+        for (const auto& search : searches) {
+            for (size_t i = 0; i < search.arity(); ++i) {
+                if (search[i] == AttributeConstraint::Inequal) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     /**
      * Check whether number of constraints in k is not equal to number of columns in lexicographical
      * order
@@ -304,6 +356,7 @@ protected:
     DischargeMap dischargedMap;           // mapping of a SearchSignature to the attributes to discharge
     IndexSignatureMap indexToSignature;   // mapping of a unique index to its SearchSignature
     SearchSet searches;                   // set of search patterns on table
+    SearchSet countedSearches;            // set of search patterns whose ranges are counted
     OrderCollection orders;               // collection of lexicographical orders
     ChainOrderMap chainToOrder;           // maps order index to set of searches covered by chain
     MaxMatching matching;                 // matching problem for finding minimal number of orders
@@ -408,6 +461,14 @@ public:
      */
     MinIndexSelection& getIndexes(const std::string& relName);
 
+    /**
+     * @Brief Get the representation of a relation; if requested, relations of the default
+     * representation that are searched by equalities only are represented by hash sets
+     * @param relation
+     * @result representation of the relation
+     */
+    RelationRepresentation getRepresentation(const Relation& rel) const;
+
     /**
      * @Brief Get index signature for an Ram IndexOperation operation
      * @param  Index-relation-search operation
@@ -415,6 +476,14 @@ public:
      */
     SearchSignature getSearchSignature(const IndexOperation* search) const;
 
+    /**
+     * @Brief Get the index signature for an input of an index intersection
+     * @param Index intersection
+     * @param Position of the input
+     * @result Index signature of the input
+     */
+    SearchSignature getSearchSignature(const IndexIntersection* intersection, size_t input) const;
+
     /**
      * @Brief Get the index signature for an existence check
      * @param Existence check
@@ -30,6 +30,7 @@
 #include "ram/Filter.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexIntersection.h"
 #include "ram/IndexScan.h"
 #include "ram/IntrinsicOperator.h"
 #include "ram/Negation.h"
@@ -131,6 +132,20 @@ int LevelAnalysis::getLevel(const Node* node) const {
             return std::max(level, visit(indexAggregate.getCondition()));
         }
 
+        // index intersection
+        int visitIndexIntersection(const IndexIntersection& intersection) override {
+            int level = -1;
+            for (size_t i = 0; i < intersection.getNumInputs(); ++i) {
+                for (auto& index : intersection.getRangePattern(i).first) {
+                    level = std::max(level, visit(index));
+                }
+                for (auto& index : intersection.getRangePattern(i).second) {
+                    level = std::max(level, visit(index));
+                }
+            }
+            return level;
+        }
+
         // unpack record
         int visitUnpackRecord(const UnpackRecord& unpack) override {
             return visit(unpack.getExpression());
@@ -30,6 +30,9 @@
 #include "ram/Filter.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexMinMax.h"
 #include "ram/IndexScan.h"
 #include "ram/Negation.h"
 #include "ram/Operation.h"
@@ -48,6 +51,7 @@
 #include "ram/UndefValue.h"
 #include "ram/UnpackRecord.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
 #include <memory>
 #include <string>
 #include <utility>
@@ -404,6 +408,117 @@ TEST(RamIndexAggregate, CloneAndEquals) {
     delete c;
 }
 
+TEST(RamIndexCount, CloneAndEquals) {
+    Relation edge("edge", 2, 1, {"src", "dest"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    // t0.0 = COUNT RANGE t0 IN edge ON INDEX t0.0 = number(1) AND t0.1 = ⊥
+    //  RETURN t0.0
+    VecOwn<Expression> a_return_args;
+    a_return_args.emplace_back(new TupleElement(0, 0));
+    auto a_return = mk<SubroutineReturn>(std::move(a_return_args));
+    RamPattern a_criteria;
+    a_criteria.first.emplace_back(new SignedConstant(1));
+    a_criteria.first.emplace_back(new UndefValue);
+    a_criteria.second.emplace_back(new SignedConstant(1));
+    a_criteria.second.emplace_back(new UndefValue);
+    IndexCount a(
+            std::move(a_return), mk<RelationReference>(&edge), mk<UndefValue>(), std::move(a_criteria), 0);
+
+    VecOwn<Expression> b_return_args;
+    b_return_args.emplace_back(new TupleElement(0, 0));
+    auto b_return = mk<SubroutineReturn>(std::move(b_return_args));
+    RamPattern b_criteria;
+    b_criteria.first.emplace_back(new SignedConstant(1));
+    b_criteria.first.emplace_back(new UndefValue);
+    b_criteria.second.emplace_back(new SignedConstant(1));
+    b_criteria.second.emplace_back(new UndefValue);
+    IndexCount b(
+            std::move(b_return), mk<RelationReference>(&edge), mk<UndefValue>(), std::move(b_criteria), 0);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(AggregateOp::COUNT, a.getFunction());
+
+    IndexCount* c = a.clone();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+}
+
+TEST(RamIndexMinMax, CloneAndEquals) {
+    Relation edge("edge", 2, 1, {"src", "dest"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    // t0.0 = MAX t0.1 LAST t0 IN edge ON INDEX t0.0 = number(1) AND
+    //     number(-2147483648) <= t0.1 <= number(2147483647)
+    //  RETURN t0.0
+    VecOwn<Expression> a_return_args;
+    a_return_args.emplace_back(new TupleElement(0, 0));
+    auto a_return = mk<SubroutineReturn>(std::move(a_return_args));
+    RamPattern a_criteria;
+    a_criteria.first.emplace_back(new SignedConstant(1));
+    a_criteria.first.emplace_back(new SignedConstant(MIN_RAM_SIGNED));
+    a_criteria.second.emplace_back(new SignedConstant(1));
+    a_criteria.second.emplace_back(new SignedConstant(MAX_RAM_SIGNED));
+    IndexMinMax a(std::move(a_return), AggregateOp::MAX, mk<RelationReference>(&edge), 1,
+            std::move(a_criteria), 0);
+
+    VecOwn<Expression> b_return_args;
+    b_return_args.emplace_back(new TupleElement(0, 0));
+    auto b_return = mk<SubroutineReturn>(std::move(b_return_args));
+    RamPattern b_criteria;
+    b_criteria.first.emplace_back(new SignedConstant(1));
+    b_criteria.first.emplace_back(new SignedConstant(MIN_RAM_SIGNED));
+    b_criteria.second.emplace_back(new SignedConstant(1));
+    b_criteria.second.emplace_back(new SignedConstant(MAX_RAM_SIGNED));
+    IndexMinMax b(std::move(b_return), AggregateOp::MAX, mk<RelationReference>(&edge), 1,
+            std::move(b_criteria), 0);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(1, a.getColumn());
+    EXPECT_TRUE(a.isLast());
+
+    IndexMinMax* c = a.clone();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    EXPECT_EQ(1, c->getColumn());
+    delete c;
+}
+
+TEST(RamIndexIntersection, CloneAndEquals) {
+    Relation edge("edge", 2, 0, {"src", "dest"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    // FOR t1 IN edge.1 ON INDEX edge.0 = t0.0 ∩ edge.0
+    //  RETURN (t1.0)
+    auto makeIntersection = [&]() {
+        VecOwn<Expression> return_args;
+        return_args.emplace_back(new TupleElement(1, 0));
+        auto ret = mk<SubroutineReturn>(std::move(return_args));
+        VecOwn<RelationReference> relations;
+        relations.emplace_back(mk<RelationReference>(&edge));
+        relations.emplace_back(mk<RelationReference>(&edge));
+        std::vector<RamPattern> criteria(2);
+        criteria[0].first.emplace_back(new TupleElement(0, 0));
+        criteria[0].first.emplace_back(new SignedConstant(MIN_RAM_SIGNED));
+        criteria[0].second.emplace_back(new TupleElement(0, 0));
+        criteria[0].second.emplace_back(new SignedConstant(MAX_RAM_SIGNED));
+        criteria[1].first.emplace_back(new SignedConstant(MIN_RAM_SIGNED));
+        criteria[1].first.emplace_back(new UndefValue);
+        criteria[1].second.emplace_back(new SignedConstant(MAX_RAM_SIGNED));
+        criteria[1].second.emplace_back(new UndefValue);
+        return mk<IndexIntersection>(
+                std::move(relations), std::vector<size_t>{1, 0}, std::move(criteria), 1, std::move(ret));
+    };
+    auto a = makeIntersection();
+    auto b = makeIntersection();
+    EXPECT_EQ(*a, *b);
+    EXPECT_NE(a.get(), b.get());
+    EXPECT_EQ(2, a->getNumInputs());
+    EXPECT_EQ(1, a->getColumn(0));
+    EXPECT_EQ(0, a->getColumn(1));
+
+    IndexIntersection* c = a->clone();
+    EXPECT_EQ(*a, *c);
+    EXPECT_NE(a.get(), c);
+    EXPECT_EQ(0, c->getColumn(1));
+    delete c;
+}
+
 TEST(RamUnpackedRecord, CloneAndEquals) {
     // UNPACK (t0.0, t0.2) INTO t1
     // RETURN number(0)
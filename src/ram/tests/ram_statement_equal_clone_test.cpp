@@ -29,12 +29,14 @@
 #include "ram/Expression.h"
 #include "ram/Extend.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/IO.h"
 #include "ram/IntrinsicOperator.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/Operation.h"
 #include "ram/Parallel.h"
@@ -45,6 +47,7 @@
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineReturn.h"
 #include "ram/Swap.h"
@@ -92,6 +95,48 @@ TEST(Clear, CloneAndEquals) {
     delete c;
 }
 
+TEST(Freeze, CloneAndEquals) {
+    // FREEZE A
+    Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    Freeze a(mk<RelationReference>(&A));
+    Freeze b(mk<RelationReference>(&A));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    Freeze* c = a.clone();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+}
+
+TEST(Spill, CloneAndEquals) {
+    // SPILL A, B
+    Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    Relation B("B", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    VecOwn<RelationReference> a_refs;
+    a_refs.push_back(mk<RelationReference>(&A));
+    a_refs.push_back(mk<RelationReference>(&B));
+    Spill a(std::move(a_refs));
+    VecOwn<RelationReference> b_refs;
+    b_refs.push_back(mk<RelationReference>(&A));
+    b_refs.push_back(mk<RelationReference>(&B));
+    Spill b(std::move(b_refs));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    Spill* c = a.clone();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+
+    // the order of the relations matters
+    VecOwn<RelationReference> d_refs;
+    d_refs.push_back(mk<RelationReference>(&B));
+    d_refs.push_back(mk<RelationReference>(&A));
+    Spill d(std::move(d_refs));
+    EXPECT_NE(a, d);
+}
+
 TEST(Extend, CloneAndEquals) {
     // MERGE B WITH A
     Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
@@ -107,6 +152,21 @@ TEST(Extend, CloneAndEquals) {
     delete c;
 }
 
+TEST(Merge, CloneAndEquals) {
+    // MERGE A INTO B
+    Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    Relation B("B", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    Merge a(mk<RelationReference>(&B), mk<RelationReference>(&A));
+    Merge b(mk<RelationReference>(&B), mk<RelationReference>(&A));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    Merge* c = a.clone();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+}
+
 TEST(Swap, CloneAndEquals) {
     // SWAP(A,B)
     Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
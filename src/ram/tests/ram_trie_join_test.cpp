@@ -0,0 +1,145 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ram_trie_join_test.cpp
+ *
+ * Tests which joins are rewritten into trie joins.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "RelationTag.h"
+#include "ram/Condition.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexScan.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Project.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/Visitor.h"
+#include "ram/transform/TrieJoin.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::test {
+
+namespace {
+
+/** Binary relations a, b, c, and a ternary relation out */
+VecOwn<Relation> getRelations() {
+    VecOwn<Relation> rels;
+    for (const char* name : {"a", "b", "c"}) {
+        rels.push_back(mk<Relation>(name, 2, 0, std::vector<std::string>({"x", "y"}),
+                std::vector<std::string>({"i:number", "i:number"}), RelationRepresentation::BTREE));
+    }
+    rels.push_back(mk<Relation>("out", 3, 0, std::vector<std::string>({"x", "y", "z"}),
+            std::vector<std::string>({"i:number", "i:number", "i:number"}), RelationRepresentation::BTREE));
+    return rels;
+}
+
+/** The loop nest of a(x,y), b(y,z), with out(x,y,z) nested, guarded by the given condition if any */
+Own<Operation> getPath(const VecOwn<Relation>& rels, Own<Condition> condition) {
+    VecOwn<Expression> values;
+    values.push_back(mk<TupleElement>(0, 0));
+    values.push_back(mk<TupleElement>(0, 1));
+    values.push_back(mk<TupleElement>(1, 1));
+    Own<Operation> nested = mk<Project>(mk<RelationReference>(rels[3].get()), std::move(values));
+    if (condition != nullptr) {
+        nested = mk<Filter>(std::move(condition), std::move(nested));
+    }
+
+    RamPattern pattern;
+    pattern.first.push_back(mk<TupleElement>(0, 1));
+    pattern.first.push_back(mk<UndefValue>());
+    pattern.second.push_back(mk<TupleElement>(0, 1));
+    pattern.second.push_back(mk<UndefValue>());
+    return mk<Scan>(mk<RelationReference>(rels[0].get()), 0,
+            mk<IndexScan>(mk<RelationReference>(rels[1].get()), 1, std::move(pattern), std::move(nested)));
+}
+
+/** A program running the given query */
+Own<Program> getProgram(VecOwn<Relation> rels, Own<Operation> op) {
+    std::map<std::string, Own<Statement>> subs;
+    return mk<Program>(std::move(rels), mk<Sequence>(mk<Query>(std::move(op))), std::move(subs));
+}
+
+/** The query of a program */
+const Operation& getOperation(const Program& program) {
+    const Operation* res = nullptr;
+    visitDepthFirst(program, [&](const Query& query) { res = &query.getOperation(); });
+    return *res;
+}
+
+/** The number of intersections of a program */
+std::size_t countIntersections(const Program& program) {
+    std::size_t res = 0;
+    visitDepthFirst(program, [&](const IndexIntersection&) { ++res; });
+    return res;
+}
+
+}  // namespace
+
+TEST(TrieJoin, Triangle) {
+    // out(x,y,z) :- a(x,y), b(y,z), c(z,x).
+    VecOwn<Relation> rels = getRelations();
+    VecOwn<Expression> values;
+    values.push_back(mk<TupleElement>(1, 1));
+    values.push_back(mk<TupleElement>(0, 0));
+    auto exists = mk<ExistenceCheck>(mk<RelationReference>(rels[2].get()), std::move(values));
+    Own<Operation> op = getPath(rels, std::move(exists));
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    TranslationUnit tu(getProgram(std::move(rels), std::move(op)), SymbolTable(), errReport, debugReport);
+    EXPECT_TRUE(transform::TrieJoinTransformer().apply(tu));
+
+    // one intersection per variable, the existence check is discharged by them
+    EXPECT_EQ(3, countIntersections(tu.getProgram()));
+    EXPECT_TRUE(isA<IndexIntersection>(getOperation(tu.getProgram())));
+    std::size_t numChecks = 0;
+    visitDepthFirst(tu.getProgram(), [&](const ExistenceCheck&) { ++numChecks; });
+    EXPECT_EQ(0, numChecks);
+}
+
+TEST(TrieJoin, Acyclic) {
+    // out(x,y,z) :- a(x,y), b(y,z).
+    VecOwn<Relation> rels = getRelations();
+    Own<Operation> op = getPath(rels, nullptr);
+    Own<Operation> original = souffle::clone(op);
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    TranslationUnit tu(getProgram(std::move(rels), std::move(op)), SymbolTable(), errReport, debugReport);
+    EXPECT_FALSE(transform::TrieJoinTransformer().apply(tu));
+
+    EXPECT_EQ(0, countIntersections(tu.getProgram()));
+    EXPECT_EQ(*original, getOperation(tu.getProgram()));
+}
+
+}  // namespace souffle::ram::test
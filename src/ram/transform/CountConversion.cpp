@@ -0,0 +1,59 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CountConversion.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/CountConversion.h"
+#include "AggregateOp.h"
+#include "ram/Expression.h"
+#include "ram/IndexAggregate.h"
+#include "ram/IndexCount.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Relation.h"
+#include "ram/Statement.h"
+#include "ram/Utils.h"
+#include "ram/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+bool CountConversionTransformer::convertCounts(Program& program) {
+    bool changed = false;
+
+    visitDepthFirst(program, [&](const Query& query) {
+        std::function<Own<Node>(Own<Node>)> countRewriter = [&](Own<Node> node) -> Own<Node> {
+            // a count with a condition has to inspect every tuple of the range
+            if (const IndexAggregate* aggregate = dynamic_cast<IndexAggregate*>(node.get())) {
+                if (!isA<IndexCount>(aggregate) && aggregate->getFunction() == AggregateOp::COUNT &&
+                        isTrue(&aggregate->getCondition())) {
+                    changed = true;
+                    const Relation& rel = aggregate->getRelation();
+                    node = mk<IndexCount>(souffle::clone(&aggregate->getOperation()),
+                            mk<RelationReference>(&rel), souffle::clone(&aggregate->getExpression()),
+                            clone(aggregate->getRangePattern()), aggregate->getTupleId());
+                }
+            }
+            node->apply(makeLambdaRamMapper(countRewriter));
+            return node;
+        };
+        const_cast<Query*>(&query)->apply(makeLambdaRamMapper(countRewriter));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,67 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CountConversion.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class CountConversionTransformer
+ * @brief Converts unconditional count aggregates over an index range into IndexCount operations.
+ *
+ * The size of the range is then obtained from the index, in logarithmic time for
+ * b-tree indexes, instead of enumerating the tuples in the range.
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *    t0.0=count SEARCH t0 ∈ S ON INDEX t0.0 = number(1)
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *    t0.0=count RANGE t0 ∈ S ON INDEX t0.0 = number(1)
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ */
+class CountConversionTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "CountConversionTransformer";
+    }
+
+    /**
+     * @brief Convert count aggregates over index ranges
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool convertCounts(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        return convertCounts(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
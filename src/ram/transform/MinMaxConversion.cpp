@@ -0,0 +1,112 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MinMaxConversion.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/MinMaxConversion.h"
+#include "AggregateOp.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Expression.h"
+#include "ram/IndexAggregate.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexMinMax.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Relation.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/Utils.h"
+#include "ram/Visitor.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+bool MinMaxConversionTransformer::convertMinMax(Program& program) {
+    // indexed inequalities are only kept for b-tree relations without provenance
+    if (Global::config().has("provenance")) {
+        return false;
+    }
+
+    // obtain the aggregated attribute if the aggregate is eligible for the shortcut
+    auto getColumn = [](const IndexAggregate& aggregate) -> int {
+        if (isA<IndexCount>(&aggregate) || isA<IndexMinMax>(&aggregate)) {
+            return -1;
+        }
+        if (aggregate.getFunction() != AggregateOp::MIN && aggregate.getFunction() != AggregateOp::MAX) {
+            return -1;
+        }
+        // a condition has to be checked for every tuple of the range
+        if (!isTrue(&aggregate.getCondition())) {
+            return -1;
+        }
+        const auto* element = dynamic_cast<const TupleElement*>(&aggregate.getExpression());
+        if (element == nullptr || element->getTupleId() != aggregate.getTupleId()) {
+            return -1;
+        }
+        const Relation& rel = aggregate.getRelation();
+        if (rel.getRepresentation() != RelationRepresentation::BTREE &&
+                rel.getRepresentation() != RelationRepresentation::DEFAULT) {
+            return -1;
+        }
+        size_t column = element->getElement();
+        if (rel.getAttributeTypes()[column][0] != 'i') {
+            return -1;
+        }
+        // the remaining attributes of the range have to be bound by equalities
+        auto pattern = aggregate.getRangePattern();
+        for (size_t i = 0; i < rel.getArity(); ++i) {
+            bool unbound = isUndefValue(pattern.first[i]) && isUndefValue(pattern.second[i]);
+            if (i == column && !unbound) {
+                return -1;
+            }
+            if (!unbound && !(*pattern.first[i] == *pattern.second[i])) {
+                return -1;
+            }
+        }
+        return static_cast<int>(column);
+    };
+
+    bool changed = false;
+    visitDepthFirst(program, [&](const Query& query) {
+        std::function<Own<Node>(Own<Node>)> minMaxRewriter = [&](Own<Node> node) -> Own<Node> {
+            if (const IndexAggregate* aggregate = dynamic_cast<IndexAggregate*>(node.get())) {
+                int column = getColumn(*aggregate);
+                if (column >= 0) {
+                    changed = true;
+                    const Relation& rel = aggregate->getRelation();
+                    RamPattern pattern = clone(aggregate->getRangePattern());
+                    pattern.first[column] = mk<SignedConstant>(MIN_RAM_SIGNED);
+                    pattern.second[column] = mk<SignedConstant>(MAX_RAM_SIGNED);
+                    node = mk<IndexMinMax>(souffle::clone(&aggregate->getOperation()),
+                            aggregate->getFunction(), mk<RelationReference>(&rel), column,
+                            std::move(pattern), aggregate->getTupleId());
+                }
+            }
+            node->apply(makeLambdaRamMapper(minMaxRewriter));
+            return node;
+        };
+        const_cast<Query*>(&query)->apply(makeLambdaRamMapper(minMaxRewriter));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
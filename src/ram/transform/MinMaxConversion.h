@@ -0,0 +1,71 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MinMaxConversion.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class MinMaxConversionTransformer
+ * @brief Converts unconditional min/max aggregates over an index range into IndexMinMax operations.
+ *
+ * The aggregated attribute is added to the range as an unbounded inequality, such that
+ * the index selection places it right after the attributes bound by equalities. The
+ * minimum (maximum) is then the attribute of the first (last) tuple of the range and
+ * the tuples of the range are not enumerated. The backends fall back to a general
+ * aggregate if the selected index order does not admit the shortcut.
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *    t0.0=min t0.1 SEARCH t0 ∈ S ON INDEX t0.0 = number(1)
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *    t0.0=min t0.1 FIRST t0 ∈ S ON INDEX t0.0 = number(1) AND
+ *        number(-2147483648) <= t0.1 <= number(2147483647)
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ */
+class MinMaxConversionTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "MinMaxConversionTransformer";
+    }
+
+    /**
+     * @brief Convert min/max aggregates over index ranges
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool convertMinMax(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        return convertMinMax(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
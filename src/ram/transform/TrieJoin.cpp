@@ -0,0 +1,359 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TrieJoin.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/TrieJoin.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/AbstractParallel.h"
+#include "ram/Condition.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexOperation.h"
+#include "ram/IndexScan.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/RelationOperation.h"
+#include "ram/Scan.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/TupleElement.h"
+#include "ram/TupleOperation.h"
+#include "ram/UndefValue.h"
+#include "ram/Utils.h"
+#include "ram/Visitor.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Whether the atoms of a relation may be intersected, leapfrogging over signed values */
+bool isJoinable(const Relation& rel) {
+    if (rel.getRepresentation() != RelationRepresentation::BTREE &&
+            rel.getRepresentation() != RelationRepresentation::DEFAULT) {
+        return false;
+    }
+    if (rel.getArity() == 0 || rel.getAuxiliaryArity() > 0) {
+        return false;
+    }
+    const auto& types = rel.getAttributeTypes();
+    return std::all_of(types.begin(), types.end(), [](const std::string& type) { return type[0] == 'i'; });
+}
+
+/** Whether an expression refers to no tuple, i.e., is invariant for the query */
+bool isInvariant(const Expression& expr) {
+    bool invariant = true;
+    visitDepthFirst(expr, [&](const TupleElement&) { invariant = false; });
+    return invariant;
+}
+
+/** A union-find structure over the attributes of the atoms */
+struct Partition {
+    std::vector<size_t> parent;
+
+    size_t add() {
+        parent.push_back(parent.size());
+        return parent.size() - 1;
+    }
+
+    size_t find(size_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    void unite(size_t x, size_t y) {
+        parent[find(x)] = find(y);
+    }
+};
+
+}  // namespace
+
+Own<Operation> TrieJoinTransformer::rewriteJoin(const Operation& op) {
+    // the attributes of the scanned tuples, either bound to query-invariant values or variables
+    struct Slot {
+        size_t id;
+        const Expression* invariant;
+    };
+    std::map<int, std::vector<Slot>> slots;
+    Partition partition;
+
+    // an atom of the join, its attributes refer to the representatives of their slots
+    struct Atom {
+        const Relation* relation;
+        std::vector<Slot> attributes;
+    };
+    std::vector<Atom> atoms;
+
+    // collect the scans and conditions on top of the loop nest
+    VecOwn<Condition> conditions;
+    const Operation* cur = &op;
+    while (true) {
+        if (const auto* filter = dynamic_cast<const Filter*>(cur)) {
+            for (auto& condition : toConjunctionList(&filter->getCondition())) {
+                conditions.push_back(std::move(condition));
+            }
+            cur = &filter->getOperation();
+            continue;
+        }
+        const auto* scan = dynamic_cast<const RelationOperation*>(cur);
+        if (scan == nullptr || isA<AbstractParallel>(scan) || !(isA<Scan>(scan) || isA<IndexScan>(scan)) ||
+                !isJoinable(scan->getRelation())) {
+            break;
+        }
+
+        // attributes of an index scan are free or bound to earlier attributes or invariant values
+        const Relation& rel = scan->getRelation();
+        std::vector<Slot> attributes;
+        bool eligible = true;
+        for (size_t i = 0; i < rel.getArity() && eligible; ++i) {
+            Slot slot{partition.add(), nullptr};
+            if (const auto* indexScan = dynamic_cast<const IndexScan*>(scan)) {
+                const Expression* lower = indexScan->getRangePattern().first[i];
+                const Expression* upper = indexScan->getRangePattern().second[i];
+                if (isUndefValue(lower) && isUndefValue(upper)) {
+                    // free attribute
+                } else if (!(*lower == *upper)) {
+                    eligible = false;
+                } else if (const auto* element = dynamic_cast<const TupleElement*>(lower)) {
+                    auto pos = slots.find(element->getTupleId());
+                    if (pos == slots.end()) {
+                        eligible = false;
+                    } else {
+                        const Slot& bound = pos->second[element->getElement()];
+                        partition.unite(slot.id, bound.id);
+                        slot.invariant = bound.invariant;
+                    }
+                } else if (isInvariant(*lower)) {
+                    slot.invariant = lower;
+                } else {
+                    eligible = false;
+                }
+            }
+            attributes.push_back(slot);
+        }
+        if (!eligible) {
+            break;
+        }
+        slots[scan->getTupleId()] = attributes;
+        atoms.push_back({&rel, attributes});
+        cur = &scan->getOperation();
+    }
+    if (atoms.size() < 2) {
+        return nullptr;
+    }
+
+    // obtains the slot of an expression, if it is a scanned attribute
+    auto getSlot = [&](const Expression* expr) -> const Slot* {
+        if (const auto* element = dynamic_cast<const TupleElement*>(expr)) {
+            auto pos = slots.find(element->getTupleId());
+            if (pos != slots.end()) {
+                return &pos->second[element->getElement()];
+            }
+        }
+        return nullptr;
+    };
+
+    // existence checks of full tuples over scanned attributes are atoms as well
+    VecOwn<Condition> remaining;
+    for (auto& condition : conditions) {
+        const auto* exists = dynamic_cast<const ExistenceCheck*>(condition.get());
+        if (exists != nullptr && isJoinable(exists->getRelation())) {
+            std::vector<Slot> attributes;
+            for (const Expression* value : exists->getValues()) {
+                if (const Slot* slot = getSlot(value)) {
+                    attributes.push_back(*slot);
+                } else if (!isUndefValue(value) && isInvariant(*value)) {
+                    attributes.push_back({partition.add(), value});
+                } else {
+                    break;
+                }
+            }
+            bool bindsVariable = std::any_of(attributes.begin(), attributes.end(),
+                    [](const Slot& slot) { return slot.invariant == nullptr; });
+            if (attributes.size() == exists->getRelation().getArity() && bindsVariable) {
+                atoms.push_back({&exists->getRelation(), attributes});
+                continue;
+            }
+        }
+        remaining.push_back(std::move(condition));
+    }
+
+    // number the variables in the order they are bound by the loop nest
+    std::map<size_t, size_t> variables;
+    for (const Atom& atom : atoms) {
+        for (const Slot& slot : atom.attributes) {
+            if (slot.invariant == nullptr) {
+                variables.emplace(partition.find(slot.id), variables.size());
+            }
+        }
+    }
+    auto getVariable = [&](const Slot& slot) -> int {
+        return (slot.invariant == nullptr) ? static_cast<int>(variables.at(partition.find(slot.id))) : -1;
+    };
+
+    // every atom has to bind distinct variables
+    size_t incidences = 0;
+    for (const Atom& atom : atoms) {
+        std::vector<int> bound;
+        for (const Slot& slot : atom.attributes) {
+            if (getVariable(slot) >= 0) {
+                bound.push_back(getVariable(slot));
+            }
+        }
+        std::sort(bound.begin(), bound.end());
+        if (bound.empty() || std::adjacent_find(bound.begin(), bound.end()) != bound.end()) {
+            return nullptr;
+        }
+        incidences += bound.size();
+    }
+
+    // the atoms have to be connected along a cycle, i.e., their incidence graph is not a forest
+    Partition components;
+    for (size_t i = 0; i < atoms.size() + variables.size(); ++i) {
+        components.add();
+    }
+    size_t numComponents = atoms.size() + variables.size();
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        for (const Slot& slot : atoms[i].attributes) {
+            int var = getVariable(slot);
+            if (var >= 0 && components.find(i) != components.find(atoms.size() + var)) {
+                components.unite(i, atoms.size() + var);
+                --numComponents;
+            }
+        }
+    }
+    if (incidences + numComponents <= atoms.size() + variables.size()) {
+        return nullptr;
+    }
+
+    // the tuples of the intersections follow all tuples of the query
+    int base = 0;
+    visitDepthFirst(op, [&](const TupleOperation& search) {
+        base = std::max(base, search.getTupleId() + 1);
+    });
+    visitDepthFirst(op, [&](const TupleElement& element) {
+        base = std::max(base, element.getTupleId() + 1);
+    });
+
+    // replace scanned attributes by the values of their variables
+    std::function<Own<Node>(Own<Node>)> attributeRewriter = [&](Own<Node> node) -> Own<Node> {
+        if (const Slot* slot = getSlot(dynamic_cast<const Expression*>(node.get()))) {
+            if (slot->invariant != nullptr) {
+                return souffle::clone(slot->invariant);
+            }
+            return mk<TupleElement>(base + getVariable(*slot), 0);
+        }
+        node->apply(makeLambdaRamMapper(attributeRewriter));
+        return node;
+    };
+
+    // check the remaining conditions as soon as their variables are bound
+    std::vector<VecOwn<Condition>> filters(variables.size() + 1);
+    for (auto& condition : remaining) {
+        int level = -1;
+        visitDepthFirst(*condition, [&](const TupleElement& element) {
+            if (const Slot* slot = getSlot(&element)) {
+                level = std::max(level, getVariable(*slot));
+            }
+        });
+        condition->apply(makeLambdaRamMapper(attributeRewriter));
+        filters[level + 1].push_back(std::move(condition));
+    }
+    auto addFilter = [&](int level, Own<Operation> nested) -> Own<Operation> {
+        if (filters[level + 1].empty()) {
+            return nested;
+        }
+        return mk<Filter>(toCondition(filters[level + 1]), std::move(nested));
+    };
+
+    // build the intersections from the inner-most one, nesting the rest of the loop nest
+    Own<Operation> res = souffle::clone(cur);
+    res->apply(makeLambdaRamMapper(attributeRewriter));
+    for (int level = static_cast<int>(variables.size()) - 1; level >= 0; --level) {
+        res = addFilter(level, std::move(res));
+
+        VecOwn<RelationReference> relations;
+        std::vector<size_t> columns;
+        std::vector<RamPattern> patterns;
+        for (const Atom& atom : atoms) {
+            auto pos = std::find_if(atom.attributes.begin(), atom.attributes.end(),
+                    [&](const Slot& slot) { return getVariable(slot) == level; });
+            if (pos == atom.attributes.end()) {
+                continue;
+            }
+            RamPattern pattern;
+            for (const Slot& slot : atom.attributes) {
+                int var = getVariable(slot);
+                if (var == level) {
+                    pattern.first.push_back(mk<SignedConstant>(MIN_RAM_SIGNED));
+                    pattern.second.push_back(mk<SignedConstant>(MAX_RAM_SIGNED));
+                } else if (var < 0) {
+                    pattern.first.push_back(souffle::clone(slot.invariant));
+                    pattern.second.push_back(souffle::clone(slot.invariant));
+                } else if (var < level) {
+                    pattern.first.push_back(mk<TupleElement>(base + var, 0));
+                    pattern.second.push_back(mk<TupleElement>(base + var, 0));
+                } else {
+                    pattern.first.push_back(mk<UndefValue>());
+                    pattern.second.push_back(mk<UndefValue>());
+                }
+            }
+            relations.push_back(mk<RelationReference>(atom.relation));
+            columns.push_back(static_cast<size_t>(pos - atom.attributes.begin()));
+            patterns.push_back(std::move(pattern));
+        }
+        res = mk<IndexIntersection>(
+                std::move(relations), std::move(columns), std::move(patterns), base + level, std::move(res));
+    }
+    return addFilter(-1, std::move(res));
+}
+
+bool TrieJoinTransformer::convertJoins(Program& program) {
+    // provenance annotations are not intersected
+    if (Global::config().has("provenance")) {
+        return false;
+    }
+
+    bool changed = false;
+    visitDepthFirst(program, [&](const Query& query) {
+        std::function<Own<Node>(Own<Node>)> joinRewriter = [&](Own<Node> node) -> Own<Node> {
+            if (Own<Operation> op = rewriteJoin(static_cast<const Operation&>(*node))) {
+                changed = true;
+                return op;
+            }
+            return node;
+        };
+        const_cast<Query*>(&query)->apply(makeLambdaRamMapper(joinRewriter));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,89 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TrieJoin.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class TrieJoinTransformer
+ * @brief Evaluates loop nests joining atoms along a cycle as trie joins.
+ *
+ * The outer scans of a query, together with the existence checks filtering them,
+ * form a conjunction of atoms over variables. If the atoms and variables of the
+ * conjunction are connected along a cycle, as in triangles or cliques, nested
+ * loops may enumerate far more partial results than the query produces. Such loop
+ * nests are rewritten into a nest of IndexIntersection operations, binding one
+ * variable at a time to the values it takes in all atoms it occurs in, in the
+ * order the variables are bound by the loop nest. The remaining conditions are
+ * checked as soon as their variables are bound.
+ *
+ * Only relations represented by b-trees whose attributes are signed numbers take
+ * part, such that the values of an attribute can be leapfrogged over through
+ * indexed inequalities.
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN a
+ *    FOR t1 IN b ON INDEX t1.0 = t0.1
+ *     IF (t1.1,t0.0) IN c
+ *      PROJECT (t0.0, t0.1, t1.1) INTO t
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN a.0 ∩ c.1
+ *    FOR t1 IN a.1 ON INDEX a.0 = t0.0 ∩ b.0
+ *     FOR t2 IN b.1 ON INDEX b.0 = t1.0 ∩ c.0 ON INDEX c.1 = t0.0
+ *      PROJECT (t0.0, t1.0, t2.0) INTO t
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ */
+class TrieJoinTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "TrieJoinTransformer";
+    }
+
+    /**
+     * @brief Rewrite the loop nest of a query into a trie join
+     * @param op Outer-most operation of the query
+     * @return The trie join, or null if the loop nest does not qualify
+     */
+    Own<Operation> rewriteJoin(const Operation& op);
+
+    /**
+     * @brief Convert the loop nests of queries into trie joins
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool convertJoins(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        return convertJoins(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
@@ -7,6 +7,7 @@
  */
 
 #include "synthesiser/Relation.h"
+#include "Global.h"
 #include "RelationTag.h"
 #include "ram/analysis/Index.h"
 #include "souffle/utility/StreamUtil.h"
@@ -24,6 +25,51 @@ using namespace ram;
 using ram::analysis::MinIndexSelection;
 using ram::analysis::SearchSignature;
 
+namespace {
+
+/** Generate the merge of the indexes of another relation of the same type, in parallel across indexes */
+void generateIndexMerge(std::ostream& out, size_t numIndexes) {
+    if (numIndexes > 1) {
+        out << "#pragma omp parallel sections\n";
+        out << "{\n";
+    }
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (numIndexes > 1) {
+            out << "#pragma omp section\n";
+        }
+        out << "ind_" << i << ".insertAll(other.ind_" << i << ");\n";
+    }
+    if (numIndexes > 1) {
+        out << "}\n";
+    }
+}
+
+/** Generate the insertion of the tuples of a relation of any type, with an operation context if it is used */
+void generateTupleInsertAll(std::ostream& out, bool withContext) {
+    out << "template <typename T>\n";
+    out << "void insertAll(const T& other) {\n";
+    if (withContext) {
+        out << "context h;\n";
+    }
+    out << "for (auto const& cur : other) {\n";
+    out << (withContext ? "insert(cur, h);\n" : "insert(cur);\n");
+    out << "}\n";
+    out << "}\n";
+}
+
+/** Generate the insertion of the tuples of a source index into index i, sorted in the order of index i */
+void generateSortedLoad(std::ostream& out, size_t i, const std::string& source) {
+    out << "{\n";
+    out << "std::vector<t_tuple> sorted(" << source << ".begin(), " << source << ".end());\n";
+    out << "t_comparator_" << i << " comparator;\n";
+    out << "std::sort(sorted.begin(), sorted.end(), [&](const t_tuple& a, const t_tuple& b) { "
+           "return comparator.less(a, b); });\n";
+    out << "ind_" << i << ".insertSortedBulk(sorted.begin(), sorted.end());\n";
+    out << "}\n";
+}
+
+}  // namespace
+
 std::string Relation::getTypeAttributeString(const std::vector<std::string>& attributeTypes,
         const std::unordered_set<uint32_t>& attributesUsed) const {
     std::stringstream type;
@@ -40,8 +86,8 @@ std::string Relation::getTypeAttributeString(const std::vector<std::string>& att
     return type.str();
 }
 
-Own<Relation> Relation::getSynthesiserRelation(
-        const ram::Relation& ramRel, const MinIndexSelection& indexSet, bool isProvenance) {
+Own<Relation> Relation::getSynthesiserRelation(const ram::Relation& ramRel,
+        const MinIndexSelection& indexSet, RelationRepresentation representation, bool isProvenance) {
     Relation* rel;
 
     // Handle the qualifier in souffle code
@@ -53,6 +99,8 @@ Own<Relation> Relation::getSynthesiserRelation(
         rel = new DirectRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BRIE) {
         rel = new BrieRelation(ramRel, indexSet, isProvenance);
+    } else if (representation == RelationRepresentation::HASHSET) {
+        rel = new HashsetRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::EQREL) {
         rel = new EqrelRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::INFO) {
@@ -156,6 +204,12 @@ void DirectRelation::computeIndices() {
     }
     assert(masterIndex < inds.size() && "no full index in relation");
     computedIndices = inds;
+
+    // the maintenance of secondary indexes may be deferred by relations of this type
+    deferrableIndexes = !isProvenance && inds.size() > 1 && Global::config().has("deferred-indexes");
+
+    // a Bloom filter identifies tuples by their attributes excluding the auxiliary ones
+    filterSupport = Global::config().has("bloom-filters") && getArity() > relation.getAuxiliaryArity();
 }
 
 /** Generate type name of a direct indexed relation */
@@ -179,9 +233,31 @@ std::string DirectRelation::getTypeName() {
         res << "__" << search;
     }
 
+    if (!isProvenance) {
+        for (auto& search : getMinIndexSelection().getCountedSearches()) {
+            res << "__c" << search;
+        }
+    }
+
     return res.str();
 }
 
+/** Check whether the ranges of a search of a direct indexed relation are counted by its index */
+bool DirectRelation::countsRange(const SearchSignature& search) const {
+    const auto& countedSearches = getMinIndexSelection().getCountedSearches();
+    return !isProvenance && countedSearches.find(search) != countedSearches.end();
+}
+
+/** Check whether a search of a direct indexed relation reads an index which may be deferred */
+bool DirectRelation::searchesDeferrableIndex(const SearchSignature& search) const {
+    if (!deferrableIndexes || search.empty()) {
+        return false;
+    }
+    const auto& lexOrder = getMinIndexSelection().getLexOrder(search);
+    auto pos = std::find(computedIndices.begin(), computedIndices.end(), lexOrder);
+    return pos != computedIndices.end() && static_cast<size_t>(pos - computedIndices.begin()) != masterIndex;
+}
+
 /** Generate type struct of a direct indexed relation */
 void DirectRelation::generateTypeStruct(std::ostream& out) {
     size_t arity = getArity();
@@ -303,11 +379,31 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
                    "souffle::detail::default_strategy<t_tuple>::type,"
                 << comparator_aux << ",updater_" << getTypeName() << ">;\n";
         } else {
+            // small tuples ordered by signed attributes only are searched through SIMD instructions
+            std::string strategy;
+            bool isSigned = std::all_of(ind.begin(), ind.end(),
+                    [&](size_t attrib) { return typecasts[attrib] == "ramBitCast<RamSigned>"; });
+            if (arity <= 4 && !ind.empty() && isSigned) {
+                std::stringstream params;
+                params << ",std::allocator<t_tuple>,256,souffle::detail::simd_search<" << join(ind, ",")
+                       << ">";
+                strategy = params.str();
+            }
+            // indices whose ranges are counted cache the sizes of their sub-trees
+            if (i < getMinIndexSelection().getAllOrders().size() && getMinIndexSelection().isCounted(i)) {
+                if (strategy.empty()) {
+                    strategy =
+                            ",std::allocator<t_tuple>,256,typename "
+                            "souffle::detail::default_strategy<t_tuple>::type";
+                }
+                strategy += "," + comparator + ",souffle::detail::updater<t_tuple>,true";
+            }
             if (ind.size() == arity) {
-                out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator << ">;\n";
+                out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator << strategy << ">;\n";
             } else {
                 // without provenance, some indices may be not full, so we use btree_multiset for those
-                out << "using t_ind_" << i << " = btree_multiset<t_tuple," << comparator << ">;\n";
+                out << "using t_ind_" << i << " = btree_multiset<t_tuple," << comparator << strategy
+                    << ">;\n";
             }
         }
         out << "t_ind_" << i << " ind_" << i << ";\n";
@@ -327,6 +423,32 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "};\n";
     out << "context createContext() { return context(); }\n";
 
+    // while the secondary indexes are deferred, only the master index is maintained
+    if (deferrableIndexes) {
+        out << "bool deferring = false;\n";
+        out << "std::atomic<bool> indexesDeferred{false};\n";
+        out << "std::mutex buildLock;\n";
+        out << "void deferIndexes() {\n";
+        out << "deferring = true;\n";
+        out << "indexesDeferred = true;\n";
+        out << "}\n";
+    }
+
+    // the Bloom filter, if enabled, holds the tuples identified by their attributes but the auxiliary ones
+    auto genFilterInsert = [&](const std::string& tuple) {
+        out << "filter->insert(BloomFilter::hash(&" << tuple << "[0], " << arity - auxiliaryArity << "));\n";
+    };
+    if (filterSupport) {
+        out << "Own<BloomFilter> filter;\n";
+        out << "void enableFilter(std::size_t capacity) {\n";
+        out << "filter = mk<BloomFilter>(capacity);\n";
+        out << "}\n";
+        out << "bool mayContain(const t_tuple& t) const {\n";
+        out << "return !filter || filter->mayContain(BloomFilter::hash(&t[0], "
+            << arity - auxiliaryArity << "));\n";
+        out << "}\n";
+    }
+
     // insert methods
     out << "bool insert(const t_tuple& t) {\n";
     out << "context h;\n";
@@ -336,12 +458,23 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "bool insert(const t_tuple& t, context& h) {\n";
     out << "if (ind_" << masterIndex << ".insert(t, h.hints_" << masterIndex << "_lower"
         << ")) {\n";
+    if (filterSupport) {
+        out << "if (filter) {\n";
+        genFilterInsert("t");
+        out << "}\n";
+    }
+    if (deferrableIndexes) {
+        out << "if (!indexesDeferred) {\n";
+    }
     for (size_t i = 0; i < numIndexes; i++) {
         if (i != masterIndex && provenanceIndexNumbers.find(i) == provenanceIndexNumbers.end()) {
             out << "ind_" << i << ".insert(t, h.hints_" << i << "_lower"
                 << ");\n";
         }
     }
+    if (deferrableIndexes) {
+        out << "}\n";
+    }
     out << "return true;\n";
     out << "} else return false;\n";
     out << "}\n";  // end of insert(t_tuple&, context&)
@@ -365,6 +498,122 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return insert(data);\n";
     out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
 
+    // insertAll method for relations of any type, inserting tuple by tuple
+    generateTupleInsertAll(out, true);
+
+    // insertAll method for relations of the same type, merging the indexes in bulk; secondary indexes
+    // hold the same tuples as the master index only if all indexes are full
+    bool fullIndexes = std::all_of(
+            inds.begin(), inds.end(), [&](const auto& ind) { return ind.size() == arity; });
+    if (!isProvenance && fullIndexes) {
+        out << "void insertAll(const " << getTypeName() << "& other) {\n";
+        if (filterSupport) {
+            out << "if (filter) {\n";
+            out << "for (const auto& cur : other.ind_" << masterIndex << ") {\n";
+            genFilterInsert("cur");
+            out << "}\n";
+            out << "}\n";
+        }
+        if (deferrableIndexes) {
+            // deferred indexes neither receive nor provide tuples
+            out << "if (indexesDeferred) {\n";
+            out << "ind_" << masterIndex << ".insertAll(other.ind_" << masterIndex << ");\n";
+            out << "return;\n";
+            out << "}\n";
+            out << "if (other.indexesDeferred) {\n";
+            out << "#pragma omp parallel sections\n";
+            out << "{\n";
+            out << "#pragma omp section\n";
+            out << "ind_" << masterIndex << ".insertAll(other.ind_" << masterIndex << ");\n";
+            for (size_t i = 0; i < numIndexes; i++) {
+                if (i != masterIndex) {
+                    out << "#pragma omp section\n";
+                    generateSortedLoad(out, i, "other.ind_" + std::to_string(masterIndex));
+                }
+            }
+            out << "}\n";
+            out << "return;\n";
+            out << "}\n";
+        }
+        generateIndexMerge(out, numIndexes);
+        out << "}\n";
+    }
+
+    // insertBulk method, merging the given tuples into each index in its own order, in parallel across
+    // indexes; the tuples are reordered
+    if (!isProvenance) {
+        out << "void insertBulk(std::vector<t_tuple>& tuples) {\n";
+        out << "{\n";
+        out << "t_comparator_" << masterIndex << " comparator;\n";
+        out << "std::sort(tuples.begin(), tuples.end(), [&](const t_tuple& a, const t_tuple& b) { "
+               "return comparator.less(a, b); });\n";
+        out << "tuples.erase(std::unique(tuples.begin(), tuples.end(), [&](const t_tuple& a, "
+               "const t_tuple& b) { return comparator.equal(a, b); }), tuples.end());\n";
+        out << "}\n";
+        if (!fullIndexes) {
+            // indexes that are not full hold each tuple once only if it is new to the relation
+            out << "{\n";
+            out << "context h;\n";
+            out << "tuples.erase(std::remove_if(tuples.begin(), tuples.end(), [&](const t_tuple& t) { "
+                   "return ind_" << masterIndex << ".contains(t, h.hints_" << masterIndex << "_lower); }), "
+                   "tuples.end());\n";
+            out << "}\n";
+        }
+        if (filterSupport) {
+            out << "if (filter) {\n";
+            out << "for (const auto& cur : tuples) {\n";
+            genFilterInsert("cur");
+            out << "}\n";
+            out << "}\n";
+        }
+        if (deferrableIndexes) {
+            out << "if (indexesDeferred) {\n";
+            out << "ind_" << masterIndex << ".insertSortedBulk(tuples.begin(), tuples.end());\n";
+            out << "return;\n";
+            out << "}\n";
+        }
+        if (numIndexes > 1) {
+            out << "#pragma omp parallel sections\n";
+            out << "{\n";
+            out << "#pragma omp section\n";
+        }
+        out << "ind_" << masterIndex << ".insertSortedBulk(tuples.begin(), tuples.end());\n";
+        for (size_t i = 0; i < numIndexes; i++) {
+            if (i != masterIndex) {
+                out << "#pragma omp section\n";
+                generateSortedLoad(out, i, "tuples");
+            }
+        }
+        if (numIndexes > 1) {
+            out << "}\n";
+        }
+        out << "}\n";
+    }
+
+    // buildIndexes method, loading each secondary index from the sorted tuples of the master index
+    if (deferrableIndexes) {
+        out << "void buildIndexes() {\n";
+        out << "if (!indexesDeferred) {\n";
+        out << "return;\n";
+        out << "}\n";
+        out << "std::lock_guard<std::mutex> guard(buildLock);\n";
+        out << "if (!indexesDeferred) {\n";
+        out << "return;\n";
+        out << "}\n";
+        out << "#pragma omp parallel sections\n";
+        out << "{\n";
+        for (size_t i = 0; i < numIndexes; i++) {
+            if (i == masterIndex) {
+                continue;
+            }
+            out << "#pragma omp section\n";
+            generateSortedLoad(out, i, "ind_" + std::to_string(masterIndex));
+        }
+        out << "}\n";
+        out << "indexesDeferred = false;\n";
+        out << "}\n";
+    }
+
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
     out << "return ind_" << masterIndex << ".contains(t, h.hints_" << masterIndex << "_lower"
@@ -452,6 +701,31 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         out << "context h;\n";
         out << "return lowerUpperRange_" << search << "(lower,upper,h);\n";
         out << "}\n";
+
+        // countRange method, counting the tuples of the range through the ranks of its bounds
+        if (countsRange(search)) {
+            out << "std::size_t countRange_" << search;
+            out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+            out << "t_comparator_" << indNum << " comparator;\n";
+            out << "if (comparator(lower, upper) > 0) {\n";
+            out << "    return 0;\n";
+            out << "}\n";
+            out << "return ind_" << indNum << ".rank(ind_" << indNum << ".upper_bound(upper, h.hints_"
+                << indNum << "_upper)) - ind_" << indNum << ".rank(ind_" << indNum
+                << ".lower_bound(lower, h.hints_" << indNum << "_lower));\n";
+            out << "}\n";
+        }
+
+        // boundary method, obtaining the first or the last tuple of the range
+        out << "bool boundary_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, bool last, t_tuple& res, context& h) const {\n";
+        out << "auto range = lowerUpperRange_" << search << "(lower, upper, h);\n";
+        out << "if (range.empty()) {\n";
+        out << "    return false;\n";
+        out << "}\n";
+        out << "res = last ? *ind_" << indNum << ".predecessor(range.end()) : *range.begin();\n";
+        out << "return true;\n";
+        out << "}\n";
     }
 
     // empty method
@@ -469,6 +743,21 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     for (size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".clear();\n";
     }
+    if (deferrableIndexes) {
+        out << "indexesDeferred = deferring;\n";
+    }
+    if (filterSupport) {
+        out << "if (filter) {\n";
+        out << "filter->clear();\n";
+        out << "}\n";
+    }
+    out << "}\n";
+
+    // spill method, moving the leaves of the indexes to a file
+    out << "void spill() {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".spill();\n";
+    }
     out << "}\n";
 
     // begin and end iterators
@@ -688,6 +977,9 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return insert(data);\n";
     out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
 
+    // insertAll method for relations of any type, inserting tuple by tuple
+    generateTupleInsertAll(out, true);
+
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
     out << "return ind_" << masterIndex << ".contains(&t, h.hints_" << masterIndex << "_lower"
@@ -800,6 +1092,13 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "dataTable.clear();\n";
     out << "}\n";
 
+    // spill method, moving the leaves of the indexes to a file
+    out << "void spill() {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".spill();\n";
+    }
+    out << "}\n";
+
     // begin and end iterators
     out << "iterator begin() const {\n";
     out << "return ind_" << masterIndex << ".begin();\n";
@@ -985,6 +1284,14 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
     out << "return insert(data);\n";
     out << "}\n";
 
+    // insertAll method for relations of any type, inserting tuple by tuple
+    generateTupleInsertAll(out, true);
+
+    // insertAll method for relations of the same type, merging the tries in bulk
+    out << "void insertAll(const " << getTypeName() << "& other) {\n";
+    generateIndexMerge(out, numIndexes);
+    out << "}\n";
+
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
     out << "return ind_" << masterIndex << ".contains(orderIn_" << masterIndex << "(t), h.hints_"
@@ -1115,6 +1422,220 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
     out << "};\n";
 }
 
+// -------- Hashset Relation --------
+
+/** Generate index set for a hashset relation */
+void HashsetRelation::computeIndices() {
+    assert(!isProvenance && "hash sets cannot be used with provenance");
+
+    // Generate and set indices
+    MinIndexSelection::OrderCollection inds = indices.getAllOrders();
+
+    // generate a full index if no indices exist
+    assert(!inds.empty() && "No full index in relation");
+
+    // expand all indexes to be full; the attributes beyond the key are only used for the type name
+    for (auto& ind : inds) {
+        if (ind.size() != getArity()) {
+            // use a set as a cache for fast lookup
+            std::set<int> curIndexElems(ind.begin(), ind.end());
+
+            // expand index to be full
+            for (size_t i = 0; i < getArity(); i++) {
+                if (curIndexElems.find(i) == curIndexElems.end()) {
+                    ind.push_back(i);
+                }
+            }
+        }
+
+        assert(ind.size() == getArity() && "index is not a full");
+    }
+    masterIndex = 0;
+
+    computedIndices = inds;
+}
+
+/** Generate type name of a hashset relation */
+std::string HashsetRelation::getTypeName() {
+    // collect all attributes used in the lex-order
+    std::unordered_set<uint32_t> attributesUsed;
+    for (auto& ind : getIndices()) {
+        for (auto& attr : ind) {
+            attributesUsed.insert(attr);
+        }
+    }
+
+    std::stringstream res;
+    res << "t_hashset_" << getTypeAttributeString(relation.getAttributeTypes(), attributesUsed);
+
+    for (auto& ind : getIndices()) {
+        res << "__" << join(ind, "_");
+    }
+
+    for (auto& search : getMinIndexSelection().getSearches()) {
+        res << "__" << search;
+    }
+
+    return res.str();
+}
+
+/** Generate type struct of a hashset relation */
+void HashsetRelation::generateTypeStruct(std::ostream& out) {
+    size_t arity = getArity();
+    const auto& inds = getIndices();
+    size_t numIndexes = inds.size();
+    std::map<MinIndexSelection::LexOrder, int> indexToNumMap;
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+
+    // define hash sets, each keyed on the leading attributes bound by all searches it covers;
+    // tuples are stored in their original order by all of them
+    out << "using t_ind = HashSet<" << arity << ">;\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        std::vector<uint32_t> key(inds[i].begin(), inds[i].end());
+        if (i < getMinIndexSelection().getAllOrders().size()) {
+            indexToNumMap[getMinIndexSelection().getAllOrders()[i]] = i;
+            key.resize(getMinIndexSelection().getKeySize(i));
+        }
+        out << "t_ind ind_" << i << "{std::vector<std::size_t>{" << join(key, ",") << "}};\n";
+    }
+    out << "using t_tuple = t_ind::element_type;\n";
+    out << "using iterator = t_ind::iterator;\n";
+
+    // hints struct; hash sets do not use any hints
+    out << "struct context {};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "if (ind_" << masterIndex << ".insert(t)) {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (i != masterIndex) {
+            out << "ind_" << i << ".insert(t);\n";
+        }
+    }
+    out << "return true;\n";
+    out << "} else return false;\n";
+    out << "}\n";
+
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "return insert(t);\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "return insert(tuple);\n";
+    out << "}\n";
+
+    // insert method
+    std::vector<std::string> decls;
+    std::vector<std::string> params;
+    for (size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\nRamDomain data[";
+    out << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";
+
+    // insertAll method for relations of any type, inserting tuple by tuple
+    generateTupleInsertAll(out, false);
+
+    // insertAll method for relations of the same type, merging the hash sets in bulk
+    out << "void insertAll(const " << getTypeName() << "& other) {\n";
+    generateIndexMerge(out, numIndexes);
+    out << "}\n";
+
+    // contains methods
+    out << "bool contains(const t_tuple& t, context& h) const {\n";
+    out << "return ind_" << masterIndex << ".contains(t);\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "return ind_" << masterIndex << ".contains(t);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return ind_" << masterIndex << ".size();\n";
+    out << "}\n";
+
+    // empty lowerUpperRange method
+    out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper, context& h) const "
+           "{\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    // lowerUpperRange methods, following the chain of the key of the bound attributes
+    for (auto search : getMinIndexSelection().getSearches()) {
+        auto& lexOrder = getMinIndexSelection().getLexOrder(search);
+        size_t indNum = indexToNumMap[lexOrder];
+
+        // bitset literals list the attributes from the highest to the lowest
+        std::string attributes;
+        for (size_t i = arity; i-- > 0;) {
+            assert(search[i] != analysis::AttributeConstraint::Inequal && "hash sets are not ordered");
+            attributes += search[i] == analysis::AttributeConstraint::Equal ? '1' : '0';
+        }
+
+        out << "range<t_ind::equal_iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+        out << "static const t_ind::attribute_set attributes(\"" << attributes << "\");\n";
+        out << "return ind_" << indNum << ".equalRange(lower, attributes);\n";
+        out << "}\n";
+
+        out << "range<t_ind::equal_iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
+        out << "context h; return lowerUpperRange_" << search << "(lower,upper, h);\n";
+        out << "}\n";
+    }
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "}\n";
+
+    // partition method
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return ind_" << masterIndex << ".partition(400);\n";
+    out << "}\n";
+
+    // purge method
+    out << "void purge() {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".clear();\n";
+    }
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return ind_" << masterIndex << ".end();\n";
+    out << "}\n";
+
+    // printStatistics method
+    out << "void printStatistics(std::ostream& o) const {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "o << \" arity " << arity << " hashset index " << i << " lex-order " << inds[i] << "\\n\";\n";
+        out << "ind_" << i << ".printStats(o);\n";
+    }
+    out << "}\n";
+
+    // end class
+    out << "};\n";
+}
+
 // -------- Eqrel Relation --------
 
 /** Generate index set for a eqrel relation */
@@ -1211,6 +1732,14 @@ void EqrelRelation::generateTypeStruct(std::ostream& out) {
     out << "return insert(data);\n";
     out << "}\n";
 
+    // insertAll method for relations of any type, inserting tuple by tuple
+    generateTupleInsertAll(out, true);
+
+    // insertAll method for relations of the same type, merging the equivalence classes in bulk
+    out << "void insertAll(const " << getTypeName() << "& other) {\n";
+    out << "ind_" << masterIndex << ".insertAll(other.ind_" << masterIndex << ");\n";
+    out << "}\n";
+
     // extends method for eqrel
     // performs a delta extension, where we union the sets that share elements between this and other.
     //      i.e. if a in this, and a in other, union(set(this->a), set(other->a))
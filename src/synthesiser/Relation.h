@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "RelationTag.h"
 #include "ram/Relation.h"
 #include "ram/analysis/Index.h"
 #include <cstddef>
@@ -75,8 +76,8 @@ public:
     virtual void generateTypeStruct(std::ostream& out) = 0;
 
     /** Factory method to generate a SynthesiserRelation */
-    static Own<Relation> getSynthesiserRelation(
-            const ram::Relation& ramRel, const MinIndexSelection& indexSet, bool isProvenance);
+    static Own<Relation> getSynthesiserRelation(const ram::Relation& ramRel,
+            const MinIndexSelection& indexSet, RelationRepresentation representation, bool isProvenance);
 
 protected:
     /** Ram relation referred to by this */
@@ -129,6 +130,29 @@ public:
     void computeIndices() override;
     std::string getTypeName() override;
     void generateTypeStruct(std::ostream& out) override;
+
+    /** Tests whether the ranges of the given search are counted through the sub-tree sizes of its index */
+    bool countsRange(const ram::analysis::SearchSignature& search) const;
+
+    /** Tests whether relations of this type may defer the maintenance of their secondary indexes */
+    bool hasDeferrableIndexes() const {
+        return deferrableIndexes;
+    }
+
+    /** Tests whether the given search is answered by a secondary index which may be deferred */
+    bool searchesDeferrableIndex(const ram::analysis::SearchSignature& search) const;
+
+    /** Tests whether relations of this type may maintain a Bloom filter of their tuples */
+    bool hasFilterSupport() const {
+        return filterSupport;
+    }
+
+private:
+    /** Whether the secondary indexes may be built when first searched instead of maintained by inserts */
+    bool deferrableIndexes = false;
+
+    /** Whether a Bloom filter may be enabled, consulted by existence checks */
+    bool filterSupport = false;
 };
 
 class IndirectRelation : public Relation {
@@ -151,6 +175,16 @@ public:
     void generateTypeStruct(std::ostream& out) override;
 };
 
+class HashsetRelation : public Relation {
+public:
+    HashsetRelation(const ram::Relation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : Relation(ramRel, indexSet, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+};
+
 class EqrelRelation : public Relation {
 public:
     EqrelRelation(const ram::Relation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
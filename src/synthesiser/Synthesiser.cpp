@@ -19,6 +19,7 @@
 #include "FunctorOps.h"
 #include "Global.h"
 #include "RelationTag.h"
+#include "ram/AbstractExistenceCheck.h"
 #include "ram/AbstractParallel.h"
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
@@ -37,16 +38,21 @@
 #include "ram/Extend.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Freeze.h"
 #include "ram/FloatConstant.h"
 #include "ram/IO.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexChoice.h"
+#include "ram/IndexCount.h"
+#include "ram/IndexIntersection.h"
+#include "ram/IndexMinMax.h"
 #include "ram/IndexScan.h"
 #include "ram/IntrinsicOperator.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
+#include "ram/Merge.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
@@ -70,6 +76,7 @@
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
+#include "ram/Spill.h"
 #include "ram/Statement.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -84,6 +91,7 @@
 #include "ram/UserDefinedOperator.h"
 #include "ram/Utils.h"
 #include "ram/Visitor.h"
+#include "ram/analysis/BloomFilter.h"
 #include "ram/analysis/Index.h"
 #include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
@@ -105,6 +113,7 @@
 #include <iterator>
 #include <limits>
 #include <map>
+#include <set>
 #include <sstream>
 #include <tuple>
 #include <type_traits>
@@ -115,6 +124,7 @@
 namespace souffle::synthesiser {
 
 using json11::Json;
+using ram::analysis::BloomFilterAnalysis;
 using ram::analysis::IndexAnalysis;
 using namespace ram;
 
@@ -211,6 +221,10 @@ std::set<const ram::Relation*> Synthesiser::getReferencedRelations(const Operati
             res.insert(&provExists->getRelation());
         } else if (auto project = dynamic_cast<const Project*>(&node)) {
             res.insert(&project->getRelation());
+        } else if (auto intersection = dynamic_cast<const IndexIntersection*>(&node)) {
+            for (size_t i = 0; i < intersection->getNumInputs(); ++i) {
+                res.insert(&intersection->getRelation(i));
+            }
         }
     });
     return res;
@@ -221,6 +235,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
     private:
         Synthesiser& synthesiser;
         IndexAnalysis* const isa = synthesiser.getTranslationUnit().getAnalysis<IndexAnalysis>();
+        BloomFilterAnalysis* const bfa = synthesiser.getTranslationUnit().getAnalysis<BloomFilterAnalysis>();
 
 // macros to add comments to generated code for debugging
 #ifndef PRINT_BEGIN_COMMENT
@@ -242,6 +257,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
         std::ostringstream preamble;
         bool preambleIssued = false;
 
+        // relations the threads of the current query insert into via buffers of their own
+        std::set<const ram::Relation*> bufferedRelations;
+
     public:
         CodeEmitter(Synthesiser& syn) : synthesiser(syn) {
             rec = [&](auto& out, const auto* value) {
@@ -317,6 +335,19 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             return std::make_pair(std::move(low), std::move(high));
         }
 
+        // tests whether an existence check consults the Bloom filter of its relation before searching it;
+        // only direct b-tree relations maintain filters
+        bool consultsFilter(const AbstractExistenceCheck& exists) {
+            if (!bfa->isFiltered(exists)) {
+                return false;
+            }
+            const auto& rel = exists.getRelation();
+            auto relationType = Relation::getSynthesiserRelation(rel, isa->getIndexes(rel),
+                    isa->getRepresentation(rel), Global::config().has("provenance"));
+            const auto* direct = dynamic_cast<const DirectRelation*>(relationType.get());
+            return direct != nullptr && direct->hasFilterSupport();
+        }
+
         // -- relation statements --
 
         void visitIO(const IO& io, std::ostream& out) override {
@@ -412,6 +443,31 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             // enclose operation in its own scope
             out << "{\n";
 
+            // build the deferred indexes searched by this operation before it runs
+            std::set<const ram::Relation*> searched;
+            auto buildIndexes = [&](const ram::Relation& rel, const analysis::SearchSignature& search) {
+                auto relationType = Relation::getSynthesiserRelation(rel, isa->getIndexes(rel),
+                        isa->getRepresentation(rel), Global::config().has("provenance"));
+                const auto* direct = dynamic_cast<const DirectRelation*>(relationType.get());
+                if (rel.isTemp() && direct != nullptr && direct->searchesDeferrableIndex(search) &&
+                        searched.insert(&rel).second) {
+                    out << synthesiser.getRelationName(rel) << "->buildIndexes();\n";
+                }
+            };
+            visitDepthFirst(query.getOperation(), [&](const IndexOperation& op) {
+                buildIndexes(op.getRelation(), isa->getSearchSignature(&op));
+            });
+            visitDepthFirst(query.getOperation(), [&](const ExistenceCheck& exists) {
+                if (!isa->isTotalSignature(&exists)) {
+                    buildIndexes(exists.getRelation(), isa->getSearchSignature(&exists));
+                }
+            });
+            visitDepthFirst(query.getOperation(), [&](const IndexIntersection& intersection) {
+                for (size_t i = 0; i < intersection.getNumInputs(); ++i) {
+                    buildIndexes(intersection.getRelation(i), isa->getSearchSignature(&intersection, i));
+                }
+            });
+
             // check whether loop nest can be parallelized
             bool isParallel = false;
             visitDepthFirst(*next, [&](const AbstractParallel&) { isParallel = true; });
@@ -428,6 +484,37 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 preamble << "->createContext());\n";
             }
 
+            // let the threads of a parallel query buffer the tuples projected into relations the
+            // query does not read, merged into the relations once the query has finished
+            bufferedRelations.clear();
+            if (isParallel && Global::config().has("buffered-inserts")) {
+                std::set<const ram::Relation*> read;
+                visitDepthFirst(*next, [&](const Node& node) {
+                    if (auto scan = dynamic_cast<const RelationOperation*>(&node)) {
+                        read.insert(&scan->getRelation());
+                    } else if (auto exists = dynamic_cast<const AbstractExistenceCheck*>(&node)) {
+                        read.insert(&exists->getRelation());
+                    } else if (auto emptiness = dynamic_cast<const EmptinessCheck*>(&node)) {
+                        read.insert(&emptiness->getRelation());
+                    } else if (auto size = dynamic_cast<const RelationSize*>(&node)) {
+                        read.insert(&size->getRelation());
+                    } else if (auto intersection = dynamic_cast<const IndexIntersection*>(&node)) {
+                        for (size_t i = 0; i < intersection->getNumInputs(); ++i) {
+                            read.insert(&intersection->getRelation(i));
+                        }
+                    }
+                });
+                visitDepthFirst(*next, [&](const Project& project) {
+                    const ram::Relation* rel = &project.getRelation();
+                    if (rel->getArity() > 0 && !contains(read, rel) && bufferedRelations.insert(rel).second) {
+                        const auto& relName = synthesiser.getRelationName(*rel);
+                        out << "InsertBuffer<Tuple<RamDomain," << rel->getArity() << ">> " << relName
+                            << "_buffer;\n";
+                        preamble << "auto& " << relName << "_tuples = " << relName << "_buffer.local();\n";
+                    }
+                });
+            }
+
             // discharge conditions that require a context
             if (isParallel) {
                 if (requireCtx.size() > 0) {
@@ -456,6 +543,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "PARALLEL_END\n";  // end parallel
             }
 
+            // merge the buffered tuples into their relations
+            for (const ram::Relation* rel : bufferedRelations) {
+                const auto& relName = synthesiser.getRelationName(*rel);
+                out << relName << "_buffer.flush(*" << relName << ");\n";
+            }
+
             out << "}\n";
             out << "();";  // call lambda
 
@@ -478,6 +571,32 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitFreeze(const Freeze&, std::ostream& out) override {
+            // the types of the indexes of synthesised relations are fixed, hence they remain b-trees
+            PRINT_BEGIN_COMMENT(out);
+            PRINT_END_COMMENT(out);
+        }
+
+        void visitSpill(const Spill& spill, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+
+            // only the b-tree indexes of direct and indirect relations are spilled
+            const std::string limit =
+                    Global::config().has("memory-limit") ? Global::config().get("memory-limit") : "0";
+            for (const auto* rel : spill.getRelations()) {
+                auto relationType = Relation::getSynthesiserRelation(*rel, isa->getIndexes(*rel),
+                        isa->getRepresentation(*rel), Global::config().has("provenance"));
+                if (dynamic_cast<const DirectRelation*>(relationType.get()) == nullptr &&
+                        dynamic_cast<const IndirectRelation*>(relationType.get()) == nullptr) {
+                    continue;
+                }
+                out << "if (getResidentMemory() > " << limit << "ULL) ";
+                out << synthesiser.getRelationName(*rel) << "->spill();\n";
+            }
+
+            PRINT_END_COMMENT(out);
+        }
+
         void visitLogSize(const LogSize& size, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             out << "ProfileEventSingleton::instance().makeQuantityEvent( R\"(";
@@ -558,6 +677,14 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitMerge(const Merge& merge, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            out << synthesiser.getRelationName(merge.getTargetRelation()) << "->"
+                << "insertAll("
+                << "*" << synthesiser.getRelationName(merge.getSourceRelation()) << ");\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visitExit(const Exit& exit, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             out << "if(";
@@ -1276,6 +1403,193 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitIndexCount(const IndexCount& count, std::ostream& out) override {
+            const auto& rel = count.getRelation();
+            auto keys = isa->getSearchSignature(&count);
+
+            // only b-tree relations with counted indexes provide the size of a range
+            bool isProvInfo = rel.getRepresentation() == RelationRepresentation::INFO;
+            auto relationType = Relation::getSynthesiserRelation(rel, isa->getIndexes(rel),
+                    isa->getRepresentation(rel), Global::config().has("provenance") && !isProvInfo);
+            const auto* direct = dynamic_cast<const DirectRelation*>(relationType.get());
+            if (keys.empty() || direct == nullptr || !direct->countsRange(keys)) {
+                visitIndexAggregate(count, out);
+                return;
+            }
+
+            PRINT_BEGIN_COMMENT(out);
+            auto relName = synthesiser.getRelationName(rel);
+            auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
+            auto identifier = count.getTupleId();
+
+            // declare environment variable
+            out << "Tuple<RamDomain,1> env" << identifier << ";\n";
+
+            // count the tuples of the range through the index
+            const auto& rangePatternLower = count.getRangePattern().first;
+            const auto& rangePatternUpper = count.getRangePattern().second;
+            auto rangeBounds = getPaddedRangeBounds(rel, rangePatternLower, rangePatternUpper);
+            out << "env" << identifier << "[0] = " << relName << "->"
+                << "countRange_" << keys << "(" << rangeBounds.first.str() << ","
+                << rangeBounds.second.str() << "," << ctxName << ");\n";
+            visitTupleOperation(count, out);
+            PRINT_END_COMMENT(out);
+        }
+
+        void visitIndexMinMax(const IndexMinMax& minMax, std::ostream& out) override {
+            const auto& rel = minMax.getRelation();
+            auto keys = isa->getSearchSignature(&minMax);
+
+            // only b-tree relations ordered by the aggregated attribute after the bound ones qualify
+            bool isProvInfo = rel.getRepresentation() == RelationRepresentation::INFO;
+            auto relationType = Relation::getSynthesiserRelation(rel, isa->getIndexes(rel),
+                    isa->getRepresentation(rel), Global::config().has("provenance") && !isProvInfo);
+            size_t bound = 0;
+            for (size_t i = 0; i < keys.arity(); ++i) {
+                if (keys[i] == analysis::AttributeConstraint::Equal) {
+                    ++bound;
+                }
+            }
+            const auto& lexOrder = isa->getIndexes(rel).getLexOrder(keys);
+            if (keys.empty() || !isA<DirectRelation>(relationType.get()) || lexOrder.size() <= bound ||
+                    lexOrder[bound] != minMax.getColumn()) {
+                visitIndexAggregate(minMax, out);
+                return;
+            }
+
+            PRINT_BEGIN_COMMENT(out);
+            auto relName = synthesiser.getRelationName(rel);
+            auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
+            auto identifier = minMax.getTupleId();
+
+            // declare environment variable and the tuple holding the boundary of the range
+            out << "Tuple<RamDomain,1> env" << identifier << ";\n";
+            out << "Tuple<RamDomain," << rel.getArity() << "> boundary" << identifier << ";\n";
+
+            // take the minimum or maximum from the first or last tuple of the range
+            const auto& rangePatternLower = minMax.getRangePattern().first;
+            const auto& rangePatternUpper = minMax.getRangePattern().second;
+            auto rangeBounds = getPaddedRangeBounds(rel, rangePatternLower, rangePatternUpper);
+            out << "if (" << relName << "->"
+                << "boundary_" << keys << "(" << rangeBounds.first.str() << "," << rangeBounds.second.str()
+                << "," << (minMax.isLast() ? "true" : "false") << ",boundary" << identifier << ","
+                << ctxName << ")) {\n";
+            out << "env" << identifier << "[0] = boundary" << identifier << "[" << minMax.getColumn()
+                << "];\n";
+            visitTupleOperation(minMax, out);
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
+        void visitIndexIntersection(const IndexIntersection& intersection, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            auto identifier = intersection.getTupleId();
+            auto id = std::to_string(identifier);
+            size_t numInputs = intersection.getNumInputs();
+
+            // whether the index searched by an input orders the attribute after the bound ones, such that
+            // values are leapfrogged over through the b-tree
+            auto isOrdered = [&](size_t i) {
+                const auto& rel = intersection.getRelation(i);
+                auto keys = isa->getSearchSignature(&intersection, i);
+                auto relationType = Relation::getSynthesiserRelation(rel, isa->getIndexes(rel),
+                        isa->getRepresentation(rel), Global::config().has("provenance"));
+                size_t bound = 0;
+                for (size_t j = 0; j < keys.arity(); ++j) {
+                    if (keys[j] == analysis::AttributeConstraint::Equal) {
+                        ++bound;
+                    }
+                }
+                const auto& lexOrder = isa->getIndexes(rel).getLexOrder(keys);
+                return isA<DirectRelation>(relationType.get()) && lexOrder.size() > bound &&
+                       lexOrder[bound] == intersection.getColumn(i);
+            };
+
+            // declare environment variable and the bounds of the ranges of the inputs
+            out << "Tuple<RamDomain,1> env" << id << "{{MIN_RAM_SIGNED}};\n";
+            for (size_t i = 0; i < numInputs; ++i) {
+                const auto& rel = intersection.getRelation(i);
+                auto input = id + "_" + std::to_string(i);
+                auto rangeBounds = getPaddedRangeBounds(
+                        rel, intersection.getRangePattern(i).first, intersection.getRangePattern(i).second);
+                out << "auto lower" << input << " = " << rangeBounds.first.str() << ";\n";
+                out << "auto upper" << input << " = " << rangeBounds.second.str() << ";\n";
+                if (isOrdered(i)) {
+                    continue;
+                }
+
+                // collect the values of the attribute in the range once, in ascending order without duplicates
+                auto relName = synthesiser.getRelationName(rel);
+                auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
+                auto keys = isa->getSearchSignature(&intersection, i);
+                out << "std::vector<RamDomain> values" << input << ";\n";
+                out << "for (const auto& cur : " << relName << "->lowerUpperRange_" << keys << "(lower"
+                    << input << ",upper" << input << "," << ctxName << ")) {\n";
+                out << "values" << input << ".push_back(cur[" << intersection.getColumn(i) << "]);\n";
+                out << "}\n";
+                out << "std::sort(values" << input << ".begin(), values" << input << ".end());\n";
+                out << "values" << input << ".erase(std::unique(values" << input << ".begin(), values" << input
+                    << ".end()), values" << input << ".end());\n";
+                out << "auto position" << input << " = values" << input << ".begin();\n";
+            }
+
+            // leapfrog over the inputs until all of them agree on a value
+            out << "std::size_t agreed" << id << " = 0;\n";
+            out << "for (std::size_t input" << id << " = 0;; input" << id << " = (input" << id << " + 1) % "
+                << numInputs << ") {\n";
+            out << "bool found" << id << " = false;\n";
+            out << "RamDomain next" << id << " = 0;\n";
+            out << "switch (input" << id << ") {\n";
+            for (size_t i = 0; i < numInputs; ++i) {
+                const auto& rel = intersection.getRelation(i);
+                auto relName = synthesiser.getRelationName(rel);
+                auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
+                auto keys = isa->getSearchSignature(&intersection, i);
+                auto column = intersection.getColumn(i);
+                auto input = id + "_" + std::to_string(i);
+                auto bounds = "lower" + input + ",upper" + input;
+
+                // seek the least value not below the current one in b-trees ordering the attribute
+                // after the bound ones, or among the collected values otherwise; as the values sought
+                // never decrease, the latter search resumes from the last position
+                out << "case " << i << ": {\n";
+                if (isOrdered(i)) {
+                    out << "lower" << input << "[" << column << "] = env" << id << "[0];\n";
+                    out << "Tuple<RamDomain," << rel.getArity() << "> boundary;\n";
+                    out << "if (" << relName << "->boundary_" << keys << "(" << bounds
+                        << ",false,boundary," << ctxName << ")) {\n";
+                    out << "found" << id << " = true;\n";
+                    out << "next" << id << " = boundary[" << column << "];\n";
+                    out << "}\n";
+                } else {
+                    out << "position" << input << " = std::lower_bound(position" << input << ", values" << input
+                        << ".end(), env" << id << "[0]);\n";
+                    out << "if (position" << input << " != values" << input << ".end()) {\n";
+                    out << "found" << id << " = true;\n";
+                    out << "next" << id << " = *position" << input << ";\n";
+                    out << "}\n";
+                }
+                out << "break;\n";
+                out << "}\n";
+            }
+            out << "}\n";
+            out << "if (!found" << id << ") break;\n";
+            out << "if (next" << id << " == env" << id << "[0]) {\n";
+            out << "++agreed" << id << ";\n";
+            out << "} else {\n";
+            out << "env" << id << "[0] = next" << id << ";\n";
+            out << "agreed" << id << " = 1;\n";
+            out << "}\n";
+            out << "if (agreed" << id << " == " << numInputs << ") {\n";
+            visitTupleOperation(intersection, out);
+            out << "if (env" << id << "[0] == MAX_RAM_SIGNED) break;\n";
+            out << "++env" << id << "[0];\n";
+            out << "agreed" << id << " = 0;\n";
+            out << "}\n";
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visitParallelAggregate(const ParallelAggregate& aggregate, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             // get some properties
@@ -1611,9 +1925,13 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "Tuple<RamDomain," << arity << "> tuple{{" << join(project.getValues(), ",", rec)
                 << "}};\n";
 
-            // insert tuple
-            out << relName << "->"
-                << "insert(tuple," << ctxName << ");\n";
+            // insert tuple, or collect it in the buffer of the thread
+            if (contains(bufferedRelations, &rel)) {
+                out << relName << "_tuples.push_back(tuple);\n";
+            } else {
+                out << relName << "->"
+                    << "insert(tuple," << ctxName << ");\n";
+            }
 
             PRINT_END_COMMENT(out);
         }
@@ -1691,35 +2009,35 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
                 // strings
                 case BinaryConstraintOp::MATCH: {
-                    out << "regex_wrapper(symTable.resolve(";
+                    out << "patternCache.match(";
                     visit(rel.getLHS(), out);
-                    out << "),symTable.resolve(";
+                    out << ",";
                     visit(rel.getRHS(), out);
-                    out << "))";
+                    out << ")";
                     break;
                 }
                 case BinaryConstraintOp::NOT_MATCH: {
-                    out << "!regex_wrapper(symTable.resolve(";
+                    out << "patternCache.notMatch(";
                     visit(rel.getLHS(), out);
-                    out << "),symTable.resolve(";
+                    out << ",";
                     visit(rel.getRHS(), out);
-                    out << "))";
+                    out << ")";
                     break;
                 }
                 case BinaryConstraintOp::CONTAINS: {
-                    out << "(symTable.resolve(";
-                    visit(rel.getRHS(), out);
-                    out << ").find(symTable.resolve(";
+                    out << "patternCache.contains(";
                     visit(rel.getLHS(), out);
-                    out << ")) != std::string::npos)";
+                    out << ",";
+                    visit(rel.getRHS(), out);
+                    out << ")";
                     break;
                 }
                 case BinaryConstraintOp::NOT_CONTAINS: {
-                    out << "(symTable.resolve(";
-                    visit(rel.getRHS(), out);
-                    out << ").find(symTable.resolve(";
+                    out << "!patternCache.contains(";
                     visit(rel.getLHS(), out);
-                    out << ")) == std::string::npos)";
+                    out << ",";
+                    visit(rel.getRHS(), out);
+                    out << ")";
                     break;
                 }
             }
@@ -1761,11 +2079,21 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 after = ")";
             }
 
+            // tuples the Bloom filter rules out need not be searched for
+            bool filtered = consultsFilter(exists);
+            if (filtered) {
+                after = ")" + after;
+            }
+
             // if it is total we use the contains function
             if (isa->isTotalSignature(&exists)) {
+                std::stringstream tuple;
+                tuple << "Tuple<RamDomain," << arity << ">{{" << join(exists.getValues(), ",", rec) << "}}";
+                if (filtered) {
+                    out << "(" << relName << "->mayContain(" << tuple.str() << ") && ";
+                }
                 out << relName << "->"
-                    << "contains(Tuple<RamDomain," << arity << ">{{" << join(exists.getValues(), ",", rec)
-                    << "}}," << ctxName << ")" << after;
+                    << "contains(" << tuple.str() << "," << ctxName << ")" << after;
                 PRINT_END_COMMENT(out);
                 return;
             }
@@ -1774,6 +2102,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             auto rangePatternUpper = exists.getValues();
 
             auto rangeBounds = getPaddedRangeBounds(rel, rangePatternLower, rangePatternUpper);
+            if (filtered) {
+                out << "(" << relName << "->mayContain(" << rangeBounds.first.str() << ") && ";
+            }
             // else we conduct a range query
             out << "!" << relName << "->"
                 << "lowerUpperRange";
@@ -1793,12 +2124,6 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             auto arity = rel.getArity();
             auto auxiliaryArity = rel.getAuxiliaryArity();
 
-            // provenance not exists is never total, conduct a range query
-            out << "[&]() -> bool {\n";
-            out << "auto existenceCheck = " << relName << "->"
-                << "lowerUpperRange";
-            out << "_" << isa->getSearchSignature(&provExists);
-
             // parts refers to payload + rule number
             size_t parts = arity - auxiliaryArity + 1;
 
@@ -1827,6 +2152,16 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             rangeBounds.first << ",ramBitCast<RamDomain, RamSigned>(MIN_RAM_SIGNED)}}";
             rangeBounds.second << ",ramBitCast<RamDomain, RamSigned>(MAX_RAM_SIGNED)}}";
 
+            // provenance not exists is never total, conduct a range query
+            out << "[&]() -> bool {\n";
+            // tuples the Bloom filter rules out need not be searched for
+            if (consultsFilter(provExists)) {
+                out << "if (!" << relName << "->mayContain(" << rangeBounds.first.str()
+                    << ")) return false;\n";
+            }
+            out << "auto existenceCheck = " << relName << "->"
+                << "lowerUpperRange";
+            out << "_" << isa->getSearchSignature(&provExists);
             out << "(" << rangeBounds.first.str() << "," << rangeBounds.second.str() << "," << ctxName
                 << ");\n";
             out << "if (existenceCheck.empty()) return false; else return ((*existenceCheck.begin())["
@@ -2232,6 +2567,7 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     const SymbolTable& symTable = translationUnit.getSymbolTable();
     const Program& prog = translationUnit.getProgram();
     auto* idxAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+    auto* filterAnalysis = translationUnit.getAnalysis<BloomFilterAnalysis>();
     // ---------------------------------------------------------------
     //                      Code Generation
     // ---------------------------------------------------------------
@@ -2306,8 +2642,8 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     // synthesise data-structures for relations
     for (auto rel : prog.getRelations()) {
         bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
-        auto relationType = Relation::getSynthesiserRelation(
-                *rel, idxAnalysis->getIndexes(*rel), Global::config().has("provenance") && !isProvInfo);
+        auto relationType = Relation::getSynthesiserRelation(*rel, idxAnalysis->getIndexes(*rel),
+                idxAnalysis->getRepresentation(*rel), Global::config().has("provenance") && !isProvInfo);
 
         generateRelationTypeStruct(os, std::move(relationType));
     }
@@ -2315,16 +2651,6 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
 
     os << "class " << classname << " : public SouffleProgram {\n";
 
-    // regex wrapper
-    os << "private:\n";
-    os << "static inline bool regex_wrapper(const std::string& pattern, const std::string& text) {\n";
-    os << "   bool result = false; \n";
-    os << "   try { result = std::regex_match(text, std::regex(pattern)); } catch(...) { \n";
-    os << "     std::cerr << \"warning: wrong pattern provided for match(\\\"\" << pattern << \"\\\",\\\"\" "
-          "<< text << \"\\\").\\n\";\n}\n";
-    os << "   return result;\n";
-    os << "}\n";
-
     // substring wrapper
     os << "private:\n";
     os << "static inline std::string substr_wrapper(const std::string& str, size_t idx, size_t len) {\n";
@@ -2361,6 +2687,10 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     os << "RecordTable recordTable;"
        << "\n";
 
+    // declare pattern cache
+    os << "// -- initialize pattern cache --\n";
+    os << "PatternCache patternCache{symTable};\n";
+
     if (Global::config().has("profile")) {
         os << "private:\n";
         size_t numFreq = 0;
@@ -2406,14 +2736,23 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         const std::string& cppName = getRelationName(*rel);
 
         bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
-        auto relationType = Relation::getSynthesiserRelation(
-                *rel, idxAnalysis->getIndexes(*rel), Global::config().has("provenance") && !isProvInfo);
+        auto relationType = Relation::getSynthesiserRelation(*rel, idxAnalysis->getIndexes(*rel),
+                idxAnalysis->getRepresentation(*rel), Global::config().has("provenance") && !isProvInfo);
         const std::string& type = relationType->getTypeName();
 
         // defining table
         os << "// -- Table: " << datalogName << "\n";
 
         os << "Own<" << type << "> " << cppName << " = mk<" << type << ">();\n";
+        // the secondary indexes of temporary relations are mostly read after they are filled
+        const auto* direct = dynamic_cast<const DirectRelation*>(relationType.get());
+        if (rel->isTemp() && direct != nullptr && direct->hasDeferrableIndexes()) {
+            registerRel += cppName + "->deferIndexes();\n";
+        }
+        if (direct != nullptr && direct->hasFilterSupport() && filterAnalysis->hasFilter(*rel)) {
+            registerRel +=
+                    cppName + "->enableFilter(" + std::to_string(filterAnalysis->getCapacity(*rel)) + ");\n";
+        }
         if (!rel->isTemp()) {
             os << "souffle::RelationWrapper<";
             os << relCtr++ << ",";
@@ -2476,6 +2815,20 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         os << "ProfileEventSingleton::instance().setOutputFile(profiling_fname);\n";
     }
     os << registerRel;
+    // compile constant patterns of match constraints ahead of evaluation
+    std::set<RamDomain> patterns;
+    visitDepthFirst(prog, [&](const Constraint& constraint) {
+        auto op = constraint.getOperator();
+        if (op != BinaryConstraintOp::MATCH && op != BinaryConstraintOp::NOT_MATCH) {
+            return;
+        }
+        if (const auto* pattern = dynamic_cast<const SignedConstant*>(&constraint.getLHS())) {
+            patterns.insert(pattern->getConstant());
+        }
+    });
+    for (RamDomain pattern : patterns) {
+        os << "patternCache.pin(" << pattern << ");\n";
+    }
     os << "}\n";
     // -- destructor --
 
@@ -570,6 +570,47 @@ TEST(EqRelTest, ParallelScaling) {
         throw std::runtime_error("here's a gdb trap");
     }
 }
+
+TEST(EqRelTest, ParallelUnion) {
+    // join elements into classes by their residue in parallel, the size follows without enumeration
+    const int N = 10000;
+    const int M = 13;
+    EqRel br;
+#pragma omp parallel for
+    for (int i = M; i < N; i++) {
+        br.insert(i, (i * 31) % (i / M) * M + i % M);
+    }
+
+    size_t expected = 0;
+    for (int r = 0; r < M; r++) {
+        size_t classSize = (N - r + M - 1) / M;
+        expected += classSize * classSize;
+    }
+    EXPECT_EQ(expected, br.size());
+
+    // the iteration and the partitions cover the same pairs
+    size_t count = 0;
+    for (auto x : br) {
+        EXPECT_EQ(x[0] % M, x[1] % M);
+        ++count;
+    }
+    EXPECT_EQ(expected, count);
+
+    count = 0;
+    for (auto chunk : br.partition(100)) {
+        for (auto x : chunk) {
+            testutil::ignore(x);
+            ++count;
+        }
+    }
+    EXPECT_EQ(expected, count);
+
+    // merging into another relation keeps the classes
+    EqRel other;
+    other.insertAll(br);
+    EXPECT_EQ(expected, other.size());
+    EXPECT_TRUE(other.contains(M + 1, N - N % M + 1));
+}
 #endif
 
 }  // namespace test
@@ -0,0 +1,96 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file bloom_filter_test.cpp
+ *
+ * A test case testing the Bloom filter implementation.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/BloomFilter.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace souffle {
+
+namespace test {
+
+uint64_t hashOf(RamDomain a, RamDomain b) {
+    RamDomain values[] = {a, b};
+    return BloomFilter::hash(values, 2);
+}
+
+TEST(BloomFilter, Basic) {
+    BloomFilter filter;
+    EXPECT_EQ(0, filter.size());
+    EXPECT_FALSE(filter.mayContain(hashOf(1, 2)));
+
+    filter.insert(hashOf(1, 2));
+    filter.insert(hashOf(2, 1));
+    EXPECT_EQ(2, filter.size());
+    EXPECT_TRUE(filter.mayContain(hashOf(1, 2)));
+    EXPECT_TRUE(filter.mayContain(hashOf(2, 1)));
+    EXPECT_FALSE(filter.mayContain(hashOf(2, 2)));
+
+    filter.clear();
+    EXPECT_EQ(0, filter.size());
+    EXPECT_FALSE(filter.mayContain(hashOf(1, 2)));
+}
+
+TEST(BloomFilter, Growth) {
+    // the filter grows far beyond its initial capacity
+    BloomFilter filter(100);
+    const RamDomain N = 100000;
+    for (RamDomain i = 0; i < N; ++i) {
+        filter.insert(hashOf(i, i % 7));
+    }
+    EXPECT_EQ(N, filter.size());
+
+    // no false negatives
+    for (RamDomain i = 0; i < N; ++i) {
+        EXPECT_TRUE(filter.mayContain(hashOf(i, i % 7)));
+    }
+
+    // few false positives
+    std::size_t positives = 0;
+    for (RamDomain i = 0; i < N; ++i) {
+        positives += filter.mayContain(hashOf(i, i % 7 + 7)) ? 1 : 0;
+    }
+    EXPECT_LT(positives, N / 20);
+
+    // once cleared, the filter is sized for its previous content
+    filter.clear();
+    EXPECT_EQ(0, filter.size());
+    for (RamDomain i = 0; i < N; ++i) {
+        filter.insert(hashOf(i, 0));
+    }
+    for (RamDomain i = 0; i < N; ++i) {
+        EXPECT_TRUE(filter.mayContain(hashOf(i, 0)));
+    }
+}
+
+TEST(BloomFilter, ParallelInsert) {
+    BloomFilter filter;
+    const RamDomain N = 100000;
+#pragma omp parallel for
+    for (RamDomain i = 0; i < N; ++i) {
+        filter.insert(hashOf(i, -i));
+    }
+    EXPECT_EQ(N, filter.size());
+    for (RamDomain i = 0; i < N; ++i) {
+        EXPECT_TRUE(filter.mayContain(hashOf(i, -i)));
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
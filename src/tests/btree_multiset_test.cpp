@@ -16,9 +16,11 @@
 
 #include "tests/test.h"
 
+#include "souffle/CompiledTuple.h"
 #include "souffle/datastructure/BTree.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <iomanip>
@@ -365,6 +367,27 @@ TEST(BTreeMultiSet, Load) {
     }
 }
 
+TEST(BTreeMultiSet, InsertSortedBulk) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    for (int N = 0; N < 500; N += 7) {
+        // a sorted range with duplicates is appended, twice
+        std::vector<int> data;
+        for (int i = 0; i < N; i++) {
+            data.push_back(i / 3);
+        }
+        test_set t;
+        t.insertSortedBulk(data.begin(), data.end());
+        t.insertSortedBulk(data.begin(), data.end());
+        EXPECT_EQ(2 * data.size(), t.size());
+        EXPECT_TRUE(t.check());
+
+        std::multiset<int> should(data.begin(), data.end());
+        should.insert(data.begin(), data.end());
+        EXPECT_TRUE(std::equal(should.begin(), should.end(), t.begin()));
+    }
+}
+
 TEST(BTreeMultiSet, Clear) {
     using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -382,6 +405,82 @@ TEST(BTreeMultiSet, Clear) {
     EXPECT_TRUE(t.empty());
 }
 
+TEST(BTreeMultiSet, Rank) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16,
+            detail::default_strategy<int>::type, detail::comparator<int>, detail::updater<int>, true>;
+
+    // the difference of ranks is the number of duplicates
+    test_set t;
+    for (int i = 0; i < 1000; i++) {
+        t.insert(i % 37);
+        EXPECT_EQ(std::size_t(i / 37 + 1), t.rank(t.upper_bound(i % 37)) - t.rank(t.lower_bound(i % 37)));
+    }
+    EXPECT_EQ(1000, t.rank(t.end()));
+    EXPECT_EQ(0, t.rank(t.lower_bound(0)));
+    EXPECT_EQ(1000 - 27, t.rank(t.lower_bound(36)));
+}
+
+TEST(BTreeMultiSet, Predecessor) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    // the last of a group of duplicates precedes the upper bound of the group
+    test_set t;
+    for (int i = 0; i < 1000; i++) {
+        t.insert(2 * (i % 37));
+    }
+    for (int k = 0; k < 37; k++) {
+        auto last = t.predecessor(t.upper_bound(2 * k));
+        EXPECT_EQ(2 * k, *last);
+        EXPECT_EQ(t.upper_bound(2 * k), ++last);
+        EXPECT_EQ(2 * k, *t.predecessor(t.lower_bound(2 * k + 1)));
+    }
+    EXPECT_EQ(t.end(), t.predecessor(t.begin()));
+}
+
+TEST(BTreeMultiSet, SimdSearch) {
+    using Key = Tuple<int32_t, 2>;
+
+    // a comparator ordering tuples by their second component only
+    struct comparator {
+        int operator()(const Key& a, const Key& b) const {
+            return (a[1] < b[1]) ? -1 : ((a[1] > b[1]) ? 1 : 0);
+        }
+        bool less(const Key& a, const Key& b) const {
+            return a[1] < b[1];
+        }
+        bool equal(const Key& a, const Key& b) const {
+            return a[1] == b[1];
+        }
+    };
+    using test_set = btree_multiset<Key, comparator, std::allocator<Key>, 256, detail::simd_search<1>>;
+
+    test_set t;
+    std::vector<int> counts(100);
+    std::mt19937 generator(42);
+    for (int i = 0; i < 10000; ++i) {
+        int value = generator() % 100 - 50;
+        t.insert(Key{{i, value}});
+        counts[value + 50]++;
+    }
+    EXPECT_EQ(10000, t.size());
+    EXPECT_TRUE(t.check());
+
+    // the range of each value covers all of its occurrences
+    for (int value = -60; value < 60; ++value) {
+        Key key{{0, value}};
+        auto lower = t.lower_bound(key);
+        auto upper = t.upper_bound(key);
+        int count = 0;
+        for (auto it = lower; it != upper; ++it) {
+            EXPECT_EQ(value, (*it)[1]);
+            ++count;
+        }
+        bool known = -50 <= value && value < 50;
+        EXPECT_EQ(known ? counts[value + 50] : 0, count);
+        EXPECT_EQ(known && counts[value + 50] > 0, t.contains(key));
+    }
+}
+
 using Entry = std::tuple<int, int>;
 
 std::vector<Entry> getData(unsigned numEntries) {
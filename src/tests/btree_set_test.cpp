@@ -16,15 +16,18 @@
 
 #include "tests/test.h"
 
+#include "souffle/CompiledTuple.h"
 #include "souffle/datastructure/BTree.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <set>
@@ -484,6 +487,84 @@ TEST(BTreeSet, Load) {
     }
 }
 
+TEST(BTreeSet, InsertSortedBulk) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    for (int N = 0; N < 500; N += 7) {
+        // a sorted range is appended to an empty set
+        std::vector<int> data;
+        for (int i = 0; i < N; i++) {
+            data.push_back(2 * i);
+        }
+        test_set t;
+        t.insertSortedBulk(data.begin(), data.end());
+        EXPECT_EQ(data.size(), t.size());
+        EXPECT_TRUE(t.check());
+
+        // a range partly beyond the maximum, with duplicates and unsorted elements
+        std::vector<int> more;
+        for (int i = 0; i < N; i++) {
+            more.push_back(N + i);
+        }
+        for (int i = 0; i < N; i += 3) {
+            more.push_back(i);
+        }
+        t.insertSortedBulk(more.begin(), more.end());
+        EXPECT_TRUE(t.check());
+
+        std::set<int> should(data.begin(), data.end());
+        should.insert(more.begin(), more.end());
+        EXPECT_EQ(should.size(), t.size());
+        EXPECT_TRUE(std::equal(should.begin(), should.end(), t.begin()));
+    }
+}
+
+TEST(BTreeSet, InsertRangeParallel) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    // sorted, overlapping ranges are inserted concurrently
+    test_set t;
+#pragma omp parallel for
+    for (int i = 0; i < 64; i++) {
+        std::vector<int> data;
+        for (int j = 0; j < 1000; j++) {
+            data.push_back(i * 500 + j);
+        }
+        t.insert(data.begin(), data.end());
+    }
+    EXPECT_TRUE(t.check());
+    EXPECT_EQ(63 * 500 + 1000, t.size());
+}
+
+TEST(BTreeSet, InsertAll) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set a;
+    test_set b;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 2 == 0) {
+            a.insert(i);
+        }
+        if (i % 3 == 0) {
+            b.insert(i);
+        }
+    }
+
+    // merging into an empty set copies the other set
+    test_set c;
+    c.insertAll(b);
+    EXPECT_EQ(b.size(), c.size());
+    EXPECT_TRUE(c.check());
+    EXPECT_TRUE(b == c);
+
+    a.insertAll(b);
+    EXPECT_EQ(667, a.size());
+    EXPECT_TRUE(a.check());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(i % 2 == 0 || i % 3 == 0, a.contains(i)) << "i=" << i;
+    }
+}
+
 TEST(BTreeSet, Clear) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -501,6 +582,160 @@ TEST(BTreeSet, Clear) {
     EXPECT_TRUE(t.empty());
 }
 
+TEST(BTreeSet, ClearReuse) {
+    // keys requiring destruction, with nodes released in bulk
+    using test_set = btree_set<std::string, detail::comparator<std::string>, std::allocator<std::string>, 64>;
+
+    test_set t;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 1000; i++) {
+            t.insert(std::to_string(i * (round + 1)) + std::string(32, 'x'));
+        }
+        EXPECT_EQ(1000, t.size());
+        EXPECT_TRUE(t.check());
+
+        test_set copy(t);
+        test_set other;
+        other.swap(copy);
+        EXPECT_TRUE(copy.empty());
+        EXPECT_EQ(t, other);
+
+        t.clear();
+        EXPECT_TRUE(t.empty());
+        EXPECT_EQ(0, t.size());
+    }
+}
+
+TEST(BTreeSet, Rank) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16,
+            detail::default_strategy<int>::type, detail::comparator<int>, detail::updater<int>, true>;
+
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> dist(0, 5000);
+
+    test_set t;
+    std::set<int> should;
+    EXPECT_EQ(0, t.rank(t.begin()));
+
+    // ranks are queried in between insertions, invalidating the cached counts
+    for (int i = 0; i < 2000; i++) {
+        int k = dist(generator);
+        t.insert(k);
+        should.insert(k);
+        if (i % 50 == 0) {
+            int q = dist(generator);
+            std::size_t expected = std::distance(should.begin(), should.lower_bound(q));
+            EXPECT_EQ(expected, t.rank(t.lower_bound(q)));
+            EXPECT_EQ(should.size(), t.rank(t.end()));
+        }
+    }
+
+    // the rank of every element is its position
+    std::size_t pos = 0;
+    for (auto it = t.begin(); it != t.end(); ++it) {
+        EXPECT_EQ(pos++, t.rank(it));
+    }
+
+    // ranges appended in bulk
+    std::vector<int> more;
+    for (int i = 0; i < 1000; i++) {
+        more.push_back(6000 + i);
+    }
+    t.insertSortedBulk(more.begin(), more.end());
+    should.insert(more.begin(), more.end());
+    EXPECT_EQ(should.size(), t.size());
+    EXPECT_EQ(should.size() - 500, t.rank(t.lower_bound(6500)));
+    EXPECT_EQ(500, t.rank(t.lower_bound(6500)) - t.rank(t.lower_bound(6000)));
+
+    // insertions conducted in parallel
+#pragma omp parallel for
+    for (int i = 0; i < 2000; i++) {
+        t.insert(8000 + i);
+    }
+    EXPECT_TRUE(t.check());
+    EXPECT_EQ(should.size() + 2000, t.rank(t.end()));
+    EXPECT_EQ(1000, t.rank(t.lower_bound(9000)) - t.rank(t.lower_bound(8000)));
+}
+
+TEST(BTreeSet, RankParallelRounds) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16,
+            detail::default_strategy<int>::type, detail::comparator<int>, detail::updater<int>, true>;
+
+    std::vector<int> data;
+    for (int i = 0; i < 20000; i++) {
+        data.push_back(i);
+    }
+    std::mt19937 generator(5);
+    std::shuffle(data.begin(), data.end(), generator);
+
+    // rounds of parallel insertions invalidate the counts cached in between
+    test_set t;
+    std::set<int> should;
+    for (int round = 0; round < 4; round++) {
+#pragma omp parallel for schedule(dynamic, 64)
+        for (int i = round * 5000; i < (round + 1) * 5000; i++) {
+            t.insert(data[i]);
+        }
+        should.insert(data.begin() + round * 5000, data.begin() + (round + 1) * 5000);
+        EXPECT_TRUE(t.check());
+        EXPECT_EQ(should.size(), t.size());
+        std::size_t expected = std::distance(should.lower_bound(5000), should.lower_bound(15000));
+        EXPECT_EQ(expected, t.rank(t.lower_bound(15000)) - t.rank(t.lower_bound(5000)));
+    }
+}
+
+TEST(BTreeSet, Predecessor) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    EXPECT_EQ(t.end(), t.predecessor(t.end()));
+
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<int> dist(0, 5000);
+    std::set<int> should;
+    for (int i = 0; i < 2000; i++) {
+        int k = dist(generator);
+        t.insert(k);
+        should.insert(k);
+    }
+
+    // walking backwards from the end visits all elements in reverse order
+    auto it = t.end();
+    for (auto cur = should.rbegin(); cur != should.rend(); ++cur) {
+        it = t.predecessor(it);
+        EXPECT_NE(t.end(), it);
+        EXPECT_EQ(*cur, *it);
+    }
+    EXPECT_EQ(t.begin(), it);
+    EXPECT_EQ(t.end(), t.predecessor(t.begin()));
+
+    // the last element of a range
+    for (int q = 0; q < 5000; q += 97) {
+        auto pos = should.upper_bound(q);
+        auto last = t.predecessor(t.upper_bound(q));
+        if (pos == should.begin()) {
+            EXPECT_EQ(t.end(), last);
+        } else {
+            EXPECT_EQ(*std::prev(pos), *last);
+        }
+    }
+
+    // trees built by appending sorted ranges
+    for (int N = 1; N < 500; N += 7) {
+        std::vector<int> data;
+        for (int i = 0; i < N; i++) {
+            data.push_back(i);
+        }
+        test_set u;
+        u.insertSortedBulk(data.begin(), data.end());
+        auto cur = u.end();
+        for (int i = N - 1; i >= 0; i--) {
+            cur = u.predecessor(cur);
+            EXPECT_EQ(i, *cur);
+        }
+    }
+}
+
 TEST(BTreeSet, ChunkSplit) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -576,6 +811,99 @@ TEST(BTreeSet, ChunkSplitStress) {
     }
 }
 
+TEST(BTreeSet, Spill) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    const int N = 100000;
+    test_set t;
+    for (int i = 0; i < N; i += 2) {
+        t.insert(i);
+    }
+
+    // the content remains accessible, and modifiable, after spilling
+    t.spill();
+    EXPECT_EQ(N / 2, t.size());
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ(i % 2 == 0, t.contains(i));
+    }
+    for (int i = 1; i < N; i += 2) {
+        t.insert(i);
+    }
+    t.spill();
+
+    int last = -1;
+    for (int i : t) {
+        EXPECT_EQ(last + 1, i);
+        last = i;
+    }
+    EXPECT_EQ(N - 1, last);
+
+    // spilled memory is released on clearing
+    t.clear();
+    EXPECT_TRUE(t.empty());
+    t.insert(1);
+    EXPECT_TRUE(t.contains(1));
+}
+
+// a comparator ordering tuples lexicographically by the given columns
+template <unsigned... Columns>
+struct ColumnComparator {
+    template <typename T>
+    int operator()(const T& a, const T& b) const {
+        for (unsigned i : {Columns...}) {
+            if (a[i] != b[i]) {
+                return (a[i] < b[i]) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+    template <typename T>
+    bool less(const T& a, const T& b) const {
+        return (*this)(a, b) < 0;
+    }
+    template <typename T>
+    bool equal(const T& a, const T& b) const {
+        return (*this)(a, b) == 0;
+    }
+};
+
+TEST(BTreeSet, SimdSearch) {
+    using Key = Tuple<int64_t, 3>;
+    using comparator = ColumnComparator<1, 0, 2>;
+    using test_set = btree_set<Key, comparator, std::allocator<Key>, 256, detail::simd_search<1, 0, 2>>;
+    using reference_set = btree_set<Key, comparator, std::allocator<Key>, 256, detail::binary_search>;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int64_t> values(-20, 20);
+    auto random = [&]() { return Key{{values(generator), values(generator), values(generator)}}; };
+
+    test_set t;
+    reference_set r;
+    for (int i = 0; i < 5000; ++i) {
+        auto cur = random();
+        EXPECT_EQ(r.insert(cur), t.insert(cur));
+    }
+    EXPECT_EQ(r.size(), t.size());
+    EXPECT_TRUE(t.check());
+    EXPECT_TRUE(std::equal(r.begin(), r.end(), t.begin()));
+
+    // lookups agree with a binary search
+    for (int i = 0; i < 5000; ++i) {
+        auto cur = random();
+        EXPECT_EQ(r.contains(cur), t.contains(cur));
+        auto lower = t.lower_bound(cur);
+        auto upper = t.upper_bound(cur);
+        EXPECT_EQ(r.lower_bound(cur) == r.end(), lower == t.end());
+        EXPECT_EQ(r.upper_bound(cur) == r.end(), upper == t.end());
+        if (lower != t.end()) {
+            EXPECT_EQ(*r.lower_bound(cur), *lower);
+        }
+        if (upper != t.end()) {
+            EXPECT_EQ(*r.upper_bound(cur), *upper);
+        }
+    }
+}
+
 using Entry = std::tuple<int, int>;
 
 std::vector<Entry> getData(unsigned numEntries) {
@@ -327,6 +327,44 @@ TEST(DjTest, Clear) {
     ds.clear();
 }
 
+TEST(DjTest, SetSizes) {
+    // the set sizes, member cycles and pair count follow the unions
+    souffle::DisjointSet ds;
+    for (size_t i = 0; i < 6; ++i) {
+        ds.makeNode();
+    }
+    EXPECT_EQ(ds.pairCount(), 6);
+
+    ds.unionNodes(0, 1);
+    ds.unionNodes(2, 3);
+    ds.unionNodes(3, 4);
+    EXPECT_EQ(ds.pairCount(), 4 + 9 + 1);
+    EXPECT_EQ(ds.setSize(ds.findNode(4)), 3);
+
+    // joining nodes of the same set changes nothing
+    ds.unionNodes(2, 4);
+    EXPECT_EQ(ds.pairCount(), 4 + 9 + 1);
+
+    ds.unionNodes(1, 4);
+    EXPECT_EQ(ds.pairCount(), 25 + 1);
+    EXPECT_EQ(ds.setSize(ds.findNode(0)), 5);
+    EXPECT_EQ(ds.setSize(5), 1);
+
+    // the cycle of members starting at any member covers the set
+    size_t count = 0;
+    parent_t cur = 3;
+    do {
+        EXPECT_TRUE(ds.sameSet(cur, 0));
+        cur = ds.nextMember(cur);
+        ++count;
+    } while (cur != 3);
+    EXPECT_EQ(count, 5);
+    EXPECT_EQ(ds.nextMember(5), 5);
+
+    ds.clear();
+    EXPECT_EQ(ds.pairCount(), 0);
+}
+
 #ifdef _OPENMP
 TEST(DjTest, ParallelScaling) {
     // insert, union, and stuff in parallel, then check things are in the valid sets
@@ -353,6 +391,42 @@ TEST(DjTest, ParallelScaling) {
     for (size_t i = 0; i < N; ++i) {
         EXPECT_EQ(rep, ds.findNode(i));
     }
+    EXPECT_EQ(ds.setSize(rep), N);
+    EXPECT_EQ(ds.pairCount(), N * N);
+}
+
+TEST(DjTest, ParallelSetSizes) {
+    // join nodes into sets by their residue in parallel, each with a scattered earlier node of its set
+    souffle::DisjointSet ds;
+    constexpr size_t N = 10000;
+    constexpr size_t M = 7;
+    for (size_t i = 0; i < N; ++i) {
+        ds.makeNode();
+    }
+
+#pragma omp parallel for
+    for (size_t i = M; i < N; ++i) {
+        ds.unionNodes(i, (i * 31) % (i / M) * M + i % M);
+    }
+
+    size_t pairs = 0;
+    for (size_t r = 0; r < M; ++r) {
+        parent_t rep = ds.findNode(r);
+        size_t expected = (N - r + M - 1) / M;
+        EXPECT_EQ(ds.setSize(rep), expected);
+        pairs += expected * expected;
+
+        // the cycle of members visits every member once
+        size_t count = 0;
+        parent_t cur = rep;
+        do {
+            EXPECT_EQ(cur % M, r);
+            cur = ds.nextMember(cur);
+            ++count;
+        } while (cur != rep);
+        EXPECT_EQ(count, expected);
+    }
+    EXPECT_EQ(ds.pairCount(), pairs);
 }
 #endif  // ifdef _OPENMP
 
@@ -0,0 +1,174 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hashset_test.cpp
+ *
+ * A test case testing the hash set implementation.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/BTree.h"
+#include "souffle/datastructure/HashSet.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using Entry = Tuple<RamDomain, 3>;
+
+template <typename Range>
+std::size_t length(const Range& range) {
+    return std::distance(range.begin(), range.end());
+}
+
+TEST(HashSet, Basic) {
+    HashSet<3> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+
+    EXPECT_TRUE(set.insert(Entry{{1, 2, 3}}));
+    EXPECT_FALSE(set.insert(Entry{{1, 2, 3}}));
+    EXPECT_TRUE(set.insert(Entry{{3, 2, 1}}));
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(2, set.size());
+
+    EXPECT_TRUE(set.contains(Entry{{1, 2, 3}}));
+    EXPECT_TRUE(set.contains(Entry{{3, 2, 1}}));
+    EXPECT_FALSE(set.contains(Entry{{2, 2, 2}}));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains(Entry{{1, 2, 3}}));
+}
+
+TEST(HashSet, Growth) {
+    HashSet<3> set;
+    for (RamDomain i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(set.insert(Entry{{i, i % 7, 0}}));
+    }
+    EXPECT_EQ(10000, set.size());
+
+    // tuples are enumerated in the order of their insertion
+    RamDomain i = 0;
+    for (const auto& cur : set) {
+        EXPECT_EQ((Entry{{i, i % 7, 0}}), cur);
+        ++i;
+    }
+    EXPECT_EQ(10000, i);
+}
+
+TEST(HashSet, EqualRange) {
+    HashSet<3> set(std::vector<std::size_t>{0});
+    std::multiset<RamDomain> expected;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        set.insert(Entry{{i % 10, i, i % 3}});
+        if (i % 10 == 4 && i % 3 == 1) {
+            expected.insert(i);
+        }
+    }
+
+    // follow the chain of a key
+    HashSet<3>::attribute_set key("001");
+    std::size_t count = 0;
+    for (const auto& cur : set.equalRange(Entry{{4, 0, 0}}, key)) {
+        EXPECT_EQ(4, cur[0]);
+        ++count;
+    }
+    EXPECT_EQ(100, count);
+
+    // follow the chain of a key, filtered by another attribute
+    HashSet<3>::attribute_set attributes("101");
+    std::multiset<RamDomain> found;
+    for (const auto& cur : set.equalRange(Entry{{4, 0, 1}}, attributes)) {
+        found.insert(cur[1]);
+    }
+    EXPECT_EQ(expected, found);
+
+    // locate a single tuple
+    HashSet<3>::attribute_set all("111");
+    EXPECT_EQ(1, length(set.equalRange(Entry{{4, 14, 2}}, all)));
+    EXPECT_EQ(0, length(set.equalRange(Entry{{4, 15, 2}}, all)));
+    EXPECT_EQ(0, length(set.equalRange(Entry{{11, 0, 0}}, key)));
+}
+
+TEST(HashSet, Partition) {
+    HashSet<3> set;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        set.insert(Entry{{i, 0, 0}});
+    }
+
+    std::set<RamDomain> found;
+    for (const auto& part : set.partition(7)) {
+        for (const auto& cur : part) {
+            EXPECT_TRUE(found.insert(cur[0]).second);
+        }
+    }
+    EXPECT_EQ(1000, found.size());
+
+    HashSet<3> copy;
+    copy.insertAll(set);
+    EXPECT_EQ(1000, copy.size());
+    EXPECT_TRUE(copy.contains(Entry{{999, 0, 0}}));
+}
+
+TEST(HashSet, ParallelInsert) {
+    HashSet<3> set(std::vector<std::size_t>{1});
+
+    // every tuple is inserted by several threads
+#pragma omp parallel for
+    for (int i = 0; i < 100000; ++i) {
+        RamDomain j = i % 20000;
+        set.insert(Entry{{j, j % 50, 0}});
+    }
+    EXPECT_EQ(20000, set.size());
+
+    HashSet<3>::attribute_set key("010");
+    for (RamDomain k = 0; k < 50; ++k) {
+        EXPECT_EQ(400, length(set.equalRange(Entry{{0, k, 0}}, key)));
+    }
+}
+
+TEST(HashSet, MemoryUsage) {
+    HashSet<3> set;
+    HashSet<3> keyed(std::vector<std::size_t>{0});
+    btree_set<Entry> btree;
+
+    for (RamDomain i = 0; i < 100000; ++i) {
+        Entry tuple{{i % 1000, i, i % 3}};
+        set.insert(tuple);
+        keyed.insert(tuple);
+        btree.insert(tuple);
+    }
+
+    // the tuples are stored inline, next to a slot per tuple and, if keyed, a successor and a slot per key
+    EXPECT_LT(100000 * (sizeof(Entry) + sizeof(std::uint64_t)), set.getMemoryUsage());
+    EXPECT_LT(set.getMemoryUsage() + 100000 * sizeof(std::size_t), keyed.getMemoryUsage());
+
+    // constant-time lookups are paid for with more memory than a b-tree takes
+    std::cout << "memory per tuple - hash set: " << set.getMemoryUsage() / 100000
+              << " bytes, keyed hash set: " << keyed.getMemoryUsage() / 100000
+              << " bytes, b-tree: " << btree.getMemoryUsage() / 100000 << " bytes\n";
+    EXPECT_LT(btree.getMemoryUsage(), set.getMemoryUsage());
+}
+
+}  // namespace test
+}  // namespace souffle
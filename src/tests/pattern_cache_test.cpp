@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file pattern_cache_test.cpp
+ *
+ * Tests the pattern cache for match and contains constraints.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/PatternCache.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace souffle::test {
+
+TEST(PatternCache, Match) {
+    SymbolTable symTable;
+    PatternCache cache(symTable);
+    RamDomain pattern = symTable.lookup("a.*c");
+    RamDomain abc = symTable.lookup("abc");
+    RamDomain abd = symTable.lookup("abd");
+    cache.pin(pattern);
+
+    // repeated queries are answered from the memo table
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_TRUE(cache.match(pattern, abc));
+        EXPECT_FALSE(cache.match(pattern, abd));
+        EXPECT_FALSE(cache.notMatch(pattern, abc));
+        EXPECT_TRUE(cache.notMatch(pattern, abd));
+    }
+}
+
+TEST(PatternCache, MalformedPattern) {
+    SymbolTable symTable;
+    PatternCache cache(symTable);
+    RamDomain pattern = symTable.lookup("a((");
+    RamDomain text = symTable.lookup("a");
+
+    // neither constraint holds for a malformed pattern
+    EXPECT_FALSE(cache.match(pattern, text));
+    EXPECT_FALSE(cache.notMatch(pattern, text));
+}
+
+TEST(PatternCache, Contains) {
+    SymbolTable symTable;
+    PatternCache cache(symTable);
+    RamDomain pattern = symTable.lookup("an");
+    RamDomain banana = symTable.lookup("banana");
+    RamDomain cherry = symTable.lookup("cherry");
+
+    EXPECT_TRUE(cache.contains(pattern, banana));
+    EXPECT_FALSE(cache.contains(pattern, cherry));
+    EXPECT_FALSE(cache.contains(banana, pattern));
+    EXPECT_TRUE(cache.contains(pattern, pattern));
+}
+
+TEST(PatternCache, Eviction) {
+    SymbolTable symTable;
+    // a small capacity forces the tables to be flushed repeatedly
+    PatternCache cache(symTable, 32);
+    std::vector<RamDomain> patterns;
+    std::vector<RamDomain> texts;
+    for (int i = 0; i < 20; ++i) {
+        patterns.push_back(symTable.lookup("x" + std::to_string(i) + "[0-9]*"));
+        texts.push_back(symTable.lookup("x" + std::to_string(i % 5) + std::to_string(i)));
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (RamDomain pattern : patterns) {
+            for (RamDomain text : texts) {
+                bool expected =
+                        std::regex_match(symTable.resolve(text), std::regex(symTable.resolve(pattern)));
+                EXPECT_EQ(expected, cache.match(pattern, text));
+            }
+        }
+    }
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,176 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sorted_array_test.cpp
+ *
+ * A test case testing the sorted array implementation.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/datastructure/BTree.h"
+#include "souffle/datastructure/SortedArray.h"
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using test_set = SortedArray<int>;
+
+TEST(SortedArray, Basic) {
+    test_set a;
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(0, a.size());
+    EXPECT_FALSE(a.contains(1));
+    EXPECT_EQ(a.end(), a.lower_bound(1));
+
+    EXPECT_TRUE(a.insert(1));
+    EXPECT_TRUE(a.insert(3));
+    EXPECT_TRUE(a.insert(5));
+    EXPECT_FALSE(a.insert(3));
+    EXPECT_EQ(3, a.size());
+
+    // keys out of order are placed in between
+    EXPECT_TRUE(a.insert(2));
+    EXPECT_TRUE(a.insert(0));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 5}), std::vector<int>(a.begin(), a.end()));
+
+    EXPECT_TRUE(a.contains(2));
+    EXPECT_FALSE(a.contains(4));
+    EXPECT_EQ(a.end(), a.find(4));
+    EXPECT_EQ(3, *a.find(3));
+    EXPECT_EQ(5, *a.lower_bound(4));
+    EXPECT_EQ(5, *a.upper_bound(3));
+    EXPECT_EQ(a.end(), a.upper_bound(5));
+
+    a.clear();
+    EXPECT_TRUE(a.empty());
+}
+
+TEST(SortedArray, Bounds) {
+    // large enough for the directory to be kept
+    const int N = 100000;
+    test_set a;
+    for (int i = 0; i < N; i++) {
+        a.insert(2 * i);
+    }
+    EXPECT_EQ(N, a.size());
+
+    // random probes, reusing the hints across searches in any direction
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> dist(-1, 2 * N);
+    test_set::operation_hints hints;
+    for (int i = 0; i < 10000; i++) {
+        int k = dist(generator);
+        int lower = (k <= 0) ? 0 : (k + 1) / 2;
+        int upper = (k < 0) ? 0 : k / 2 + 1;
+        EXPECT_EQ(lower, a.lower_bound(k, hints) - a.begin());
+        EXPECT_EQ(std::min(upper, N), a.upper_bound(k, hints) - a.begin());
+        EXPECT_EQ(k >= 0 && k % 2 == 0 && k < 2 * N, a.contains(k, hints));
+    }
+
+    // ascending probes gallop from the last result
+    for (int k = -1; k <= 2 * N; k++) {
+        EXPECT_EQ(std::min((k <= 0) ? 0 : (k + 1) / 2, N), a.lower_bound(k, hints) - a.begin());
+    }
+}
+
+TEST(SortedArray, InsertAll) {
+    test_set a;
+    test_set b;
+    std::set<int> all;
+    for (int i = 0; i < 10000; i++) {
+        a.insert(3 * i);
+        b.insert(5 * i);
+        all.insert(3 * i);
+        all.insert(5 * i);
+    }
+    a.insertAll(b);
+    EXPECT_EQ(all.size(), a.size());
+    EXPECT_TRUE(std::equal(a.begin(), a.end(), all.begin(), all.end()));
+    for (int k : all) {
+        EXPECT_TRUE(a.contains(k));
+    }
+}
+
+TEST(SortedArray, Copy) {
+    btree_set<int> src;
+    for (int i = 1000; i > 0; i--) {
+        src.insert(i);
+    }
+
+    // copying an ordered set appends its keys
+    test_set a;
+    a.reserve(src.size());
+    a.insert(src.begin(), src.end());
+    EXPECT_EQ(src.size(), a.size());
+    EXPECT_TRUE(std::equal(a.begin(), a.end(), src.begin(), src.end()));
+
+    test_set b(a);
+    test_set c(std::move(a));
+    EXPECT_EQ(1000, b.size());
+    EXPECT_EQ(1000, c.size());
+    EXPECT_TRUE(c.contains(500));
+}
+
+TEST(SortedArray, Partition) {
+    test_set a;
+    for (int i = 0; i < 1000; i++) {
+        a.insert(i);
+    }
+    for (std::size_t n : {1, 7, 100, 5000}) {
+        auto chunks = a.partition(n);
+        EXPECT_EQ(std::min<std::size_t>(n, 1000), chunks.size());
+        int next = 0;
+        for (const auto& chunk : chunks) {
+            EXPECT_FALSE(chunk.empty());
+            for (int i : chunk) {
+                EXPECT_EQ(next++, i);
+            }
+        }
+        EXPECT_EQ(1000, next);
+    }
+    EXPECT_TRUE(test_set().partition(4).empty());
+}
+
+TEST(SortedArray, Spill) {
+    const int N = 1000000;
+    test_set a;
+    for (int i = 0; i < N; i++) {
+        a.insert(i);
+    }
+
+    // the keys remain accessible after spilling, and are retained on modification
+    a.spill();
+    EXPECT_EQ(N, a.size());
+    EXPECT_TRUE(a.contains(N / 2));
+    EXPECT_TRUE(a.insert(N));
+    EXPECT_TRUE(a.insert(-1));
+    int last = -2;
+    for (int i : a) {
+        EXPECT_EQ(last + 1, i);
+        last = i;
+    }
+    EXPECT_EQ(N, last);
+
+    a.spill();
+    a.clear();
+    EXPECT_TRUE(a.empty());
+}
+
+}  // namespace test
+
+}  // namespace souffle